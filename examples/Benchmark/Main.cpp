@@ -0,0 +1,250 @@
+#define BM_NO_LOGGING
+#include "bmdl.h"
+#include "formats/bmdl_stl.h"
+
+#include <math.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Loader benchmark, builds a synthetic model with many meshes in memory and times
+// bmdl::LoadModel with an increasing number of loader threads. The model is also written
+// to a file and loaded once with bmdl::LoadModelAsync at each thread count. A binary STL grid
+// is then imported with bmdl::LoadStl, welding identical positions and welding within an epsilon.
+// usage : Example-Benchmark [meshCount] [vertsPerMesh] [iterations] [stlTriangles]
+
+template<typename T>
+static void Append(std::vector<uint8_t>& buffer, const T& value)
+{
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+	buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+}
+
+static std::vector<uint8_t> CreateModelData(uint32_t meshCount, uint32_t vertsPerMesh)
+{
+	uint32_t indicesPerMesh = vertsPerMesh * 3;
+
+	std::vector<uint8_t> meshBlock;
+	meshBlock.reserve(sizeof(bmdl::BmMeshBlockHeader) + meshCount * (sizeof(bmdl::BmMeshHeader) + sizeof(bmdl::BmSubMeshHeader) +
+		vertsPerMesh * sizeof(BmVert) + indicesPerMesh * sizeof(uint16_t)));
+
+	// headers are value initialized so fields and padding not set below are written as zero
+	bmdl::BmMeshBlockHeader blockHeader = bmdl::BmMeshBlockHeader();
+	blockHeader.numMeshes = static_cast<uint16_t>(meshCount);
+	Append(meshBlock, blockHeader);
+
+	for (uint32_t m = 0; m < meshCount; m++)
+	{
+		bmdl::BmMeshHeader meshHeader = bmdl::BmMeshHeader();
+		snprintf(meshHeader.name, sizeof(meshHeader.name), "mesh_%u", m);
+		meshHeader.vertCount = vertsPerMesh;
+		meshHeader.interleaved = true;
+		meshHeader.indiceCount = indicesPerMesh;
+		meshHeader.indiceType = static_cast<uint8_t>(BmIndexType::UInt16);
+		meshHeader.vertAttrCount = BmDefaultLayout.attributeCount;
+		for (uint32_t a = 0; a < BmDefaultLayout.attributeCount; a++)
+			meshHeader.verAttrList[a] = BmDefaultLayout.attributes[a];
+		meshHeader.subMeshCount = 1;
+		Append(meshBlock, meshHeader);
+
+		bmdl::BmSubMeshHeader subMeshHeader = bmdl::BmSubMeshHeader();
+		subMeshHeader.indiceOffset = 0;
+		subMeshHeader.indiceCount = indicesPerMesh;
+		subMeshHeader.materialID = 0;
+		Append(meshBlock, subMeshHeader);
+
+		for (uint32_t v = 0; v < vertsPerMesh; v++)
+		{
+			BmVert vert;
+			vert.position = BmVec3(static_cast<float>(v), static_cast<float>(m), 0.0f);
+			vert.texCoord = BmVec2(0.5f);
+			vert.normal = BmVec3(0.0f, 0.0f, 1.0f);
+			vert.color = BmColor32(255);
+			Append(meshBlock, vert);
+		}
+
+		for (uint32_t i = 0; i < indicesPerMesh; i++)
+			Append(meshBlock, static_cast<uint16_t>((i / 3 + i % 3) % vertsPerMesh));
+	}
+
+	std::vector<uint8_t> fileData;
+	fileData.reserve(sizeof(bmdl::BmFileHeader) + sizeof(bmdl::BmFileBlock) + meshBlock.size());
+
+	bmdl::BmFileHeader fileHeader = bmdl::BmFileHeader();
+	fileHeader.fileID = bmdl::BmFileID;
+	fileHeader.versionMajor = bmdl::BmVersionMajor;
+	fileHeader.versionMinor = bmdl::BmVersionMinor;
+	Append(fileData, fileHeader);
+
+	bmdl::BmFileBlock fileBlock = bmdl::BmFileBlock();
+	fileBlock.type = bmdl::BmFileBlockType::MeshData;
+	fileBlock.blockLength = static_cast<uint32_t>(meshBlock.size());
+	Append(fileData, fileBlock);
+
+	fileData.insert(fileData.end(), meshBlock.begin(), meshBlock.end());
+
+	return fileData;
+}
+
+// binary STL of a grid of size x size quads, two triangles each, every corner stored unshared
+static std::vector<uint8_t> CreateStlData(uint32_t size)
+{
+	uint32_t triangleCount = size * size * 2;
+
+	std::vector<uint8_t> stlData(84, 0);
+	stlData.reserve(84 + static_cast<size_t>(triangleCount) * 50);
+	memcpy(stlData.data(), "benchmark grid", 14);
+	memcpy(stlData.data() + 80, &triangleCount, sizeof(triangleCount));
+
+	for (uint32_t y = 0; y < size; y++)
+	{
+		for (uint32_t x = 0; x < size; x++)
+		{
+			float corners[4][3] =
+			{
+				{ static_cast<float>(x), static_cast<float>(y), 0.0f }, { static_cast<float>(x + 1), static_cast<float>(y), 0.0f },
+				{ static_cast<float>(x), static_cast<float>(y + 1), 0.0f }, { static_cast<float>(x + 1), static_cast<float>(y + 1), 0.0f }
+			};
+			const uint32_t triangles[2][3] = { { 0, 1, 2 }, { 1, 3, 2 } };
+
+			for (const uint32_t* triangle : triangles)
+			{
+				float normal[3] = { 0.0f, 0.0f, 1.0f };
+				Append(stlData, normal);
+				for (uint32_t c = 0; c < 3; c++)
+					Append(stlData, corners[triangle[c]]);
+				Append(stlData, static_cast<uint16_t>(0));
+			}
+		}
+	}
+
+	return stlData;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t meshCount = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 4096;
+	uint32_t vertsPerMesh = argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : 1024;
+	uint32_t iterations = argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 5;
+	uint32_t stlTriangles = argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : 1000000;
+
+	if (meshCount > UINT16_MAX) meshCount = UINT16_MAX;
+
+	std::vector<uint8_t> fileData = CreateModelData(meshCount, vertsPerMesh);
+	double megabytes = fileData.size() / (1024.0 * 1024.0);
+
+	const char* asyncFileName = "benchmark.bmf";
+	FILE* asyncFile = fopen(asyncFileName, "wb");
+	if (asyncFile == nullptr || fwrite(fileData.data(), 1, fileData.size(), asyncFile) != fileData.size())
+	{
+		printf("Unable to write %s\n", asyncFileName);
+		return 1;
+	}
+	fclose(asyncFile);
+
+	printf("Model : %u meshes, %u vertices per mesh, %.1f MB\n", meshCount, vertsPerMesh, megabytes);
+	printf("%8s %12s %12s %10s %12s\n", "threads", "best (ms)", "MB/s", "speedup", "async (ms)");
+
+	uint32_t maxThreads = std::thread::hardware_concurrency();
+	if (maxThreads == 0) maxThreads = 1;
+
+	double singleThreadTime = 0.0;
+	// 1, 2, 4 ... threads up to the hardware thread count
+	for (uint32_t threads = 1; ; threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads)
+	{
+		bmdl::SetWorkerCount(threads);
+
+		double bestTime = 0.0;
+		for (uint32_t it = 0; it < iterations; it++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			BmModel<BmVert, uint16_t>* model = bmdl::LoadModel<BmVert, uint16_t>(fileData.data(), static_cast<uint32_t>(fileData.size()));
+			auto end = std::chrono::high_resolution_clock::now();
+
+			if (model == nullptr || model->meshList.count != meshCount)
+			{
+				printf("Load failed\n");
+				return 1;
+			}
+			delete model;
+
+			double ms = std::chrono::duration<double, std::milli>(end - start).count();
+			if (it == 0 || ms < bestTime)
+				bestTime = ms;
+		}
+
+		if (threads == 1)
+			singleThreadTime = bestTime;
+
+		// with one thread the pool has no workers and the IO thread decodes the model itself
+		auto asyncStart = std::chrono::high_resolution_clock::now();
+		BmModel<BmVert, uint16_t>* asyncModel = bmdl::LoadModelAsync<BmVert, uint16_t>(asyncFileName).Wait();
+		auto asyncEnd = std::chrono::high_resolution_clock::now();
+
+		if (asyncModel == nullptr || asyncModel->meshList.count != meshCount)
+		{
+			printf("Async load failed\n");
+			return 1;
+		}
+		delete asyncModel;
+
+		double asyncTime = std::chrono::duration<double, std::milli>(asyncEnd - asyncStart).count();
+		printf("%8u %12.2f %12.1f %9.2fx %12.2f\n", threads, bestTime, megabytes / (bestTime / 1000.0), singleThreadTime / bestTime, asyncTime);
+
+		if (threads == maxThreads)
+			break;
+	}
+
+	remove(asyncFileName);
+
+	// STL import, the grid's corners weld to one vertex per grid point with and without an epsilon
+	uint32_t gridSize = static_cast<uint32_t>(sqrt(stlTriangles / 2.0));
+	if (gridSize == 0) gridSize = 1;
+
+	std::vector<uint8_t> stlData = CreateStlData(gridSize);
+	uint32_t weldedVertices = (gridSize + 1) * (gridSize + 1);
+	double stlTriangleMillions = gridSize * gridSize * 2 / 1000000.0;
+
+	bmdl::BmStlOptions epsilonOptions;
+	epsilonOptions.weldEpsilon = 0.01f;
+
+	printf("\nSTL : %u triangles, %.1f MB\n", gridSize * gridSize * 2, stlData.size() / (1024.0 * 1024.0));
+	printf("%8s %12s %12s %14s %12s\n", "threads", "exact (ms)", "Mtri/s", "epsilon (ms)", "Mtri/s");
+
+	for (uint32_t threads = 1; ; threads = (threads * 2 < maxThreads) ? threads * 2 : maxThreads)
+	{
+		bmdl::SetWorkerCount(threads);
+
+		double bestTimes[2] = { 0.0, 0.0 };
+		for (uint32_t weld = 0; weld < 2; weld++)
+		{
+			for (uint32_t it = 0; it < iterations; it++)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				BmModel<BmVert, uint32_t>* model = bmdl::LoadStl<BmVert, uint32_t>(stlData.data(), stlData.size(), &BmDefaultLayout,
+					weld == 0 ? bmdl::BmStlOptions() : epsilonOptions);
+				auto end = std::chrono::high_resolution_clock::now();
+
+				if (model == nullptr || model->meshList.count != 1 || model->meshList[0].vertices.count != weldedVertices)
+				{
+					printf("STL load failed\n");
+					return 1;
+				}
+				delete model;
+
+				double ms = std::chrono::duration<double, std::milli>(end - start).count();
+				if (it == 0 || ms < bestTimes[weld])
+					bestTimes[weld] = ms;
+			}
+		}
+
+		printf("%8u %12.2f %12.2f %14.2f %12.2f\n", threads, bestTimes[0], stlTriangleMillions / (bestTimes[0] / 1000.0),
+			bestTimes[1], stlTriangleMillions / (bestTimes[1] / 1000.0));
+
+		if (threads == maxThreads)
+			break;
+	}
+
+	return 0;
+}
@@ -4,6 +4,7 @@
 #include <GL/wglew.h>
 #include <GLFW/glfw3.h>
 #include "bmdl.h"
+#include "bmdl_draw.h"
 #include "Shader.h"
 
 #define XRES    1680
@@ -11,6 +12,13 @@
 #define DEG2RAD 0.0174533f
 
 struct Vert { BmVec3 pos; BmVec3 normal; BmVec2 uv; };
+
+// describes Vert so the loader can convert from whatever attributes the file stores
+BM_CREATE_LAYOUT(VertLayout)
+	BM_VERT_ATTR(BmBaseType::Float, 3, BmAttrMap::Position)
+	BM_VERT_ATTR(BmBaseType::Float, 3, BmAttrMap::Normal)
+	BM_VERT_ATTR(BmBaseType::Float, 2, BmAttrMap::TexCoord1)
+BM_END_LAYOUT(VertLayout)
 struct SubMesh { uint32_t offset; uint32_t count; };
 
 struct Mesh
@@ -29,6 +37,7 @@ struct UniformBufferData { BmMat4 modelViewProjection; };
 
 bool	InitializeGraphics();
 void	Draw(const Mesh& mesh);
+void	DrawIndirect(const Mesh& mesh);
 void	CreateMesh(Mesh* mesh, const void* vertexData, uint32_t vertexCount, const void* indiceData, uint32_t indiceCount, GLenum usage);
 GLuint	CreateShaderObject(const char* source, GLenum shaderType);
 GLuint	CreateBuffer(const void* data, uint32_t size, GLenum target, GLenum usage);
@@ -45,7 +54,12 @@ GLuint programID;
 GLuint uniformBuffer;
 UniformBufferData uniformData;
 
-std::vector<Mesh> meshList;
+Mesh modelMesh;
+
+// every submesh of the model is a command in indirectBuffer, drawn a batch (material) at a time
+bmdl::BmDrawList drawList;
+std::vector<bmdl::BmDrawIndirectCommand> commands;
+GLuint indirectBuffer;
 
 int main()
 {
@@ -54,18 +68,19 @@ int main()
 
 	// Load our model, read/store vertices interleaved that is the attributes for each vertex are stored like :- 
 	// {[pos, normal, uv],[pos, normal, uv]} rather than non-interleaved where values are stored seperately like {[pos, pos, pos] [normal, normal, normal] [uv, uv, uv]}
-	auto* model = bmdl::LoadModel<Vert>("resources/Angel.bmf"); // TODO : Force setting layout argument, and maybe vert also...?
+	// with ContiguousBuffers every mesh's vertices and indices are in one buffer each, ready to upload
+	auto* model = bmdl::LoadModel<Vert>("resources/Angel.bmf", &VertLayout, true, BmLoadFlags::ContiguousBuffers);
 
-	// create meshes from model
-	for (uint32_t m = 0; m < model->meshList.count; m++)
-	{
-		BmMesh<Vert, uint16_t>* curMesh = &model->meshList[m];
+	// each submesh becomes an indirect draw command in to the model buffers
+	bmdl::BmBufferLayout layout;
+	bmdl::BuildDrawList(&model, 1, drawList);
+	bmdl::BuildBufferLayout(&model, 1, layout);
+	bmdl::BuildIndirectCommands(drawList, layout, commands);
 
-		Mesh newMesh;
-		CreateMesh(&newMesh, curMesh->vertices.data, curMesh->vertices.count, curMesh->indices.data, curMesh->indices.count, GL_DYNAMIC_DRAW);
+	CreateMesh(&modelMesh, model->vertexBuffer.data, model->vertexBuffer.count, model->indexBuffer.data, model->indexBuffer.count, GL_DYNAMIC_DRAW);
 
-		meshList.push_back(newMesh);
-	}
+	if (GLEW_ARB_multi_draw_indirect)
+		indirectBuffer = CreateBuffer(commands.data(), static_cast<uint32_t>(commands.size() * sizeof(bmdl::BmDrawIndirectCommand)), GL_DRAW_INDIRECT_BUFFER, GL_STATIC_DRAW);
 
 	BmVec4 camPos = BmVec4(0.0f, -2.15f, -4.0f, 1.0f);
 	float camRotation = 0.0f;
@@ -82,10 +97,12 @@ int main()
 		uniformData.modelViewProjection = GetMVPMat(70.0f, static_cast<float>(XRES) / static_cast<float>(YRES), 0.001f, 1000.0f, camPos, camRotation);
 		UpdateBuffer(uniformBuffer, &uniformData, sizeof(UniformBufferData), GL_UNIFORM_BUFFER, GL_DYNAMIC_DRAW);
 
-		// draw meshes of model
+		// draw the model, one multi draw per material when the driver supports it
 		glUseProgram(programID);
-		for (auto const& mesh : meshList)
-			Draw(mesh);
+		if (GLEW_ARB_multi_draw_indirect)
+			DrawIndirect(modelMesh);
+		else
+			Draw(modelMesh);
 
 		glfwSwapBuffers(window);
 	}
@@ -98,7 +115,21 @@ int main()
 void Draw(const Mesh& mesh)
 {
 	glBindVertexArray(mesh.vertexArrayID);
-	glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indiceCount, GL_UNSIGNED_SHORT, 0, 0);
+	for (const bmdl::BmDrawIndirectCommand& command : commands)
+		glDrawElementsBaseVertex(GL_TRIANGLES, command.indexCount, GL_UNSIGNED_SHORT, (GLvoid*)(command.firstIndex * sizeof(uint16_t)), command.baseVertex);
+	glBindVertexArray(0);
+}
+
+void DrawIndirect(const Mesh& mesh)
+{
+	glBindVertexArray(mesh.vertexArrayID);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	for (const bmdl::BmDrawBatch& batch : drawList.batches)
+	{
+		// bind the material of batch.materialID here
+		glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, (GLvoid*)(batch.drawOffset * sizeof(bmdl::BmDrawIndirectCommand)), batch.drawCount, 0);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 	glBindVertexArray(0);
 }
 
@@ -87,6 +87,12 @@ class ExportBMF(bpy.types.Operator, ExportHelper, IO3DSOrientationHelper):
                 default=1,
             )
             
+    quantize = BoolProperty(
+                name="Quantize Vertices",
+                description="Store 16 bit positions, octahedral normals and half float UVs, about half the size",
+                default=False,
+            )
+            
     indice_type = EnumProperty(items=(('AUTO', "Automatic", "Automatically determine best indice type"),
                                         ('UInt16', "Short", "16 bit indices max 65536 vertices"),
                                         ('UInt32', "Integer", "32 bit indices"),
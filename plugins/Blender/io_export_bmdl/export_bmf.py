@@ -157,7 +157,13 @@ class BmBaseType(IntEnum):
     Int64   = 7,
     Uint64  = 8,
     Float   = 9,
-    Double  = 10
+    Double  = 10,
+    Half    = 11,
+    
+    # quantized encodings
+    OctSnorm8       = 16,
+    OctSnorm16      = 17,
+    BoundsUnorm16   = 18
     
 class BmAttrMap(IntEnum):
     Unknown     = 0,
@@ -191,6 +197,40 @@ BM_VERSION_MAJOR = 0
 BM_VERSION_MINOR = 1
 BM_MAX_VERT_ATTRS = 32
 
+# Quantization helpers, must match the loader's decoding in bmdl_convert.h
+# ========================
+
+def float_to_half(val):
+    # struct rounds to nearest even like the loader's FloatToHalf
+    try:
+        return struct.unpack("<H", struct.pack("<e", val))[0]
+    except OverflowError:
+        return 0xFC00 if val < 0 else 0x7C00
+
+def to_snorm16(val):
+    val = max(-1.0, min(1.0, val)) * 32767.0
+    return int(val - 0.5) if val < 0 else int(val + 0.5)
+
+def to_unorm16(val):
+    return int(max(0.0, min(1.0, val)) * 65535.0 + 0.5)
+
+# unit vector -> 2 components in [-1, 1] on an octahedron with the lower half folded over the upper
+def encode_octahedral(v):
+    l1 = abs(v.x) + abs(v.y) + abs(v.z)
+    if l1 == 0.0:
+        return (0.0, 0.0)
+    
+    x = v.x / l1
+    y = v.y / l1
+    if v.z < 0.0:
+        fold_x = (1.0 - abs(y)) * (1.0 if x >= 0.0 else -1.0)
+        fold_y = (1.0 - abs(x)) * (1.0 if y >= 0.0 else -1.0)
+        x, y = fold_x, fold_y
+    
+    return (x, y)
+
+# ========================
+
 class BmFileBlockType(IntEnum):
     MeshData		= 0,
     MaterialData	= 8,
@@ -224,6 +264,14 @@ class BmVertAttr(object):
         self.components = 0
         self.attr_map = BmAttrMap.Unknown
         
+    @classmethod
+    def create(cls, base_type, components, attr_map):
+        attr = cls()
+        attr.base_type = base_type
+        attr.components = components
+        attr.attr_map = attr_map
+        return attr
+        
     def write(self, stream):
         stream.write_uint8(self.base_type)
         stream.write_uint8(self.components)
@@ -250,10 +298,10 @@ class BmSubMesh(object):
         if(indiceType == BmIndexType.UInt16):
             for i in self.indices:
                 stream.write_uint16(min(i, 0xFFFF))
-        elif(indiceType == BmIndexTypeUInt32):
+        elif(indiceType == BmIndexType.UInt32):
             for i in self.indices:
                 stream.write_uint32(i)
-        elif(indiceType == BmIndexTypeUInt8):
+        elif(indiceType == BmIndexType.UInt8):
             for i in self.indices:
                 stream.write_uint8(min(i, 0xFF))
         
@@ -356,7 +404,7 @@ class BmFace(object):
     
 class BmMesh(object):
 
-    def __init__(self, obj, mesh, matrix, uv_channels):
+    def __init__(self, obj, mesh, matrix, uv_channels, quantize=False):
         self.mesh = mesh
         self.submeshes = defaultdict(BmSubMesh)
         self.vertices = []
@@ -373,12 +421,45 @@ class BmMesh(object):
         self.vertAttributes = [None] * BM_MAX_VERT_ATTRS
         self.interleaved = True
         
+        # 16 bit positions against the mesh bounds, octahedral normals and half float uvs
+        self.quantize = quantize
+        self.bounds_min = Vec3(0.0, 0.0, 0.0)
+        self.bounds_max = Vec3(0.0, 0.0, 0.0)
+        
         # calculate split normals to preserve hard edges
         self.mesh.calc_normals_split()
         self.mesh.calc_tessface()
         
         self._create_mesh(obj,mesh,matrix)
         
+        # 16 bit indices unless the mesh has too many vertices to address with them
+        if len(self.vertices) > 0x10000:
+            self.indiceType = BmIndexType.UInt32
+        
+        self._set_attributes()
+        
+    def _set_attributes(self):
+        if self.quantize:
+            attributes = [BmVertAttr.create(BmBaseType.BoundsUnorm16, 3, BmAttrMap.Position),
+                          BmVertAttr.create(BmBaseType.OctSnorm16, 2, BmAttrMap.Normal)]
+            uv_type = BmBaseType.Half
+        else:
+            attributes = [BmVertAttr.create(BmBaseType.Float, 3, BmAttrMap.Position),
+                          BmVertAttr.create(BmBaseType.Float, 3, BmAttrMap.Normal)]
+            uv_type = BmBaseType.Float
+        
+        for uvc in range(0, self.num_uv_channels):
+            attributes.append(BmVertAttr.create(uv_type, 2, BmAttrMap(BmAttrMap.TexCoord1 + uvc)))
+        
+        self.vertAttrCount = len(attributes)
+        for a, attr in enumerate(attributes):
+            self.vertAttributes[a] = attr
+        
+        if self.quantize and len(self.vertices) > 0:
+            positions = [v.pos for v in self.vertices]
+            self.bounds_min = Vec3(min(p.x for p in positions), min(p.y for p in positions), min(p.z for p in positions))
+            self.bounds_max = Vec3(max(p.x for p in positions), max(p.y for p in positions), max(p.z for p in positions))
+        
     def write(self, stream):
         # write main mesh header
         self._write_mesh_header(stream)
@@ -389,9 +470,18 @@ class BmMesh(object):
             submesh.write_header(stream, indice_count)
             indice_count += len(submesh.indices)
         
+        # bounds the quantized positions are stored against
+        if self.quantize:
+            stream.write(self.bounds_min)
+            stream.write(self.bounds_max)
+        
         # write vertex data
         if self.interleaved:
             for i in range(0, len(self.vertices)):
+                if self.quantize:
+                    self._write_quantized_vertex(stream, self.vertices[i])
+                    continue
+                
                 stream.write(self.vertices[i].pos)
                 stream.write(self.vertices[i].normal)
                 for uv in self.vertices[i].uv_channels:
@@ -405,6 +495,19 @@ class BmMesh(object):
         
         print("Wrote {0} vertices, {1} indices, {2} submeshes".format(len(self.vertices), indice_count, len(self.submeshes)))
             
+    def _write_quantized_vertex(self, stream, vertex):
+        lo = self.bounds_min
+        hi = self.bounds_max
+        for p, l, h in ((vertex.pos.x, lo.x, hi.x), (vertex.pos.y, lo.y, hi.y), (vertex.pos.z, lo.z, hi.z)):
+            stream.write_uint16(to_unorm16((p - l) / (h - l)) if h > l else 0)
+        
+        for c in encode_octahedral(vertex.normal):
+            stream.write_int16(to_snorm16(c))
+        
+        for uv in vertex.uv_channels:
+            stream.write_uint16(float_to_half(uv.x))
+            stream.write_uint16(float_to_half(uv.y))
+    
     def _write_mesh_header(self, stream):
         stream.write_string(sane_name(self.meshName), 64)
         
@@ -540,6 +643,7 @@ def write_file(operator,
                 export_selected=True,
                 global_matrix=None,
 				uv_channels=0,
+                quantize=False,
                 ):
     
     # TODO: build vertex attributes from these options
@@ -602,7 +706,7 @@ def write_file(operator,
      
     bm_mesh_list = []
     for obj, mesh, matrix in mesh_list:
-        new_mesh = BmMesh(obj, mesh, matrix, uv_channels)
+        new_mesh = BmMesh(obj, mesh, matrix, uv_channels, quantize)
         bm_mesh_list.append(new_mesh)
 
     write_mesh_block(bm_mesh_list, mesh_block_stream)
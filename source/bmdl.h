@@ -2,6 +2,13 @@
 
 #include "bmdl_common.h"
 #include "bmdl_util.h"
+#include "bmdl_worker.h"
+#include "bmdl_convert.h"
+#include "bmdl_layout.h"
+#include "bmdl_codec.h"
+#include "bmdl_lz.h"
+
+#include <algorithm>
 
 #define BM_FUNC_DECL
 
@@ -12,6 +19,93 @@ class BmModel;
 template<typename V = BmVert, typename I = uint16_t>
 class BmMesh;
 
+// a single non-interleaved vertex attribute, count elements of stride bytes stored contiguously
+struct BmVertStream
+{
+	BmVertAttr	attribute;
+	uint32_t	stride;
+	uint32_t	count;
+	uint8_t*	data;
+
+	template<typename T>
+	T* As() const { BM_ASSERT(sizeof(T) == stride); return reinterpret_cast<T*>(data); }
+};
+
+struct BmSubMesh
+{
+	uint32_t indexOffset;
+	uint32_t indexCount;
+	uint16_t materialID;
+};
+
+// a cluster of up to 255 vertices and triangles of a mesh. vertexCount entries of BmMesh::meshletVertices from
+// vertexOffset map its local vertices to mesh vertices, triangleCount * 3 local vertex numbers of
+// BmMesh::meshletTriangles from triangleOffset make up its triangles. stored in MeshletData blocks as is
+struct BmMeshlet
+{
+	uint32_t	vertexOffset;
+	uint32_t	triangleOffset;
+	uint8_t		vertexCount;
+	uint8_t		triangleCount;
+	uint16_t	subMesh;		// BmSubMesh the triangles come from
+};
+
+// culling bounds of a meshlet, each row of four floats loads in to one SIMD register. every triangle faces
+// away from an eye where dot(normalize(coneApex - eye), coneAxis) > coneCutoff, a cutoff of 1 never culls
+struct BmMeshletBounds
+{
+	float	center[3];
+	float	radius;
+	float	coneAxis[3];
+	float	coneCutoff;		// sine of the cone's half angle
+	float	coneApex[3];
+	float	reserved;
+};
+
+static_assert(sizeof(BmMeshlet) == 12 && sizeof(BmMeshletBounds) == 48, "meshlets are stored in files as is");
+
+// a lower level of detail of a mesh, drawn with the mesh's own vertices. indexCount entries of BmMesh::lodIndices
+// from indexOffset, split in to subMeshCount ranges of BmMesh::lodSubMeshes from subMeshOffset like the mesh
+// itself is split by its subMeshList
+struct BmMeshLod
+{
+	uint32_t	indexOffset;
+	uint32_t	indexCount;
+	uint32_t	subMeshOffset;
+	uint16_t	subMeshCount;
+	uint16_t	level;		// 1 for the most detailed level below the mesh
+	float		error;		// how far the surface moved from the mesh, relative to the mesh extent
+};
+
+// one step refining a progressive mesh. adds vertexCount vertices after the ones the mesh has, adds triangleCount
+// triangles at the positions in BmMesh::splitTriangles from triangleOffset and moves the updateCount corners of
+// BmMesh::splitUpdates from updateOffset on to the new vertices
+struct BmVertexSplit
+{
+	uint32_t	vertexCount;
+	uint32_t	triangleOffset;
+	uint32_t	triangleCount;
+	uint32_t	updateOffset;
+	uint32_t	updateCount;
+	float		error;		// how far the mesh is from full detail before the split, relative to the mesh extent
+};
+
+struct BmIndexUpdate
+{
+	uint32_t	position;	// of the corner in BmMesh::indices
+	uint32_t	previous;	// vertex before the split
+	uint32_t	vertex;		// vertex after the split
+};
+
+// where the vertices and indices of a mesh are in buffers shared with other meshes
+struct BmMeshBufferRange
+{
+	uint32_t firstVertex;
+	uint32_t vertexCount;
+	uint32_t firstIndex;
+	uint32_t indexCount;
+};
+
 namespace bmdl
 {
 
@@ -35,11 +129,16 @@ namespace bmdl
 
 	enum class BmFileBlockType : uint16_t
 	{
-		MeshData		= 0,
-		MaterialData	= 8,
-		SceneData		= 16,
-		ExtensionData	= 24,
-		AnimationData	= 32
+		MeshData			= 0,
+		CompressedMeshData	= 1,	// MeshData with vertex and index data coded by bmdl_codec.h
+		MeshletData			= 2,	// meshlets of meshes read earlier, see BmMeshletBlockHeader
+		LodData				= 3,	// one level of detail of meshes read earlier, see BmLodBlockHeader
+		ProgressiveData		= 4,	// vertex splits refining meshes read earlier, see BmProgressiveBlockHeader
+		MaterialData		= 8,
+		SceneData			= 16,
+		ExtensionData		= 24,
+		AnimationData		= 32,
+		CompressedBlock		= 40	// any other block compressed with bmdl_lz.h, see BmCompressedBlockHeader
 	};
 
 	struct BmFileBlock
@@ -77,31 +176,142 @@ namespace bmdl
 		uint16_t materialID;
 	};
 
+	// precedes the vertex and index data of each mesh in a CompressedMeshData block
+	struct BmCompressedStreamHeader
+	{
+		uint32_t vertexBytes;	// encoded size of the vertex data
+		uint32_t indexBytes;	// encoded size of the index data
+	};
+
+	// starts a CompressedBlock, followed by the compressed size of each chunk and then the chunk data.
+	// chunk c holds bytes [c * chunkSize, (c + 1) * chunkSize) of the wrapped block
+	struct BmCompressedBlockHeader
+	{
+		BmFileBlockType	type;				// type of the wrapped block
+		uint32_t		compressedLength;	// bytes of chunk data after the chunk size table
+		uint32_t		uncompressedLength;	// block length of the wrapped block
+		uint32_t		chunkSize;			// uncompressed bytes per chunk, the last chunk may be shorter
+	};
+
+	// starts a MeshletData block, followed at dataOffset by one set for each of meshCount meshes. a set is a
+	// BmMeshletSetHeader and then its BmMeshlet, BmMeshletBounds, vertex (uint32_t) and triangle (3 x uint8_t)
+	// arrays, each padded to 16 bytes. the writer places dataOffset so the sets are 16 byte aligned in the file
+	struct BmMeshletBlockHeader
+	{
+		uint32_t meshCount;
+		uint32_t dataOffset;	// bytes from the start of the block to the first set
+	};
+
+	struct BmMeshletSetHeader
+	{
+		uint32_t meshIndex;		// mesh in the model, counting the meshes of every mesh block before this one
+		uint32_t meshletCount;
+		uint32_t vertexCount;	// entries of the vertex array
+		uint32_t triangleCount;	// triangles of the triangle array
+	};
+
+	// starts a LodData block holding one level of detail of meshCount meshes, each following as a BmLodSetHeader,
+	// its BmSubMeshHeader ranges and its indices. every level is a block of its own so the loader can read one
+	// and skip the others
+	struct BmLodBlockHeader
+	{
+		uint16_t level;			// 1 for the most detailed level below the meshes themselves
+		uint32_t meshCount;
+	};
+
+	struct BmLodSetHeader
+	{
+		uint32_t	meshIndex;		// mesh in the model, counting the meshes of every mesh block before this one
+		uint32_t	indexCount;
+		uint8_t		indexType;		// BmIndexType of the indices, which number the vertices of the mesh
+		uint16_t	subMeshCount;
+		float		error;			// how far the surface moved from the mesh, relative to the mesh extent
+	};
+
+	// starts a ProgressiveData block refining meshes whose coarse base was read from the mesh blocks before it. meshCount
+	// sets follow, each a BmProgressiveSetHeader and for each region the index count (uint32_t) it has in the base and once
+	// fully refined. then come
+	// splitCount records in the order they are made, each a BmVertexSplitHeader, its vertices, the region (uint16_t) and
+	// corners of its triangles and the index position (uint32_t) and vertex of its updates. the block is never wrapped in a
+	// CompressedBlock so it can be read as it arrives, see BmProgressiveLoader
+	struct BmProgressiveBlockHeader
+	{
+		uint32_t meshCount;
+		uint32_t splitCount;
+	};
+
+	// regions are the submeshes of the mesh, or all of its indices when it has none. each keeps room in the
+	// mesh indices for every triangle it gets and splits add triangles to the end of what it holds
+	struct BmProgressiveSetHeader
+	{
+		uint32_t	meshIndex;		// mesh in the model, counting the meshes of every mesh block before this one
+		uint32_t	vertexCount;	// vertices once every split is made
+		uint8_t		indexType;		// BmIndexType of the indices in the records, which number the vertices of the mesh
+		uint16_t	regionCount;
+		uint16_t	vertAttrCount;	// attributes of the vertices in the records, none when they are stored as V
+		BmVertAttr	verAttrList[MAX_VERTEX_ATTRIBS];
+	};
+
+	struct BmVertexSplitHeader
+	{
+		uint32_t	set;			// set of the block the split refines
+		uint32_t	vertexCount;
+		uint32_t	triangleCount;
+		uint32_t	updateCount;
+		float		error;			// see BmVertexSplit
+	};
+
 	#pragma pack(pop)
 
+	static const uint32_t BmMeshletAlignment = 16;
+
 	// =================================
 
 	template<typename V = BmVert, typename I = uint16_t>
-	BM_FUNC_DECL BmModel<V, I>* LoadModel(std::string name, BmVertLayout* vertLayout = &BmDefaultLayout, bool interleaved = true)
-	{
-		int32_t dataSize = 0;
-		uint8_t* fileData = FileReadAll(name.c_str(), dataSize);
+	BM_FUNC_DECL BmModel<V, I>* LoadModel(uint8_t* fileData, uint32_t dataSize, BmVertLayout* vertLayout = &BmDefaultLayout, bool interleaved = true, BmLoadFlags flags = BmLoadFlags::None);
+
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL bool ReadMeshBlock(uint8_t* data, uint32_t blockLength, BmModel<V, I> *model, const BmVertLayout* vertLayout = &BmDefaultLayout, bool interleaved = true, BmLoadFlags flags = BmLoadFlags::None, BmFileBlockType blockType = BmFileBlockType::MeshData);
+
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL bool ReadFileBlock(BmFileBlockType type, uint8_t* data, uint32_t blockLength, BmModel<V, I>* model, const BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags);
 
-		if (fileData != nullptr)
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL BmModel<V, I>* LoadModelStreamed(const char* name, const BmVertLayout* vertLayout = &BmDefaultLayout, bool interleaved = true, BmLoadFlags flags = BmLoadFlags::None);
+
+	template<typename V, typename I>
+	BM_FUNC_DECL bool PackModelBuffers(BmModel<V, I>& model);
+
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL BmModel<V, I>* LoadModel(std::string name, BmVertLayout* vertLayout = &BmDefaultLayout, bool interleaved = true, BmLoadFlags flags = BmLoadFlags::None)
+	{
+		// map the file so mesh data can reference it in place, the model takes ownership of the mapping
+		if (BmHasFlag(flags, BmLoadFlags::MemoryMapped))
 		{
-			BmModel<V,I>* newModel = LoadModel<V,I>(fileData, dataSize, vertLayout, interleaved);
-			// BM_FREE(fileData);
+			BmFileMapping mapping;
+			if (!FileMap(name.c_str(), mapping))
+			{
+				BmSetLastError("Unable to map file");
+				return nullptr;
+			}
+
+			BmModel<V, I>* newModel = LoadModel<V, I>(mapping.data, mapping.size, vertLayout, interleaved, flags);
+			if (newModel != nullptr)
+				newModel->fileMapping = mapping;
+			else
+				FileUnmap(mapping);
+
 			return newModel;
 		}
-		else
-		{
-			BmSetLastError("Unable to read file");
-			return nullptr;
-		}
+
+		// read a block at a time so the whole file is never held in memory
+		return LoadModelStreamed<V, I>(name.c_str(), vertLayout, interleaved, flags);
 	}
 
-	template<typename V = BmVert, typename I = uint16_t>
-	BM_FUNC_DECL BmModel<V, I>* LoadModel(uint8_t* fileData, uint32_t dataSize, BmVertLayout* vertLayout = &BmDefaultLayout, bool interleaved = true)
+	// loads a model from a buffer holding the file data. when flags contains BmLoadFlags::MemoryMapped mesh
+	// data may reference fileData directly, in that case fileData must outlive the returned model
+	template<typename V, typename I>
+	BM_FUNC_DECL BmModel<V, I>* LoadModel(uint8_t* fileData, uint32_t dataSize, BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags)
 	{
 		BmModel<V, I>* newModel = new BmModel<V, I>();
 
@@ -142,7 +352,7 @@ namespace bmdl
 			}
 		}*/
 
-		printf("Read BMDL Header version %i.%i \n", fileHeader->versionMajor, fileHeader->versionMinor);
+		BM_LOG("Read BMDL Header version %i.%i \n", fileHeader->versionMajor, fileHeader->versionMinor);
 
 		// read file blocks and dispatch
 		BmFileBlock* fileBlock;
@@ -151,108 +361,2023 @@ namespace bmdl
 			fileBlock = reinterpret_cast<BmFileBlock*>(fileData + readPos);
 			readPos += sizeof(BmFileBlock);
 
-			std::string blockTypeName = "UNKNOWN";
-
-			switch (fileBlock->type)
+			if (fileBlock->blockLength > dataSize - readPos)
 			{
-				case BmFileBlockType::MeshData:
-					blockTypeName = "Mesh";
-					ReadMeshBlock<V,I>(fileData + readPos, fileBlock->blockLength, newModel);
-				break;
-				default:
-					blockTypeName = "UNKNOWN";
-				break;
+				BmSetLastError("File truncated : block extends past the end of the file");
+				delete newModel;
+				return nullptr;
 			}
 
-			printf("Read Block of type %s with length %u\n", blockTypeName.c_str(), fileBlock->blockLength);
+			if (!ReadFileBlock<V, I>(fileBlock->type, fileData + readPos, fileBlock->blockLength, newModel, vertLayout, interleaved, flags))
+			{
+				delete newModel;
+				return nullptr;
+			}
 
 			readPos += fileBlock->blockLength;
 		}
 
-		printf("Read all blocks\n");
-		printf("Loaded Successfully ...\n");
+		BM_LOG("Read all blocks\n");
+
+		if (BmHasFlag(flags, BmLoadFlags::ContiguousBuffers) && !PackModelBuffers(*newModel))
+		{
+			delete newModel;
+			return nullptr;
+		}
+
+		BM_LOG("Loaded Successfully ...\n");
 
 		return newModel;
 	}
 
+	// returns true if data of type T can be referenced at the given address rather than copied
+	template<typename T>
+	inline bool CanReferenceData(const uint8_t* data)
+	{
+	#if defined(BM_ALLOW_UNALIGNED_VIEWS)
+		(void)data;
+		return true;
+	#else
+		return (reinterpret_cast<uintptr_t>(data) % alignof(T)) == 0;
+	#endif
+	}
+
+	// location of a mesh inside a mesh block, found by scanning the headers before any mesh data is decoded
+	struct BmMeshRecord
+	{
+		BmMeshHeader*		header;
+		BmSubMeshHeader*	subMeshHeaders;
+		uint8_t*			vertexData;
+		uint8_t*			indexData;
+
+		bool				hasBounds;		// mesh stores BoundsUnorm16 attributes quantized against bounds
+		BmAttrBounds		bounds;
+
+		uint32_t			vertexStride;	// bytes per vertex as stored in the file
+
+		bool				compressed;		// vertex and index data are coded, sizes below
+		uint32_t			vertexBytes;
+		uint32_t			indexBytes;
+	};
+
+	// first pass over a mesh block, walks the mesh headers and records where each mesh's data starts
 	template<typename V = BmVert, typename I = uint16_t>
-	BM_FUNC_DECL bool ReadMeshBlock(uint8_t* data, uint32_t blockLength, BmModel<V, I> *model)
+	BM_FUNC_DECL bool ScanMeshBlock(uint8_t* data, uint32_t blockLength, BmList<BmMeshRecord>& records, bool compressed = false)
 	{
+		if (blockLength < sizeof(BmMeshBlockHeader))
+		{
+			BmSetLastError("Mesh block too small to hold a mesh block header");
+			return false;
+		}
+
 		uint32_t readPos = 0;
 		BmMeshBlockHeader* meshBlock = reinterpret_cast<BmMeshBlockHeader*>(data);
 		readPos += sizeof(BmMeshBlockHeader);
 
-		// read all meshes
+		records.reserve(records.count + meshBlock->numMeshes);
+
 		for (uint32_t m = 0; m < meshBlock->numMeshes; m++)
 		{
-			model->meshList.add(BmMesh<V, I>());
-			BmMesh<V, I>& newMesh = model->meshList.last();
+			BmMeshRecord record = {};
 
-			BmMeshHeader* meshHeader = reinterpret_cast<BmMeshHeader*>(data + readPos);
+			if (blockLength - readPos < sizeof(BmMeshHeader))
+			{
+				BmSetLastError("Mesh block truncated : not enough data for mesh header");
+				return false;
+			}
+
+			record.header = reinterpret_cast<BmMeshHeader*>(data + readPos);
 			readPos += sizeof(BmMeshHeader);
 
-			for (uint32_t sm = 0; sm < meshHeader->subMeshCount; sm++)
+			uint64_t subMeshBytes = static_cast<uint64_t>(sizeof(BmSubMeshHeader)) * record.header->subMeshCount;
+			record.subMeshHeaders = reinterpret_cast<BmSubMeshHeader*>(data + readPos);
+
+			// files without attribute descriptions are assumed to store V as is
+			uint32_t bytesPerVert = record.header->vertAttrCount > 0 ? GetVertexStride(record.header->verAttrList, record.header->vertAttrCount) : sizeof(V);
+
+			uint32_t bytesPerIndx = GetIndexTypeSize(record.header->indiceType);
+			if (bytesPerIndx == 0)
+			{
+				BmSetLastError("Mesh uses an unknown index type");
+				return false;
+			}
+
+			// quantized attributes are preceded by the bounds they were quantized against
+			record.hasBounds = UsesAttrBounds(record.header->verAttrList, record.header->vertAttrCount);
+			uint64_t boundsBytes = record.hasBounds ? sizeof(BmAttrBounds) : 0;
+
+			uint64_t vertexBytes = static_cast<uint64_t>(bytesPerVert) * record.header->vertCount;
+			uint64_t indexBytes = static_cast<uint64_t>(bytesPerIndx) * record.header->indiceCount;
+			record.vertexStride = bytesPerVert;
+
+			// coded streams carry their own sizes ahead of the data
+			uint64_t streamHeaderBytes = 0;
+			if (compressed)
+			{
+				streamHeaderBytes = sizeof(BmCompressedStreamHeader);
+				if (blockLength - readPos < subMeshBytes + boundsBytes + streamHeaderBytes)
+				{
+					BmSetLastError("Mesh block truncated : not enough data for compressed stream header");
+					return false;
+				}
+
+				BmCompressedStreamHeader streamHeader;
+				memcpy(&streamHeader, data + readPos + subMeshBytes + boundsBytes, sizeof(streamHeader));
+
+				record.compressed = true;
+				record.vertexBytes = streamHeader.vertexBytes;
+				record.indexBytes = streamHeader.indexBytes;
+				vertexBytes = streamHeader.vertexBytes;
+				indexBytes = streamHeader.indexBytes;
+			}
+
+			if (blockLength - readPos < subMeshBytes + boundsBytes + streamHeaderBytes + vertexBytes + indexBytes)
 			{
-				BmSubMeshHeader* subMeshHeader = reinterpret_cast<BmSubMeshHeader*>(data + readPos);
-				readPos += sizeof(BmSubMeshHeader);
+				BmSetLastError("Mesh block truncated : not enough data for mesh contents");
+				return false;
 			}
 
-			// TODO : Properly calculate this
-			uint32_t bytesPerVert = sizeof(V);
-			uint32_t bytesPerIndx = 2;
+			readPos += static_cast<uint32_t>(subMeshBytes);		// submesh headers
+
+			if (record.hasBounds)
+				memcpy(&record.bounds, data + readPos, sizeof(BmAttrBounds));
+			readPos += static_cast<uint32_t>(boundsBytes);		// attribute bounds
+			readPos += static_cast<uint32_t>(streamHeaderBytes);	// compressed stream sizes
+
+			record.vertexData = data + readPos;
+			readPos += static_cast<uint32_t>(vertexBytes);		// vertices
+
+			record.indexData = data + readPos;
+			readPos += static_cast<uint32_t>(indexBytes);		// indices
+
+			records.add(record);
+		}
+
+		BM_LOG("found %i meshes in mesh block.\n", meshBlock->numMeshes);
+
+		return true;
+	}
+
+	// reads interleaved vertices in to mesh.vertices, converting from the attributes stored in the file to vertLayout
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL bool ReadInterleavedVertices(const BmMeshRecord& record, BmMesh<V, I>& newMesh, const BmVertLayout* vertLayout, bool referenceData)
+	{
+		BmMeshHeader* meshHeader = record.header;
+		bool filePlanar = !meshHeader->interleaved;
+
+		// compiled reader for V, when one is registered for the layout stored in the file
+		if (!filePlanar && meshHeader->vertAttrCount > 0 &&
+			BmStaticVertReader<V>::Read(vertLayout, meshHeader->verAttrList, meshHeader->vertAttrCount, record.vertexData, meshHeader->vertCount, newMesh.vertices))
+			return true;
+
+		// without a layout to convert to, described vertices are only used as is when they are stored as V would be
+		if (meshHeader->vertAttrCount > 0 && vertLayout == nullptr &&
+			(filePlanar || GetVertexStride(meshHeader->verAttrList, meshHeader->vertAttrCount) != sizeof(V)))
+		{
+			BmSetLastError("A vertex layout is required to convert the vertices stored in the file");
+			return false;
+		}
+
+		// files without attribute descriptions are assumed to match V, otherwise convert from the file's attributes to vertLayout
+		const BmVertConversionPlan* plan = nullptr;
+		if (meshHeader->vertAttrCount > 0 && vertLayout != nullptr)
+		{
+			plan = GetConversionPlan(meshHeader->verAttrList, meshHeader->vertAttrCount, vertLayout->attributes, vertLayout->attributeCount, sizeof(V));
+			if (plan == nullptr)
+				return false;
+		}
 
-			// read vertex data
-			V* vertexData = reinterpret_cast<V*>(data + readPos);
+		// read vertex data, referencing it in place when mapped and the layout on disk matches V
+		V* vertexData = reinterpret_cast<V*>(record.vertexData);
+		if (plan != nullptr && (filePlanar || !plan->IsIdentity()))
+		{
+			newMesh.vertices.reserve(meshHeader->vertCount);
+			newMesh.vertices.count = meshHeader->vertCount;
+			plan->Convert(record.vertexData, reinterpret_cast<uint8_t*>(newMesh.vertices.data), meshHeader->vertCount, filePlanar, false, record.hasBounds ? &record.bounds : nullptr);
+		}
+		else if (referenceData && CanReferenceData<V>(record.vertexData))
+			newMesh.vertices.setView(vertexData, meshHeader->vertCount);
+		else
 			newMesh.vertices.setData(vertexData, meshHeader->vertCount);
-			readPos += bytesPerVert * meshHeader->vertCount;	// vertices
 
-			// read index data
-			I* indexData = reinterpret_cast<I*>(data + readPos);
-			newMesh.indices.setData(indexData, meshHeader->indiceCount);
-			readPos += bytesPerIndx * meshHeader->indiceCount;	// indices
+		return true;
+	}
+
+	// reads vertices in to one stream per attribute of vertLayout (mesh.streams), files stored
+	// non-interleaved with the same attributes are used as is, anything else is de-interleaved/converted
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL bool ReadVertexStreams(const BmMeshRecord& record, BmMesh<V, I>& newMesh, const BmVertLayout* vertLayout, bool referenceData)
+	{
+		BmMeshHeader* meshHeader = record.header;
+		bool filePlanar = !meshHeader->interleaved;
+		uint32_t vertCount = meshHeader->vertCount;
+
+		if (vertLayout == nullptr)
+		{
+			BmSetLastError("A vertex layout is required to load non-interleaved vertices");
+			return false;
+		}
+
+		const BmVertAttr* srcAttrs = meshHeader->verAttrList;
+		uint32_t srcAttrCount = meshHeader->vertAttrCount;
+		if (srcAttrCount == 0)
+		{
+			// without attribute descriptions the file is assumed to store V, which vertLayout describes
+			if (GetVertexStride(vertLayout->attributes, vertLayout->attributeCount) != sizeof(V))
+			{
+				BmSetLastError("Unable to de-interleave vertices : file has no attribute descriptions and vertLayout does not match V");
+				return false;
+			}
+
+			srcAttrs = vertLayout->attributes;
+			srcAttrCount = vertLayout->attributeCount;
+		}
+
+		uint32_t packedStride = GetVertexStride(vertLayout->attributes, vertLayout->attributeCount);
+		const BmVertConversionPlan* plan = GetConversionPlan(srcAttrs, srcAttrCount, vertLayout->attributes, vertLayout->attributeCount, packedStride);
+		if (plan == nullptr)
+			return false;
 
-			printf("Read Mesh with %i vertices, %i submeshes\n", meshHeader->vertCount, meshHeader->subMeshCount);
+		if (filePlanar && plan->IsIdentity())
+		{
+			if (referenceData && CanReferenceData<float>(record.vertexData))
+				newMesh.streamData.setView(record.vertexData, packedStride * vertCount);
+			else
+				newMesh.streamData.setData(record.vertexData, packedStride * vertCount);
+		}
+		else
+		{
+			newMesh.streamData.reserve(packedStride * vertCount);
+			newMesh.streamData.count = packedStride * vertCount;
+			plan->Convert(record.vertexData, newMesh.streamData.data, vertCount, filePlanar, true, record.hasBounds ? &record.bounds : nullptr);
 		}
 
-		printf("found %i meshes in mesh block.\n", meshBlock->numMeshes);
+		// each attribute's stream starts at its interleaved offset * vertCount
+		newMesh.streams.reserve(vertLayout->attributeCount);
+		newMesh.streams.count = 0;
+
+		uint32_t attrOffset = 0;
+		for (uint32_t a = 0; a < vertLayout->attributeCount; a++)
+		{
+			BmVertStream stream;
+			stream.attribute = vertLayout->attributes[a];
+			stream.stride = GetBaseTypeSize(stream.attribute.baseType) * stream.attribute.components;
+			stream.count = vertCount;
+			stream.data = newMesh.streamData.data + static_cast<size_t>(attrOffset) * vertCount;
+			newMesh.streams.add(stream);
+
+			attrOffset += stream.stride;
+		}
 
 		return true;
 	}
-}
 
-struct BmSubMesh
-{
-	uint32_t indexOffset;
-	uint32_t indexCount;
-};
+	// checks every index refers to one of vertCount vertices, maxIndex receives the largest index
+	inline bool CheckIndexRange(const uint8_t* indexData, uint32_t indexSize, uint32_t indexCount, uint32_t vertCount, uint32_t& maxIndex)
+	{
+		maxIndex = indexCount > 0 ? GetMaxIndex(indexData, indexSize, indexCount) : 0;
+		if (indexCount > 0 && maxIndex >= vertCount)
+		{
+			BmSetLastError("Mesh indices reference vertices outside the mesh");
+			return false;
+		}
 
-template<typename V = BmVert, typename I = uint16_t>
-class BmMesh
-{
-public:
+		return true;
+	}
 
-	BmMesh() {} 
+	// reads index data of any stored width in to mesh.indices, widening or narrowing to I, after checking every
+	// index refers to a vertex of the mesh. with BmLoadFlags::CompactIndices indices go to mesh.compactIndices
+	// using the smallest type that holds them
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL bool ReadIndices(const BmMeshRecord& record, BmMesh<V, I>& newMesh, BmLoadFlags flags)
+	{
+		bool referenceData = BmHasFlag(flags, BmLoadFlags::MemoryMapped);
+		BmMeshHeader* meshHeader = record.header;
 
-	BmList<V> vertices; // interleaved vertex attributes
-	BmList<I> indices;  
+		uint32_t indexCount = meshHeader->indiceCount;
+		uint32_t fileIndexSize = GetIndexTypeSize(meshHeader->indiceType);
 
-	BmList<BmSubMesh> subMeshList;
+		uint32_t maxIndex;
+		if (!CheckIndexRange(record.indexData, fileIndexSize, indexCount, meshHeader->vertCount, maxIndex))
+			return false;
 
-	BmMat4 transform;
+		if (BmHasFlag(flags, BmLoadFlags::CompactIndices))
+		{
+			BmIndexType compactType = GetSmallestIndexType(maxIndex);
+			uint32_t compactSize = GetIndexTypeSize(static_cast<uint8_t>(compactType));
 
-private:
+			newMesh.compactIndexType = compactType;
+			bool aligned = compactSize == 4 ? CanReferenceData<uint32_t>(record.indexData) : CanReferenceData<uint16_t>(record.indexData);
+			if (referenceData && compactSize == fileIndexSize && aligned)
+			{
+				newMesh.compactIndices.setView(record.indexData, indexCount * compactSize);
+			}
+			else
+			{
+				newMesh.compactIndices.reserve(indexCount * compactSize);
+				newMesh.compactIndices.count = indexCount * compactSize;
+				ConvertIndices(record.indexData, fileIndexSize, newMesh.compactIndices.data, compactSize, indexCount);
+			}
+
+			return true;
+		}
 
+		// stored indices wider than I are narrowed, so every value must fit in I
+		if (fileIndexSize > sizeof(I) && maxIndex >= (1ull << (sizeof(I) * 8)))
+		{
+			BmSetLastError("Mesh indices do not fit in the requested index type");
+			return false;
+		}
 
-};
+		I* indexData = reinterpret_cast<I*>(record.indexData);
+		if (fileIndexSize != sizeof(I))
+		{
+			newMesh.indices.reserve(indexCount);
+			newMesh.indices.count = indexCount;
+			ConvertIndices(record.indexData, fileIndexSize, reinterpret_cast<uint8_t*>(newMesh.indices.data), sizeof(I), indexCount);
+		}
+		else if (referenceData && CanReferenceData<I>(record.indexData))
+			newMesh.indices.setView(indexData, indexCount);
+		else
+			newMesh.indices.setData(indexData, indexCount);
 
-template<typename V = BmVert, typename I = uint16_t>
-class BmModel
-{
-public:
+		return true;
+	}
 
-	DECLARE_BM_ALLOCATOR()
+	// decodes the coded vertex and index data of a compressed mesh. data the mesh keeps as stored (vertices
+	// already matching V, indices no wider than I) is decoded straight in to the mesh, anything else is
+	// decoded to a scratch buffer and read from there like uncompressed data
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL bool ReadCompressedStreams(const BmMeshRecord& record, BmMesh<V, I>& newMesh, const BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags)
+	{
+		BmMeshHeader* meshHeader = record.header;
+		uint32_t vertCount = meshHeader->vertCount;
+		uint32_t indexCount = meshHeader->indiceCount;
+		uint32_t fileIndexSize = GetIndexTypeSize(meshHeader->indiceType);
 
-	BmModel() { }
+		BmMeshRecord decoded = record;
+		decoded.compressed = false;
 
-	BmList<BmMesh<V, I>> meshList;
-};
\ No newline at end of file
+		BmList<uint8_t> vertexScratch;
+		BmList<uint8_t> indexScratch;
+
+		bool directVertices = interleaved && meshHeader->interleaved && record.vertexStride == sizeof(V);
+		if (directVertices && meshHeader->vertAttrCount > 0)
+		{
+			const BmVertConversionPlan* plan = vertLayout != nullptr ?
+				GetConversionPlan(meshHeader->verAttrList, meshHeader->vertAttrCount, vertLayout->attributes, vertLayout->attributeCount, sizeof(V)) : nullptr;
+			directVertices = plan != nullptr && plan->IsIdentity();
+		}
+
+		uint8_t* vertexTarget;
+		if (directVertices)
+		{
+			newMesh.vertices.reserve(vertCount);
+			newMesh.vertices.count = vertCount;
+			vertexTarget = reinterpret_cast<uint8_t*>(newMesh.vertices.data);
+		}
+		else
+		{
+			vertexScratch.reserve(record.vertexStride * vertCount);
+			vertexScratch.count = record.vertexStride * vertCount;
+			vertexTarget = vertexScratch.data;
+		}
+
+		if (!DecodeVertexBuffer(record.vertexData, record.vertexBytes, vertexTarget, record.vertexStride, vertCount))
+		{
+			BmSetLastError("Compressed vertex data is corrupt");
+			return false;
+		}
+
+		if (!directVertices)
+		{
+			decoded.vertexData = vertexScratch.data;
+
+			bool readVertices = interleaved ?
+				ReadInterleavedVertices<V, I>(decoded, newMesh, vertLayout, false) :
+				ReadVertexStreams<V, I>(decoded, newMesh, vertLayout, false);
+
+			if (!readVertices)
+				return false;
+		}
+
+		// indices that widen or keep their size decode straight to I
+		bool directIndices = !BmHasFlag(flags, BmLoadFlags::CompactIndices) && sizeof(I) >= fileIndexSize;
+
+		uint8_t* indexTarget;
+		uint32_t indexTargetSize = directIndices ? sizeof(I) : fileIndexSize;
+		if (directIndices)
+		{
+			newMesh.indices.reserve(indexCount);
+			newMesh.indices.count = indexCount;
+			indexTarget = reinterpret_cast<uint8_t*>(newMesh.indices.data);
+		}
+		else
+		{
+			indexScratch.reserve(fileIndexSize * indexCount);
+			indexScratch.count = fileIndexSize * indexCount;
+			indexTarget = indexScratch.data;
+		}
+
+		if (!DecodeIndexBuffer(record.indexData, record.indexBytes, indexTarget, indexTargetSize, indexCount))
+		{
+			BmSetLastError("Compressed index data is corrupt");
+			return false;
+		}
+
+		if (!directIndices)
+		{
+			decoded.indexData = indexScratch.data;
+			if (!ReadIndices<V, I>(decoded, newMesh, flags & ~BmLoadFlags::MemoryMapped))
+				return false;
+		}
+
+		return true;
+	}
+
+	// second pass, decodes a single scanned mesh. meshes don't share any state so they can be read concurrently
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL bool ReadMesh(const BmMeshRecord& record, BmMesh<V, I>& newMesh, const BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags)
+	{
+		bool referenceData = BmHasFlag(flags, BmLoadFlags::MemoryMapped);
+		BmMeshHeader* meshHeader = record.header;
+
+		// non-interleaved data can only be located with the attribute list
+		if (!meshHeader->interleaved && meshHeader->vertAttrCount == 0)
+		{
+			BmSetLastError("Non-interleaved mesh has no vertex attribute descriptions");
+			return false;
+		}
+
+		newMesh.hasBounds = record.hasBounds;
+		if (record.hasBounds)
+			newMesh.bounds = record.bounds;
+
+		if (record.compressed)
+		{
+			if (!ReadCompressedStreams<V, I>(record, newMesh, vertLayout, interleaved, flags))
+				return false;
+		}
+		else
+		{
+			bool readVertices = interleaved ?
+				ReadInterleavedVertices<V, I>(record, newMesh, vertLayout, referenceData) :
+				ReadVertexStreams<V, I>(record, newMesh, vertLayout, referenceData);
+
+			if (!readVertices || !ReadIndices<V, I>(record, newMesh, flags))
+				return false;
+		}
+
+		newMesh.subMeshList.resize(meshHeader->subMeshCount);
+		for (uint32_t sm = 0; sm < meshHeader->subMeshCount; sm++)
+		{
+			BmSubMeshHeader subMeshHeader;
+			memcpy(&subMeshHeader, record.subMeshHeaders + sm, sizeof(subMeshHeader));
+			if (static_cast<uint64_t>(subMeshHeader.indiceOffset) + subMeshHeader.indiceCount > meshHeader->indiceCount)
+			{
+				BmSetLastError("Submesh references indices outside its mesh");
+				return false;
+			}
+			newMesh.subMeshList[sm] = BmSubMesh{ subMeshHeader.indiceOffset, subMeshHeader.indiceCount, subMeshHeader.materialID };
+		}
+
+		BM_LOG("Read Mesh with %i vertices, %i submeshes\n", meshHeader->vertCount, meshHeader->subMeshCount);
+
+		return true;
+	}
+
+	// reads all meshes in a mesh block, headers are scanned first so the meshes can then be decoded
+	// in parallel on the shared worker pool (see bmdl::SetWorkerCount) straight in to their slot in meshList.
+	// vertices are converted from the attributes stored in the file to vertLayout, which must describe V.
+	// with interleaved = false vertices are stored in per attribute streams instead (see BmMesh::streams)
+	template<typename V, typename I>
+	BM_FUNC_DECL bool ReadMeshBlock(uint8_t* data, uint32_t blockLength, BmModel<V, I> *model, const BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags, BmFileBlockType blockType)
+	{
+		BmList<BmMeshRecord> records;
+		if (!ScanMeshBlock<V, I>(data, blockLength, records, blockType == BmFileBlockType::CompressedMeshData))
+			return false;
+
+		uint32_t firstMesh = model->meshList.count;
+		model->meshList.resize(firstMesh + records.count);
+
+		std::atomic<bool> succeeded(true);
+		bmdl::GetWorkerPool().ParallelFor(records.count, [&](uint32_t m)
+		{
+			if (!ReadMesh<V, I>(records[m], model->meshList[firstMesh + m], vertLayout, interleaved, flags))
+				succeeded = false;
+		});
+
+		return succeeded;
+	}
+
+	// bytes of a meshlet array of count elements of T in a MeshletData block
+	template<typename T>
+	inline uint64_t GetMeshletArraySize(uint64_t count)
+	{
+		return (count * sizeof(T) + BmMeshletAlignment - 1) / BmMeshletAlignment * BmMeshletAlignment;
+	}
+
+	// references a meshlet array in place when mapped and aligned, copies it otherwise
+	template<typename T>
+	inline void ReadMeshletArray(BmList<T>& list, uint8_t* data, uint32_t count, bool referenceData)
+	{
+		if (referenceData && CanReferenceData<T>(data))
+			list.setView(reinterpret_cast<T*>(data), count);
+		else
+			list.setData(reinterpret_cast<T*>(data), count);
+	}
+
+	// reads the meshlets of a MeshletData block in to the meshes they belong to, which must already be read.
+	// the data is stored as it is used so nothing is converted, mapped files are referenced in place
+	template<typename V, typename I>
+	BM_FUNC_DECL bool ReadMeshletBlock(uint8_t* data, uint32_t blockLength, BmModel<V, I>* model, BmLoadFlags flags)
+	{
+		bool referenceData = BmHasFlag(flags, BmLoadFlags::MemoryMapped);
+
+		BmMeshletBlockHeader blockHeader;
+		if (blockLength < sizeof(blockHeader))
+		{
+			BmSetLastError("Meshlet block too small to hold a meshlet block header");
+			return false;
+		}
+		memcpy(&blockHeader, data, sizeof(blockHeader));
+
+		uint64_t readPos = blockHeader.dataOffset;
+		for (uint32_t s = 0; s < blockHeader.meshCount; s++)
+		{
+			BmMeshletSetHeader setHeader;
+			if (readPos + sizeof(setHeader) > blockLength)
+			{
+				BmSetLastError("Meshlet block truncated : not enough data for meshlet set header");
+				return false;
+			}
+			memcpy(&setHeader, data + readPos, sizeof(setHeader));
+			readPos += sizeof(setHeader);
+
+			if (setHeader.meshIndex >= model->meshList.count)
+			{
+				BmSetLastError("Meshlet block references a mesh that was not read");
+				return false;
+			}
+
+			uint64_t meshletBytes = GetMeshletArraySize<BmMeshlet>(setHeader.meshletCount);
+			uint64_t boundsBytes = GetMeshletArraySize<BmMeshletBounds>(setHeader.meshletCount);
+			uint64_t vertexBytes = GetMeshletArraySize<uint32_t>(setHeader.vertexCount);
+			uint64_t triangleBytes = GetMeshletArraySize<uint8_t>(static_cast<uint64_t>(setHeader.triangleCount) * 3);
+			if (readPos + meshletBytes + boundsBytes + vertexBytes + triangleBytes > blockLength || setHeader.triangleCount > UINT32_MAX / 3)
+			{
+				BmSetLastError("Meshlet block truncated : not enough data for meshlets");
+				return false;
+			}
+
+			BmMesh<V, I>& mesh = model->meshList[setHeader.meshIndex];
+			ReadMeshletArray(mesh.meshlets, data + readPos, setHeader.meshletCount, referenceData);
+			readPos += meshletBytes;
+			ReadMeshletArray(mesh.meshletBounds, data + readPos, setHeader.meshletCount, referenceData);
+			readPos += boundsBytes;
+			ReadMeshletArray(mesh.meshletVertices, data + readPos, setHeader.vertexCount, referenceData);
+			readPos += vertexBytes;
+			ReadMeshletArray(mesh.meshletTriangles, data + readPos, setHeader.triangleCount * 3, referenceData);
+			readPos += triangleBytes;
+
+			for (uint32_t m = 0; m < mesh.meshlets.count; m++)
+			{
+				const BmMeshlet& meshlet = mesh.meshlets[m];
+				if (static_cast<uint64_t>(meshlet.vertexOffset) + meshlet.vertexCount > setHeader.vertexCount ||
+					static_cast<uint64_t>(meshlet.triangleOffset) + meshlet.triangleCount * 3 > static_cast<uint64_t>(setHeader.triangleCount) * 3)
+				{
+					BmSetLastError("Meshlet references data outside its meshlet set");
+					return false;
+				}
+			}
+
+			uint32_t vertexCount = mesh.streams.count > 0 ? mesh.streams[0].count : mesh.vertices.count;
+			for (uint32_t v = 0; v < mesh.meshletVertices.count; v++)
+			{
+				if (mesh.meshletVertices[v] >= vertexCount)
+				{
+					BmSetLastError("Meshlet references a vertex outside its mesh");
+					return false;
+				}
+			}
+		}
+
+		BM_LOG("Read meshlets of %u meshes\n", blockHeader.meshCount);
+
+		return true;
+	}
+
+	// reads the level of detail in a LodData block in to BmMesh::lods of the meshes it belongs to, which must
+	// already be read. with BmLoadFlags::SingleLod blocks of any other level are passed over
+	template<typename V, typename I>
+	BM_FUNC_DECL bool ReadLodBlock(uint8_t* data, uint32_t blockLength, BmModel<V, I>* model, BmLoadFlags flags)
+	{
+		BmLodBlockHeader blockHeader;
+		if (blockLength < sizeof(blockHeader))
+		{
+			BmSetLastError("Lod block too small to hold a lod block header");
+			return false;
+		}
+		memcpy(&blockHeader, data, sizeof(blockHeader));
+
+		if (BmHasFlag(flags, BmLoadFlags::SingleLod) && blockHeader.level != GetLoadLodLevel(flags))
+		{
+			BM_LOG("Skipped level of detail %u\n", blockHeader.level);
+			return true;
+		}
+
+		uint64_t readPos = sizeof(blockHeader);
+		for (uint32_t s = 0; s < blockHeader.meshCount; s++)
+		{
+			BmLodSetHeader setHeader;
+			if (readPos + sizeof(setHeader) > blockLength)
+			{
+				BmSetLastError("Lod block truncated : not enough data for level of detail header");
+				return false;
+			}
+			memcpy(&setHeader, data + readPos, sizeof(setHeader));
+			readPos += sizeof(setHeader);
+
+			if (setHeader.meshIndex >= model->meshList.count)
+			{
+				BmSetLastError("Lod block references a mesh that was not read");
+				return false;
+			}
+
+			uint32_t indexSize = GetIndexTypeSize(setHeader.indexType);
+			uint64_t subMeshBytes = static_cast<uint64_t>(setHeader.subMeshCount) * sizeof(BmSubMeshHeader);
+			uint64_t indexBytes = static_cast<uint64_t>(setHeader.indexCount) * indexSize;
+			if (indexSize == 0 || readPos + subMeshBytes + indexBytes > blockLength)
+			{
+				BmSetLastError("Lod block truncated : not enough data for level of detail");
+				return false;
+			}
+
+			BmMesh<V, I>& mesh = model->meshList[setHeader.meshIndex];
+			uint8_t* indexData = data + readPos + subMeshBytes;
+			uint32_t vertexCount = mesh.streams.count > 0 ? mesh.streams[0].count : mesh.vertices.count;
+			uint32_t maxIndex = setHeader.indexCount > 0 ? GetMaxIndex(indexData, indexSize, setHeader.indexCount) : 0;
+			if (setHeader.indexCount > 0 && maxIndex >= vertexCount)
+			{
+				BmSetLastError("Level of detail references a vertex outside its mesh");
+				return false;
+			}
+
+			if (maxIndex >= (1ull << (sizeof(I) * 8)) && sizeof(I) < 4)
+			{
+				BmSetLastError("Level of detail indices do not fit in the requested index type");
+				return false;
+			}
+
+			BmMeshLod lod;
+			lod.indexOffset = mesh.lodIndices.count;
+			lod.indexCount = setHeader.indexCount;
+			lod.subMeshOffset = mesh.lodSubMeshes.count;
+			lod.subMeshCount = setHeader.subMeshCount;
+			lod.level = blockHeader.level;
+			lod.error = setHeader.error;
+
+			for (uint32_t sm = 0; sm < setHeader.subMeshCount; sm++)
+			{
+				BmSubMeshHeader subMeshHeader;
+				memcpy(&subMeshHeader, data + readPos + sm * sizeof(BmSubMeshHeader), sizeof(subMeshHeader));
+				if (static_cast<uint64_t>(subMeshHeader.indiceOffset) + subMeshHeader.indiceCount > setHeader.indexCount)
+				{
+					BmSetLastError("Level of detail submesh references indices outside its level");
+					return false;
+				}
+				mesh.lodSubMeshes.add(BmSubMesh{ subMeshHeader.indiceOffset, subMeshHeader.indiceCount, subMeshHeader.materialID });
+			}
+
+			mesh.lodIndices.resize(lod.indexOffset + lod.indexCount);
+			ConvertIndices(indexData, indexSize, reinterpret_cast<uint8_t*>(mesh.lodIndices.data + lod.indexOffset), sizeof(I), lod.indexCount);
+			mesh.lods.add(lod);
+
+			readPos += subMeshBytes + indexBytes;
+		}
+
+		BM_LOG("Read level of detail %u of %u meshes\n", blockHeader.level, blockHeader.meshCount);
+
+		return true;
+	}
+
+	// a mesh of a ProgressiveData block, regionStart holds where each region starts in the mesh indices and where the last ends
+	struct BmProgressiveSet
+	{
+		uint32_t						meshIndex;
+		uint32_t						vertexCount;
+		uint32_t						indexSize;
+		uint32_t						vertexStride;	// of the vertices in the records
+		const BmVertConversionPlan*		plan;			// nullptr when the vertices are stored as V
+		std::vector<uint32_t>			regionStart;
+	};
+
+	// bytes of the set at data, which must hold its header
+	inline uint64_t GetProgressiveSetSize(const uint8_t* data)
+	{
+		BmProgressiveSetHeader header;
+		memcpy(&header, data, sizeof(header));
+		return sizeof(header) + static_cast<uint64_t>(header.regionCount) * 2 * sizeof(uint32_t);
+	}
+
+	inline uint64_t GetVertexSplitSize(const BmVertexSplitHeader& header, const BmProgressiveSet& set)
+	{
+		return sizeof(header) + static_cast<uint64_t>(header.vertexCount) * set.vertexStride +
+			static_cast<uint64_t>(header.triangleCount) * (sizeof(uint16_t) + set.indexSize * 3) +
+			static_cast<uint64_t>(header.updateCount) * (sizeof(uint32_t) + set.indexSize);
+	}
+
+	// reads the set at data and makes room in its mesh for the refined mesh, moving each region of the base to where it
+	// starts once refined. the vertices stay interleaved and the indices in I so splits can be made in place
+	template<typename V, typename I>
+	BM_FUNC_DECL bool ReadProgressiveSet(const uint8_t* data, BmModel<V, I>* model, const BmVertLayout* vertLayout, BmProgressiveSet& set)
+	{
+		BmProgressiveSetHeader header;
+		memcpy(&header, data, sizeof(header));
+
+		if (header.meshIndex >= model->meshList.count)
+		{
+			BmSetLastError("Progressive block references a mesh that was not read");
+			return false;
+		}
+
+		BmMesh<V, I>& mesh = model->meshList[header.meshIndex];
+		if (mesh.streams.count > 0 || mesh.compactIndices.count > 0)
+		{
+			BmSetLastError("Progressive meshes can only be loaded with interleaved vertices and without CompactIndices");
+			return false;
+		}
+
+		set.meshIndex = header.meshIndex;
+		set.vertexCount = header.vertexCount;
+		set.indexSize = GetIndexTypeSize(header.indexType);
+		set.plan = nullptr;
+		set.vertexStride = sizeof(V);
+
+		if (set.indexSize == 0 || header.vertAttrCount > MAX_VERTEX_ATTRIBS || mesh.vertices.count > header.vertexCount ||
+			header.regionCount != (mesh.subMeshList.count > 0 ? mesh.subMeshList.count : 1))
+		{
+			BmSetLastError("Progressive mesh does not match its base mesh");
+			return false;
+		}
+
+		if (header.vertexCount > (1ull << (sizeof(I) * 8)) && sizeof(I) < 4)
+		{
+			BmSetLastError("Progressive mesh indices do not fit in the requested index type");
+			return false;
+		}
+
+		if (header.vertAttrCount > 0)
+		{
+			if (vertLayout == nullptr)
+			{
+				BmSetLastError("A vertex layout is required to read progressive mesh vertices");
+				return false;
+			}
+
+			if (UsesAttrBounds(header.verAttrList, header.vertAttrCount) && !mesh.hasBounds)
+			{
+				BmSetLastError("Progressive mesh has BoundsUnorm16 attributes but no bounds");
+				return false;
+			}
+
+			set.plan = GetConversionPlan(header.verAttrList, header.vertAttrCount, vertLayout->attributes, vertLayout->attributeCount, sizeof(V));
+			if (set.plan == nullptr)
+				return false;
+			set.vertexStride = GetVertexStride(header.verAttrList, header.vertAttrCount);
+		}
+
+		// the base of each region must fit in the room the region has once refined
+		set.regionStart.resize(header.regionCount + 1);
+		set.regionStart[0] = 0;
+		uint64_t indexCount = 0;
+		for (uint32_t r = 0; r < header.regionCount; r++)
+		{
+			uint32_t counts[2];
+			memcpy(counts, data + sizeof(header) + r * sizeof(counts), sizeof(counts));
+
+			uint64_t baseOffset = mesh.subMeshList.count > 0 ? mesh.subMeshList[r].indexOffset : 0;
+			uint64_t baseCount = mesh.subMeshList.count > 0 ? mesh.subMeshList[r].indexCount : mesh.indices.count;
+			if (baseCount != counts[0] || counts[0] > counts[1] || baseOffset + baseCount > mesh.indices.count)
+			{
+				BmSetLastError("Progressive mesh does not match its base mesh");
+				return false;
+			}
+
+			indexCount += counts[1];
+			if (indexCount > UINT32_MAX)
+			{
+				BmSetLastError("Progressive mesh has too many indices");
+				return false;
+			}
+			set.regionStart[r + 1] = static_cast<uint32_t>(indexCount);
+		}
+
+		if (mesh.subMeshList.count > 0)
+		{
+			std::vector<I> baseIndices(mesh.indices.data, mesh.indices.data + mesh.indices.count);
+			mesh.indices.resize(0);
+			mesh.indices.resize(static_cast<uint32_t>(indexCount));
+			for (uint32_t r = 0; r < header.regionCount; r++)
+			{
+				BmSubMesh& subMesh = mesh.subMeshList[r];
+				if (subMesh.indexCount > 0)
+					memcpy(mesh.indices.data + set.regionStart[r], &baseIndices[subMesh.indexOffset], subMesh.indexCount * sizeof(I));
+				subMesh.indexOffset = set.regionStart[r];
+			}
+		}
+		else
+			mesh.indices.reserve(static_cast<uint32_t>(indexCount));
+
+		mesh.vertices.reserve(header.vertexCount);
+		mesh.vertexSplits.resize(0);
+		mesh.splitTriangles.resize(0);
+		mesh.splitUpdates.resize(0);
+
+		return true;
+	}
+
+	// makes the split at data, which must hold all of it, in the mesh of its set
+	template<typename V, typename I>
+	BM_FUNC_DECL bool ReadVertexSplit(const uint8_t* data, const std::vector<BmProgressiveSet>& sets, BmModel<V, I>* model)
+	{
+		BmVertexSplitHeader header;
+		memcpy(&header, data, sizeof(header));
+
+		if (header.set >= sets.size())
+		{
+			BmSetLastError("Vertex split references a mesh that is not in its block");
+			return false;
+		}
+
+		const BmProgressiveSet& set = sets[header.set];
+		BmMesh<V, I>& mesh = model->meshList[set.meshIndex];
+		if (static_cast<uint64_t>(mesh.vertices.count) + header.vertexCount > set.vertexCount)
+		{
+			BmSetLastError("Vertex split adds more vertices than its mesh has");
+			return false;
+		}
+
+		const uint8_t* readPos = data + sizeof(header);
+
+		BmVertexSplit split;
+		split.vertexCount = header.vertexCount;
+		split.triangleOffset = mesh.splitTriangles.count;
+		split.triangleCount = header.triangleCount;
+		split.updateOffset = mesh.splitUpdates.count;
+		split.updateCount = header.updateCount;
+		split.error = header.error;
+
+		// the vertices go after the ones the mesh has, room was made for them when the set was read
+		V* vertices = mesh.vertices.data + mesh.vertices.count;
+		if (set.plan != nullptr)
+			set.plan->Convert(readPos, reinterpret_cast<uint8_t*>(vertices), header.vertexCount, false, false, mesh.hasBounds ? &mesh.bounds : nullptr);
+		else if (header.vertexCount > 0)
+			memcpy(vertices, readPos, static_cast<size_t>(header.vertexCount) * sizeof(V));
+		mesh.vertices.count += header.vertexCount;
+		readPos += static_cast<size_t>(header.vertexCount) * set.vertexStride;
+
+		// triangles go after the ones their region holds
+		const uint8_t* regions = readPos;
+		const uint8_t* corners = regions + static_cast<size_t>(header.triangleCount) * sizeof(uint16_t);
+		for (uint32_t t = 0; t < header.triangleCount; t++)
+		{
+			uint16_t region;
+			memcpy(&region, regions + t * sizeof(uint16_t), sizeof(region));
+
+			uint32_t triangle[3];
+			ConvertIndices(corners + static_cast<size_t>(t) * 3 * set.indexSize, set.indexSize, reinterpret_cast<uint8_t*>(triangle), sizeof(uint32_t), 3);
+
+			if (region + 1u >= set.regionStart.size() || triangle[0] >= mesh.vertices.count || triangle[1] >= mesh.vertices.count || triangle[2] >= mesh.vertices.count)
+			{
+				BmSetLastError("Vertex split adds a triangle outside its mesh");
+				return false;
+			}
+
+			uint32_t& regionCount = mesh.subMeshList.count > 0 ? mesh.subMeshList[region].indexCount : mesh.indices.count;
+			uint32_t position = set.regionStart[region] + regionCount;
+			if (position + 3 > set.regionStart[region + 1])
+			{
+				BmSetLastError("Vertex split adds more triangles than its region has room for");
+				return false;
+			}
+
+			for (uint32_t c = 0; c < 3; c++)
+				mesh.indices.data[position + c] = static_cast<I>(triangle[c]);
+			regionCount += 3;
+			mesh.splitTriangles.add(position);
+		}
+		readPos = corners + static_cast<size_t>(header.triangleCount) * 3 * set.indexSize;
+
+		// updates move corners of triangles the mesh already has
+		const uint8_t* positions = readPos;
+		const uint8_t* updateVertices = positions + static_cast<size_t>(header.updateCount) * sizeof(uint32_t);
+		for (uint32_t u = 0; u < header.updateCount; u++)
+		{
+			BmIndexUpdate update;
+			memcpy(&update.position, positions + u * sizeof(uint32_t), sizeof(uint32_t));
+			ConvertIndices(updateVertices + static_cast<size_t>(u) * set.indexSize, set.indexSize, reinterpret_cast<uint8_t*>(&update.vertex), sizeof(uint32_t), 1);
+
+			uint32_t region = static_cast<uint32_t>(std::upper_bound(set.regionStart.begin(), set.regionStart.end(), update.position) - set.regionStart.begin()) - 1;
+			bool inRegion = region + 1 < set.regionStart.size() &&
+				update.position < set.regionStart[region] + (mesh.subMeshList.count > 0 ? mesh.subMeshList[region].indexCount : mesh.indices.count);
+			if (!inRegion || update.vertex >= mesh.vertices.count)
+			{
+				BmSetLastError("Vertex split updates a corner outside its mesh");
+				return false;
+			}
+
+			update.previous = static_cast<uint32_t>(mesh.indices.data[update.position]);
+			mesh.indices.data[update.position] = static_cast<I>(update.vertex);
+			mesh.splitUpdates.add(update);
+		}
+
+		mesh.vertexSplits.add(split);
+
+		return true;
+	}
+
+	// reads the sets of a ProgressiveData block and makes all of its splits, refining the meshes to full detail.
+	// progressive meshes are refined in place so they must be loaded interleaved and without CompactIndices
+	template<typename V, typename I>
+	BM_FUNC_DECL bool ReadProgressiveBlock(uint8_t* data, uint32_t blockLength, BmModel<V, I>* model, const BmVertLayout* vertLayout, bool interleaved)
+	{
+		if (!interleaved)
+		{
+			BmSetLastError("Progressive meshes can only be loaded with interleaved vertices and without CompactIndices");
+			return false;
+		}
+
+		BmProgressiveBlockHeader blockHeader;
+		if (blockLength < sizeof(blockHeader))
+		{
+			BmSetLastError("Progressive block too small to hold a progressive block header");
+			return false;
+		}
+		memcpy(&blockHeader, data, sizeof(blockHeader));
+
+		if (blockHeader.meshCount > blockLength / sizeof(BmProgressiveSetHeader))
+		{
+			BmSetLastError("Progressive block truncated : not enough data for progressive mesh header");
+			return false;
+		}
+
+		uint64_t readPos = sizeof(blockHeader);
+		std::vector<BmProgressiveSet> sets(blockHeader.meshCount);
+		for (uint32_t s = 0; s < blockHeader.meshCount; s++)
+		{
+			if (readPos + sizeof(BmProgressiveSetHeader) > blockLength || readPos + GetProgressiveSetSize(data + readPos) > blockLength)
+			{
+				BmSetLastError("Progressive block truncated : not enough data for progressive mesh header");
+				return false;
+			}
+
+			if (!ReadProgressiveSet<V, I>(data + readPos, model, vertLayout, sets[s]))
+				return false;
+			readPos += GetProgressiveSetSize(data + readPos);
+		}
+
+		for (uint32_t v = 0; v < blockHeader.splitCount; v++)
+		{
+			BmVertexSplitHeader splitHeader;
+			if (readPos + sizeof(splitHeader) > blockLength)
+			{
+				BmSetLastError("Progressive block truncated : not enough data for vertex split header");
+				return false;
+			}
+			memcpy(&splitHeader, data + readPos, sizeof(splitHeader));
+
+			uint64_t splitSize = splitHeader.set < sets.size() ? GetVertexSplitSize(splitHeader, sets[splitHeader.set]) : sizeof(splitHeader);
+			if (readPos + splitSize > blockLength)
+			{
+				BmSetLastError("Progressive block truncated : not enough data for vertex split");
+				return false;
+			}
+
+			if (!ReadVertexSplit<V, I>(data + readPos, sets, model))
+				return false;
+			readPos += splitSize;
+		}
+
+		BM_LOG("Read %u vertex splits of %u progressive meshes\n", blockHeader.splitCount, blockHeader.meshCount);
+
+		return true;
+	}
+
+	// =================================
+	// Basic Model : Block Compression
+	// CompressedBlock wraps the payload of any other block, compressed in chunks with bmdl_lz.h.
+	// Chunks are decompressed in parallel on the worker pool, straight in to the wrapped block.
+	// =================================
+
+	inline const char* GetBlockTypeName(BmFileBlockType type)
+	{
+		switch (type)
+		{
+			case BmFileBlockType::MeshData:				return "Mesh";
+			case BmFileBlockType::CompressedMeshData:	return "Compressed Mesh";
+			case BmFileBlockType::MeshletData:			return "Meshlet";
+			case BmFileBlockType::LodData:				return "Lod";
+			case BmFileBlockType::ProgressiveData:		return "Progressive";
+			case BmFileBlockType::MaterialData:			return "Material";
+			case BmFileBlockType::SceneData:			return "Scene";
+			case BmFileBlockType::ExtensionData:		return "Extension";
+			case BmFileBlockType::AnimationData:		return "Animation";
+			case BmFileBlockType::CompressedBlock:		return "Compressed";
+			default:									return "UNKNOWN";
+		}
+	}
+
+	// true for the block types LoadModel reads, other blocks are skipped
+	inline bool IsLoadedBlockType(BmFileBlockType type)
+	{
+		return type == BmFileBlockType::MeshData || type == BmFileBlockType::CompressedMeshData || type == BmFileBlockType::MeshletData ||
+			type == BmFileBlockType::LodData || type == BmFileBlockType::ProgressiveData || type == BmFileBlockType::CompressedBlock;
+	}
+
+	// appends a CompressedBlock holding blockLength bytes of a block of the given type to out, including its BmFileBlock
+	inline void CompressFileBlock(BmFileBlockType type, const uint8_t* data, uint32_t blockLength, std::vector<uint8_t>& out, uint32_t chunkSize = BmLzDefaultChunkSize)
+	{
+		std::vector<uint32_t> chunkSizes;
+		std::vector<uint8_t> chunkData;
+		LzCompressChunks(data, blockLength, chunkSize, chunkSizes, chunkData);
+
+		BmCompressedBlockHeader header;
+		header.type = type;
+		header.compressedLength = static_cast<uint32_t>(chunkData.size());
+		header.uncompressedLength = blockLength;
+		header.chunkSize = chunkSize;
+
+		BmFileBlock fileBlock;
+		fileBlock.type = BmFileBlockType::CompressedBlock;
+		fileBlock.blockLength = static_cast<uint32_t>(sizeof(header) + chunkSizes.size() * sizeof(uint32_t) + chunkData.size());
+
+		const uint8_t* blockBytes = reinterpret_cast<const uint8_t*>(&fileBlock);
+		const uint8_t* headerBytes = reinterpret_cast<const uint8_t*>(&header);
+		const uint8_t* tableBytes = reinterpret_cast<const uint8_t*>(chunkSizes.data());
+
+		out.insert(out.end(), blockBytes, blockBytes + sizeof(fileBlock));
+		out.insert(out.end(), headerBytes, headerBytes + sizeof(header));
+		out.insert(out.end(), tableBytes, tableBytes + chunkSizes.size() * sizeof(uint32_t));
+		out.insert(out.end(), chunkData.begin(), chunkData.end());
+	}
+
+	// uncompressed size of chunk c of a CompressedBlock
+	inline uint32_t GetChunkRawSize(const BmCompressedBlockHeader& header, uint32_t c)
+	{
+		uint64_t offset = static_cast<uint64_t>(c) * header.chunkSize;
+		uint64_t remaining = header.uncompressedLength - offset;
+		return static_cast<uint32_t>(remaining < header.chunkSize ? remaining : header.chunkSize);
+	}
+
+	// finds the number of chunks of a CompressedBlock of blockLength bytes, returns false if the header doesn't fit the block
+	inline bool GetCompressedChunkCount(const BmCompressedBlockHeader& header, uint32_t blockLength, uint32_t& chunkCount)
+	{
+		if (header.type == BmFileBlockType::CompressedBlock || header.chunkSize == 0)
+			return false;
+
+		chunkCount = LzChunkCount(header.uncompressedLength, header.chunkSize);
+
+		uint64_t expectedLength = sizeof(BmCompressedBlockHeader) + static_cast<uint64_t>(chunkCount) * sizeof(uint32_t) + header.compressedLength;
+		return expectedLength == blockLength;
+	}
+
+	inline bool CheckChunkSizes(const BmCompressedBlockHeader& header, const BmList<uint32_t>& chunkSizes)
+	{
+		uint64_t total = 0;
+		for (uint32_t c = 0; c < chunkSizes.count; c++)
+		{
+			if (chunkSizes[c] == 0 || chunkSizes[c] > GetChunkRawSize(header, c))
+				return false;
+			total += chunkSizes[c];
+		}
+
+		return total == header.compressedLength;
+	}
+
+	// decompresses chunks [first, first + count) in parallel, chunkData points at the data of chunk first
+	inline bool DecompressBlockChunks(const BmCompressedBlockHeader& header, const BmList<uint32_t>& chunkSizes, uint32_t first, uint32_t count,
+		const uint8_t* chunkData, uint8_t* blockData)
+	{
+		BmList<uint32_t> offsets;
+		offsets.resize(count);
+
+		uint32_t offset = 0;
+		for (uint32_t c = 0; c < count; c++)
+		{
+			offsets[c] = offset;
+			offset += chunkSizes[first + c];
+		}
+
+		std::atomic<bool> succeeded(true);
+		bmdl::GetWorkerPool().ParallelFor(count, [&](uint32_t c)
+		{
+			uint32_t chunk = first + c;
+			uint8_t* rawData = blockData + static_cast<size_t>(chunk) * header.chunkSize;
+
+			if (!LzDecompressChunk(chunkData + offsets[c], chunkSizes[chunk], rawData, GetChunkRawSize(header, chunk)))
+				succeeded = false;
+		});
+
+		if (!succeeded)
+			BmSetLastError("Compressed block data is corrupt");
+
+		return succeeded;
+	}
+
+	// decompresses the block wrapped by a CompressedBlock and reads it. the decompressed data only lives
+	// for the duration of the call so mesh data is always copied out of it
+	template<typename V, typename I>
+	BM_FUNC_DECL bool ReadCompressedBlock(uint8_t* data, uint32_t blockLength, BmModel<V, I>* model, const BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags)
+	{
+		BmCompressedBlockHeader header;
+		uint32_t chunkCount = 0;
+
+		if (blockLength < sizeof(header))
+		{
+			BmSetLastError("Compressed block is corrupt");
+			return false;
+		}
+		memcpy(&header, data, sizeof(header));
+
+		if (!IsLoadedBlockType(header.type))
+			return true;
+
+		if (!GetCompressedChunkCount(header, blockLength, chunkCount))
+		{
+			BmSetLastError("Compressed block is corrupt");
+			return false;
+		}
+
+		BmList<uint32_t> chunkSizes;
+		chunkSizes.resize(chunkCount);
+		memcpy(chunkSizes.data, data + sizeof(header), chunkCount * sizeof(uint32_t));
+
+		if (!CheckChunkSizes(header, chunkSizes))
+		{
+			BmSetLastError("Compressed block is corrupt");
+			return false;
+		}
+
+		uint8_t* blockData = static_cast<uint8_t*>(BM_ALLOC(header.uncompressedLength > 0 ? header.uncompressedLength : 1));
+		if (blockData == nullptr)
+		{
+			BmSetLastError("Unable to allocate memory for compressed block");
+			return false;
+		}
+
+		const uint8_t* chunkData = data + sizeof(header) + chunkCount * sizeof(uint32_t);
+		bool succeeded = DecompressBlockChunks(header, chunkSizes, 0, chunkCount, chunkData, blockData) &&
+			ReadFileBlock<V, I>(header.type, blockData, header.uncompressedLength, model, vertLayout, interleaved, flags & ~BmLoadFlags::MemoryMapped);
+
+		BM_FREE(blockData);
+		return succeeded;
+	}
+
+	// reads a block of the given type in to model, unknown blocks are skipped
+	template<typename V, typename I>
+	BM_FUNC_DECL bool ReadFileBlock(BmFileBlockType type, uint8_t* data, uint32_t blockLength, BmModel<V, I>* model, const BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags)
+	{
+		bool succeeded = true;
+
+		switch (type)
+		{
+			case BmFileBlockType::MeshData:
+			case BmFileBlockType::CompressedMeshData:
+				succeeded = ReadMeshBlock<V, I>(data, blockLength, model, vertLayout, interleaved, flags, type);
+			break;
+			case BmFileBlockType::MeshletData:
+				succeeded = ReadMeshletBlock<V, I>(data, blockLength, model, flags);
+			break;
+			case BmFileBlockType::LodData:
+				succeeded = ReadLodBlock<V, I>(data, blockLength, model, flags);
+			break;
+			case BmFileBlockType::ProgressiveData:
+				succeeded = ReadProgressiveBlock<V, I>(data, blockLength, model, vertLayout, interleaved);
+			break;
+			case BmFileBlockType::CompressedBlock:
+				succeeded = ReadCompressedBlock<V, I>(data, blockLength, model, vertLayout, interleaved, flags);
+			break;
+			default:
+			break;
+		}
+
+		BM_LOG("Read Block of type %s with length %u\n", GetBlockTypeName(type), blockLength);
+
+		return succeeded;
+	}
+
+	// =================================
+	// Basic Model : Streamed Loading
+	// =================================
+
+	// reads a CompressedBlock from file a batch of chunks at a time, one chunk per loading thread, decompressing
+	// each batch in parallel before the next is read. the block is skipped if it doesn't wrap a block that is loaded
+	template<typename V, typename I>
+	BM_FUNC_DECL bool StreamCompressedBlock(FILE* file, uint32_t blockLength, BmModel<V, I>* model, const BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags)
+	{
+		BmCompressedBlockHeader header;
+		uint32_t chunkCount = 0;
+
+		if (blockLength < sizeof(header) || fread(&header, sizeof(header), 1, file) != 1)
+		{
+			BmSetLastError("Compressed block is corrupt");
+			return false;
+		}
+
+		if (!IsLoadedBlockType(header.type))
+			return true;
+
+		BmList<uint32_t> chunkSizes;
+		if (!GetCompressedChunkCount(header, blockLength, chunkCount) ||
+			(chunkSizes.resize(chunkCount), fread(chunkSizes.data, sizeof(uint32_t), chunkCount, file) != chunkCount) ||
+			!CheckChunkSizes(header, chunkSizes))
+		{
+			BmSetLastError("Compressed block is corrupt");
+			return false;
+		}
+
+		uint8_t* blockData = static_cast<uint8_t*>(BM_ALLOC(header.uncompressedLength > 0 ? header.uncompressedLength : 1));
+		if (blockData == nullptr)
+		{
+			BmSetLastError("Unable to allocate memory for compressed block");
+			return false;
+		}
+
+		uint32_t batchSize = bmdl::GetWorkerPool().GetWorkerCount() + 1;
+		std::vector<uint8_t> batchData;
+
+		bool succeeded = true;
+		for (uint32_t first = 0; succeeded && first < chunkCount; first += batchSize)
+		{
+			uint32_t count = (chunkCount - first) < batchSize ? (chunkCount - first) : batchSize;
+
+			size_t batchBytes = 0;
+			for (uint32_t c = first; c < first + count; c++)
+				batchBytes += chunkSizes[c];
+
+			batchData.resize(batchBytes);
+			if (fread(batchData.data(), 1, batchBytes, file) != batchBytes)
+			{
+				BmSetLastError("Unable to read file");
+				succeeded = false;
+				break;
+			}
+
+			succeeded = DecompressBlockChunks(header, chunkSizes, first, count, batchData.data(), blockData);
+
+			// a level of detail that isn't selected is dropped once its header is known
+			if (succeeded && first == 0 && header.type == BmFileBlockType::LodData && BmHasFlag(flags, BmLoadFlags::SingleLod) &&
+				header.uncompressedLength >= sizeof(BmLodBlockHeader) && reinterpret_cast<BmLodBlockHeader*>(blockData)->level != GetLoadLodLevel(flags))
+			{
+				BM_LOG("Skipped level of detail block with length %u\n", header.uncompressedLength);
+				BM_FREE(blockData);
+				return true;
+			}
+		}
+
+		// the compressed chunks are released before the block is read
+		std::vector<uint8_t>().swap(batchData);
+
+		if (succeeded)
+			succeeded = ReadFileBlock<V, I>(header.type, blockData, header.uncompressedLength, model, vertLayout, interleaved, flags);
+
+		BM_FREE(blockData);
+		return succeeded;
+	}
+
+	// peeks at the header of the LodData block the file is at, false when the flags select another level.
+	// a header that can't be read counts as selected so ReadLodBlock reports it
+	inline bool IsSelectedLod(FILE* file, uint32_t blockLength, BmLoadFlags flags)
+	{
+		if (!BmHasFlag(flags, BmLoadFlags::SingleLod))
+			return true;
+
+		BmLodBlockHeader header;
+		if (blockLength < sizeof(header) || fread(&header, sizeof(header), 1, file) != 1 || fseek(file, -static_cast<long>(sizeof(header)), SEEK_CUR))
+			return true;
+
+		return header.level == GetLoadLodLevel(flags);
+	}
+
+	// loads a model from a file one block at a time. blocks that aren't loaded are skipped without being read,
+	// so at most one block, decompressed if it is a CompressedBlock, is held in memory along with one batch of its chunks
+	template<typename V, typename I>
+	BM_FUNC_DECL BmModel<V, I>* LoadModelStreamed(const char* name, const BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags)
+	{
+		FILE* file = fopen(name, "rb");
+		if (file == nullptr)
+		{
+			BmSetLastError("Unable to read file");
+			return nullptr;
+		}
+
+		uint64_t fileSize = 0;
+		if (!FileGetSize(file, fileSize))
+		{
+			fclose(file);
+			BmSetLastError("Unable to read file");
+			return nullptr;
+		}
+
+		// block offsets are 32 bit, larger files can't be addressed
+		if (fileSize > UINT32_MAX)
+		{
+			fclose(file);
+			BmSetLastError("File is larger than 4 GB");
+			return nullptr;
+		}
+
+		uint32_t dataSize = static_cast<uint32_t>(fileSize);
+
+		BmFileHeader fileHeader;
+		if (dataSize < sizeof(BmFileHeader) || fread(&fileHeader, sizeof(fileHeader), 1, file) != 1)
+		{
+			fclose(file);
+			BmSetLastError("Could not read file, not enough data to define Basic Model File Header");
+			return nullptr;
+		}
+
+		if (fileHeader.fileID != BmFileID)
+		{
+			fclose(file);
+			BmSetLastError("Basic Model file ID did not match : incorrect file type or corrupt data.");
+			return nullptr;
+		}
+
+		BM_LOG("Read BMDL Header version %i.%i \n", fileHeader.versionMajor, fileHeader.versionMinor);
+
+		// blocks are read in to memory that is released once the block is loaded, mesh data is always copied
+		flags = flags & ~BmLoadFlags::MemoryMapped;
+
+		BmModel<V, I>* newModel = new BmModel<V, I>();
+
+		uint32_t readPos = sizeof(BmFileHeader);
+		bool succeeded = true;
+
+		while (succeeded && (dataSize - readPos) >= sizeof(BmFileBlock))
+		{
+			BmFileBlock fileBlock;
+			if (fseek(file, static_cast<long>(readPos), SEEK_SET) || fread(&fileBlock, sizeof(fileBlock), 1, file) != 1)
+			{
+				BmSetLastError("Unable to read file");
+				succeeded = false;
+				break;
+			}
+			readPos += sizeof(BmFileBlock);
+
+			if (fileBlock.blockLength > dataSize - readPos)
+			{
+				BmSetLastError("File truncated : block extends past the end of the file");
+				succeeded = false;
+				break;
+			}
+
+			if (fileBlock.type == BmFileBlockType::CompressedBlock)
+			{
+				succeeded = StreamCompressedBlock<V, I>(file, fileBlock.blockLength, newModel, vertLayout, interleaved, flags);
+			}
+			else if (fileBlock.type == BmFileBlockType::LodData && !IsSelectedLod(file, fileBlock.blockLength, flags))
+			{
+				BM_LOG("Skipped level of detail block with length %u\n", fileBlock.blockLength);
+			}
+			else if (IsLoadedBlockType(fileBlock.type))
+			{
+				uint8_t* blockData = static_cast<uint8_t*>(BM_ALLOC(fileBlock.blockLength > 0 ? fileBlock.blockLength : 1));
+
+				succeeded = blockData != nullptr && fread(blockData, 1, fileBlock.blockLength, file) == fileBlock.blockLength &&
+					ReadFileBlock<V, I>(fileBlock.type, blockData, fileBlock.blockLength, newModel, vertLayout, interleaved, flags);
+
+				if (blockData != nullptr)
+					BM_FREE(blockData);
+			}
+			else
+			{
+				BM_LOG("Skipped Block of type %s with length %u\n", GetBlockTypeName(fileBlock.type), fileBlock.blockLength);
+			}
+
+			readPos += fileBlock.blockLength;
+		}
+
+		fclose(file);
+
+		if (!succeeded)
+		{
+			delete newModel;
+			return nullptr;
+		}
+
+		BM_LOG("Read all blocks\n");
+
+		if (BmHasFlag(flags, BmLoadFlags::ContiguousBuffers) && !PackModelBuffers(*newModel))
+		{
+			delete newModel;
+			return nullptr;
+		}
+
+		BM_LOG("Loaded Successfully ...\n");
+
+		return newModel;
+	}
+
+	// =================================
+	// Basic Model : Progressive Loading
+	// Reads a model as its file data arrives, for streaming from a slow or cold source. The meshes are there once
+	// their block has arrived and a ProgressiveData block refines them a vertex split at a time as its records
+	// come in, so a coarse model can be drawn long before the whole file is read.
+	// =================================
+
+	// the model belongs to the loader until Release is called and changes during Append, every other block is read
+	// once all of it has arrived. vertices are always interleaved and data is copied out of what is appended.
+	// BmLoadFlags::ContiguousBuffers isn't applied while the meshes grow, call PackModelBuffers once complete
+	template<typename V = BmVert, typename I = uint16_t>
+	class BmProgressiveLoader
+	{
+	public:
+
+		explicit BmProgressiveLoader(const BmVertLayout* vertLayout = &BmDefaultLayout, BmLoadFlags flags = BmLoadFlags::None) :
+			vertLayout(vertLayout), flags(flags & ~BmLoadFlags::MemoryMapped), model(nullptr), readPos(0), headerRead(false), failed(false),
+			inBlock(false), block(), blockRead(0), blockHeaderRead(false), blockHeader(), splitsRead(0)
+		{}
+
+		~BmProgressiveLoader() { delete model; }
+
+		BmProgressiveLoader(const BmProgressiveLoader&) = delete;
+		BmProgressiveLoader& operator=(const BmProgressiveLoader&) = delete;
+
+		// reads as much as it can of the file data appended so far, the rest of an incomplete block or record is kept until
+		// more arrives. returns false once the data turned out to be corrupt, anything appended after that is ignored
+		bool Append(const uint8_t* data, size_t size)
+		{
+			if (failed)
+				return false;
+
+			pending.insert(pending.end(), data, data + size);
+
+			failed = !ReadPending();
+			if (failed)
+			{
+				delete model;
+				model = nullptr;
+			}
+
+			// keep only what is still to be read
+			pending.erase(pending.begin(), pending.begin() + readPos);
+			readPos = 0;
+
+			return !failed;
+		}
+
+		// the model read so far, nullptr until a mesh block has been read
+		BmModel<V, I>* GetModel() const { return model != nullptr && model->meshList.count > 0 ? model : nullptr; }
+
+		// hands the model over to the caller, the loader reads nothing more
+		BmModel<V, I>* Release()
+		{
+			BmModel<V, I>* released = GetModel();
+			if (released == nullptr)
+				delete model;
+
+			model = nullptr;
+			failed = true;
+			return released;
+		}
+
+		// true when the data appended so far ends between blocks, false part way through one
+		bool IsComplete() const { return !failed && headerRead && !inBlock && pending.empty(); }
+
+		// splits of the ProgressiveData block being read that haven't arrived yet
+		uint32_t GetPendingSplits() const { return inBlock && blockHeaderRead ? blockHeader.splitCount - splitsRead : 0; }
+
+	private:
+
+		bool ReadPending()
+		{
+			while (true)
+			{
+				uint8_t* data = pending.data() + readPos;
+				size_t available = pending.size() - readPos;
+
+				if (!headerRead)
+				{
+					if (available < sizeof(BmFileHeader))
+						return true;
+
+					BmFileHeader fileHeader;
+					memcpy(&fileHeader, data, sizeof(fileHeader));
+					if (fileHeader.fileID != BmFileID)
+					{
+						BmSetLastError("Basic Model file ID did not match : incorrect file type or corrupt data.");
+						return false;
+					}
+
+					BM_LOG("Read BMDL Header version %i.%i \n", fileHeader.versionMajor, fileHeader.versionMinor);
+
+					model = new BmModel<V, I>();
+					headerRead = true;
+					readPos += sizeof(BmFileHeader);
+				}
+				else if (!inBlock)
+				{
+					if (available < sizeof(BmFileBlock))
+						return true;
+
+					memcpy(&block, data, sizeof(block));
+					readPos += sizeof(BmFileBlock);
+					inBlock = true;
+					blockRead = 0;
+					blockHeaderRead = false;
+				}
+				else if (block.type == BmFileBlockType::ProgressiveData)
+				{
+					size_t read = 0;
+					if (!ReadProgressive(data, static_cast<size_t>(available < block.blockLength - blockRead ? available : block.blockLength - blockRead), read))
+						return false;
+					if (read == 0 && blockRead < block.blockLength)
+						return true;
+
+					readPos += read;
+					blockRead += static_cast<uint32_t>(read);
+					inBlock = blockRead < block.blockLength;
+				}
+				else if (!IsLoadedBlockType(block.type))
+				{
+					// passed over as it arrives
+					uint32_t skipped = static_cast<uint32_t>(available < block.blockLength - blockRead ? available : block.blockLength - blockRead);
+					readPos += skipped;
+					blockRead += skipped;
+					inBlock = blockRead < block.blockLength;
+					if (inBlock)
+						return true;
+
+					BM_LOG("Skipped Block of type %s with length %u\n", GetBlockTypeName(block.type), block.blockLength);
+				}
+				else
+				{
+					if (available < block.blockLength)
+						return true;
+
+					if (!ReadFileBlock<V, I>(block.type, data, block.blockLength, model, vertLayout, true, flags))
+						return false;
+
+					readPos += block.blockLength;
+					inBlock = false;
+				}
+			}
+		}
+
+		// reads the header, sets and splits of the progressive block that have arrived, available is capped at the
+		// end of the block. read is left at 0 when nothing complete has arrived
+		bool ReadProgressive(uint8_t* data, size_t available, size_t& read)
+		{
+			uint32_t remaining = block.blockLength - blockRead;
+
+			while (true)
+			{
+				uint8_t* readData = data + read;
+				size_t readAvailable = available - read;
+
+				if (!blockHeaderRead)
+				{
+					if (remaining < sizeof(blockHeader))
+					{
+						BmSetLastError("Progressive block too small to hold a progressive block header");
+						return false;
+					}
+					if (readAvailable < sizeof(blockHeader))
+						return true;
+
+					memcpy(&blockHeader, readData, sizeof(blockHeader));
+					if (blockHeader.meshCount > remaining / sizeof(BmProgressiveSetHeader))
+					{
+						BmSetLastError("Progressive block truncated : not enough data for progressive mesh header");
+						return false;
+					}
+
+					blockHeaderRead = true;
+					sets.clear();
+					sets.reserve(blockHeader.meshCount);
+					splitsRead = 0;
+					read += sizeof(blockHeader);
+				}
+				else if (sets.size() < blockHeader.meshCount)
+				{
+					if (read + sizeof(BmProgressiveSetHeader) > remaining || (readAvailable >= sizeof(BmProgressiveSetHeader) && read + GetProgressiveSetSize(readData) > remaining))
+					{
+						BmSetLastError("Progressive block truncated : not enough data for progressive mesh header");
+						return false;
+					}
+					if (readAvailable < sizeof(BmProgressiveSetHeader) || readAvailable < GetProgressiveSetSize(readData))
+						return true;
+
+					sets.emplace_back();
+					if (!ReadProgressiveSet<V, I>(readData, model, vertLayout, sets.back()))
+						return false;
+					read += static_cast<size_t>(GetProgressiveSetSize(readData));
+				}
+				else if (splitsRead < blockHeader.splitCount)
+				{
+					BmVertexSplitHeader splitHeader;
+					if (read + sizeof(splitHeader) > remaining)
+					{
+						BmSetLastError("Progressive block truncated : not enough data for vertex split header");
+						return false;
+					}
+					if (readAvailable < sizeof(splitHeader))
+						return true;
+
+					memcpy(&splitHeader, readData, sizeof(splitHeader));
+					uint64_t splitSize = splitHeader.set < sets.size() ? GetVertexSplitSize(splitHeader, sets[splitHeader.set]) : sizeof(splitHeader);
+					if (read + splitSize > remaining)
+					{
+						BmSetLastError("Progressive block truncated : not enough data for vertex split");
+						return false;
+					}
+					if (readAvailable < splitSize)
+						return true;
+
+					if (!ReadVertexSplit<V, I>(readData, sets, model))
+						return false;
+					splitsRead++;
+					read += static_cast<size_t>(splitSize);
+				}
+				else
+				{
+					// anything after the last split is passed over
+					read = available;
+					return true;
+				}
+			}
+		}
+
+		const BmVertLayout*		vertLayout;
+		BmLoadFlags				flags;
+		BmModel<V, I>*			model;
+
+		std::vector<uint8_t>	pending;		// appended data not read yet, from readPos
+		size_t					readPos;
+		bool					headerRead;
+		bool					failed;
+
+		// block being read
+		bool					inBlock;
+		BmFileBlock				block;
+		uint32_t				blockRead;
+
+		// progressive block being read
+		bool							blockHeaderRead;
+		BmProgressiveBlockHeader		blockHeader;
+		std::vector<BmProgressiveSet>	sets;
+		uint32_t						splitsRead;
+	};
+}
+
+template<typename V = BmVert, typename I = uint16_t>
+class BmMesh
+{
+public:
+
+	BmMesh() : compactIndexType(BmIndexType::UInt32), hasBounds(false), bounds() {}
+
+	BmList<V> vertices; // interleaved vertex attributes
+	BmList<I> indices;  
+
+	// indices stored with the smallest type able to hold them, filled instead of indices when loaded
+	// with BmLoadFlags::CompactIndices. holds indices.count * GetIndexTypeSize(compactIndexType) bytes
+	BmList<uint8_t> compactIndices;
+	BmIndexType compactIndexType;
+
+	// bounds of the BoundsUnorm16 attributes stored in the file, the loader dequantizes them unless the
+	// vertex layout keeps BoundsUnorm16 in which case they map the raw values back (min + v / 65535 * (max - min))
+	bool hasBounds;
+	BmAttrBounds bounds;
+
+	// non-interleaved vertex attributes, filled instead of vertices when loaded with interleaved = false.
+	// one stream per attribute of the vertex layout, stored back to back in streamData
+	BmList<BmVertStream> streams;
+	BmList<uint8_t> streamData;
+
+	// returns the stream holding the given attribute, or nullptr if the mesh doesn't have it
+	const BmVertStream* GetStream(BmAttrMap attrMap) const
+	{
+		for (uint32_t s = 0; s < streams.count; s++)
+		{
+			if (streams[s].attribute.attrMap == attrMap)
+				return &streams[s];
+		}
+		return nullptr;
+	}
+
+	BmList<BmSubMesh> subMeshList;
+
+	// clusters of the mesh and their culling bounds, filled from a MeshletData block or by bmdl::BuildMeshlets
+	BmList<BmMeshlet> meshlets;
+	BmList<BmMeshletBounds> meshletBounds;
+	BmList<uint32_t> meshletVertices;	// mesh vertex of each local vertex of each meshlet
+	BmList<uint8_t> meshletTriangles;	// three local vertices per triangle
+
+	// lower levels of detail from most to least detailed, filled from LodData blocks or by bmdl::BuildLods
+	BmList<BmMeshLod> lods;
+	BmList<I> lodIndices;
+	BmList<BmSubMesh> lodSubMeshes;	// ranges of lodIndices, relative to the level they belong to
+
+	// splits refining a progressive mesh from its coarse base, filled from a ProgressiveData block or by
+	// bmdl::BuildProgressiveMeshes. holds the splits made so far. each submesh keeps room in indices for all
+	// of its triangles and indexCount counts the ones it has, meshes without submeshes grow indices instead
+	BmList<BmVertexSplit> vertexSplits;
+	BmList<uint32_t> splitTriangles;	// position in indices of the first corner of each triangle a split adds
+	BmList<BmIndexUpdate> splitUpdates;
+
+	BmMat4 transform;
+
+private:
+
+
+};
+
+template<typename V = BmVert, typename I = uint16_t>
+class BmModel
+{
+public:
+
+	DECLARE_BM_ALLOCATOR()
+
+	BmModel() { }
+	~BmModel()
+	{
+		// meshList doesn't run element destructors, release each mesh's data here
+		for (uint32_t m = 0; m < meshList.count; m++)
+			meshList[m].~BmMesh<V, I>();
+
+		bmdl::FileUnmap(fileMapping);
+	}
+
+	BmList<BmMesh<V, I>> meshList;
+
+	// with BmLoadFlags::ContiguousBuffers the vertices and indices of every mesh, one mesh after another.
+	// meshRanges locates each mesh and the mesh lists are views of these, see bmdl::PackModelBuffers
+	BmList<V> vertexBuffer;
+	BmList<I> indexBuffer;
+	BmList<BmMeshBufferRange> meshRanges;
+
+	// file the model was mapped from when loaded with BmLoadFlags::MemoryMapped, mesh data may reference it
+	bmdl::BmFileMapping fileMapping;
+};
+
+// =================================
+// Basic Model : Contiguous Buffers
+// Moves the vertices of every mesh in to one buffer and the indices in to another so a model is
+// uploaded with one call per buffer and bound once. Indices stay relative to their mesh, draw with
+// the first vertex of the mesh as base vertex.
+// =================================
+
+namespace bmdl
+{
+	// copies the vertices and indices of every mesh of the model in to BmModel::vertexBuffer and
+	// BmModel::indexBuffer and makes the mesh lists views of them, filling BmModel::meshRanges. the
+	// buffers start where BM_ALLOC aligns allocations and every mesh starts on a whole vertex and index.
+	// meshes must have interleaved vertices and indices in I. a mesh that is changed afterwards, like a
+	// progressive mesh being refined, copies its data back out of the buffers
+	template<typename V, typename I>
+	BM_FUNC_DECL bool PackModelBuffers(BmModel<V, I>& model)
+	{
+		uint64_t vertexCount = 0;
+		uint64_t indexCount = 0;
+		for (uint32_t m = 0; m < model.meshList.count; m++)
+		{
+			const BmMesh<V, I>& mesh = model.meshList[m];
+			if (mesh.streams.count > 0 || mesh.compactIndices.count > 0)
+			{
+				BmSetLastError("Contiguous buffers need interleaved vertices and indices of the mesh index type");
+				return false;
+			}
+
+			vertexCount += mesh.vertices.count;
+			indexCount += mesh.indices.count;
+		}
+
+		if (vertexCount > UINT32_MAX || indexCount > UINT32_MAX)
+		{
+			BmSetLastError("Model has too many vertices or indices for contiguous buffers");
+			return false;
+		}
+
+		// the new buffers are filled before the old ones are released, meshes may be views of them
+		BmList<V> vertexBuffer(static_cast<uint32_t>(vertexCount));
+		BmList<I> indexBuffer(static_cast<uint32_t>(indexCount));
+		model.meshRanges.resize(model.meshList.count);
+
+		uint32_t firstVertex = 0;
+		uint32_t firstIndex = 0;
+		for (uint32_t m = 0; m < model.meshList.count; m++)
+		{
+			const BmMesh<V, I>& mesh = model.meshList[m];
+			if (mesh.vertices.count > 0)
+				memcpy(vertexBuffer.data + firstVertex, mesh.vertices.data, mesh.vertices.count * sizeof(V));
+			if (mesh.indices.count > 0)
+				memcpy(indexBuffer.data + firstIndex, mesh.indices.data, mesh.indices.count * sizeof(I));
+
+			model.meshRanges[m] = BmMeshBufferRange{ firstVertex, mesh.vertices.count, firstIndex, mesh.indices.count };
+			firstVertex += mesh.vertices.count;
+			firstIndex += mesh.indices.count;
+		}
+		vertexBuffer.count = firstVertex;
+		indexBuffer.count = firstIndex;
+
+		for (uint32_t m = 0; m < model.meshList.count; m++)
+		{
+			BmMesh<V, I>& mesh = model.meshList[m];
+			const BmMeshBufferRange& range = model.meshRanges[m];
+			mesh.vertices.setView(vertexBuffer.data + range.firstVertex, range.vertexCount);
+			mesh.indices.setView(indexBuffer.data + range.firstIndex, range.indexCount);
+		}
+
+		model.vertexBuffer.swap(vertexBuffer);
+		model.indexBuffer.swap(indexBuffer);
+
+		BM_LOG("Packed %u meshes in to %u vertices and %u indices\n", model.meshList.count, firstVertex, firstIndex);
+		return true;
+	}
+}
+// =================================
+// Basic Model : Asynchronous Loading
+// Files are read one at a time on the IO thread and then decoded on the worker pool,
+// so reading one model overlaps with decoding the models read before it.
+// =================================
+
+enum class BmLoadStatus : uint8_t
+{
+	Pending		= 0,	// queued, file not read yet
+	Loading		= 1,	// file read in progress or model being decoded
+	Complete	= 2,
+	Failed		= 3,
+	Cancelled	= 4
+};
+
+namespace bmdl
+{
+	template<typename V, typename I>
+	struct BmLoadRequest
+	{
+		typedef std::function<void(BmModel<V, I>* model, BmLoadStatus status)> Callback;
+
+		BmLoadRequest() : vertLayout(nullptr), interleaved(true), flags(BmLoadFlags::None), priority(0),
+			cancelled(false), status(BmLoadStatus::Pending), result(promise.get_future().share())
+		{}
+
+		std::string		name;
+		BmVertLayout*	vertLayout;
+		bool			interleaved;
+		BmLoadFlags		flags;
+		int32_t			priority;
+		Callback		callback;
+
+		std::atomic<bool>			cancelled;
+		std::atomic<BmLoadStatus>	status;
+
+		std::promise<BmModel<V, I>*>		promise;
+		std::shared_future<BmModel<V, I>*>	result;
+
+		// finish the request, the model is passed to the callback and the future, or deleted if the request was cancelled
+		void Finish(BmModel<V, I>* model, BmLoadStatus finalStatus)
+		{
+			if (cancelled && finalStatus != BmLoadStatus::Failed)
+			{
+				delete model;
+				model = nullptr;
+				finalStatus = BmLoadStatus::Cancelled;
+			}
+
+			status = finalStatus;
+			if (callback)
+				callback(model, finalStatus);
+			promise.set_value(model);
+		}
+	};
+
+	// handle to a model being loaded by bmdl::LoadModelAsync, copies refer to the same request
+	template<typename V = BmVert, typename I = uint16_t>
+	class BmLoadHandle
+	{
+	public:
+
+		// a default constructed handle has no request, it reports a failed load that is already done
+		BmLoadHandle() {}
+		explicit BmLoadHandle(std::shared_ptr<BmLoadRequest<V, I>> request) : request(request) {}
+
+		bool			IsValid()	const { return request != nullptr; }
+		BmLoadStatus	GetStatus()	const { return request != nullptr ? request->status.load() : BmLoadStatus::Failed; }
+
+		// true once the request completed, failed or was cancelled
+		bool IsDone() const { return request == nullptr || request->result.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+
+		// blocks until the request is done, returns the loaded model or nullptr on failure or cancellation.
+		// the model belongs to the caller, the same pointer is also passed to the completion callback
+		BmModel<V, I>* Wait() const { return request != nullptr ? request->result.get() : nullptr; }
+
+		// the request's future, invalid for a handle without a request
+		std::shared_future<BmModel<V, I>*> GetFuture() const { return request != nullptr ? request->result : std::shared_future<BmModel<V, I>*>(); }
+
+		// stop the request, a file that has not been read is skipped and a model that is still
+		// being decoded is discarded when it finishes. has no effect once the request is done
+		void Cancel() { if (request != nullptr) request->cancelled = true; }
+
+	private:
+
+		std::shared_ptr<BmLoadRequest<V, I>> request;
+	};
+
+	template<typename V, typename I>
+	void DecodeModelAsync(std::shared_ptr<BmLoadRequest<V, I>> request, uint8_t* fileData, uint32_t dataSize, BmFileMapping mapping)
+	{
+		bool mapped = mapping.data != nullptr;
+
+		if (request->cancelled)
+		{
+			if (mapped) FileUnmap(mapping); else BM_FREE(fileData);
+			request->Finish(nullptr, BmLoadStatus::Cancelled);
+			return;
+		}
+
+		BmModel<V, I>* model = LoadModel<V, I>(fileData, dataSize, request->vertLayout, request->interleaved, request->flags);
+
+		if (mapped)
+		{
+			if (model != nullptr)
+				model->fileMapping = mapping;
+			else
+				FileUnmap(mapping);
+		}
+		else
+		{
+			BM_FREE(fileData);
+		}
+
+		request->Finish(model, model != nullptr ? BmLoadStatus::Complete : BmLoadStatus::Failed);
+	}
+
+	template<typename V, typename I>
+	void ReadModelAsync(std::shared_ptr<BmLoadRequest<V, I>> request)
+	{
+		if (request->cancelled)
+		{
+			request->Finish(nullptr, BmLoadStatus::Cancelled);
+			return;
+		}
+
+		request->status = BmLoadStatus::Loading;
+
+		uint8_t* fileData = nullptr;
+		uint32_t dataSize = 0;
+		BmFileMapping mapping;
+
+		if (BmHasFlag(request->flags, BmLoadFlags::MemoryMapped))
+		{
+			if (FileMap(request->name.c_str(), mapping))
+			{
+				fileData = mapping.data;
+				dataSize = mapping.size;
+			}
+		}
+		else
+		{
+			int32_t fileSize = 0;
+			fileData = FileReadAll(request->name.c_str(), fileSize);
+			dataSize = static_cast<uint32_t>(fileSize);
+		}
+
+		if (fileData == nullptr)
+		{
+			BmSetLastError("Unable to read file");
+			request->Finish(nullptr, BmLoadStatus::Failed);
+			return;
+		}
+
+		// decoding happens on the worker pool so the IO thread can move on to the next file
+		GetWorkerPool().Submit([request, fileData, dataSize, mapping]()
+		{
+			DecodeModelAsync<V, I>(request, fileData, dataSize, mapping);
+		}, request->priority);
+	}
+
+	// starts loading a model in the background and returns immediately. requests with a higher priority are
+	// read and decoded first. callback, if given, is called from a loader thread once the request is done
+	template<typename V = BmVert, typename I = uint16_t>
+	BM_FUNC_DECL BmLoadHandle<V, I> LoadModelAsync(std::string name, typename BmLoadRequest<V, I>::Callback callback = nullptr, int32_t priority = 0,
+		BmVertLayout* vertLayout = &BmDefaultLayout, bool interleaved = true, BmLoadFlags flags = BmLoadFlags::None)
+	{
+		std::shared_ptr<BmLoadRequest<V, I>> request = std::make_shared<BmLoadRequest<V, I>>();
+		request->name = name;
+		request->vertLayout = vertLayout;
+		request->interleaved = interleaved;
+		request->flags = flags;
+		request->priority = priority;
+		request->callback = callback;
+
+		GetIoPool().Submit([request]() { ReadModelAsync<V, I>(request); }, priority);
+
+		return BmLoadHandle<V, I>(request);
+	}
+}
+
+// =================================
@@ -0,0 +1,469 @@
+#pragma once
+
+#include "bmdl_common.h"
+#include "bmdl_convert.h"
+
+#include <vector>
+
+// =================================
+// Basic Model : Geometry Codec
+// Lossless compression for vertex and index buffers, used by CompressedMeshData blocks.
+//
+// Vertices are coded in blocks of up to BmVertexCodecBlockSize vertices. Within a block each byte of
+// the vertex is stored as its own plane (byte b of every vertex) holding the zig-zagged difference
+// to the same byte of the previous vertex. Planes are cut in to groups of 16 bytes and each group is
+// packed with 0, 2, 4 or 8 bits per byte, selected by a 2 bit mode stored ahead of the plane's groups.
+//
+// Indices are coded as the zig-zagged difference to the previous index, packed as stream vbyte :
+// a control stream with a 2 bit byte length (1 to 4) per value followed by the value bytes.
+//
+// Neither stream stores its element count or size, these come from the mesh header.
+// =================================
+
+static const uint32_t BmVertexCodecBlockSize = 256;
+static const uint32_t BmVertexCodecGroupSize = 16;
+
+// payload bytes of a 16 byte group for each of the 4 group modes
+static const uint32_t BmVertexCodecGroupBytes[4] = { 0, 4, 8, 16 };
+
+static inline uint8_t ZigZagByte(uint8_t delta) { return static_cast<uint8_t>((delta << 1) ^ (static_cast<int8_t>(delta) >> 7)); }
+static inline uint8_t UnZigZagByte(uint8_t value) { return static_cast<uint8_t>((value >> 1) ^ (0u - (value & 1u))); }
+
+static inline uint32_t ZigZag32(uint32_t delta) { return (delta << 1) ^ static_cast<uint32_t>(static_cast<int32_t>(delta) >> 31); }
+static inline uint32_t UnZigZag32(uint32_t value) { return (value >> 1) ^ (0u - (value & 1u)); }
+
+// =================================
+// Vertex Encoding
+// =================================
+
+// packs 16 zig-zagged deltas with the given mode. 2 bit values : byte k holds values k, k + 4, k + 8, k + 12.
+// 4 bit values : byte k holds value k in the low nibble and k + 8 in the high nibble
+static inline void PackVertexGroup(const uint8_t* values, uint32_t mode, std::vector<uint8_t>& out)
+{
+	switch (mode)
+	{
+		case 1:
+			for (uint32_t k = 0; k < 4; k++)
+				out.push_back(static_cast<uint8_t>(values[k] | (values[k + 4] << 2) | (values[k + 8] << 4) | (values[k + 12] << 6)));
+		break;
+		case 2:
+			for (uint32_t k = 0; k < 8; k++)
+				out.push_back(static_cast<uint8_t>(values[k] | (values[k + 8] << 4)));
+		break;
+		case 3:
+			out.insert(out.end(), values, values + BmVertexCodecGroupSize);
+		break;
+		default:
+		break;
+	}
+}
+
+// appends the encoded form of count vertices of stride bytes to out
+static inline void EncodeVertexBuffer(const uint8_t* vertices, uint32_t stride, uint32_t count, std::vector<uint8_t>& out)
+{
+	std::vector<uint8_t> last(stride, 0);
+	uint8_t plane[BmVertexCodecBlockSize + BmVertexCodecGroupSize];
+
+	for (uint32_t base = 0; base < count; base += BmVertexCodecBlockSize)
+	{
+		uint32_t blockCount = (count - base) < BmVertexCodecBlockSize ? (count - base) : BmVertexCodecBlockSize;
+		uint32_t groupCount = (blockCount + BmVertexCodecGroupSize - 1) / BmVertexCodecGroupSize;
+
+		for (uint32_t b = 0; b < stride; b++)
+		{
+			memset(plane, 0, sizeof(plane));
+
+			uint8_t previous = last[b];
+			for (uint32_t v = 0; v < blockCount; v++)
+			{
+				uint8_t value = vertices[static_cast<size_t>(base + v) * stride + b];
+				plane[v] = ZigZagByte(static_cast<uint8_t>(value - previous));
+				previous = value;
+			}
+			last[b] = previous;
+
+			// group modes, 4 per byte starting at the low bits
+			size_t modeStart = out.size();
+			out.resize(modeStart + (groupCount + 3) / 4, 0);
+
+			for (uint32_t g = 0; g < groupCount; g++)
+			{
+				const uint8_t* values = plane + g * BmVertexCodecGroupSize;
+
+				uint8_t maxValue = 0;
+				for (uint32_t i = 0; i < BmVertexCodecGroupSize; i++)
+					maxValue = values[i] > maxValue ? values[i] : maxValue;
+
+				uint32_t mode = maxValue == 0 ? 0 : (maxValue < 4 ? 1 : (maxValue < 16 ? 2 : 3));
+				out[modeStart + g / 4] |= static_cast<uint8_t>(mode << ((g % 4) * 2));
+
+				PackVertexGroup(values, mode, out);
+			}
+		}
+	}
+}
+
+// =================================
+// Vertex Decoding
+// =================================
+
+static inline void UnpackVertexGroup(const uint8_t* src, uint32_t mode, uint8_t* values)
+{
+	switch (mode)
+	{
+		case 0:
+			memset(values, 0, BmVertexCodecGroupSize);
+		break;
+		case 1:
+			for (uint32_t k = 0; k < 4; k++)
+			{
+				values[k] = src[k] & 3;
+				values[k + 4] = (src[k] >> 2) & 3;
+				values[k + 8] = (src[k] >> 4) & 3;
+				values[k + 12] = src[k] >> 6;
+			}
+		break;
+		case 2:
+			for (uint32_t k = 0; k < 8; k++)
+			{
+				values[k] = src[k] & 15;
+				values[k + 8] = src[k] >> 4;
+			}
+		break;
+		default:
+			memcpy(values, src, BmVertexCodecGroupSize);
+		break;
+	}
+}
+
+#if defined(BM_SIMD_SSE2)
+
+// unpacks a group, reverses the zig-zag and adds the deltas on to carry (the previous byte in every lane)
+static inline __m128i DecodeVertexGroup(const uint8_t* src, uint32_t mode, __m128i carry)
+{
+	const __m128i lowBits2 = _mm_set1_epi8(3);
+	const __m128i lowBits4 = _mm_set1_epi8(15);
+	const __m128i lowBits7 = _mm_set1_epi8(127);
+	const __m128i one = _mm_set1_epi8(1);
+
+	__m128i z;
+	switch (mode)
+	{
+		case 0:
+			return carry;
+		case 1:
+		{
+			int32_t packed;
+			memcpy(&packed, src, sizeof(packed));
+			__m128i x = _mm_cvtsi32_si128(packed);
+			__m128i v0 = _mm_and_si128(x, lowBits2);
+			__m128i v1 = _mm_and_si128(_mm_srli_epi16(x, 2), lowBits2);
+			__m128i v2 = _mm_and_si128(_mm_srli_epi16(x, 4), lowBits2);
+			__m128i v3 = _mm_and_si128(_mm_srli_epi16(x, 6), lowBits2);
+			z = _mm_unpacklo_epi64(_mm_unpacklo_epi32(v0, v1), _mm_unpacklo_epi32(v2, v3));
+		}
+		break;
+		case 2:
+		{
+			__m128i x = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src));
+			z = _mm_unpacklo_epi64(_mm_and_si128(x, lowBits4), _mm_and_si128(_mm_srli_epi16(x, 4), lowBits4));
+		}
+		break;
+		default:
+			z = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		break;
+	}
+
+	// (z >> 1) ^ -(z & 1)
+	__m128i d = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(z, 1), lowBits7), _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(z, one)));
+
+	// prefix sum over the 16 lanes
+	d = _mm_add_epi8(d, _mm_slli_si128(d, 1));
+	d = _mm_add_epi8(d, _mm_slli_si128(d, 2));
+	d = _mm_add_epi8(d, _mm_slli_si128(d, 4));
+	d = _mm_add_epi8(d, _mm_slli_si128(d, 8));
+
+	return _mm_add_epi8(d, carry);
+}
+
+// broadcasts the last byte of v to every lane
+static inline __m128i BroadcastLastByte(__m128i v)
+{
+	__m128i high = _mm_shufflehi_epi16(_mm_unpackhi_epi8(v, v), 0xFF);
+	return _mm_unpackhi_epi64(high, high);
+}
+
+#endif
+
+// decodes count vertices of stride bytes from src straight in to dst. returns false if src is
+// truncated or malformed, dst contents are undefined in that case
+static bool DecodeVertexBuffer(const uint8_t* src, size_t srcSize, uint8_t* dst, uint32_t stride, uint32_t count)
+{
+	if (stride == 0)
+		return count == 0;
+
+	const uint8_t* srcEnd = src + srcSize;
+
+	// decoded planes of the current block, padded so every group can be written whole
+	const uint32_t planeSize = BmVertexCodecBlockSize + BmVertexCodecGroupSize;
+	std::vector<uint8_t> planes(static_cast<size_t>(stride) * planeSize);
+	std::vector<uint8_t> last(stride, 0);
+
+	for (uint32_t base = 0; base < count; base += BmVertexCodecBlockSize)
+	{
+		uint32_t blockCount = (count - base) < BmVertexCodecBlockSize ? (count - base) : BmVertexCodecBlockSize;
+		uint32_t groupCount = (blockCount + BmVertexCodecGroupSize - 1) / BmVertexCodecGroupSize;
+		uint32_t modeBytes = (groupCount + 3) / 4;
+
+		for (uint32_t b = 0; b < stride; b++)
+		{
+			if (static_cast<size_t>(srcEnd - src) < modeBytes)
+				return false;
+
+			const uint8_t* modes = src;
+			src += modeBytes;
+
+			uint8_t* plane = planes.data() + static_cast<size_t>(b) * planeSize;
+
+		#if defined(BM_SIMD_SSE2)
+			__m128i carry = _mm_set1_epi8(static_cast<char>(last[b]));
+		#else
+			uint8_t previous = last[b];
+		#endif
+
+			for (uint32_t g = 0; g < groupCount; g++)
+			{
+				uint32_t mode = (modes[g / 4] >> ((g % 4) * 2)) & 3;
+				uint32_t groupBytes = BmVertexCodecGroupBytes[mode];
+				if (static_cast<size_t>(srcEnd - src) < groupBytes)
+					return false;
+
+				uint8_t* values = plane + g * BmVertexCodecGroupSize;
+
+			#if defined(BM_SIMD_SSE2)
+				__m128i decoded = DecodeVertexGroup(src, mode, carry);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(values), decoded);
+				carry = BroadcastLastByte(decoded);
+			#else
+				UnpackVertexGroup(src, mode, values);
+				for (uint32_t i = 0; i < BmVertexCodecGroupSize; i++)
+				{
+					previous = static_cast<uint8_t>(previous + UnZigZagByte(values[i]));
+					values[i] = previous;
+				}
+			#endif
+
+				src += groupBytes;
+			}
+
+			// the last group may hold padding, carry on from the last real vertex
+			last[b] = plane[blockCount - 1];
+		}
+
+		// interleave the planes back in to vertices
+		uint8_t* blockDst = dst + static_cast<size_t>(base) * stride;
+		uint32_t b = 0;
+
+	#if defined(BM_SIMD_SSE2)
+		// 4 planes at a time, 16 vertices per step
+		for (; b + 4 <= stride; b += 4)
+		{
+			const uint8_t* p0 = planes.data() + static_cast<size_t>(b) * planeSize;
+			const uint8_t* p1 = p0 + planeSize;
+			const uint8_t* p2 = p1 + planeSize;
+			const uint8_t* p3 = p2 + planeSize;
+
+			uint32_t v = 0;
+			for (; v + 16 <= blockCount; v += 16)
+			{
+				__m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p0 + v));
+				__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p1 + v));
+				__m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p2 + v));
+				__m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p3 + v));
+
+				__m128i lo01 = _mm_unpacklo_epi8(x0, x1), hi01 = _mm_unpackhi_epi8(x0, x1);
+				__m128i lo23 = _mm_unpacklo_epi8(x2, x3), hi23 = _mm_unpackhi_epi8(x2, x3);
+
+				__m128i quads[4] = {
+					_mm_unpacklo_epi16(lo01, lo23), _mm_unpackhi_epi16(lo01, lo23),
+					_mm_unpacklo_epi16(hi01, hi23), _mm_unpackhi_epi16(hi01, hi23) };
+
+				uint8_t* out = blockDst + static_cast<size_t>(v) * stride + b;
+				for (uint32_t q = 0; q < 4; q++)
+				{
+					__m128i quad = quads[q];
+					for (uint32_t i = 0; i < 4; i++, out += stride)
+					{
+						int32_t bytes = _mm_cvtsi128_si32(quad);
+						memcpy(out, &bytes, sizeof(bytes));
+						quad = _mm_srli_si128(quad, 4);
+					}
+				}
+			}
+
+			for (; v < blockCount; v++)
+			{
+				uint8_t* out = blockDst + static_cast<size_t>(v) * stride + b;
+				out[0] = p0[v]; out[1] = p1[v]; out[2] = p2[v]; out[3] = p3[v];
+			}
+		}
+	#endif
+
+		for (; b < stride; b++)
+		{
+			const uint8_t* plane = planes.data() + static_cast<size_t>(b) * planeSize;
+			for (uint32_t v = 0; v < blockCount; v++)
+				blockDst[static_cast<size_t>(v) * stride + b] = plane[v];
+		}
+	}
+
+	return true;
+}
+
+// =================================
+// Index Encoding
+// =================================
+
+// appends the encoded form of count indices of indexSize bytes to out
+static inline void EncodeIndexBuffer(const uint8_t* indices, uint32_t indexSize, uint32_t count, std::vector<uint8_t>& out)
+{
+	size_t controlStart = out.size();
+	out.resize(controlStart + (count + 3) / 4, 0);
+
+	uint32_t previous = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t index = ReadIndex(indices, indexSize, i);
+		uint32_t value = ZigZag32(index - previous);
+		previous = index;
+
+		uint32_t length = value < (1u << 8) ? 1 : (value < (1u << 16) ? 2 : (value < (1u << 24) ? 3 : 4));
+		out[controlStart + i / 4] |= static_cast<uint8_t>((length - 1) << ((i % 4) * 2));
+
+		for (uint32_t b = 0; b < length; b++)
+			out.push_back(static_cast<uint8_t>(value >> (b * 8)));
+	}
+}
+
+// =================================
+// Index Decoding
+// =================================
+
+#if defined(BM_SIMD_SSSE3)
+
+// pshufb masks expanding the value bytes of 4 stream vbyte values to 4 dwords, one per control byte
+struct BmVByteShuffleTable
+{
+	BmVByteShuffleTable()
+	{
+		for (uint32_t control = 0; control < 256; control++)
+		{
+			uint8_t* mask = masks[control];
+			uint32_t read = 0;
+			for (uint32_t v = 0; v < 4; v++)
+			{
+				uint32_t length = ((control >> (v * 2)) & 3) + 1;
+				for (uint32_t b = 0; b < 4; b++)
+					mask[v * 4 + b] = b < length ? static_cast<uint8_t>(read + b) : 0x80;
+				read += length;
+			}
+			lengths[control] = static_cast<uint8_t>(read);
+		}
+	}
+
+	uint8_t masks[256][16];
+	uint8_t lengths[256];
+};
+
+static const BmVByteShuffleTable& GetVByteShuffleTable()
+{
+	static const BmVByteShuffleTable table;
+	return table;
+}
+
+#endif
+
+// decodes count indices from src in to dst as indices of dstSize bytes. values wider than dstSize
+// keep their low bits, callers narrowing stored indices should decode at the stored size first.
+// returns false if src is truncated
+static bool DecodeIndexBuffer(const uint8_t* src, size_t srcSize, uint8_t* dst, uint32_t dstSize, uint32_t count)
+{
+	size_t controlBytes = (static_cast<size_t>(count) + 3) / 4;
+	if (srcSize < controlBytes)
+		return false;
+
+	const uint8_t* control = src;
+	const uint8_t* data = src + controlBytes;
+	const uint8_t* dataEnd = src + srcSize;
+
+	uint32_t previous = 0;
+	uint32_t i = 0;
+
+#if defined(BM_SIMD_SSSE3)
+	const BmVByteShuffleTable& table = GetVByteShuffleTable();
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i bias = _mm_set1_epi32(0x8000);
+	const __m128i biasWords = _mm_set1_epi16(static_cast<short>(0x8000));
+	__m128i carry = _mm_setzero_si128();
+
+	// whole groups of 4 while a full 16 byte load stays inside src
+	for (; i + 4 <= count && dataEnd - data >= 16; i += 4)
+	{
+		uint8_t groupControl = control[i / 4];
+
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		__m128i z = _mm_shuffle_epi8(bytes, _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.masks[groupControl])));
+		data += table.lengths[groupControl];
+
+		// (z >> 1) ^ -(z & 1), then prefix sum on to the previous index
+		__m128i d = _mm_xor_si128(_mm_srli_epi32(z, 1), _mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(z, one)));
+		d = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+		d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+		d = _mm_add_epi32(d, carry);
+		carry = _mm_shuffle_epi32(d, 0xFF);
+
+		uint8_t* out = dst + static_cast<size_t>(i) * dstSize;
+		switch (dstSize)
+		{
+			case 4:
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), d);
+			break;
+			case 2:
+			{
+				__m128i words = _mm_add_epi16(_mm_packs_epi32(_mm_sub_epi32(_mm_and_si128(d, _mm_set1_epi32(0xFFFF)), bias), _mm_setzero_si128()), biasWords);
+				_mm_storel_epi64(reinterpret_cast<__m128i*>(out), words);
+			}
+			break;
+			default:
+			{
+				uint32_t values[4];
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(values), d);
+				for (uint32_t l = 0; l < 4; l++)
+					WriteIndex(dst, dstSize, i + l, values[l]);
+			}
+			break;
+		}
+	}
+
+	previous = static_cast<uint32_t>(_mm_cvtsi128_si32(carry));
+#endif
+
+	for (; i < count; i++)
+	{
+		uint32_t length = ((control[i / 4] >> ((i % 4) * 2)) & 3) + 1;
+		if (static_cast<size_t>(dataEnd - data) < length)
+			return false;
+
+		uint32_t value = 0;
+		for (uint32_t b = 0; b < length; b++)
+			value |= static_cast<uint32_t>(data[b]) << (b * 8);
+		data += length;
+
+		previous += UnZigZag32(value);
+		WriteIndex(dst, dstSize, i, previous);
+	}
+
+	return true;
+}
+
+// =================================
@@ -7,6 +7,21 @@
 #include <assert.h>
 #include <string>
 
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
 //#define _CRT_SECURE_NO_WARNINGS
 #pragma warning( disable : 4996 ) // Disable secure crt warnings
 
@@ -26,6 +41,37 @@
 
 #define BM_ASSERT(_expression) assert(_expression)
 
+#if defined(_MSC_VER)
+	#define BM_FORCE_INLINE __forceinline
+#else
+	#define BM_FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+// SIMD conversion kernels, define BM_NO_SIMD to use the scalar paths only
+#if !defined(BM_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define BM_SIMD_SSE2
+	#include <emmintrin.h>
+#endif
+
+// byte shuffles used by the index decoder, MSVC only signals SSSE3 support through /arch:AVX
+#if defined(BM_SIMD_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+	#define BM_SIMD_SSSE3
+	#include <tmmintrin.h>
+#endif
+
+// loader progress output, define BM_NO_LOGGING to compile it out
+#if defined(BM_NO_LOGGING)
+	#define BM_LOG(...)
+#else
+	#define BM_LOG(...) printf(__VA_ARGS__)
+#endif
+
+// x86/x64 handle unaligned loads in hardware, so file data can be referenced in place
+// regardless of where it lands in the file. Other targets only get views of aligned data.
+#if !defined(BM_ALLOW_UNALIGNED_VIEWS) && (defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__))
+	#define BM_ALLOW_UNALIGNED_VIEWS
+#endif
+
 #define BM_ALLOC_PTR_ARR(_count, _type) reinterpret_cast<_type**>(BM_ALLOC(sizeof(_type*) * _count));
 
 #define DECLARE_BM_ALLOCATOR()													\
@@ -129,6 +175,135 @@ namespace bmdl
 		fclose(pFile);
 		return true;
 	}
+
+	// =================================
+	// Basic Model : File Mapping
+	// Read only view of a file mapped in to memory, pages are only loaded when touched.
+	// The mapping is copy on write so data referenced from it can be modified in place
+	// without changing the file on disk.
+	// =================================
+
+	struct BmFileMapping
+	{
+		BmFileMapping() : data(nullptr), size(0)
+		#if defined(_WIN32)
+			, fileHandle(INVALID_HANDLE_VALUE), mapHandle(nullptr)
+		#endif
+		{}
+
+		uint8_t* data;
+		uint32_t size;
+
+	#if defined(_WIN32)
+		HANDLE fileHandle;
+		HANDLE mapHandle;
+	#endif
+	};
+
+	static void FileUnmap(BmFileMapping& mapping)
+	{
+	#if defined(_WIN32)
+		if (mapping.data != nullptr)
+			UnmapViewOfFile(mapping.data);
+		if (mapping.mapHandle != nullptr)
+			CloseHandle(mapping.mapHandle);
+		if (mapping.fileHandle != INVALID_HANDLE_VALUE)
+			CloseHandle(mapping.fileHandle);
+
+		mapping.mapHandle = nullptr;
+		mapping.fileHandle = INVALID_HANDLE_VALUE;
+	#else
+		if (mapping.data != nullptr)
+			munmap(mapping.data, mapping.size);
+	#endif
+
+		mapping.data = nullptr;
+		mapping.size = 0;
+	}
+
+	static bool FileMap(const char* fileLoc, BmFileMapping& mapping)
+	{
+		FileUnmap(mapping);
+
+	#if defined(_WIN32)
+		mapping.fileHandle = CreateFileA(fileLoc, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (mapping.fileHandle == INVALID_HANDLE_VALUE)
+		{
+			printf("CreateFile failed");
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(mapping.fileHandle, &fileSize) || fileSize.QuadPart == 0 || fileSize.QuadPart > UINT32_MAX)
+		{
+			FileUnmap(mapping);
+			return false;
+		}
+
+		mapping.mapHandle = CreateFileMappingA(mapping.fileHandle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+		if (mapping.mapHandle == nullptr)
+		{
+			FileUnmap(mapping);
+			return false;
+		}
+
+		mapping.data = static_cast<uint8_t*>(MapViewOfFile(mapping.mapHandle, FILE_MAP_COPY, 0, 0, 0));
+		if (mapping.data == nullptr)
+		{
+			FileUnmap(mapping);
+			return false;
+		}
+
+		mapping.size = static_cast<uint32_t>(fileSize.QuadPart);
+	#else
+		int fd = open(fileLoc, O_RDONLY);
+		if (fd == -1)
+		{
+			printf("open failed");
+			return false;
+		}
+
+		struct stat fileStat;
+		if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0 || static_cast<uint64_t>(fileStat.st_size) > UINT32_MAX)
+		{
+			close(fd);
+			return false;
+		}
+
+		void* mapped = mmap(nullptr, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+		close(fd); // the mapping keeps its own reference to the file
+
+		if (mapped == MAP_FAILED)
+			return false;
+
+		mapping.data = static_cast<uint8_t*>(mapped);
+		mapping.size = static_cast<uint32_t>(fileStat.st_size);
+	#endif
+
+		return true;
+	}
+
+	// size of an open file in bytes, measured in 64 bits so files over 2 GB aren't misread where long is
+	// 32 bits. the file position is left where it was
+	static inline bool FileGetSize(FILE* file, uint64_t& size)
+	{
+	#if defined(_WIN32)
+		int64_t position = _ftelli64(file);
+		int64_t end = -1;
+		if (position < 0 || _fseeki64(file, 0, SEEK_END) || (end = _ftelli64(file)) < 0 || _fseeki64(file, position, SEEK_SET))
+			return false;
+
+		size = static_cast<uint64_t>(end);
+	#else
+		struct stat fileStat;
+		if (fstat(fileno(file), &fileStat) != 0 || fileStat.st_size < 0)
+			return false;
+
+		size = static_cast<uint64_t>(fileStat.st_size);
+	#endif
+
+		return true;
+	}
 }
 
 // =================================
@@ -235,6 +410,17 @@ enum class BmIndexType : uint8_t
 	UInt32 = 2
 };
 
+static uint32_t GetIndexTypeSize(uint8_t indexType)
+{
+	switch (static_cast<BmIndexType>(indexType))
+	{
+		case BmIndexType::UInt8:	return 1;
+		case BmIndexType::UInt16:	return 2;
+		case BmIndexType::UInt32:	return 4;
+		default:					return 0;
+	}
+}
+
 enum class BmBaseType : uint8_t
 {
 	None	= 0,
@@ -247,15 +433,65 @@ enum class BmBaseType : uint8_t
 	Int64	= 7,
 	Uint64	= 8,
 	Float	= 9,
-	Double	= 10
+	Double	= 10,
+	Half	= 11,	// IEEE 754 half precision float
+
+	// quantized encodings, decoded by the loader when converting to a layout using another type
+	OctSnorm8		= 16,	// unit vector stored as 2 octahedral snorm8 components, decodes to xyz
+	OctSnorm16		= 17,	// unit vector stored as 2 octahedral snorm16 components, decodes to xyz
+	BoundsUnorm16	= 18	// unorm16 components spanning the mesh bounds (BmMeshBounds), used for positions
 };
 
+// true for encodings storing a unit vector in 2 octahedral components
+static inline bool IsOctahedralType(BmBaseType type) { return type == BmBaseType::OctSnorm8 || type == BmBaseType::OctSnorm16; }
+
 enum class BmMeshType : uint8_t
 {
 	StaticMesh = 0,
 	AnimatedMesh = 16,
 };
 
+static uint32_t GetBaseTypeSize(BmBaseType type)
+{
+	switch (type)
+	{
+		case BmBaseType::Int8:
+		case BmBaseType::Uint8:
+		case BmBaseType::OctSnorm8:		return 1;
+		case BmBaseType::Int16:
+		case BmBaseType::UInt16:
+		case BmBaseType::Half:
+		case BmBaseType::OctSnorm16:
+		case BmBaseType::BoundsUnorm16:	return 2;
+		case BmBaseType::Int32:
+		case BmBaseType::UInt32:
+		case BmBaseType::Float:			return 4;
+		case BmBaseType::Int64:
+		case BmBaseType::Uint64:
+		case BmBaseType::Double:		return 8;
+		default:						return 0;
+	}
+}
+
+// flags controlling how bmdl::LoadModel reads a file
+enum class BmLoadFlags : uint32_t
+{
+	None			= 0,
+	MemoryMapped	= 1 << 0,	// map the file instead of reading it, vertex/index data matching V/I is referenced in place
+	CompactIndices	= 1 << 1,	// store each mesh's indices with the smallest type that holds them (BmMesh::compactIndices)
+	SingleLod		= 1 << 2,	// read only the level of detail held in bits 16-23, see BmLoadLodLevel. level 0 reads none
+	ContiguousBuffers	= 1 << 3	// hold every mesh's vertices and indices in one buffer each, see BmModel::vertexBuffer
+};
+
+inline BmLoadFlags operator|(BmLoadFlags a, BmLoadFlags b) { return static_cast<BmLoadFlags>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b)); }
+inline BmLoadFlags operator~(BmLoadFlags a) { return static_cast<BmLoadFlags>(~static_cast<uint32_t>(a)); }
+inline BmLoadFlags operator&(BmLoadFlags a, BmLoadFlags b) { return static_cast<BmLoadFlags>(static_cast<uint32_t>(a) & static_cast<uint32_t>(b)); }
+inline bool BmHasFlag(BmLoadFlags flags, BmLoadFlags flag) { return (static_cast<uint32_t>(flags) & static_cast<uint32_t>(flag)) != 0; }
+
+// flags reading only the given level of detail of each mesh, the LodData blocks of other levels are skipped
+inline BmLoadFlags BmLoadLodLevel(uint32_t level) { return BmLoadFlags::SingleLod | static_cast<BmLoadFlags>((level & 0xFF) << 16); }
+inline uint32_t GetLoadLodLevel(BmLoadFlags flags) { return (static_cast<uint32_t>(flags) >> 16) & 0xFF; }
+
 // maps Easy Mesh vert attributes for other format importing
 enum class BmAttrMap : uint8_t
 {
@@ -302,6 +538,25 @@ struct BmVertAttr
 	BmAttrMap	attrMap;
 };
 
+// range BoundsUnorm16 attributes are quantized against, 0 maps to min and 65535 to max.
+// stored in a mesh after its submesh headers when any of its attributes uses BoundsUnorm16
+struct BmAttrBounds
+{
+	float min[3];
+	float max[3];
+};
+
+static bool UsesAttrBounds(const BmVertAttr* attributes, uint32_t attributeCount)
+{
+	for (uint32_t a = 0; a < attributeCount; a++)
+	{
+		if (attributes[a].baseType == BmBaseType::BoundsUnorm16)
+			return true;
+	}
+
+	return false;
+}
+
 class BmVertLayout
 {
 public:
@@ -311,6 +566,16 @@ public:
 	uint8_t attributeCount;
 };
 
+// byte size of one interleaved vertex described by the given attributes
+static uint32_t GetVertexStride(const BmVertAttr* attributes, uint32_t attributeCount)
+{
+	uint32_t stride = 0;
+	for (uint32_t a = 0; a < attributeCount; a++)
+		stride += GetBaseTypeSize(attributes[a].baseType) * attributes[a].components;
+
+	return stride;
+}
+
 #define BM_CREATE_LAYOUT(l_name)				\
 	class l_name ## _C : public BmVertLayout	\
 	{											\
@@ -0,0 +1,887 @@
+#pragma once
+
+#include "bmdl_common.h"
+
+#include <math.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// =================================
+// Basic Model : Vertex Conversion
+// Converts vertex data stored with one attribute list in to another, matching attributes by
+// their BmAttrMap. Attributes missing from the source are filled with a default value and
+// source attributes the destination doesn't use are dropped.
+//
+// 8 and 16 bit integer data is treated as normalized when converting to or from floating point
+// (unorm for unsigned types, snorm for signed) the same way GPUs read Color32 and packed normals.
+// 32 and 64 bit integers are converted by value.
+// =================================
+
+// default value for a component of an attribute missing from the source data
+static BM_FORCE_INLINE float GetAttrDefault(BmAttrMap attrMap, uint32_t component)
+{
+	switch (attrMap)
+	{
+		case BmAttrMap::Normal:		return component == 2 ? 1.0f : 0.0f;	// +Z
+		case BmAttrMap::Tangent:	return component == 0 ? 1.0f : 0.0f;	// +X
+		case BmAttrMap::BiTangent:	return component == 1 ? 1.0f : 0.0f;	// +Y
+
+		case BmAttrMap::Color_1:	case BmAttrMap::Color_2:	case BmAttrMap::Color_3:	case BmAttrMap::Color_4:
+		case BmAttrMap::Color32_1:	case BmAttrMap::Color32_2:	case BmAttrMap::Color32_3:	case BmAttrMap::Color32_4:
+			return 1.0f; // opaque white
+
+		default:
+			return component == 3 ? 1.0f : 0.0f; // w of a position like attribute
+	}
+}
+
+// half -> float, exact for every half value including denormals, infinity and NaN.
+// the exponent is re-biased by scaling with 2^112, the SSE2 kernel does the same
+static inline float HalfToFloat(uint16_t h)
+{
+	uint32_t expMant = h & 0x7fffu;
+	uint32_t bits = expMant << 13;
+
+	float scaled;
+	memcpy(&scaled, &bits, sizeof(scaled));
+	scaled *= 5.192296858534828e+33f; // 2^112
+	memcpy(&bits, &scaled, sizeof(bits));
+
+	if (expMant > 0x7bffu)
+		bits |= 0x7f800000u; // infinity or NaN
+	bits |= static_cast<uint32_t>(h & 0x8000u) << 16;
+
+	float f;
+	memcpy(&f, &bits, sizeof(f));
+	return f;
+}
+
+// float -> half, rounds to nearest even. values too large for a half become infinity
+static inline uint16_t FloatToHalf(float value)
+{
+	uint32_t f;
+	memcpy(&f, &value, sizeof(f));
+
+	uint32_t sign = f & 0x80000000u;
+	f ^= sign;
+
+	uint16_t h;
+	if (f >= 0x47800000u)
+	{
+		h = f > 0x7f800000u ? 0x7e00 : 0x7c00; // NaN or infinity
+	}
+	else if (f < 0x38800000u)
+	{
+		// denormal or zero, adding 0.5 lines the half mantissa up with the bottom of the float mantissa
+		// so the FPU performs the rounding
+		float denormal;
+		memcpy(&denormal, &f, sizeof(denormal));
+		denormal += 0.5f;
+		memcpy(&f, &denormal, sizeof(f));
+		h = static_cast<uint16_t>(f - 0x3f000000u);
+	}
+	else
+	{
+		uint32_t mantissaOdd = (f >> 13) & 1;
+		f += 0xc8000fffu; // re-bias the exponent, round by adding 0.5 ulp - 1
+		f += mantissaOdd;
+		h = static_cast<uint16_t>(f >> 13);
+	}
+
+	return static_cast<uint16_t>(h | (sign >> 16));
+}
+
+// octahedral unit vector encoding, xy in [-1, 1] holds the vector projected on to an octahedron
+// with the lower half folded over the upper. decoding is exact in the same order as the SSE2 kernel
+static inline void DecodeOctahedral(float x, float y, float* out)
+{
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	float t = -z > 0.0f ? -z : 0.0f;
+	x += x >= 0.0f ? -t : t;
+	y += y >= 0.0f ? -t : t;
+
+	float invLength = 1.0f / sqrtf(x * x + y * y + z * z);
+	out[0] = x * invLength;
+	out[1] = y * invLength;
+	out[2] = z * invLength;
+}
+
+static inline void EncodeOctahedral(const float* v, float* out)
+{
+	float l1 = fabsf(v[0]) + fabsf(v[1]) + fabsf(v[2]);
+	if (l1 == 0.0f)
+	{
+		out[0] = out[1] = 0.0f;
+		return;
+	}
+
+	float x = v[0] / l1;
+	float y = v[1] / l1;
+	if (v[2] < 0.0f)
+	{
+		float foldX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldX;
+		y = foldY;
+	}
+
+	out[0] = x;
+	out[1] = y;
+}
+
+// normalized reads multiply by the reciprocal like the SIMD kernels so every path gives identical results
+static BM_FORCE_INLINE float ReadComponent(BmBaseType type, const uint8_t* src)
+{
+	switch (type)
+	{
+		case BmBaseType::OctSnorm8:
+		case BmBaseType::Int8:		{ int8_t v;		memcpy(&v, src, sizeof(v)); float f = v * (1.0f / 127.0f); return f < -1.0f ? -1.0f : f; }
+		case BmBaseType::Uint8:		{ uint8_t v;	memcpy(&v, src, sizeof(v)); return v * (1.0f / 255.0f); }
+		case BmBaseType::OctSnorm16:
+		case BmBaseType::Int16:		{ int16_t v;	memcpy(&v, src, sizeof(v)); float f = v * (1.0f / 32767.0f); return f < -1.0f ? -1.0f : f; }
+		case BmBaseType::BoundsUnorm16:
+		case BmBaseType::UInt16:	{ uint16_t v;	memcpy(&v, src, sizeof(v)); return v * (1.0f / 65535.0f); }
+		case BmBaseType::Half:		{ uint16_t v;	memcpy(&v, src, sizeof(v)); return HalfToFloat(v); }
+		case BmBaseType::Int32:		{ int32_t v;	memcpy(&v, src, sizeof(v)); return static_cast<float>(v); }
+		case BmBaseType::UInt32:	{ uint32_t v;	memcpy(&v, src, sizeof(v)); return static_cast<float>(v); }
+		case BmBaseType::Int64:		{ int64_t v;	memcpy(&v, src, sizeof(v)); return static_cast<float>(v); }
+		case BmBaseType::Uint64:	{ uint64_t v;	memcpy(&v, src, sizeof(v)); return static_cast<float>(v); }
+		case BmBaseType::Float:		{ float v;		memcpy(&v, src, sizeof(v)); return v; }
+		case BmBaseType::Double:	{ double v;		memcpy(&v, src, sizeof(v)); return static_cast<float>(v); }
+		default:					return 0.0f;
+	}
+}
+
+static inline float ClampUnit(float v, float minValue) { return v < minValue ? minValue : (v > 1.0f ? 1.0f : v); }
+static inline float RoundAway(float v) { return v < 0.0f ? v - 0.5f : v + 0.5f; }
+
+static BM_FORCE_INLINE void WriteComponent(BmBaseType type, uint8_t* dst, float value)
+{
+	switch (type)
+	{
+		case BmBaseType::OctSnorm8:
+		case BmBaseType::Int8:		{ int8_t v = static_cast<int8_t>(RoundAway(ClampUnit(value, -1.0f) * 127.0f));			memcpy(dst, &v, sizeof(v)); } break;
+		case BmBaseType::Uint8:		{ uint8_t v = static_cast<uint8_t>(ClampUnit(value, 0.0f) * 255.0f + 0.5f);				memcpy(dst, &v, sizeof(v)); } break;
+		case BmBaseType::OctSnorm16:
+		case BmBaseType::Int16:		{ int16_t v = static_cast<int16_t>(RoundAway(ClampUnit(value, -1.0f) * 32767.0f));		memcpy(dst, &v, sizeof(v)); } break;
+		case BmBaseType::BoundsUnorm16:
+		case BmBaseType::UInt16:	{ uint16_t v = static_cast<uint16_t>(ClampUnit(value, 0.0f) * 65535.0f + 0.5f);			memcpy(dst, &v, sizeof(v)); } break;
+		case BmBaseType::Half:		{ uint16_t v = FloatToHalf(value);	memcpy(dst, &v, sizeof(v)); } break;
+		case BmBaseType::Int32:		{ int32_t v = static_cast<int32_t>(value);		memcpy(dst, &v, sizeof(v)); } break;
+		case BmBaseType::UInt32:	{ uint32_t v = static_cast<uint32_t>(value);	memcpy(dst, &v, sizeof(v)); } break;
+		case BmBaseType::Int64:		{ int64_t v = static_cast<int64_t>(value);		memcpy(dst, &v, sizeof(v)); } break;
+		case BmBaseType::Uint64:	{ uint64_t v = static_cast<uint64_t>(value);	memcpy(dst, &v, sizeof(v)); } break;
+		case BmBaseType::Float:		{ memcpy(dst, &value, sizeof(value)); } break;
+		case BmBaseType::Double:	{ double v = value; memcpy(dst, &v, sizeof(v)); } break;
+		default: break;
+	}
+}
+
+// one step of a conversion plan, writes a single destination attribute for a run of vertices
+struct BmAttrConversion;
+typedef void(*BmConvertKernel)(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count);
+
+struct BmAttrConversion
+{
+	BmConvertKernel	kernel;
+
+	uint32_t		srcOffset;		// byte offset of the attribute in a source vertex
+	uint32_t		dstOffset;		// byte offset of the attribute in a destination vertex
+	uint32_t		srcByteSize;	// bytes read per vertex
+	uint32_t		byteSize;		// bytes written per vertex, used by the copy kernels
+
+	BmBaseType		srcType;
+	BmBaseType		dstType;
+	uint8_t			srcComponents;
+	uint8_t			dstComponents;
+
+	bool			fromDefault;	// source doesn't have the attribute, defaultData holds the converted default
+	bool			dequantize;		// source is BoundsUnorm16, values are scaled to the mesh bounds after conversion
+	float			defaults[4];
+	uint8_t			defaultData[32];
+};
+
+// =================================
+// Conversion kernels
+// =================================
+
+static void ConvertCopy(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	// fixed size copies compile down to a couple of moves per vertex
+	switch (op.byteSize)
+	{
+		case 4:		for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride) memcpy(dst, src, 4);	break;
+		case 8:		for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride) memcpy(dst, src, 8);	break;
+		case 12:	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride) memcpy(dst, src, 12);	break;
+		case 16:	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride) memcpy(dst, src, 16);	break;
+		default:	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride) memcpy(dst, src, op.byteSize); break;
+	}
+}
+
+// attribute missing from the source, writes the pre-converted default value
+static void ConvertFill(const BmAttrConversion& op, const uint8_t*, uint32_t, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	ConvertCopy(op, op.defaultData, 0, dst, dstStride, count);
+}
+
+static void ConvertZero(const BmAttrConversion& op, const uint8_t*, uint32_t, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	for (uint32_t v = 0; v < count; v++, dst += dstStride)
+		memset(dst, 0, op.byteSize);
+}
+
+static void ConvertGeneric(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	uint32_t srcSize = GetBaseTypeSize(op.srcType);
+	uint32_t dstSize = GetBaseTypeSize(op.dstType);
+
+	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride)
+	{
+		for (uint32_t c = 0; c < op.dstComponents; c++)
+		{
+			float value = c < op.srcComponents ? ReadComponent(op.srcType, src + c * srcSize) : op.defaults[c];
+			WriteComponent(op.dstType, dst + c * dstSize, value);
+		}
+	}
+}
+
+// octahedral source, decodes the vector then converts each component
+static void ConvertFromOctahedral(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	uint32_t srcSize = GetBaseTypeSize(op.srcType);
+	uint32_t dstSize = GetBaseTypeSize(op.dstType);
+
+	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride)
+	{
+		float value[4] = { 0.0f, 0.0f, 0.0f, op.defaults[3] };
+		DecodeOctahedral(ReadComponent(op.srcType, src), ReadComponent(op.srcType, src + srcSize), value);
+
+		for (uint32_t c = 0; c < op.dstComponents; c++)
+			WriteComponent(op.dstType, dst + c * dstSize, value[c]);
+	}
+}
+
+// octahedral destination, encodes the first 3 source components
+static void ConvertToOctahedral(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	uint32_t srcSize = GetBaseTypeSize(op.srcType);
+	uint32_t dstSize = GetBaseTypeSize(op.dstType);
+
+	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride)
+	{
+		float value[3];
+		for (uint32_t c = 0; c < 3; c++)
+			value[c] = c < op.srcComponents ? ReadComponent(op.srcType, src + c * srcSize) : op.defaults[c];
+
+		float encoded[2];
+		EncodeOctahedral(value, encoded);
+		WriteComponent(op.dstType, dst, encoded[0]);
+		WriteComponent(op.dstType, dst + dstSize, encoded[1]);
+	}
+}
+
+// maps BoundsUnorm16 values already converted to unorm in dst on to the bounds, meaningful for
+// floating point destinations only as normalized integer types can't hold the scaled range
+static void ScaleToBounds(const BmAttrConversion& op, const BmAttrBounds& bounds, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	uint32_t dstSize = GetBaseTypeSize(op.dstType);
+	uint32_t components = op.dstComponents < 3 ? op.dstComponents : 3;
+	uint32_t sourced = op.srcComponents < components ? op.srcComponents : components;
+
+	for (uint32_t v = 0; v < count; v++, dst += dstStride)
+	{
+		for (uint32_t c = 0; c < sourced; c++)
+		{
+			uint8_t* component = dst + c * dstSize;
+			float value = ReadComponent(op.dstType, component);
+			WriteComponent(op.dstType, component, bounds.min[c] + value * (bounds.max[c] - bounds.min[c]));
+		}
+	}
+}
+
+#if defined(BM_SIMD_SSE2)
+
+// stores the first n lanes of v without touching the bytes after them
+static inline void StoreFloats(uint8_t* dst, __m128 v, uint32_t n)
+{
+	switch (n)
+	{
+		case 4: _mm_storeu_ps(reinterpret_cast<float*>(dst), v); break;
+		case 3: _mm_storel_pi(reinterpret_cast<__m64*>(dst), v); _mm_store_ss(reinterpret_cast<float*>(dst + 8), _mm_movehl_ps(v, v)); break;
+		case 2: _mm_storel_pi(reinterpret_cast<__m64*>(dst), v); break;
+		default: _mm_store_ss(reinterpret_cast<float*>(dst), v); break;
+	}
+}
+
+static inline __m128i LoadBytes(const uint8_t* src, uint32_t n)
+{
+	int64_t bits = 0;
+	memcpy(&bits, src, n);
+	return _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&bits));
+}
+
+// unorm8 x4 -> float x4, Color32 to float colors
+static void ConvertUnorm8ToFloat(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+	uint32_t n = op.dstComponents;
+
+	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride)
+	{
+		__m128i bytes = LoadBytes(src, n);
+		__m128i words = _mm_unpacklo_epi8(bytes, zero);
+		__m128i dwords = _mm_unpacklo_epi16(words, zero);
+		StoreFloats(dst, _mm_mul_ps(_mm_cvtepi32_ps(dwords), scale), n);
+	}
+}
+
+// snorm8 -> float, packed normals and tangents
+static void ConvertSnorm8ToFloat(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 127.0f);
+	const __m128 minValue = _mm_set1_ps(-1.0f);
+	uint32_t n = op.dstComponents;
+
+	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride)
+	{
+		__m128i bytes = LoadBytes(src, n);
+		__m128i words = _mm_unpacklo_epi8(bytes, bytes);			// sign byte in the high half
+		__m128i dwords = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 24);
+		StoreFloats(dst, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(dwords), scale), minValue), n);
+	}
+}
+
+static void ConvertUnorm16ToFloat(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128 scale = _mm_set1_ps(1.0f / 65535.0f);
+	uint32_t n = op.dstComponents;
+
+	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride)
+	{
+		__m128i dwords = _mm_unpacklo_epi16(LoadBytes(src, n * 2), zero);
+		StoreFloats(dst, _mm_mul_ps(_mm_cvtepi32_ps(dwords), scale), n);
+	}
+}
+
+static void ConvertSnorm16ToFloat(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	const __m128 scale = _mm_set1_ps(1.0f / 32767.0f);
+	const __m128 minValue = _mm_set1_ps(-1.0f);
+	uint32_t n = op.dstComponents;
+
+	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride)
+	{
+		__m128i words = LoadBytes(src, n * 2);
+		__m128i dwords = _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+		StoreFloats(dst, _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(dwords), scale), minValue), n);
+	}
+}
+
+// half x4 -> float x4, see HalfToFloat
+static void ConvertHalfToFloat(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i expMantMask = _mm_set1_epi32(0x7fff);
+	const __m128i infNanThreshold = _mm_set1_epi32(0x7bff);
+	const __m128i infNanExp = _mm_set1_epi32(0x7f800000);
+	const __m128 magic = _mm_set1_ps(5.192296858534828e+33f); // 2^112
+	uint32_t n = op.dstComponents;
+
+	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride)
+	{
+		__m128i h = _mm_unpacklo_epi16(LoadBytes(src, n * 2), zero);
+		__m128i expMant = _mm_and_si128(h, expMantMask);
+		__m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expMant), 16);
+
+		__m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expMant, 13)), magic);
+		__m128i infNan = _mm_and_si128(_mm_cmpgt_epi32(expMant, infNanThreshold), infNanExp);
+
+		StoreFloats(dst, _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNan))), n);
+	}
+}
+
+// octahedral snorm x2 -> float x3, four vertices per iteration. see DecodeOctahedral
+static void ConvertOctahedralToFloat(const BmAttrConversion& op, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	uint32_t srcSize = GetBaseTypeSize(op.srcType);
+
+	uint32_t v = 0;
+	for (; v + 4 <= count; v += 4)
+	{
+		float xs[4], ys[4];
+		for (uint32_t l = 0; l < 4; l++)
+		{
+			xs[l] = ReadComponent(op.srcType, src + l * srcStride);
+			ys[l] = ReadComponent(op.srcType, src + l * srcStride + srcSize);
+		}
+
+		__m128 x = _mm_loadu_ps(xs);
+		__m128 y = _mm_loadu_ps(ys);
+		__m128 z = _mm_sub_ps(_mm_sub_ps(one, _mm_and_ps(x, absMask)), _mm_and_ps(y, absMask));
+		__m128 t = _mm_max_ps(_mm_sub_ps(zero, z), zero);
+
+		// x += x >= 0 ? -t : t
+		__m128 xPositive = _mm_cmpge_ps(x, zero);
+		__m128 yPositive = _mm_cmpge_ps(y, zero);
+		x = _mm_add_ps(x, _mm_or_ps(_mm_and_ps(xPositive, _mm_sub_ps(zero, t)), _mm_andnot_ps(xPositive, t)));
+		y = _mm_add_ps(y, _mm_or_ps(_mm_and_ps(yPositive, _mm_sub_ps(zero, t)), _mm_andnot_ps(yPositive, t)));
+
+		__m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		__m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+		x = _mm_mul_ps(x, invLength);
+		y = _mm_mul_ps(y, invLength);
+		z = _mm_mul_ps(z, invLength);
+
+		__m128 w = zero;
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+
+		StoreFloats(dst, x, 3);	dst += dstStride;
+		StoreFloats(dst, y, 3);	dst += dstStride;
+		StoreFloats(dst, z, 3);	dst += dstStride;
+		StoreFloats(dst, w, 3);	dst += dstStride;
+		src += srcStride * 4;
+	}
+
+	if (v < count)
+		ConvertFromOctahedral(op, src, srcStride, dst, dstStride, count - v);
+}
+
+// float x4 -> unorm8 x4, float colors to Color32
+static void ConvertFloatToUnorm8(const BmAttrConversion&, const uint8_t* src, uint32_t srcStride, uint8_t* dst, uint32_t dstStride, uint32_t count)
+{
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 scale = _mm_set1_ps(255.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	for (uint32_t v = 0; v < count; v++, src += srcStride, dst += dstStride)
+	{
+		__m128 f = _mm_loadu_ps(reinterpret_cast<const float*>(src));
+		f = _mm_add_ps(_mm_mul_ps(_mm_min_ps(_mm_max_ps(f, zero), one), scale), half);
+		__m128i i = _mm_cvttps_epi32(f);
+		i = _mm_packs_epi32(i, i);
+		i = _mm_packus_epi16(i, i);
+		int32_t packed = _mm_cvtsi128_si32(i);
+		memcpy(dst, &packed, 4);
+	}
+}
+
+#endif
+
+// =================================
+// Conversion Plan
+// =================================
+
+class BmVertConversionPlan
+{
+public:
+
+	BmVertConversionPlan() : srcStride(0), dstStride(0), identity(false), valid(false) {}
+
+	// build the steps converting vertices described by srcAttrs in to vertices described by dstAttrs.
+	// dstStride may be larger than the packed size of dstAttrs when the destination struct has padding
+	bool Build(const BmVertAttr* srcAttrs, uint32_t srcCount, const BmVertAttr* dstAttrs, uint32_t dstCount, uint32_t destinationStride)
+	{
+		srcStride = GetVertexStride(srcAttrs, srcCount);
+		dstStride = destinationStride;
+		ops.clear();
+
+		uint32_t packedDstStride = GetVertexStride(dstAttrs, dstCount);
+		if (packedDstStride > dstStride)
+		{
+			bmdl::BmSetLastError("Vertex layout is larger than the vertex type it describes");
+			valid = false;
+			return false;
+		}
+
+		identity = srcStride == dstStride && srcCount == dstCount;
+
+		uint32_t dstOffset = 0;
+		for (uint32_t d = 0; d < dstCount; d++)
+		{
+			const BmVertAttr& dstAttr = dstAttrs[d];
+
+			BmAttrConversion op;
+			memset(&op, 0, sizeof(op));
+			op.dstOffset = dstOffset;
+			op.dstType = dstAttr.baseType;
+			op.dstComponents = dstAttr.components;
+			op.byteSize = GetBaseTypeSize(dstAttr.baseType) * dstAttr.components;
+
+			for (uint32_t c = 0; c < 4; c++)
+				op.defaults[c] = GetAttrDefault(dstAttr.attrMap, c);
+
+			// find the matching source attribute
+			const BmVertAttr* srcAttr = nullptr;
+			uint32_t srcOffset = 0;
+			for (uint32_t s = 0; s < srcCount; s++)
+			{
+				if (srcAttrs[s].attrMap == dstAttr.attrMap)
+				{
+					srcAttr = &srcAttrs[s];
+					break;
+				}
+				srcOffset += GetBaseTypeSize(srcAttrs[s].baseType) * srcAttrs[s].components;
+			}
+
+			if (srcAttr == nullptr)
+			{
+				op.fromDefault = true;
+				op.srcType = dstAttr.baseType;
+				op.srcComponents = 0;
+				for (uint32_t c = 0; c < dstAttr.components && c < 4; c++)
+					WriteComponent(dstAttr.baseType, op.defaultData + c * GetBaseTypeSize(dstAttr.baseType), op.defaults[c]);
+				op.kernel = &ConvertFill;
+				identity = false;
+			}
+			else
+			{
+				op.srcOffset = srcOffset;
+				op.srcByteSize = GetBaseTypeSize(srcAttr->baseType) * srcAttr->components;
+				op.srcType = srcAttr->baseType;
+				op.srcComponents = srcAttr->components;
+				op.dequantize = op.srcType == BmBaseType::BoundsUnorm16 && op.dstType != BmBaseType::BoundsUnorm16;
+
+				// quantizing needs the bounds of the whole mesh which a per vertex conversion doesn't have
+				if (op.dstType == BmBaseType::BoundsUnorm16 && op.srcType != BmBaseType::BoundsUnorm16)
+				{
+					bmdl::BmSetLastError("BoundsUnorm16 attributes can only be read from BoundsUnorm16 data");
+					valid = false;
+					return false;
+				}
+
+				op.kernel = SelectKernel(op);
+
+				if (op.srcOffset != op.dstOffset || op.srcType != op.dstType || op.srcComponents != op.dstComponents)
+					identity = false;
+			}
+
+			ops.push_back(op);
+			dstOffset += op.byteSize;
+		}
+
+		// zero any padding at the end of the destination vertex
+		if (dstOffset < dstStride)
+		{
+			BmAttrConversion pad;
+			memset(&pad, 0, sizeof(pad));
+			pad.dstOffset = dstOffset;
+			pad.byteSize = dstStride - dstOffset;
+			pad.kernel = &ConvertZero;
+			ops.push_back(pad);
+			identity = false;
+		}
+
+		valid = true;
+		return true;
+	}
+
+	// convert count vertices from src in to dst, processed in tiles so each op works on data still in cache.
+	// planar data stores each attribute as its own contiguous array, one after the other in attribute order,
+	// so an attribute's array starts at its interleaved offset * count.
+	// bounds maps BoundsUnorm16 source attributes back to their original range, nullptr leaves them as unorm
+	void Convert(const uint8_t* src, uint8_t* dst, uint32_t count, bool srcPlanar = false, bool dstPlanar = false, const BmAttrBounds* bounds = nullptr) const
+	{
+		const uint32_t tileSize = 256;
+
+		for (uint32_t base = 0; base < count; base += tileSize)
+		{
+			uint32_t tileCount = (count - base) < tileSize ? (count - base) : tileSize;
+
+			for (const BmAttrConversion& op : ops)
+			{
+				const uint8_t* opSrc = srcPlanar ?
+					src + static_cast<size_t>(op.srcOffset) * count + static_cast<size_t>(base) * op.srcByteSize :
+					src + static_cast<size_t>(base) * srcStride + op.srcOffset;
+
+				uint8_t* opDst = dstPlanar ?
+					dst + static_cast<size_t>(op.dstOffset) * count + static_cast<size_t>(base) * op.byteSize :
+					dst + static_cast<size_t>(base) * dstStride + op.dstOffset;
+
+				op.kernel(op, opSrc, srcPlanar ? op.srcByteSize : srcStride, opDst, dstPlanar ? op.byteSize : dstStride, tileCount);
+
+				if (op.dequantize && bounds != nullptr)
+					ScaleToBounds(op, *bounds, opDst, dstPlanar ? op.byteSize : dstStride, tileCount);
+			}
+		}
+	}
+
+	// true when source and destination vertices are byte for byte the same
+	bool IsIdentity() const { return identity; }
+	bool IsValid() const { return valid; }
+
+	uint32_t GetSourceStride() const { return srcStride; }
+	uint32_t GetDestinationStride() const { return dstStride; }
+
+private:
+
+	static BmConvertKernel SelectKernel(const BmAttrConversion& op)
+	{
+		if (op.srcType == op.dstType && op.srcComponents >= op.dstComponents)
+			return &ConvertCopy; // same type, extra source components are dropped
+
+		if (IsOctahedralType(op.srcType))
+		{
+		#if defined(BM_SIMD_SSE2)
+			if (op.dstType == BmBaseType::Float && op.dstComponents == 3)
+				return &ConvertOctahedralToFloat;
+		#endif
+			return &ConvertFromOctahedral;
+		}
+
+		if (IsOctahedralType(op.dstType))
+			return &ConvertToOctahedral;
+
+	#if defined(BM_SIMD_SSE2)
+		if (op.dstType == BmBaseType::Float && op.srcComponents == op.dstComponents && op.dstComponents <= 4)
+		{
+			switch (op.srcType)
+			{
+				case BmBaseType::Uint8:		return &ConvertUnorm8ToFloat;
+				case BmBaseType::Int8:		return &ConvertSnorm8ToFloat;
+				case BmBaseType::BoundsUnorm16:
+				case BmBaseType::UInt16:	return &ConvertUnorm16ToFloat;
+				case BmBaseType::Int16:		return &ConvertSnorm16ToFloat;
+				case BmBaseType::Half:		return &ConvertHalfToFloat;
+				default: break;
+			}
+		}
+
+		if (op.srcType == BmBaseType::Float && op.dstType == BmBaseType::Uint8 && op.srcComponents == 4 && op.dstComponents == 4)
+			return &ConvertFloatToUnorm8;
+	#endif
+
+		return &ConvertGeneric;
+	}
+
+	std::vector<BmAttrConversion> ops;
+
+	uint32_t	srcStride;
+	uint32_t	dstStride;
+	bool		identity;
+	bool		valid;
+};
+
+namespace bmdl
+{
+	// returns the conversion plan for a pair of attribute lists, plans are built the first time a pair
+	// is seen and reused for every later mesh. safe to call from multiple loader threads
+	inline const BmVertConversionPlan* GetConversionPlan(const BmVertAttr* srcAttrs, uint32_t srcCount, const BmVertAttr* dstAttrs, uint32_t dstCount, uint32_t dstStride)
+	{
+		static std::mutex cacheMutex;
+		static std::map<std::string, std::unique_ptr<BmVertConversionPlan>> planCache;
+
+		// key on the raw attribute descriptions of both layouts
+		std::string key;
+		key.reserve(sizeof(uint32_t) * 3 + sizeof(BmVertAttr) * (srcCount + dstCount));
+		key.append(reinterpret_cast<const char*>(&srcCount), sizeof(srcCount));
+		key.append(reinterpret_cast<const char*>(&dstCount), sizeof(dstCount));
+		key.append(reinterpret_cast<const char*>(&dstStride), sizeof(dstStride));
+		key.append(reinterpret_cast<const char*>(srcAttrs), sizeof(BmVertAttr) * srcCount);
+		key.append(reinterpret_cast<const char*>(dstAttrs), sizeof(BmVertAttr) * dstCount);
+
+		std::lock_guard<std::mutex> lock(cacheMutex);
+
+		std::unique_ptr<BmVertConversionPlan>& plan = planCache[key];
+		if (!plan)
+		{
+			plan.reset(new BmVertConversionPlan());
+			plan->Build(srcAttrs, srcCount, dstAttrs, dstCount, dstStride);
+		}
+
+		return plan->IsValid() ? plan.get() : nullptr;
+	}
+}
+
+// =================================
+
+// =================================
+// Basic Model : Index Conversion
+// Widens or narrows index data between 8, 16 and 32 bit. Narrowing keeps the low bits
+// so callers must check the largest index fits the destination first (see GetMaxIndex).
+// =================================
+
+static inline BmIndexType GetSmallestIndexType(uint32_t maxIndex)
+{
+	if (maxIndex <= UINT8_MAX)	return BmIndexType::UInt8;
+	if (maxIndex <= UINT16_MAX)	return BmIndexType::UInt16;
+	return BmIndexType::UInt32;
+}
+
+static inline uint32_t ReadIndex(const uint8_t* src, uint32_t indexSize, uint32_t i)
+{
+	switch (indexSize)
+	{
+		case 1:		return src[i];
+		case 2:		{ uint16_t v; memcpy(&v, src + i * 2, 2); return v; }
+		default:	{ uint32_t v; memcpy(&v, src + i * 4, 4); return v; }
+	}
+}
+
+static inline void WriteIndex(uint8_t* dst, uint32_t indexSize, uint32_t i, uint32_t value)
+{
+	switch (indexSize)
+	{
+		case 1:		dst[i] = static_cast<uint8_t>(value); break;
+		case 2:		{ uint16_t v = static_cast<uint16_t>(value); memcpy(dst + i * 2, &v, 2); } break;
+		default:	memcpy(dst + i * 4, &value, 4); break;
+	}
+}
+
+// largest index value in an index buffer of indexSize byte indices
+static uint32_t GetMaxIndex(const uint8_t* src, uint32_t indexSize, uint32_t count)
+{
+	uint32_t maxIndex = 0;
+	uint32_t i = 0;
+
+#if defined(BM_SIMD_SSE2)
+	uint32_t perVector = 16 / indexSize;
+	if (count >= perVector)
+	{
+		__m128i maxVec = _mm_setzero_si128();
+		const __m128i bias16 = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+		const __m128i bias32 = _mm_set1_epi32(static_cast<int32_t>(0x80000000));
+
+		if (indexSize == 2)
+			maxVec = bias16;
+		else if (indexSize == 4)
+			maxVec = bias32;
+
+		for (; i + perVector <= count; i += perVector)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * indexSize));
+
+			switch (indexSize)
+			{
+				case 1:	maxVec = _mm_max_epu8(maxVec, v); break;
+				// SSE2 only has signed 16/32 bit compares, bias the values in to signed range first
+				case 2:	maxVec = _mm_max_epi16(maxVec, _mm_xor_si128(v, bias16)); break;
+				default:
+				{
+					__m128i biased = _mm_xor_si128(v, bias32);
+					__m128i greater = _mm_cmpgt_epi32(biased, maxVec);
+					maxVec = _mm_or_si128(_mm_and_si128(greater, biased), _mm_andnot_si128(greater, maxVec));
+				}
+				break;
+			}
+		}
+
+		if (indexSize == 2)
+			maxVec = _mm_xor_si128(maxVec, bias16);
+		else if (indexSize == 4)
+			maxVec = _mm_xor_si128(maxVec, bias32);
+
+		uint8_t lanes[16];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), maxVec);
+		for (uint32_t l = 0; l < perVector; l++)
+		{
+			uint32_t value = ReadIndex(lanes, indexSize, l);
+			maxIndex = value > maxIndex ? value : maxIndex;
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		uint32_t value = ReadIndex(src, indexSize, i);
+		maxIndex = value > maxIndex ? value : maxIndex;
+	}
+
+	return maxIndex;
+}
+
+// converts count indices of srcSize bytes in to indices of dstSize bytes
+static void ConvertIndices(const uint8_t* src, uint32_t srcSize, uint8_t* dst, uint32_t dstSize, uint32_t count)
+{
+	if (srcSize == dstSize)
+	{
+		memcpy(dst, src, static_cast<size_t>(count) * srcSize);
+		return;
+	}
+
+	uint32_t i = 0;
+
+#if defined(BM_SIMD_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+
+	if (srcSize == 1 && dstSize == 2)
+	{
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_unpacklo_epi8(v, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2 + 16), _mm_unpackhi_epi8(v, zero));
+		}
+	}
+	else if (srcSize == 1 && dstSize == 4)
+	{
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			__m128i lo = _mm_unpacklo_epi8(v, zero);
+			__m128i hi = _mm_unpackhi_epi8(v, zero);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(lo, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_unpackhi_epi16(lo, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 32), _mm_unpacklo_epi16(hi, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 48), _mm_unpackhi_epi16(hi, zero));
+		}
+	}
+	else if (srcSize == 2 && dstSize == 4)
+	{
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_unpacklo_epi16(v, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4 + 16), _mm_unpackhi_epi16(v, zero));
+		}
+	}
+	else if (srcSize == 2 && dstSize == 1)
+	{
+		const __m128i lowByte = _mm_set1_epi16(0xFF);
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2)), lowByte);
+			__m128i b = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 2 + 16)), lowByte);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(a, b));
+		}
+	}
+	else if (srcSize == 4 && dstSize == 2)
+	{
+		// sign extend the low 16 bits so the signed saturating pack passes them through unchanged
+		for (; i + 8 <= count; i += 8)
+		{
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16));
+			a = _mm_srai_epi32(_mm_slli_epi32(a, 16), 16);
+			b = _mm_srai_epi32(_mm_slli_epi32(b, 16), 16);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 2), _mm_packs_epi32(a, b));
+		}
+	}
+	else if (srcSize == 4 && dstSize == 1)
+	{
+		const __m128i lowByte = _mm_set1_epi32(0xFF);
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i a = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4)), lowByte);
+			__m128i b = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 16)), lowByte);
+			__m128i c = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 32)), lowByte);
+			__m128i d = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i * 4 + 48)), lowByte);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+		WriteIndex(dst, dstSize, i, ReadIndex(src, srcSize, i));
+}
+
+// =================================
@@ -0,0 +1,334 @@
+#pragma once
+
+#include "bmdl.h"
+
+#include <string.h>
+
+#include <vector>
+
+// =================================
+// Basic Model : Draw Lists
+// Gathers the submeshes of many models in to one list sorted by material and then by mesh, so a
+// renderer changes material state once per material rather than once per submesh. Sorting is a least
+// significant digit radix sort over the material, mesh and first index of each submesh a byte at a time,
+// skipping the bytes every submesh shares. Submeshes of the same mesh and material whose indices follow
+// each other are then merged in to a single draw.
+//
+// Lists hold the index ranges as they are when built, rebuild them after anything changes the
+// submeshes, such as a BmProgressiveLoader refining its model.
+//
+// For multi draw indirect the meshes of the same models are placed one after another in a single vertex
+// and a single index buffer (BmBufferLayout), and each draw becomes a BmDrawIndirectCommand pointing in to
+// them. Indices stay relative to their mesh, the command adds the first vertex of the mesh as base vertex,
+// so 16 bit indices keep working however many vertices the buffers hold. Every batch of the list is then
+// one glMultiDrawElementsIndirect call, or ExecuteIndirect with D3D12_DRAW_INDEXED_ARGUMENTS.
+// =================================
+
+namespace bmdl
+{
+	// a range of indices of one mesh drawn with one material
+	struct BmDraw
+	{
+		uint32_t	model;			// in the models the list was built from
+		uint32_t	mesh;			// in the meshList of the model
+		uint32_t	indexOffset;
+		uint32_t	indexCount;
+		uint16_t	materialID;
+	};
+
+	// draws sharing a material, each batch is one material state change
+	struct BmDrawBatch
+	{
+		uint16_t	materialID;
+		uint32_t	drawOffset;		// in BmDrawList::draws
+		uint32_t	drawCount;
+	};
+
+	struct BmDrawList
+	{
+		BmDrawList() : subMeshCount(0) {}
+
+		std::vector<BmDraw>			draws;
+		std::vector<BmDrawBatch>	batches;
+		uint32_t					subMeshCount;	// ranges gathered before merging
+	};
+
+	// =================================
+	// Radix Sort
+	// =================================
+
+	// 10 byte sort key, first index in the low 4 bytes, then the mesh numbered across every model, then the material
+	struct BmDrawSortKey
+	{
+		uint32_t indexOffset;
+		uint32_t mesh;
+		uint16_t materialID;
+	};
+
+	static const uint32_t BmDrawSortKeyBytes = 10;
+
+	static inline uint32_t GetDrawSortKeyByte(const BmDrawSortKey& key, uint32_t byte)
+	{
+		if (byte < 4)
+			return (key.indexOffset >> (byte * 8)) & 0xFF;
+		if (byte < 8)
+			return (key.mesh >> ((byte - 4) * 8)) & 0xFF;
+		return (key.materialID >> ((byte - 8) * 8)) & 0xFF;
+	}
+
+	// fills order with the positions of keys in sorted order. the counts of every byte are gathered in one
+	// pass, bytes where all keys fall in the same bucket need no pass of their own
+	static void RadixSortDrawKeys(const std::vector<BmDrawSortKey>& keys, std::vector<uint32_t>& order)
+	{
+		uint32_t keyCount = static_cast<uint32_t>(keys.size());
+		order.resize(keyCount);
+		for (uint32_t k = 0; k < keyCount; k++)
+			order[k] = k;
+		if (keyCount < 2)
+			return;
+
+		std::vector<uint32_t> counts(BmDrawSortKeyBytes * 256, 0);
+		for (const BmDrawSortKey& key : keys)
+		{
+			for (uint32_t b = 0; b < BmDrawSortKeyBytes; b++)
+				counts[b * 256 + GetDrawSortKeyByte(key, b)]++;
+		}
+
+		std::vector<uint32_t> sorted(keyCount);
+		for (uint32_t b = 0; b < BmDrawSortKeyBytes; b++)
+		{
+			uint32_t* byteCounts = &counts[b * 256];
+			if (byteCounts[GetDrawSortKeyByte(keys[0], b)] == keyCount)
+				continue;
+
+			uint32_t start = 0;
+			for (uint32_t d = 0; d < 256; d++)
+			{
+				uint32_t count = byteCounts[d];
+				byteCounts[d] = start;
+				start += count;
+			}
+
+			for (uint32_t k = 0; k < keyCount; k++)
+				sorted[byteCounts[GetDrawSortKeyByte(keys[order[k]], b)]++] = order[k];
+			order.swap(sorted);
+		}
+	}
+
+	// =================================
+	// Draw Lists
+	// =================================
+
+	// builds drawList from the submeshes of modelCount models, meshes without submeshes are drawn whole with
+	// material 0. null models, empty submeshes and submeshes reaching past the indices of their mesh are left out
+	template<typename V, typename I>
+	BM_FUNC_DECL void BuildDrawList(const BmModel<V, I>* const* models, uint32_t modelCount, BmDrawList& drawList)
+	{
+		std::vector<BmDraw> draws;
+		std::vector<BmDrawSortKey> keys;
+		uint32_t meshNumber = 0;
+
+		for (uint32_t m = 0; m < modelCount; m++)
+		{
+			if (models[m] == nullptr)
+				continue;
+
+			const BmModel<V, I>& model = *models[m];
+			for (uint32_t n = 0; n < model.meshList.count; n++, meshNumber++)
+			{
+				const BmMesh<V, I>& mesh = model.meshList[n];
+				uint32_t indexCount = mesh.indices.count > 0 ? mesh.indices.count : mesh.compactIndices.count / GetIndexTypeSize(static_cast<uint8_t>(mesh.compactIndexType));
+
+				if (mesh.subMeshList.count == 0)
+				{
+					if (indexCount > 0)
+					{
+						draws.push_back(BmDraw{ m, n, 0, indexCount, 0 });
+						keys.push_back(BmDrawSortKey{ 0, meshNumber, 0 });
+					}
+					continue;
+				}
+
+				for (uint32_t s = 0; s < mesh.subMeshList.count; s++)
+				{
+					const BmSubMesh& subMesh = mesh.subMeshList[s];
+					if (subMesh.indexCount == 0 || static_cast<uint64_t>(subMesh.indexOffset) + subMesh.indexCount > indexCount)
+						continue;
+
+					draws.push_back(BmDraw{ m, n, subMesh.indexOffset, subMesh.indexCount, subMesh.materialID });
+					keys.push_back(BmDrawSortKey{ subMesh.indexOffset, meshNumber, subMesh.materialID });
+				}
+			}
+		}
+
+		std::vector<uint32_t> order;
+		RadixSortDrawKeys(keys, order);
+
+		drawList.subMeshCount = static_cast<uint32_t>(draws.size());
+		drawList.draws.clear();
+		drawList.batches.clear();
+		for (uint32_t k = 0; k < order.size(); k++)
+		{
+			const BmDraw& draw = draws[order[k]];
+
+			if (!drawList.draws.empty())
+			{
+				BmDraw& last = drawList.draws.back();
+				if (last.model == draw.model && last.mesh == draw.mesh && last.materialID == draw.materialID &&
+					last.indexOffset + last.indexCount == draw.indexOffset)
+				{
+					last.indexCount += draw.indexCount;
+					continue;
+				}
+			}
+
+			if (drawList.batches.empty() || drawList.batches.back().materialID != draw.materialID)
+				drawList.batches.push_back(BmDrawBatch{ draw.materialID, static_cast<uint32_t>(drawList.draws.size()), 0 });
+
+			drawList.batches.back().drawCount++;
+			drawList.draws.push_back(draw);
+		}
+
+		BM_LOG("Draw list of %u submeshes in %u draws and %u batches\n", drawList.subMeshCount,
+			static_cast<uint32_t>(drawList.draws.size()), static_cast<uint32_t>(drawList.batches.size()));
+	}
+
+	// =================================
+	// Combined Buffers
+	// =================================
+
+	struct BmBufferLayout
+	{
+		BmBufferLayout() : vertexCount(0), indexCount(0) {}
+
+		std::vector<uint32_t>			modelMeshes;	// first entry of meshes for each model
+		std::vector<BmMeshBufferRange>	meshes;			// every mesh of every model in order
+		uint32_t						vertexCount;	// of the whole vertex buffer
+		uint32_t						indexCount;		// of the whole index buffer
+	};
+
+	// places the meshes of modelCount models one after another in a vertex and an index buffer, null models
+	// have no meshes. fails when the buffers would need more than UINT32_MAX vertices or indices
+	template<typename V, typename I>
+	BM_FUNC_DECL bool BuildBufferLayout(const BmModel<V, I>* const* models, uint32_t modelCount, BmBufferLayout& layout)
+	{
+		layout.modelMeshes.assign(modelCount, 0);
+		layout.meshes.clear();
+
+		uint64_t vertexCount = 0;
+		uint64_t indexCount = 0;
+		for (uint32_t m = 0; m < modelCount; m++)
+		{
+			layout.modelMeshes[m] = static_cast<uint32_t>(layout.meshes.size());
+			if (models[m] == nullptr)
+				continue;
+
+			const BmModel<V, I>& model = *models[m];
+			for (uint32_t n = 0; n < model.meshList.count; n++)
+			{
+				const BmMesh<V, I>& mesh = model.meshList[n];
+				uint32_t meshVertices = mesh.streams.count > 0 ? mesh.streams[0].count : mesh.vertices.count;
+				uint32_t meshIndices = mesh.indices.count > 0 ? mesh.indices.count : mesh.compactIndices.count / GetIndexTypeSize(static_cast<uint8_t>(mesh.compactIndexType));
+
+				layout.meshes.push_back(BmMeshBufferRange{ static_cast<uint32_t>(vertexCount), meshVertices, static_cast<uint32_t>(indexCount), meshIndices });
+				vertexCount += meshVertices;
+				indexCount += meshIndices;
+			}
+
+			if (vertexCount > UINT32_MAX || indexCount > UINT32_MAX)
+			{
+				BmSetLastError("Models have too many vertices or indices for combined buffers");
+				return false;
+			}
+		}
+
+		layout.vertexCount = static_cast<uint32_t>(vertexCount);
+		layout.indexCount = static_cast<uint32_t>(indexCount);
+		return true;
+	}
+
+	// copies the meshes of the models the layout was built from in to vertices and indices, which hold
+	// layout.vertexCount and layout.indexCount entries. meshes must have interleaved vertices and their
+	// indices in I, as loaded without BmLoadFlags::CompactIndices
+	template<typename V, typename I>
+	BM_FUNC_DECL bool FillCombinedBuffers(const BmModel<V, I>* const* models, uint32_t modelCount, const BmBufferLayout& layout, V* vertices, I* indices)
+	{
+		if (layout.modelMeshes.size() != modelCount)
+		{
+			BmSetLastError("Buffer layout was built from a different set of models");
+			return false;
+		}
+
+		for (uint32_t m = 0; m < modelCount; m++)
+		{
+			if (models[m] == nullptr)
+				continue;
+
+			const BmModel<V, I>& model = *models[m];
+			for (uint32_t n = 0; n < model.meshList.count; n++)
+			{
+				const BmMesh<V, I>& mesh = model.meshList[n];
+				if (mesh.streams.count > 0 || mesh.compactIndices.count > 0)
+				{
+					BmSetLastError("Combined buffers need interleaved vertices and indices of the mesh index type");
+					return false;
+				}
+
+				uint64_t meshEntry = static_cast<uint64_t>(layout.modelMeshes[m]) + n;
+				if (meshEntry >= layout.meshes.size() || mesh.vertices.count != layout.meshes[meshEntry].vertexCount ||
+					mesh.indices.count != layout.meshes[meshEntry].indexCount)
+				{
+					BmSetLastError("Buffer layout was built from a different set of models");
+					return false;
+				}
+
+				const BmMeshBufferRange& range = layout.meshes[meshEntry];
+				if (range.vertexCount > 0)
+					memcpy(vertices + range.firstVertex, mesh.vertices.data, static_cast<size_t>(range.vertexCount) * sizeof(V));
+				if (range.indexCount > 0)
+					memcpy(indices + range.firstIndex, mesh.indices.data, static_cast<size_t>(range.indexCount) * sizeof(I));
+			}
+		}
+
+		return true;
+	}
+
+	// =================================
+	// Indirect Commands
+	// =================================
+
+	// laid out like DrawElementsIndirectCommand of glMultiDrawElementsIndirect and D3D12_DRAW_INDEXED_ARGUMENTS
+	struct BmDrawIndirectCommand
+	{
+		uint32_t	indexCount;
+		uint32_t	instanceCount;
+		uint32_t	firstIndex;
+		int32_t		baseVertex;
+		uint32_t	baseInstance;
+	};
+
+	// fills commands with one command per draw of drawList, in the same order so each batch is the range of
+	// commands from its drawOffset. drawList and layout must be built from the same models. baseInstance holds
+	// the number of the draw, for shaders to find per draw data such as the transform of its model
+	inline bool BuildIndirectCommands(const BmDrawList& drawList, const BmBufferLayout& layout, std::vector<BmDrawIndirectCommand>& commands)
+	{
+		commands.resize(drawList.draws.size());
+		for (uint32_t d = 0; d < drawList.draws.size(); d++)
+		{
+			const BmDraw& draw = drawList.draws[d];
+			uint64_t meshEntry = draw.model < layout.modelMeshes.size() ? static_cast<uint64_t>(layout.modelMeshes[draw.model]) + draw.mesh : UINT64_MAX;
+			if (meshEntry >= layout.meshes.size() || static_cast<uint64_t>(draw.indexOffset) + draw.indexCount > layout.meshes[meshEntry].indexCount ||
+				layout.meshes[meshEntry].firstVertex > INT32_MAX)
+			{
+				BmSetLastError("Draw is outside the buffer layout");
+				commands.clear();
+				return false;
+			}
+
+			const BmMeshBufferRange& range = layout.meshes[meshEntry];
+			commands[d] = BmDrawIndirectCommand{ draw.indexCount, 1, range.firstIndex + draw.indexOffset, static_cast<int32_t>(range.firstVertex), d };
+		}
+
+		return true;
+	}
+}
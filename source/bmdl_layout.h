@@ -0,0 +1,316 @@
+#pragma once
+
+#include "bmdl_common.h"
+#include "bmdl_util.h"
+#include "bmdl_convert.h"
+
+#include <cstddef>
+#include <type_traits>
+
+// =================================
+// Basic Model : Static Vertex Layouts
+// Compile time counterpart of BM_CREATE_LAYOUT. A BmStaticLayout lists its attributes as template
+// arguments so offsets, strides and the conversion between two layouts are resolved by the compiler,
+// converting a vertex becomes a fixed sequence of loads and stores with no per-attribute dispatch.
+//
+// typedef BmStaticLayout<
+//		BmStaticAttr<BmBaseType::Float, 3, BmAttrMap::Position>,
+//		BmStaticAttr<BmBaseType::Float, 2, BmAttrMap::TexCoord1>> MyLayout;
+//
+// BM_STATIC_VERT_READER(MyVert, MyLayout, PackedLayout) compiles a reader from PackedLayout in to
+// MyVert which the loader uses whenever a file stores that layout. Files with any other layout
+// go through the runtime conversion plan as before.
+// =================================
+
+template<BmBaseType Type> struct BmBaseTypeInfo;
+
+#define BM_BASE_TYPE_INFO(type, ctype)	\
+	template<> struct BmBaseTypeInfo<type> { typedef ctype Type; static const uint32_t size = sizeof(ctype); };
+
+BM_BASE_TYPE_INFO(BmBaseType::Int8,		int8_t)
+BM_BASE_TYPE_INFO(BmBaseType::Uint8,	uint8_t)
+BM_BASE_TYPE_INFO(BmBaseType::Int16,	int16_t)
+BM_BASE_TYPE_INFO(BmBaseType::UInt16,	uint16_t)
+BM_BASE_TYPE_INFO(BmBaseType::Int32,	int32_t)
+BM_BASE_TYPE_INFO(BmBaseType::UInt32,	uint32_t)
+BM_BASE_TYPE_INFO(BmBaseType::Int64,	int64_t)
+BM_BASE_TYPE_INFO(BmBaseType::Uint64,	uint64_t)
+BM_BASE_TYPE_INFO(BmBaseType::Float,	float)
+BM_BASE_TYPE_INFO(BmBaseType::Double,	double)
+BM_BASE_TYPE_INFO(BmBaseType::Half,		uint16_t)
+
+#undef BM_BASE_TYPE_INFO
+
+template<BmBaseType Type, uint8_t Components, BmAttrMap Mapping>
+struct BmStaticAttr
+{
+	static_assert(Components >= 1 && Components <= 4, "vertex attributes have 1 to 4 components");
+
+	static const BmBaseType	baseType = Type;
+	static const uint8_t	components = Components;
+	static const BmAttrMap	attrMap = Mapping;
+
+	static const uint32_t	componentSize = BmBaseTypeInfo<Type>::size;
+	static const uint32_t	size = componentSize * Components;
+};
+
+// stands in for an attribute the source layout doesn't have, every component reads as its default
+template<BmAttrMap Mapping>
+struct BmStaticMissingAttr
+{
+	static const BmBaseType	baseType = BmBaseType::None;
+	static const uint8_t	components = 0;
+	static const BmAttrMap	attrMap = Mapping;
+
+	static const uint32_t	componentSize = 0;
+	static const uint32_t	size = 0;
+};
+
+// =================================
+// Compile time conversion
+// =================================
+
+// component C of Dst, converted from Src or set to the attribute default when Src has fewer components
+template<typename Src, typename Dst, uint32_t C, bool InSource = (C < Src::components)>
+struct BmStaticComponent
+{
+	static BM_FORCE_INLINE void Convert(const uint8_t* src, uint8_t* dst)
+	{
+		WriteComponent(Dst::baseType, dst + C * Dst::componentSize, ReadComponent(Src::baseType, src + C * Src::componentSize));
+	}
+};
+
+template<typename Src, typename Dst, uint32_t C>
+struct BmStaticComponent<Src, Dst, C, false>
+{
+	static BM_FORCE_INLINE void Convert(const uint8_t* src, uint8_t* dst)
+	{
+		WriteComponent(Dst::baseType, dst + C * Dst::componentSize, GetAttrDefault(Dst::attrMap, C));
+	}
+};
+
+template<typename Src, typename Dst, uint32_t C, uint32_t N>
+struct BmStaticComponents
+{
+	static BM_FORCE_INLINE void Convert(const uint8_t* src, uint8_t* dst)
+	{
+		BmStaticComponent<Src, Dst, C>::Convert(src, dst);
+		BmStaticComponents<Src, Dst, C + 1, N>::Convert(src, dst);
+	}
+};
+
+template<typename Src, typename Dst, uint32_t N>
+struct BmStaticComponents<Src, Dst, N, N>
+{
+	static BM_FORCE_INLINE void Convert(const uint8_t*, uint8_t*) {}
+};
+
+// matching type and component count is a fixed size copy, anything else goes component by component
+template<typename Src, typename Dst, bool Copy = (Src::baseType == Dst::baseType && Src::components == Dst::components)>
+struct BmStaticAttrConvert
+{
+	static BM_FORCE_INLINE void Convert(const uint8_t* src, uint8_t* dst)
+	{
+		BmStaticComponents<Src, Dst, 0, Dst::components>::Convert(src, dst);
+	}
+};
+
+template<typename Src, typename Dst>
+struct BmStaticAttrConvert<Src, Dst, true>
+{
+	static BM_FORCE_INLINE void Convert(const uint8_t* src, uint8_t* dst)
+	{
+		memcpy(dst, src, Dst::size);
+	}
+};
+
+// locates the attribute mapped to Mapping, Offset is the byte offset of the first attribute in the list
+template<BmAttrMap Mapping, uint32_t Offset, typename... Attrs>
+struct BmStaticFind
+{
+	typedef BmStaticMissingAttr<Mapping> Attr;
+	static const bool		found = false;
+	static const uint32_t	offset = 0;
+};
+
+template<typename A, uint32_t Offset>
+struct BmStaticFound
+{
+	typedef A Attr;
+	static const bool		found = true;
+	static const uint32_t	offset = Offset;
+};
+
+template<BmAttrMap Mapping, uint32_t Offset, typename First, typename... Rest>
+struct BmStaticFind<Mapping, Offset, First, Rest...> :
+	std::conditional<First::attrMap == Mapping, BmStaticFound<First, Offset>, BmStaticFind<Mapping, Offset + First::size, Rest...>>::type
+{
+};
+
+template<typename... Attrs>
+struct BmStaticStride { static const uint32_t value = 0; };
+
+template<typename First, typename... Rest>
+struct BmStaticStride<First, Rest...> { static const uint32_t value = First::size + BmStaticStride<Rest...>::value; };
+
+// writes every attribute of one destination vertex, reading each from wherever SrcLayout stores it
+template<typename SrcLayout, uint32_t DstOffset, typename... DstAttrs>
+struct BmStaticVertConvert
+{
+	static BM_FORCE_INLINE void Convert(const uint8_t*, uint8_t*) {}
+};
+
+template<typename SrcLayout, uint32_t DstOffset, typename First, typename... Rest>
+struct BmStaticVertConvert<SrcLayout, DstOffset, First, Rest...>
+{
+	typedef typename SrcLayout::template Find<First::attrMap> Source;
+
+	static BM_FORCE_INLINE void Convert(const uint8_t* src, uint8_t* dst)
+	{
+		BmStaticAttrConvert<typename Source::Attr, First>::Convert(src + Source::offset, dst + DstOffset);
+		BmStaticVertConvert<SrcLayout, DstOffset + First::size, Rest...>::Convert(src, dst);
+	}
+};
+
+// =================================
+// Static Layout
+// =================================
+
+template<typename... Attrs>
+struct BmStaticLayout
+{
+	static_assert(sizeof...(Attrs) > 0 && sizeof...(Attrs) <= MAX_VERTEX_ATTRIBS, "static layouts hold 1 to MAX_VERTEX_ATTRIBS attributes");
+
+	static const uint32_t attributeCount = sizeof...(Attrs);
+	static const uint32_t stride = BmStaticStride<Attrs...>::value;
+
+	template<BmAttrMap Mapping>
+	struct Find : BmStaticFind<Mapping, 0, Attrs...> {};
+
+	// converts count interleaved vertices stored with SrcLayout in to this layout
+	template<typename SrcLayout>
+	static void ConvertFrom(const uint8_t* src, uint8_t* dst, uint32_t count)
+	{
+		for (uint32_t v = 0; v < count; v++, src += SrcLayout::stride, dst += stride)
+			BmStaticVertConvert<SrcLayout, 0, Attrs...>::Convert(src, dst);
+	}
+
+	// true if a runtime attribute list (a file's or a BmVertLayout's) describes this layout
+	static bool Matches(const BmVertAttr* attributes, uint32_t count)
+	{
+		if (count != attributeCount)
+			return false;
+
+		const BmVertAttr* expected = GetLayout().attributes;
+		for (uint32_t a = 0; a < count; a++)
+		{
+			if (attributes[a].baseType != expected[a].baseType || attributes[a].components != expected[a].components || attributes[a].attrMap != expected[a].attrMap)
+				return false;
+		}
+
+		return true;
+	}
+
+	// runtime description for the paths that only take a BmVertLayout
+	static const BmVertLayout& GetLayout()
+	{
+		static const BmVertLayout layout = CreateLayout();
+		return layout;
+	}
+
+private:
+
+	static BmVertLayout CreateLayout()
+	{
+		BmVertLayout layout;
+		BmVertAttr attributes[] = { BmVertAttr(Attrs::baseType, Attrs::components, Attrs::attrMap)... };
+
+		layout.attributeCount = static_cast<uint8_t>(attributeCount);
+		for (uint32_t a = 0; a < attributeCount; a++)
+			layout.attributes[a] = attributes[a];
+
+		return layout;
+	}
+};
+
+template<typename Layout, BmAttrMap Mapping>
+struct BmStaticLayoutFind : Layout::template Find<Mapping> {};
+
+// fails to compile if member of V is not where Layout puts the attribute mapped to mapping
+#define BM_CHECK_VERT_ATTR(V, member, Layout, mapping)										\
+	static_assert(BmStaticLayoutFind<Layout, mapping>::found &&								\
+		offsetof(V, member) == BmStaticLayoutFind<Layout, mapping>::offset,					\
+		#V "::" #member " does not match the " #mapping " attribute of " #Layout);
+
+typedef BmStaticLayout<
+	BmStaticAttr<BmBaseType::Float, 3, BmAttrMap::Position>,
+	BmStaticAttr<BmBaseType::Float, 2, BmAttrMap::TexCoord1>,
+	BmStaticAttr<BmBaseType::Float, 3, BmAttrMap::Normal>,
+	BmStaticAttr<BmBaseType::Uint8, 4, BmAttrMap::Color32_1>> BmDefaultStaticLayout;
+
+static_assert(sizeof(BmVert) == BmDefaultStaticLayout::stride, "BmVert does not match BmDefaultStaticLayout");
+BM_CHECK_VERT_ATTR(BmVert, position, BmDefaultStaticLayout, BmAttrMap::Position)
+BM_CHECK_VERT_ATTR(BmVert, texCoord, BmDefaultStaticLayout, BmAttrMap::TexCoord1)
+BM_CHECK_VERT_ATTR(BmVert, normal, BmDefaultStaticLayout, BmAttrMap::Normal)
+BM_CHECK_VERT_ATTR(BmVert, color, BmDefaultStaticLayout, BmAttrMap::Color32_1)
+
+// =================================
+// Static Vertex Readers
+// =================================
+
+// compiled reader used by the loader for vertices of type V, registered with BM_STATIC_VERT_READER.
+// Read returns false when no compiled reader handles the file's layout and the runtime path is used
+template<typename V>
+struct BmStaticVertReader
+{
+	static bool Read(const BmVertLayout*, const BmVertAttr*, uint32_t, const uint8_t*, uint32_t, BmList<V>&) { return false; }
+};
+
+template<typename V, typename DstLayout, typename... SrcLayouts>
+struct BmStaticTryRead
+{
+	static bool Read(const BmVertAttr*, uint32_t, const uint8_t*, uint32_t, BmList<V>&) { return false; }
+};
+
+template<typename V, typename DstLayout, typename SrcLayout, typename... Rest>
+struct BmStaticTryRead<V, DstLayout, SrcLayout, Rest...>
+{
+	static bool Read(const BmVertAttr* fileAttrs, uint32_t fileAttrCount, const uint8_t* src, uint32_t count, BmList<V>& vertices)
+	{
+		if (!SrcLayout::Matches(fileAttrs, fileAttrCount))
+			return BmStaticTryRead<V, DstLayout, Rest...>::Read(fileAttrs, fileAttrCount, src, count, vertices);
+
+		vertices.reserve(count);
+		vertices.count = count;
+		DstLayout::template ConvertFrom<SrcLayout>(src, reinterpret_cast<uint8_t*>(vertices.data), count);
+
+		return true;
+	}
+};
+
+template<typename V, typename DstLayout, typename... SrcLayouts>
+struct BmStaticVertReaderImpl
+{
+	static_assert(sizeof(V) == DstLayout::stride, "vertex struct size does not match its static layout");
+	static_assert(sizeof...(SrcLayouts) > 0, "a static vertex reader needs at least one source layout");
+
+	// only used when the caller asked for DstLayout, files already stored as DstLayout are left
+	// to the loader so they can still be referenced in place
+	static bool Read(const BmVertLayout* vertLayout, const BmVertAttr* fileAttrs, uint32_t fileAttrCount, const uint8_t* src, uint32_t count, BmList<V>& vertices)
+	{
+		if (vertLayout != nullptr && !DstLayout::Matches(vertLayout->attributes, vertLayout->attributeCount))
+			return false;
+
+		if (DstLayout::Matches(fileAttrs, fileAttrCount))
+			return false;
+
+		return BmStaticTryRead<V, DstLayout, SrcLayouts...>::Read(fileAttrs, fileAttrCount, src, count, vertices);
+	}
+};
+
+// registers a compiled reader converting files stored with any of the source layouts in to V,
+// must appear at global scope before the first LoadModel<V> call
+#define BM_STATIC_VERT_READER(V, DstLayout, ...)	\
+	template<> struct BmStaticVertReader<V> : BmStaticVertReaderImpl<V, DstLayout, __VA_ARGS__> {};
+
+// =================================
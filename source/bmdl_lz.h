@@ -0,0 +1,277 @@
+#pragma once
+
+#include "bmdl_common.h"
+
+#include <vector>
+
+// =================================
+// Basic Model : Block Compression
+// General purpose LZ77 compression used by CompressedBlock, works on any block payload.
+//
+// The compressed form is a list of sequences in the LZ4 style. Each sequence starts with a token byte,
+// the high nibble is the literal count and the low nibble the match length minus BmLzMinMatch, a nibble
+// of 15 is continued by extra bytes that are added on until one is below 255. The literals follow,
+// then a 2 byte little endian offset back in to the output and the extra match length bytes.
+// The last sequence only holds literals and ends at the end of the input.
+//
+// Larger buffers are cut in to chunks that are compressed independently, so they can be decoded
+// in parallel and one at a time while streaming. A chunk that doesn't compress is stored as is,
+// recognised by its compressed size matching its uncompressed size.
+// =================================
+
+static const uint32_t BmLzMinMatch = 4;
+static const uint32_t BmLzMaxOffset = 65535;
+static const uint32_t BmLzHashBits = 14;
+static const uint32_t BmLzDefaultChunkSize = 256 * 1024;
+
+// matches are not started in the last BmLzMatchLimit bytes or extended in to the last BmLzEndLiterals,
+// keeping the end of every chunk as literals lets the decoder copy in whole words most of the time
+static const uint32_t BmLzMatchLimit = 12;
+static const uint32_t BmLzEndLiterals = 5;
+
+// largest compressed size of size bytes
+static inline uint32_t LzCompressBound(uint32_t size) { return size + size / 255 + 16; }
+
+static inline uint32_t LzRead32(const uint8_t* src) { uint32_t value; memcpy(&value, src, sizeof(value)); return value; }
+static inline uint32_t LzHash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - BmLzHashBits); }
+
+// =================================
+// Compression
+// =================================
+
+static inline uint8_t* LzWriteLength(uint8_t* dst, uint32_t length)
+{
+	for (; length >= 255; length -= 255)
+		*dst++ = 255;
+	*dst++ = static_cast<uint8_t>(length);
+	return dst;
+}
+
+static inline uint8_t* LzWriteSequence(uint8_t* dst, const uint8_t* literals, uint32_t literalCount, uint32_t offset, uint32_t matchLength)
+{
+	uint32_t matchCode = matchLength - BmLzMinMatch;
+
+	uint8_t* token = dst++;
+	*token = static_cast<uint8_t>((literalCount < 15 ? literalCount : 15) << 4);
+	if (literalCount >= 15)
+		dst = LzWriteLength(dst, literalCount - 15);
+
+	memcpy(dst, literals, literalCount);
+	dst += literalCount;
+
+	// the final sequence has no match
+	if (matchLength == 0)
+		return dst;
+
+	*dst++ = static_cast<uint8_t>(offset);
+	*dst++ = static_cast<uint8_t>(offset >> 8);
+
+	*token |= static_cast<uint8_t>(matchCode < 15 ? matchCode : 15);
+	if (matchCode >= 15)
+		dst = LzWriteLength(dst, matchCode - 15);
+
+	return dst;
+}
+
+// compresses srcSize bytes in to dst, which must hold LzCompressBound(srcSize) bytes. returns the compressed size
+static uint32_t LzCompress(const uint8_t* src, uint32_t srcSize, uint8_t* dst)
+{
+	std::vector<uint32_t> table(static_cast<size_t>(1) << BmLzHashBits, 0);
+
+	uint8_t* out = dst;
+	uint32_t anchor = 0;
+	uint32_t pos = 0;
+
+	if (srcSize > BmLzMatchLimit)
+	{
+		uint32_t searchEnd = srcSize - BmLzMatchLimit;
+		uint32_t matchEnd = srcSize - BmLzEndLiterals;
+
+		while (pos < searchEnd)
+		{
+			uint32_t sequence = LzRead32(src + pos);
+			uint32_t hash = LzHash(sequence);
+			uint32_t candidate = table[hash];
+			table[hash] = pos;
+
+			// empty slots hold 0, that is only a real match if the bytes agree
+			if (candidate >= pos || pos - candidate > BmLzMaxOffset || LzRead32(src + candidate) != sequence)
+			{
+				// step further the longer nothing matched so incompressible data is skipped quickly
+				pos += 1 + ((pos - anchor) >> 6);
+				continue;
+			}
+
+			// extend the match back over the pending literals, then forward
+			while (pos > anchor && candidate > 0 && src[pos - 1] == src[candidate - 1])
+			{
+				pos--;
+				candidate--;
+			}
+
+			uint32_t length = BmLzMinMatch;
+			while (pos + length < matchEnd && src[candidate + length] == src[pos + length])
+				length++;
+
+			out = LzWriteSequence(out, src + anchor, pos - anchor, pos - candidate, length);
+
+			pos += length;
+			anchor = pos;
+
+			if (pos - 2 < searchEnd)
+				table[LzHash(LzRead32(src + pos - 2))] = pos - 2;
+		}
+	}
+
+	out = LzWriteSequence(out, src + anchor, srcSize - anchor, 0, 0);
+
+	return static_cast<uint32_t>(out - dst);
+}
+
+// =================================
+// Decompression
+// =================================
+
+static inline bool LzReadLength(const uint8_t*& src, const uint8_t* srcEnd, uint32_t& length)
+{
+	uint8_t extra;
+	do
+	{
+		if (src == srcEnd)
+			return false;
+		extra = *src++;
+		length += extra;
+	} while (extra == 255);
+
+	return true;
+}
+
+// decompresses src in to exactly dstSize bytes at dst, returns false if src is corrupt or doesn't decode to dstSize bytes
+static bool LzDecompress(const uint8_t* src, uint32_t srcSize, uint8_t* dst, uint32_t dstSize)
+{
+	const uint8_t* srcEnd = src + srcSize;
+	uint8_t* out = dst;
+	uint8_t* outEnd = dst + dstSize;
+
+	for (;;)
+	{
+		if (src == srcEnd)
+			return false;
+
+		uint8_t token = *src++;
+
+		uint32_t literalCount = token >> 4;
+		if (literalCount == 15 && !LzReadLength(src, srcEnd, literalCount))
+			return false;
+
+		if (literalCount > static_cast<size_t>(srcEnd - src) || literalCount > static_cast<size_t>(outEnd - out))
+			return false;
+
+		// short runs are copied as a whole 16 bytes when both buffers have the room
+		if (literalCount <= 16 && srcEnd - src >= 16 && outEnd - out >= 16)
+			memcpy(out, src, 16);
+		else
+			memcpy(out, src, literalCount);
+
+		src += literalCount;
+		out += literalCount;
+
+		if (src == srcEnd)
+			return out == outEnd;
+
+		if (srcEnd - src < 2)
+			return false;
+
+		uint32_t offset = src[0] | (src[1] << 8);
+		src += 2;
+
+		if (offset == 0 || offset > static_cast<size_t>(out - dst))
+			return false;
+
+		uint32_t length = (token & 15) + BmLzMinMatch;
+		if ((token & 15) == 15 && !LzReadLength(src, srcEnd, length))
+			return false;
+
+		if (length > static_cast<size_t>(outEnd - out))
+			return false;
+
+		const uint8_t* match = out - offset;
+
+		if (static_cast<size_t>(outEnd - out) < static_cast<size_t>(length) + 16)
+		{
+			for (uint32_t i = 0; i < length; i++)
+				out[i] = match[i];
+		}
+		else
+		{
+			// copy in 8 byte words, at least 8 bytes behind the output so every word reads bytes already written.
+			// a closer match repeats with a period of offset, so the first bytes are copied one at a time
+			// until the output is a whole number of periods and at least 8 bytes past the match
+			uint32_t distance = offset;
+			if (offset < 8)
+			{
+				distance = offset * ((8 + offset - 1) / offset);
+				uint32_t head = distance < length ? distance : length;
+				for (uint32_t i = 0; i < head; i++)
+					out[i] = match[i];
+			}
+
+			uint32_t start = distance == offset ? 0 : distance;
+			const uint8_t* from = out + start - distance;
+			for (uint32_t i = start; i < length; i += 8)
+				memcpy(out + i, from + i - start, 8);
+		}
+
+		out += length;
+	}
+}
+
+// =================================
+// Chunks
+// =================================
+
+static inline uint32_t LzChunkCount(uint32_t length, uint32_t chunkSize)
+{
+	return length / chunkSize + (length % chunkSize != 0 ? 1 : 0);
+}
+
+// compresses length bytes as chunks of chunkSize bytes, the compressed size of each chunk is added to chunkSizes
+// and its data appended to out. chunks that don't get smaller are stored uncompressed
+static void LzCompressChunks(const uint8_t* data, uint32_t length, uint32_t chunkSize, std::vector<uint32_t>& chunkSizes, std::vector<uint8_t>& out)
+{
+	std::vector<uint8_t> scratch(LzCompressBound(length < chunkSize ? length : chunkSize));
+
+	for (uint32_t offset = 0; offset < length; offset += chunkSize)
+	{
+		uint32_t rawSize = (length - offset) < chunkSize ? (length - offset) : chunkSize;
+		uint32_t packedSize = LzCompress(data + offset, rawSize, scratch.data());
+
+		if (packedSize >= rawSize)
+		{
+			out.insert(out.end(), data + offset, data + offset + rawSize);
+			chunkSizes.push_back(rawSize);
+		}
+		else
+		{
+			out.insert(out.end(), scratch.data(), scratch.data() + packedSize);
+			chunkSizes.push_back(packedSize);
+		}
+
+		if (length - offset <= chunkSize)
+			break;
+	}
+}
+
+// decodes a chunk written by LzCompressChunks in to rawSize bytes at dst
+static inline bool LzDecompressChunk(const uint8_t* src, uint32_t srcSize, uint8_t* dst, uint32_t rawSize)
+{
+	if (srcSize == rawSize)
+	{
+		memcpy(dst, src, rawSize);
+		return true;
+	}
+
+	return srcSize < rawSize && LzDecompress(src, srcSize, dst, rawSize);
+}
+
+// =================================
@@ -0,0 +1,525 @@
+#pragma once
+
+#include "bmdl.h"
+#include "bmdl_optimize.h"
+
+#include <float.h>
+#include <math.h>
+
+#include <vector>
+
+// =================================
+// Basic Model : Meshlets
+// Splits meshes in to small clusters for cluster culling, see BmMeshlet. Meshlets never span submeshes.
+// Each one is grown from a seed triangle by adding the neighbouring triangle that brings in the fewest
+// new vertices, the one closest to the centre of the meshlet between equals, so meshlets stay compact
+// and their bounds tight. Seeds come from the triangles left around the previous meshlet, input in
+// vertex cache order (bmdl_optimize.h) isn't required.
+//
+// Bounds are a sphere around the vertices and a cone holding the triangle normals, for culling whole
+// meshlets that are outside the view or face away from it, CullMeshlets tests them four at a time.
+// Building them is meant to happen offline, they are saved in a MeshletData block which loads without
+// any conversion.
+// =================================
+
+namespace bmdl
+{
+	static const uint32_t BmMeshletMaxVertices = 64;
+	static const uint32_t BmMeshletMaxTriangles = 124;
+
+	struct BmMeshletOptions
+	{
+		BmMeshletOptions() : maxVertices(BmMeshletMaxVertices), maxTriangles(BmMeshletMaxTriangles) {}
+
+		uint32_t maxVertices;	// 3 to 255
+		uint32_t maxTriangles;	// 1 to 255
+	};
+
+	// =================================
+	// Bounds
+	// =================================
+
+	static inline void GetMeshletTriangleNormal(const float* a, const float* b, const float* c, float* normal)
+	{
+		float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	// bounds of a meshlet from the positions of its mesh, 3 floats per vertex
+	inline BmMeshletBounds ComputeMeshletBounds(const BmMeshlet& meshlet, const uint32_t* meshletVertices, const uint8_t* meshletTriangles, const float* positions)
+	{
+		BmMeshletBounds bounds = {};
+		const uint32_t* vertices = meshletVertices + meshlet.vertexOffset;
+		const uint8_t* triangles = meshletTriangles + meshlet.triangleOffset;
+
+		// sphere around the centre of the vertex box
+		float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (uint32_t v = 0; v < meshlet.vertexCount; v++)
+		{
+			const float* p = positions + static_cast<size_t>(vertices[v]) * 3;
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				low[i] = p[i] < low[i] ? p[i] : low[i];
+				high[i] = p[i] > high[i] ? p[i] : high[i];
+			}
+		}
+
+		for (uint32_t i = 0; i < 3 && meshlet.vertexCount > 0; i++)
+			bounds.center[i] = (low[i] + high[i]) * 0.5f;
+
+		float radiusSq = 0.0f;
+		for (uint32_t v = 0; v < meshlet.vertexCount; v++)
+		{
+			const float* p = positions + static_cast<size_t>(vertices[v]) * 3;
+			float dx = p[0] - bounds.center[0], dy = p[1] - bounds.center[1], dz = p[2] - bounds.center[2];
+			float distanceSq = dx * dx + dy * dy + dz * dz;
+			radiusSq = distanceSq > radiusSq ? distanceSq : radiusSq;
+		}
+		bounds.radius = sqrtf(radiusSq);
+
+		// cone around the average triangle normal, degenerate triangles don't count. until a cone is
+		// found the apex is the centre and the cutoff never culls
+		float axis[3] = { 0.0f, 0.0f, 0.0f };
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+		{
+			const uint8_t* corners = triangles + t * 3;
+			float normal[3];
+			GetMeshletTriangleNormal(positions + static_cast<size_t>(vertices[corners[0]]) * 3, positions + static_cast<size_t>(vertices[corners[1]]) * 3,
+				positions + static_cast<size_t>(vertices[corners[2]]) * 3, normal);
+
+			float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (uint32_t i = 0; i < 3 && length > 0.0f; i++)
+				axis[i] += normal[i] / length;
+		}
+
+		memcpy(bounds.coneApex, bounds.center, sizeof(bounds.center));
+		bounds.coneCutoff = 1.0f;
+
+		float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		if (axisLength <= 0.0f)
+			return bounds;
+
+		for (uint32_t i = 0; i < 3; i++)
+			bounds.coneAxis[i] = axis[i] / axisLength;
+
+		float minDot = 1.0f;
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+		{
+			const uint8_t* corners = triangles + t * 3;
+			float normal[3];
+			GetMeshletTriangleNormal(positions + static_cast<size_t>(vertices[corners[0]]) * 3, positions + static_cast<size_t>(vertices[corners[1]]) * 3,
+				positions + static_cast<size_t>(vertices[corners[2]]) * 3, normal);
+
+			float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			if (length > 0.0f)
+			{
+				float dot = (normal[0] * bounds.coneAxis[0] + normal[1] * bounds.coneAxis[1] + normal[2] * bounds.coneAxis[2]) / length;
+				minDot = dot < minDot ? dot : minDot;
+			}
+		}
+
+		// cones wider than about 84 degrees cull next to nothing and push the apex far away
+		if (minDot <= 0.1f)
+			return bounds;
+
+		// the apex moves back along the axis until it is behind the plane of every triangle
+		float apexDistance = 0.0f;
+		for (uint32_t t = 0; t < meshlet.triangleCount; t++)
+		{
+			const uint8_t* corners = triangles + t * 3;
+			const float* a = positions + static_cast<size_t>(vertices[corners[0]]) * 3;
+			float normal[3];
+			GetMeshletTriangleNormal(a, positions + static_cast<size_t>(vertices[corners[1]]) * 3, positions + static_cast<size_t>(vertices[corners[2]]) * 3, normal);
+
+			float alongAxis = normal[0] * bounds.coneAxis[0] + normal[1] * bounds.coneAxis[1] + normal[2] * bounds.coneAxis[2];
+			if (alongAxis <= 0.0f)
+				continue;
+
+			float distance = ((bounds.center[0] - a[0]) * normal[0] + (bounds.center[1] - a[1]) * normal[1] + (bounds.center[2] - a[2]) * normal[2]) / alongAxis;
+			apexDistance = distance > apexDistance ? distance : apexDistance;
+		}
+
+		for (uint32_t i = 0; i < 3; i++)
+			bounds.coneApex[i] = bounds.center[i] - bounds.coneAxis[i] * apexDistance;
+		bounds.coneCutoff = sqrtf(1.0f - minDot * minDot);
+
+		return bounds;
+	}
+
+	// =================================
+	// Culling
+	// =================================
+
+	// true when every triangle of the meshlet faces away from eye, the scalar form of the cone test
+	inline bool IsMeshletBackfacing(const BmMeshletBounds& bounds, const float* eye)
+	{
+		float direction[3] = { bounds.coneApex[0] - eye[0], bounds.coneApex[1] - eye[1], bounds.coneApex[2] - eye[2] };
+		float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+		return direction[0] * bounds.coneAxis[0] + direction[1] * bounds.coneAxis[1] + direction[2] * bounds.coneAxis[2] > bounds.coneCutoff * length;
+	}
+
+	// true when the sphere is entirely on the outer side of one of the planes. planes hold 4 floats each,
+	// a point p is inside when p.x * a + p.y * b + p.z * c + d >= 0
+	inline bool IsMeshletOutside(const BmMeshletBounds& bounds, const float* planes, uint32_t planeCount)
+	{
+		for (uint32_t p = 0; p < planeCount; p++)
+		{
+			const float* plane = planes + p * 4;
+			if (bounds.center[0] * plane[0] + bounds.center[1] * plane[1] + bounds.center[2] * plane[2] + plane[3] < -bounds.radius)
+				return true;
+		}
+		return false;
+	}
+
+	// writes the numbers of the meshlets that pass the plane test, and the cone test when eye isn't null, to
+	// visible and returns how many there are. four meshlets are tested at once when SSE2 is available
+	inline uint32_t CullMeshlets(const BmMeshletBounds* bounds, uint32_t count, const float* planes, uint32_t planeCount, const float* eye, uint32_t* visible)
+	{
+		uint32_t visibleCount = 0;
+		uint32_t m = 0;
+
+	#if defined(BM_SIMD_SSE2)
+		for (; m + 4 <= count; m += 4)
+		{
+			const float* first = bounds[m].center;
+			__m128 x = _mm_loadu_ps(first);
+			__m128 y = _mm_loadu_ps(first + 12);
+			__m128 z = _mm_loadu_ps(first + 24);
+			__m128 radius = _mm_loadu_ps(first + 36);
+			_MM_TRANSPOSE4_PS(x, y, z, radius);
+
+			__m128 outside = _mm_setzero_ps();
+			__m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), radius);
+			for (uint32_t p = 0; p < planeCount; p++)
+			{
+				const float* plane = planes + p * 4;
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane[0])), _mm_mul_ps(y, _mm_set1_ps(plane[1]))),
+					_mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane[2])), _mm_set1_ps(plane[3])));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, negRadius));
+			}
+
+			if (eye)
+			{
+				__m128 axisX = _mm_loadu_ps(first + 4);
+				__m128 axisY = _mm_loadu_ps(first + 16);
+				__m128 axisZ = _mm_loadu_ps(first + 28);
+				__m128 cutoff = _mm_loadu_ps(first + 40);
+				_MM_TRANSPOSE4_PS(axisX, axisY, axisZ, cutoff);
+
+				__m128 apexX = _mm_loadu_ps(first + 8);
+				__m128 apexY = _mm_loadu_ps(first + 20);
+				__m128 apexZ = _mm_loadu_ps(first + 32);
+				__m128 reserved = _mm_loadu_ps(first + 44);
+				_MM_TRANSPOSE4_PS(apexX, apexY, apexZ, reserved);
+
+				__m128 dx = _mm_sub_ps(apexX, _mm_set1_ps(eye[0]));
+				__m128 dy = _mm_sub_ps(apexY, _mm_set1_ps(eye[1]));
+				__m128 dz = _mm_sub_ps(apexZ, _mm_set1_ps(eye[2]));
+				__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+				__m128 alongAxis = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, axisX), _mm_mul_ps(dy, axisY)), _mm_mul_ps(dz, axisZ));
+				outside = _mm_or_ps(outside, _mm_cmpgt_ps(alongAxis, _mm_mul_ps(cutoff, length)));
+			}
+
+			int mask = ~_mm_movemask_ps(outside) & 0xF;
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				visible[visibleCount] = m + i;
+				visibleCount += (mask >> i) & 1;
+			}
+		}
+	#endif
+
+		for (; m < count; m++)
+		{
+			if (!IsMeshletOutside(bounds[m], planes, planeCount) && !(eye && IsMeshletBackfacing(bounds[m], eye)))
+				visible[visibleCount++] = m;
+		}
+
+		return visibleCount;
+	}
+
+	// =================================
+	// Building
+	// =================================
+
+	// splits the triangles of indices in to meshlets appended to meshlets, meshletVertices and meshletTriangles,
+	// every meshlet records subMesh. positions holds 3 floats for each of vertexCount vertices. returns false,
+	// adding nothing, when indices reference vertices past them
+	template<typename I>
+	BM_FUNC_DECL bool BuildMeshlets(std::vector<BmMeshlet>& meshlets, std::vector<uint32_t>& meshletVertices, std::vector<uint8_t>& meshletTriangles,
+		const I* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, uint16_t subMesh = 0, const BmMeshletOptions& options = BmMeshletOptions())
+	{
+		uint32_t triangleCount = indexCount / 3;
+		if (triangleCount == 0)
+			return true;
+
+		uint32_t firstVertex, rangeCount;
+		GetVertexRange(indices, triangleCount * 3, firstVertex, rangeCount);
+		if (static_cast<uint64_t>(firstVertex) + rangeCount > vertexCount)
+			return false;
+
+		uint32_t maxVertices = options.maxVertices < 3 ? 3 : (options.maxVertices > 255 ? 255 : options.maxVertices);
+		uint32_t maxTriangles = options.maxTriangles < 1 ? 1 : (options.maxTriangles > 255 ? 255 : options.maxTriangles);
+
+		std::vector<uint32_t> source(triangleCount * 3);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+			source[i] = static_cast<uint32_t>(indices[i]) - firstVertex;
+		positions += static_cast<size_t>(firstVertex) * 3;
+
+		// triangles using each vertex
+		std::vector<uint32_t> adjacencyStart(rangeCount + 1, 0);
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+			adjacencyStart[source[i] + 1]++;
+		for (uint32_t v = 0; v < rangeCount; v++)
+			adjacencyStart[v + 1] += adjacencyStart[v];
+		{
+			std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+				adjacency[fill[source[i]]++] = i / 3;
+		}
+
+		std::vector<float> centroids(triangleCount * 3);
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				centroids[t * 3 + i] = (positions[static_cast<size_t>(source[t * 3 + 0]) * 3 + i] + positions[static_cast<size_t>(source[t * 3 + 1]) * 3 + i] +
+					positions[static_cast<size_t>(source[t * 3 + 2]) * 3 + i]) / 3.0f;
+			}
+		}
+
+		std::vector<uint8_t> assigned(triangleCount, 0);
+		std::vector<uint32_t> queuedBy(triangleCount, UINT32_MAX);	// meshlet that last added the triangle to candidates
+		std::vector<uint8_t> localVertex(rangeCount, 0xFF);		// number of the vertex in the current meshlet
+		std::vector<uint32_t> candidates;
+
+		BmMeshlet meshlet = { static_cast<uint32_t>(meshletVertices.size()), static_cast<uint32_t>(meshletTriangles.size()), 0, 0, subMesh };
+		uint32_t meshletNumber = 0;
+		float centroidSum[3] = { 0.0f, 0.0f, 0.0f };
+		uint32_t nextSeed = 0;
+
+		auto finishMeshlet = [&]()
+		{
+			for (size_t v = meshlet.vertexOffset; v < meshletVertices.size(); v++)
+				localVertex[meshletVertices[v] - firstVertex] = 0xFF;
+
+			meshlets.push_back(meshlet);
+			meshlet.vertexOffset = static_cast<uint32_t>(meshletVertices.size());
+			meshlet.triangleOffset = static_cast<uint32_t>(meshletTriangles.size());
+			meshlet.vertexCount = 0;
+			meshlet.triangleCount = 0;
+			meshletNumber++;
+			centroidSum[0] = centroidSum[1] = centroidSum[2] = 0.0f;
+		};
+
+		for (uint32_t added = 0; added < triangleCount; added++)
+		{
+			uint32_t best = UINT32_MAX;
+
+			// the candidate adding the fewest vertices that still fits, then the closest
+			if (meshlet.triangleCount > 0)
+			{
+				uint32_t bestNew = 4;
+				float bestDistance = FLT_MAX;
+				float center[3] = { centroidSum[0] / meshlet.triangleCount, centroidSum[1] / meshlet.triangleCount, centroidSum[2] / meshlet.triangleCount };
+
+				for (size_t c = 0; c < candidates.size(); )
+				{
+					uint32_t t = candidates[c];
+					if (assigned[t])
+					{
+						candidates[c] = candidates.back();
+						candidates.pop_back();
+						continue;
+					}
+					c++;
+
+					const uint32_t* corners = &source[t * 3];
+					uint32_t newCount = (localVertex[corners[0]] == 0xFF ? 1 : 0) +
+						(localVertex[corners[1]] == 0xFF && corners[1] != corners[0] ? 1 : 0) +
+						(localVertex[corners[2]] == 0xFF && corners[2] != corners[0] && corners[2] != corners[1] ? 1 : 0);
+					if (meshlet.vertexCount + newCount > maxVertices || newCount > bestNew)
+						continue;
+
+					const float* centroid = &centroids[t * 3];
+					float dx = centroid[0] - center[0], dy = centroid[1] - center[1], dz = centroid[2] - center[2];
+					float distance = dx * dx + dy * dy + dz * dz;
+					if (newCount < bestNew || distance < bestDistance)
+					{
+						best = t;
+						bestNew = newCount;
+						bestDistance = distance;
+					}
+				}
+			}
+
+			// full, or nothing left next to the meshlet. the next one starts from a triangle left around it
+			if (best == UINT32_MAX)
+			{
+				if (meshlet.triangleCount > 0)
+					finishMeshlet();
+
+				for (uint32_t t : candidates)
+				{
+					if (!assigned[t])
+					{
+						best = t;
+						break;
+					}
+				}
+
+				if (best == UINT32_MAX)
+				{
+					while (assigned[nextSeed])
+						nextSeed++;
+					best = nextSeed;
+				}
+
+				candidates.clear();
+			}
+
+			assigned[best] = 1;
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				uint32_t v = source[best * 3 + c];
+				if (localVertex[v] == 0xFF)
+				{
+					localVertex[v] = meshlet.vertexCount++;
+					meshletVertices.push_back(v + firstVertex);
+
+					for (uint32_t a = adjacencyStart[v]; a < adjacencyStart[v + 1]; a++)
+					{
+						uint32_t t = adjacency[a];
+						if (!assigned[t] && queuedBy[t] != meshletNumber)
+						{
+							queuedBy[t] = meshletNumber;
+							candidates.push_back(t);
+						}
+					}
+				}
+				meshletTriangles.push_back(localVertex[v]);
+			}
+
+			meshlet.triangleCount++;
+			for (uint32_t i = 0; i < 3; i++)
+				centroidSum[i] += centroids[best * 3 + i];
+
+			if (meshlet.triangleCount == maxTriangles)
+				finishMeshlet();
+		}
+
+		if (meshlet.triangleCount > 0)
+			finishMeshlet();
+
+		return true;
+	}
+
+	// builds the meshlets and bounds of every mesh of the model on the worker pool, replacing any it had.
+	// positions are read through vertLayout, which must describe V. meshes without positions or with
+	// indices referencing missing vertices are left without meshlets and make it return false
+	template<typename V, typename I>
+	BM_FUNC_DECL bool BuildMeshlets(BmModel<V, I>& model, const BmVertLayout* vertLayout = &BmDefaultLayout, const BmMeshletOptions& options = BmMeshletOptions())
+	{
+		BmWorkerPool& pool = GetWorkerPool();
+		uint32_t meshCount = model.meshList.count;
+
+		std::vector<std::vector<float>> meshPositions(meshCount);
+		std::vector<uint8_t> meshBuilt(meshCount, 0);
+		pool.ParallelFor(meshCount, [&](uint32_t m)
+		{
+			meshBuilt[m] = GetMeshPositions(model.meshList[m], vertLayout, meshPositions[m]) ? 1 : 0;
+		});
+
+		// ranges come mesh by mesh, each builds its own meshlets which are then joined per mesh
+		std::vector<BmIndexRange> ranges;
+		GetIndexRanges(model, ranges);
+
+		struct RangeMeshlets
+		{
+			RangeMeshlets() : built(true) {}
+
+			bool					built;
+			std::vector<BmMeshlet>	meshlets;
+			std::vector<uint32_t>	vertices;
+			std::vector<uint8_t>	triangles;
+		};
+
+		std::vector<RangeMeshlets> rangeMeshlets(ranges.size());
+		pool.ParallelFor(static_cast<uint32_t>(ranges.size()), [&](uint32_t r)
+		{
+			uint32_t m = ranges[r].mesh;
+			if (!meshBuilt[m])
+				return;
+
+			const std::vector<float>& positions = meshPositions[m];
+			RangeMeshlets& out = rangeMeshlets[r];
+			VisitIndexRange(model.meshList[m], ranges[r], [&](auto* indices, uint32_t indexCount)
+			{
+				out.built = BuildMeshlets(out.meshlets, out.vertices, out.triangles, indices, indexCount, positions.data(),
+					static_cast<uint32_t>(positions.size() / 3), static_cast<uint16_t>(ranges[r].subMesh), options);
+			});
+		});
+
+		std::vector<uint32_t> firstRange(meshCount + 1, static_cast<uint32_t>(ranges.size()));
+		for (uint32_t r = static_cast<uint32_t>(ranges.size()); r-- > 0; )
+			firstRange[ranges[r].mesh] = r;
+		for (uint32_t m = meshCount; m-- > 0; )
+			firstRange[m] = firstRange[m] < firstRange[m + 1] ? firstRange[m] : firstRange[m + 1];
+
+		pool.ParallelFor(meshCount, [&](uint32_t m)
+		{
+			BmMesh<V, I>& mesh = model.meshList[m];
+			mesh.meshlets.resize(0);
+			mesh.meshletBounds.resize(0);
+			mesh.meshletVertices.resize(0);
+			mesh.meshletTriangles.resize(0);
+
+			for (uint32_t r = firstRange[m]; r < firstRange[m + 1]; r++)
+				meshBuilt[m] &= rangeMeshlets[r].built ? 1 : 0;
+
+			if (!meshBuilt[m])
+				return;
+
+			for (uint32_t r = firstRange[m]; r < firstRange[m + 1]; r++)
+			{
+				const RangeMeshlets& range = rangeMeshlets[r];
+				uint32_t vertexBase = mesh.meshletVertices.count;
+				uint32_t triangleBase = mesh.meshletTriangles.count;
+
+				for (BmMeshlet meshlet : range.meshlets)
+				{
+					meshlet.vertexOffset += vertexBase;
+					meshlet.triangleOffset += triangleBase;
+					mesh.meshlets.add(meshlet);
+				}
+
+				mesh.meshletVertices.reserve(vertexBase + static_cast<uint32_t>(range.vertices.size()));
+				for (uint32_t v : range.vertices)
+					mesh.meshletVertices.add(v);
+
+				mesh.meshletTriangles.reserve(triangleBase + static_cast<uint32_t>(range.triangles.size()));
+				for (uint8_t v : range.triangles)
+					mesh.meshletTriangles.add(v);
+			}
+
+			mesh.meshletBounds.resize(mesh.meshlets.count);
+			for (uint32_t k = 0; k < mesh.meshlets.count; k++)
+				mesh.meshletBounds[k] = ComputeMeshletBounds(mesh.meshlets[k], mesh.meshletVertices.data, mesh.meshletTriangles.data, meshPositions[m].data());
+		});
+
+		uint32_t meshletCount = 0, builtCount = 0;
+		for (uint32_t m = 0; m < meshCount; m++)
+		{
+			meshletCount += model.meshList[m].meshlets.count;
+			builtCount += meshBuilt[m];
+		}
+
+		BM_LOG("Built %u meshlets for %u of %u meshes\n", meshletCount, builtCount, meshCount);
+		return builtCount == meshCount;
+	}
+}
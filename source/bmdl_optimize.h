@@ -0,0 +1,752 @@
+#pragma once
+
+#include "bmdl.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+// =================================
+// Basic Model : Mesh Optimization
+// Reorders the index data of loaded models for the GPU, each BmSubMesh is optimized on its own so
+// draw ranges and materials are kept. Indices are rewritten in place, for both indices and
+// compactIndices, memory mapped models only copy the pages that are written.
+//
+// Vertex cache : triangles are reordered with Tom Forsyth's linear speed vertex cache optimization,
+// a greedy pass that always emits the triangle whose vertices score best against a modelled LRU
+// cache. Results are measured with a FIFO cache, closer to what GPUs implement, as ACMR (vertices
+// transformed per triangle) and ATVR (vertices transformed per vertex referenced).
+//
+// Overdraw : after the vertex cache pass, triangles are split in to clusters (Sander, Nehab and
+// Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"). A cluster ends where
+// the cache order jumped to a new patch, and patches are split further wherever the ACMR of the part
+// so far is within the threshold of the whole patch. Clusters are then drawn in order of how much
+// they face away from the centre of the submesh, a view independent measure of how likely they are to
+// occlude the rest, so outer surfaces come first and hidden interiors fail the depth test.
+//
+// Vertex fetch : vertices are renumbered in the order the index data first uses them, so fetches walk
+// the vertex buffer forwards. Run it last, after the index order is final. The remap table from old to
+// new vertex numbers lets data kept outside the model follow.
+// =================================
+
+namespace bmdl
+{
+	static const uint32_t BmVertexCacheSize = 16;	// FIFO size used to measure ACMR and ATVR
+	static const uint32_t BmForsythCacheSize = 32;	// LRU size modelled while reordering
+	static const uint32_t BmForsythMaxValence = 32;	// valence scores past this are computed rather than looked up
+	static const float BmOverdrawThreshold = 1.05f;	// overdraw clusters may raise ACMR by up to this factor
+
+	struct BmVertexCacheStats
+	{
+		BmVertexCacheStats() : acmr(0.0f), atvr(0.0f), triangleCount(0), vertexCount(0), transformCount(0) {}
+
+		float		acmr;			// transformed vertices per triangle, 3 at worst, around 0.5-0.7 for a good order
+		float		atvr;			// transformed vertices per referenced vertex, 1 at best
+		uint32_t	triangleCount;
+		uint32_t	vertexCount;	// distinct vertices referenced
+		uint32_t	transformCount;	// cache misses
+	};
+
+	struct BmVertexCacheReport
+	{
+		BmVertexCacheStats before;
+		BmVertexCacheStats after;
+	};
+
+	// =================================
+	// Index Ranges
+	// =================================
+
+	// range of one submesh in the index data of its mesh
+	struct BmIndexRange
+	{
+		uint32_t mesh;
+		uint32_t subMesh;
+		uint32_t indexOffset;
+		uint32_t indexCount;
+	};
+
+	// lowest vertex and the number of vertices up to the highest one used by the indices
+	template<typename I>
+	static void GetVertexRange(const I* indices, uint32_t indexCount, uint32_t& firstVertex, uint32_t& vertexCount)
+	{
+		if (indexCount == 0)
+		{
+			firstVertex = 0;
+			vertexCount = 0;
+			return;
+		}
+
+		uint32_t low = UINT32_MAX, high = 0;
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			uint32_t v = static_cast<uint32_t>(indices[i]);
+			low = v < low ? v : low;
+			high = v > high ? v : high;
+		}
+
+		firstVertex = low;
+		vertexCount = high - low + 1;
+	}
+
+	// index ranges of every submesh in the model, meshes without submeshes are a single range.
+	// ranges reaching past the index data of their mesh are left out
+	template<typename V, typename I>
+	static void GetIndexRanges(const BmModel<V, I>& model, std::vector<BmIndexRange>& ranges)
+	{
+		for (uint32_t m = 0; m < model.meshList.count; m++)
+		{
+			const BmMesh<V, I>& mesh = model.meshList[m];
+			uint32_t indexCount = mesh.indices.count > 0 ? mesh.indices.count : mesh.compactIndices.count / GetIndexTypeSize(static_cast<uint8_t>(mesh.compactIndexType));
+
+			if (mesh.subMeshList.count == 0)
+			{
+				ranges.push_back(BmIndexRange{ m, 0, 0, indexCount });
+				continue;
+			}
+
+			for (uint32_t s = 0; s < mesh.subMeshList.count; s++)
+			{
+				const BmSubMesh& subMesh = mesh.subMeshList[s];
+				if (static_cast<uint64_t>(subMesh.indexOffset) + subMesh.indexCount <= indexCount)
+					ranges.push_back(BmIndexRange{ m, s, subMesh.indexOffset, subMesh.indexCount });
+			}
+		}
+	}
+
+	// leaves out the ranges of progressive meshes, their vertex splits depend on the order of the triangles
+	template<typename V, typename I>
+	static void RemoveProgressiveRanges(const BmModel<V, I>& model, std::vector<BmIndexRange>& ranges)
+	{
+		size_t kept = 0;
+		for (size_t r = 0; r < ranges.size(); r++)
+		{
+			if (model.meshList[ranges[r].mesh].vertexSplits.count == 0)
+				ranges[kept++] = ranges[r];
+		}
+		ranges.resize(kept);
+	}
+
+	// calls fn(indices, indexCount) with the indices of the range in whichever type the mesh holds them
+	template<typename V, typename I, typename Fn>
+	static void VisitIndexRange(BmMesh<V, I>& mesh, const BmIndexRange& range, Fn fn)
+	{
+		if (mesh.indices.count > 0)
+		{
+			fn(mesh.indices.data + range.indexOffset, range.indexCount);
+			return;
+		}
+
+		switch (mesh.compactIndexType)
+		{
+			case BmIndexType::UInt8:	fn(reinterpret_cast<uint8_t*>(mesh.compactIndices.data) + range.indexOffset, range.indexCount); break;
+			case BmIndexType::UInt16:	fn(reinterpret_cast<uint16_t*>(mesh.compactIndices.data) + range.indexOffset, range.indexCount); break;
+			case BmIndexType::UInt32:	fn(reinterpret_cast<uint32_t*>(mesh.compactIndices.data) + range.indexOffset, range.indexCount); break;
+		}
+	}
+
+	// positions of the mesh vertices as 3 floats each, converted from the position attribute of
+	// vertLayout or from the position stream. false when the mesh has no positions
+	template<typename V, typename I>
+	static bool GetMeshPositions(const BmMesh<V, I>& mesh, const BmVertLayout* vertLayout, std::vector<float>& positions)
+	{
+		static const BmVertAttr positionAttribute[] = { BmVertAttr(BmBaseType::Float, 3, BmAttrMap::Position) };
+		const BmAttrBounds* bounds = mesh.hasBounds ? &mesh.bounds : nullptr;
+
+		if (mesh.streams.count > 0)
+		{
+			const BmVertStream* stream = mesh.GetStream(BmAttrMap::Position);
+			const BmVertConversionPlan* plan = stream != nullptr ? GetConversionPlan(&stream->attribute, 1, positionAttribute, 1, sizeof(float) * 3) : nullptr;
+			if (plan == nullptr)
+				return false;
+
+			positions.resize(static_cast<size_t>(stream->count) * 3);
+			plan->Convert(stream->data, reinterpret_cast<uint8_t*>(positions.data()), stream->count, false, false, bounds);
+			return true;
+		}
+
+		bool hasPosition = false;
+		for (uint32_t a = 0; a < vertLayout->attributeCount; a++)
+			hasPosition |= vertLayout->attributes[a].attrMap == BmAttrMap::Position;
+
+		const BmVertConversionPlan* plan = hasPosition ? GetConversionPlan(vertLayout->attributes, vertLayout->attributeCount, positionAttribute, 1, sizeof(float) * 3) : nullptr;
+		if (plan == nullptr)
+			return false;
+
+		positions.resize(static_cast<size_t>(mesh.vertices.count) * 3);
+		plan->Convert(reinterpret_cast<const uint8_t*>(mesh.vertices.data), reinterpret_cast<uint8_t*>(positions.data()), mesh.vertices.count, false, false, bounds);
+		return true;
+	}
+
+	// =================================
+	// Vertex Cache
+	// =================================
+
+	// simulates a FIFO cache of cacheSize vertices over the triangles of indices
+	template<typename I>
+	BM_FUNC_DECL BmVertexCacheStats AnalyzeVertexCache(const I* indices, uint32_t indexCount, uint32_t cacheSize = BmVertexCacheSize)
+	{
+		BmVertexCacheStats stats;
+		indexCount -= indexCount % 3;
+		stats.triangleCount = indexCount / 3;
+
+		uint32_t firstVertex, vertexCount;
+		GetVertexRange(indices, indexCount, firstVertex, vertexCount);
+
+		// a vertex is cached while fewer than cacheSize misses happened since its own
+		std::vector<uint32_t> missTime(vertexCount, 0);
+		uint32_t time = cacheSize + 1;
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			uint32_t v = static_cast<uint32_t>(indices[i]) - firstVertex;
+			if (time - missTime[v] > cacheSize)
+			{
+				stats.vertexCount += missTime[v] == 0 ? 1 : 0;
+				missTime[v] = time++;
+			}
+		}
+
+		stats.transformCount = time - (cacheSize + 1);
+		stats.acmr = stats.triangleCount > 0 ? static_cast<float>(stats.transformCount) / stats.triangleCount : 0.0f;
+		stats.atvr = stats.vertexCount > 0 ? static_cast<float>(stats.transformCount) / stats.vertexCount : 0.0f;
+		return stats;
+	}
+
+	// sums the stats of several ranges
+	static inline void AddVertexCacheStats(BmVertexCacheStats& total, const BmVertexCacheStats& stats)
+	{
+		total.triangleCount += stats.triangleCount;
+		total.vertexCount += stats.vertexCount;
+		total.transformCount += stats.transformCount;
+		total.acmr = total.triangleCount > 0 ? static_cast<float>(total.transformCount) / total.triangleCount : 0.0f;
+		total.atvr = total.vertexCount > 0 ? static_cast<float>(total.transformCount) / total.vertexCount : 0.0f;
+	}
+
+	// Forsyth's scores, recently used vertices score higher apart from the last triangle's, which is
+	// likely to be reused by the next one anyway. vertices with few triangles left score higher so
+	// they are finished off rather than left to be transformed again later
+	struct BmForsythScores
+	{
+		BmForsythScores()
+		{
+			for (uint32_t p = 0; p < BmForsythCacheSize; p++)
+				cache[p] = p < 3 ? 0.75f : powf(1.0f - (p - 3) / static_cast<float>(BmForsythCacheSize - 3), 1.5f);
+
+			valence[0] = -1.0f;
+			for (uint32_t v = 1; v < BmForsythMaxValence; v++)
+				valence[v] = 2.0f / sqrtf(static_cast<float>(v));
+		}
+
+		inline float Get(int32_t cachePosition, uint32_t valenceCount) const
+		{
+			if (valenceCount == 0)
+				return -1.0f;
+
+			float score = valenceCount < BmForsythMaxValence ? valence[valenceCount] : 2.0f / sqrtf(static_cast<float>(valenceCount));
+			return cachePosition >= 0 ? score + cache[cachePosition] : score;
+		}
+
+		float cache[BmForsythCacheSize];
+		float valence[BmForsythMaxValence];
+	};
+
+	// reorders the triangles of indices in place for the post transform cache, vertices are unchanged
+	template<typename I>
+	BM_FUNC_DECL void OptimizeVertexCache(I* indices, uint32_t indexCount)
+	{
+		uint32_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+			return;
+
+		static const BmForsythScores scores;
+
+		uint32_t firstVertex, vertexCount;
+		GetVertexRange(indices, triangleCount * 3, firstVertex, vertexCount);
+
+		std::vector<uint32_t> source(triangleCount * 3);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+			source[i] = static_cast<uint32_t>(indices[i]) - firstVertex;
+
+		// triangles using each vertex, valence counts the ones not emitted yet at the front of each list
+		std::vector<uint32_t> valence(vertexCount, 0);
+		std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+		std::vector<uint32_t> adjacency(triangleCount * 3);
+
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+			valence[source[i]]++;
+		for (uint32_t v = 0; v < vertexCount; v++)
+			adjacencyStart[v + 1] = adjacencyStart[v] + valence[v];
+		for (uint32_t v = 0; v < vertexCount; v++)
+			valence[v] = 0;
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+		{
+			uint32_t v = source[i];
+			adjacency[adjacencyStart[v] + valence[v]++] = i / 3;
+		}
+
+		std::vector<int32_t> cachePosition(vertexCount, -1);
+		std::vector<float> vertexScore(vertexCount);
+		for (uint32_t v = 0; v < vertexCount; v++)
+			vertexScore[v] = scores.Get(-1, valence[v]);
+
+		// start from the best scoring triangle, ones at the open edge of the mesh
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		uint32_t bestTriangle = 0;
+		float bestScore = -1.0f;
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			const uint32_t* corners = &source[t * 3];
+			float score = vertexScore[corners[0]] + vertexScore[corners[1]] + vertexScore[corners[2]];
+			if (score > bestScore)
+			{
+				bestScore = score;
+				bestTriangle = t;
+			}
+		}
+
+		uint32_t cache[BmForsythCacheSize + 3];
+		uint32_t cacheCount = 0;
+		uint32_t nextUnemitted = 0;
+
+		for (uint32_t out = 0; out < triangleCount; out++)
+		{
+			// nothing in the cache has triangles left, carry on with the next triangle in the original order
+			if (bestTriangle == UINT32_MAX)
+			{
+				while (emitted[nextUnemitted])
+					nextUnemitted++;
+				bestTriangle = nextUnemitted;
+			}
+
+			const uint32_t* corners = &source[bestTriangle * 3];
+			emitted[bestTriangle] = 1;
+
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				uint32_t v = corners[c];
+				indices[out * 3 + c] = static_cast<I>(v + firstVertex);
+
+				// move the triangle past the end of the vertex's remaining triangles
+				uint32_t* list = &adjacency[adjacencyStart[v]];
+				for (uint32_t a = 0; a < valence[v]; a++)
+				{
+					if (list[a] == bestTriangle)
+					{
+						list[a] = list[valence[v] - 1];
+						list[valence[v] - 1] = bestTriangle;
+						valence[v]--;
+						break;
+					}
+				}
+			}
+
+			// the triangle's vertices go to the front of the cache, the rest move back
+			uint32_t newCache[BmForsythCacheSize + 3];
+			uint32_t newCount = 0;
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				if (newCount == 0 || (newCache[0] != corners[c] && (newCount == 1 || newCache[1] != corners[c])))
+					newCache[newCount++] = corners[c];
+			}
+			for (uint32_t e = 0; e < cacheCount; e++)
+			{
+				uint32_t v = cache[e];
+				if (v != corners[0] && v != corners[1] && v != corners[2])
+					newCache[newCount++] = v;
+			}
+
+			// rescore the cached and evicted vertices and their triangles, picking the best for next
+			for (uint32_t e = 0; e < newCount; e++)
+			{
+				uint32_t v = newCache[e];
+				cachePosition[v] = e < BmForsythCacheSize ? static_cast<int32_t>(e) : -1;
+				vertexScore[v] = scores.Get(cachePosition[v], valence[v]);
+			}
+
+			bestTriangle = UINT32_MAX;
+			bestScore = -1.0f;
+			for (uint32_t e = 0; e < newCount; e++)
+			{
+				uint32_t v = newCache[e];
+				const uint32_t* list = &adjacency[adjacencyStart[v]];
+				for (uint32_t a = 0; a < valence[v]; a++)
+				{
+					uint32_t t = list[a];
+					const uint32_t* other = &source[t * 3];
+					float score = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+					if (score > bestScore)
+					{
+						bestScore = score;
+						bestTriangle = t;
+					}
+				}
+			}
+
+			cacheCount = newCount < BmForsythCacheSize ? newCount : BmForsythCacheSize;
+			for (uint32_t e = 0; e < cacheCount; e++)
+				cache[e] = newCache[e];
+		}
+	}
+
+	// measures every submesh of the model with a FIFO cache of cacheSize vertices
+	template<typename V, typename I>
+	BM_FUNC_DECL BmVertexCacheStats AnalyzeVertexCache(BmModel<V, I>& model, uint32_t cacheSize = BmVertexCacheSize)
+	{
+		std::vector<BmIndexRange> ranges;
+		GetIndexRanges(model, ranges);
+
+		BmVertexCacheStats total;
+		for (const BmIndexRange& range : ranges)
+		{
+			VisitIndexRange(model.meshList[range.mesh], range, [&](auto* indices, uint32_t indexCount)
+			{
+				AddVertexCacheStats(total, AnalyzeVertexCache(indices, indexCount, cacheSize));
+			});
+		}
+		return total;
+	}
+
+	// reorders the triangles of every submesh of the model in place on the worker pool. progressive meshes
+	// are left as they are
+	template<typename V, typename I>
+	BM_FUNC_DECL BmVertexCacheReport OptimizeVertexCache(BmModel<V, I>& model, uint32_t cacheSize = BmVertexCacheSize)
+	{
+		std::vector<BmIndexRange> ranges;
+		GetIndexRanges(model, ranges);
+		RemoveProgressiveRanges(model, ranges);
+
+		std::vector<BmVertexCacheReport> rangeReports(ranges.size());
+		GetWorkerPool().ParallelFor(static_cast<uint32_t>(ranges.size()), [&](uint32_t r)
+		{
+			VisitIndexRange(model.meshList[ranges[r].mesh], ranges[r], [&](auto* indices, uint32_t indexCount)
+			{
+				rangeReports[r].before = AnalyzeVertexCache(indices, indexCount, cacheSize);
+				OptimizeVertexCache(indices, indexCount);
+				rangeReports[r].after = AnalyzeVertexCache(indices, indexCount, cacheSize);
+			});
+		});
+
+		BmVertexCacheReport report;
+		for (const BmVertexCacheReport& rangeReport : rangeReports)
+		{
+			AddVertexCacheStats(report.before, rangeReport.before);
+			AddVertexCacheStats(report.after, rangeReport.after);
+		}
+
+		BM_LOG("Vertex cache optimized %u triangles, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", report.after.triangleCount,
+			report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+		return report;
+	}
+
+	// =================================
+	// Overdraw
+	// =================================
+
+	// adds the misses of one triangle to a FIFO cache simulation, see AnalyzeVertexCache
+	static inline uint32_t SimulateCacheTriangle(const uint32_t* corners, uint32_t* missTime, uint32_t& time, uint32_t cacheSize)
+	{
+		uint32_t misses = 0;
+		for (uint32_t c = 0; c < 3; c++)
+		{
+			if (time - missTime[corners[c]] > cacheSize)
+			{
+				missTime[corners[c]] = time++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	// reorders the triangles of vertex cache optimized indices in place to reduce overdraw, keeping ACMR
+	// within about threshold times the input's. positions holds 3 floats for each of vertexCount vertices,
+	// false when indices reference vertices past them
+	template<typename I>
+	BM_FUNC_DECL bool OptimizeOverdraw(I* indices, uint32_t indexCount, const float* positions, uint32_t vertexCount, float threshold = BmOverdrawThreshold, uint32_t cacheSize = BmVertexCacheSize)
+	{
+		uint32_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+			return true;
+
+		uint32_t firstVertex, rangeCount;
+		GetVertexRange(indices, triangleCount * 3, firstVertex, rangeCount);
+		if (static_cast<uint64_t>(firstVertex) + rangeCount > vertexCount)
+			return false;
+
+		std::vector<uint32_t> source(triangleCount * 3);
+		for (uint32_t i = 0; i < triangleCount * 3; i++)
+			source[i] = static_cast<uint32_t>(indices[i]) - firstVertex;
+		positions += static_cast<size_t>(firstVertex) * 3;
+
+		// patches start where every vertex of a triangle missed, the cache order moved somewhere new
+		std::vector<uint32_t> missTime(rangeCount, 0);
+		std::vector<uint32_t> patchStarts;
+		uint32_t time = cacheSize + 1;
+		for (uint32_t t = 0; t < triangleCount; t++)
+		{
+			if (SimulateCacheTriangle(&source[t * 3], missTime.data(), time, cacheSize) == 3 || t == 0)
+				patchStarts.push_back(t);
+		}
+		patchStarts.push_back(triangleCount);
+
+		// each patch is split as soon as the ACMR of its current cluster, starting with an empty cache,
+		// comes down to threshold times the ACMR of the whole patch. a remainder that never gets there
+		// joins the cluster before it
+		std::vector<uint32_t> clusterStarts;
+		for (uint32_t p = 0; p + 1 < patchStarts.size(); p++)
+		{
+			uint32_t begin = patchStarts[p], end = patchStarts[p + 1];
+
+			std::fill(missTime.begin(), missTime.end(), 0);
+			time = cacheSize + 1;
+			uint32_t patchMisses = 0;
+			for (uint32_t t = begin; t < end; t++)
+				patchMisses += SimulateCacheTriangle(&source[t * 3], missTime.data(), time, cacheSize);
+			float patchLimit = threshold * patchMisses / (end - begin);
+
+			std::fill(missTime.begin(), missTime.end(), 0);
+			time = cacheSize + 1;
+			uint32_t clusterStart = begin, clusterMisses = 0;
+			clusterStarts.push_back(begin);
+			for (uint32_t t = begin; t < end; t++)
+			{
+				clusterMisses += SimulateCacheTriangle(&source[t * 3], missTime.data(), time, cacheSize);
+				if (t + 1 < end && clusterMisses <= patchLimit * (t + 1 - clusterStart))
+				{
+					clusterStart = t + 1;
+					clusterMisses = 0;
+					clusterStarts.push_back(clusterStart);
+					std::fill(missTime.begin(), missTime.end(), 0);
+					time = cacheSize + 1;
+				}
+			}
+
+			if (clusterStarts.back() != begin && clusterMisses > patchLimit * (end - clusterStart))
+				clusterStarts.pop_back();
+		}
+		clusterStarts.push_back(triangleCount);
+
+		// area weighted centroid and normal of each cluster and centroid of the whole range
+		uint32_t clusterCount = static_cast<uint32_t>(clusterStarts.size() - 1);
+		std::vector<float> clusterData(static_cast<size_t>(clusterCount) * 7, 0.0f);
+		double meshCentroid[3] = { 0.0, 0.0, 0.0 };
+		double meshArea = 0.0;
+
+		for (uint32_t k = 0; k < clusterCount; k++)
+		{
+			float* data = &clusterData[static_cast<size_t>(k) * 7];
+			float area = 0.0f;
+			for (uint32_t t = clusterStarts[k]; t < clusterStarts[k + 1]; t++)
+			{
+				const float* a = positions + static_cast<size_t>(source[t * 3 + 0]) * 3;
+				const float* b = positions + static_cast<size_t>(source[t * 3 + 1]) * 3;
+				const float* c = positions + static_cast<size_t>(source[t * 3 + 2]) * 3;
+
+				float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+				float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+				float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+				float triangleArea = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+				for (uint32_t i = 0; i < 3; i++)
+				{
+					data[i] += (a[i] + b[i] + c[i]) * triangleArea / 3.0f;
+					data[3 + i] += n[i];
+				}
+				area += triangleArea;
+			}
+
+			for (uint32_t i = 0; i < 3; i++)
+				meshCentroid[i] += data[i];
+			meshArea += area;
+
+			for (uint32_t i = 0; i < 3 && area > 0.0f; i++)
+				data[i] /= area;
+		}
+
+		for (uint32_t i = 0; i < 3 && meshArea > 0.0; i++)
+			meshCentroid[i] /= meshArea;
+
+		// clusters facing away from the centre occlude more of the rest, they are drawn first
+		std::vector<uint32_t> order(clusterCount);
+		for (uint32_t k = 0; k < clusterCount; k++)
+		{
+			float* data = &clusterData[static_cast<size_t>(k) * 7];
+			float length = sqrtf(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+			float facing = 0.0f;
+			for (uint32_t i = 0; i < 3; i++)
+				facing += (data[i] - static_cast<float>(meshCentroid[i])) * data[3 + i];
+			data[6] = length > 0.0f ? facing / length : 0.0f;
+			order[k] = k;
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return clusterData[static_cast<size_t>(a) * 7 + 6] > clusterData[static_cast<size_t>(b) * 7 + 6]; });
+
+		uint32_t out = 0;
+		for (uint32_t k : order)
+		{
+			for (uint32_t i = clusterStarts[k] * 3; i < clusterStarts[k + 1] * 3; i++)
+				indices[out++] = static_cast<I>(source[i] + firstVertex);
+		}
+		return true;
+	}
+
+	// optimizes every submesh of the model for the vertex cache and then for overdraw, in place on the
+	// worker pool. positions are read through vertLayout, which must describe V. submeshes of meshes
+	// without positions are only optimized for the vertex cache and progressive meshes are left as they are
+	template<typename V, typename I>
+	BM_FUNC_DECL BmVertexCacheReport OptimizeOverdraw(BmModel<V, I>& model, const BmVertLayout* vertLayout = &BmDefaultLayout, float threshold = BmOverdrawThreshold, uint32_t cacheSize = BmVertexCacheSize)
+	{
+		BmWorkerPool& pool = GetWorkerPool();
+
+		std::vector<std::vector<float>> meshPositions(model.meshList.count);
+		std::vector<uint8_t> hasPositions(model.meshList.count, 0);
+		pool.ParallelFor(model.meshList.count, [&](uint32_t m)
+		{
+			hasPositions[m] = GetMeshPositions(model.meshList[m], vertLayout, meshPositions[m]) ? 1 : 0;
+		});
+
+		std::vector<BmIndexRange> ranges;
+		GetIndexRanges(model, ranges);
+		RemoveProgressiveRanges(model, ranges);
+
+		std::vector<BmVertexCacheReport> rangeReports(ranges.size());
+		pool.ParallelFor(static_cast<uint32_t>(ranges.size()), [&](uint32_t r)
+		{
+			const std::vector<float>& positions = meshPositions[ranges[r].mesh];
+			VisitIndexRange(model.meshList[ranges[r].mesh], ranges[r], [&](auto* indices, uint32_t indexCount)
+			{
+				rangeReports[r].before = AnalyzeVertexCache(indices, indexCount, cacheSize);
+				OptimizeVertexCache(indices, indexCount);
+				if (hasPositions[ranges[r].mesh])
+					OptimizeOverdraw(indices, indexCount, positions.data(), static_cast<uint32_t>(positions.size() / 3), threshold, cacheSize);
+				rangeReports[r].after = AnalyzeVertexCache(indices, indexCount, cacheSize);
+			});
+		});
+
+		BmVertexCacheReport report;
+		for (const BmVertexCacheReport& rangeReport : rangeReports)
+		{
+			AddVertexCacheStats(report.before, rangeReport.before);
+			AddVertexCacheStats(report.after, rangeReport.after);
+		}
+
+		BM_LOG("Overdraw optimized %u triangles, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", report.after.triangleCount,
+			report.before.acmr, report.after.acmr, report.before.atvr, report.after.atvr);
+		return report;
+	}
+
+	// =================================
+	// Vertex Fetch
+	// =================================
+
+	// fills remap[v] with the new number of each of vertexCount vertices, in the order indices first use
+	// them, unused vertices follow in their original order. returns the number of used vertices, or
+	// UINT32_MAX when indices reference vertices past vertexCount
+	template<typename I>
+	BM_FUNC_DECL uint32_t GetVertexFetchRemap(uint32_t* remap, const I* indices, uint32_t indexCount, uint32_t vertexCount)
+	{
+		for (uint32_t v = 0; v < vertexCount; v++)
+			remap[v] = UINT32_MAX;
+
+		uint32_t next = 0;
+		for (uint32_t i = 0; i < indexCount; i++)
+		{
+			uint32_t v = static_cast<uint32_t>(indices[i]);
+			if (v >= vertexCount)
+				return UINT32_MAX;
+			if (remap[v] == UINT32_MAX)
+				remap[v] = next++;
+		}
+
+		uint32_t usedCount = next;
+		for (uint32_t v = 0; v < vertexCount; v++)
+		{
+			if (remap[v] == UINT32_MAX)
+				remap[v] = next++;
+		}
+		return usedCount;
+	}
+
+	template<typename I>
+	BM_FUNC_DECL void RemapIndices(I* indices, uint32_t indexCount, const uint32_t* remap)
+	{
+		for (uint32_t i = 0; i < indexCount; i++)
+			indices[i] = static_cast<I>(remap[static_cast<uint32_t>(indices[i])]);
+	}
+
+	// moves vertexCount vertices of stride bytes in place to their remapped positions
+	static void RemapVertices(uint8_t* vertices, uint32_t vertexCount, uint32_t stride, const uint32_t* remap)
+	{
+		std::vector<uint8_t> source(vertices, vertices + static_cast<size_t>(vertexCount) * stride);
+		for (uint32_t v = 0; v < vertexCount; v++)
+			memcpy(vertices + static_cast<size_t>(remap[v]) * stride, &source[static_cast<size_t>(v) * stride], stride);
+	}
+
+	// renumbers the vertices of every mesh of the model in first use order on the worker pool, moving
+	// the interleaved vertices or every stream and rewriting the indices, meshlet vertices and lod indices.
+	// remapTables, when given, receives a table per mesh from old to new vertex numbers, empty for meshes
+	// left unchanged because their indices reference missing vertices. progressive meshes already have
+	// their vertices in the order splits add them and get an identity table. returns false if any mesh
+	// was left unchanged
+	template<typename V, typename I>
+	BM_FUNC_DECL bool OptimizeVertexFetch(BmModel<V, I>& model, std::vector<std::vector<uint32_t>>* remapTables = nullptr)
+	{
+		std::vector<std::vector<uint32_t>> remaps(model.meshList.count);
+		std::vector<uint8_t> remapped(model.meshList.count, 0);
+
+		GetWorkerPool().ParallelFor(model.meshList.count, [&](uint32_t m)
+		{
+			BmMesh<V, I>& mesh = model.meshList[m];
+			uint32_t vertexCount = mesh.streams.count > 0 ? mesh.streams[0].count : mesh.vertices.count;
+			uint32_t indexCount = mesh.indices.count > 0 ? mesh.indices.count : mesh.compactIndices.count / GetIndexTypeSize(static_cast<uint8_t>(mesh.compactIndexType));
+			std::vector<uint32_t>& remap = remaps[m];
+			remap.resize(vertexCount);
+
+			if (mesh.vertexSplits.count > 0)
+			{
+				for (uint32_t v = 0; v < vertexCount; v++)
+					remap[v] = v;
+				remapped[m] = 1;
+				return;
+			}
+
+			uint32_t usedCount = UINT32_MAX;
+			VisitIndexRange(mesh, BmIndexRange{ m, 0, 0, indexCount }, [&](auto* indices, uint32_t count)
+			{
+				usedCount = GetVertexFetchRemap(remap.data(), indices, count, vertexCount);
+				if (usedCount != UINT32_MAX)
+					RemapIndices(indices, count, remap.data());
+			});
+
+			if (usedCount == UINT32_MAX)
+			{
+				remap.clear();
+				return;
+			}
+
+			if (mesh.streams.count > 0)
+			{
+				for (uint32_t s = 0; s < mesh.streams.count; s++)
+					RemapVertices(mesh.streams[s].data, vertexCount, mesh.streams[s].stride, remap.data());
+			}
+			else
+				RemapVertices(reinterpret_cast<uint8_t*>(mesh.vertices.data), vertexCount, sizeof(V), remap.data());
+
+			// meshlets and levels of detail keep referencing the same vertices
+			RemapIndices(mesh.meshletVertices.data, mesh.meshletVertices.count, remap.data());
+			RemapIndices(mesh.lodIndices.data, mesh.lodIndices.count, remap.data());
+
+			remapped[m] = 1;
+		});
+
+		uint32_t remappedCount = 0;
+		for (uint32_t m = 0; m < model.meshList.count; m++)
+			remappedCount += remapped[m];
+
+		BM_LOG("Vertex fetch optimized %u of %u meshes\n", remappedCount, model.meshList.count);
+
+		if (remapTables != nullptr)
+			remapTables->swap(remaps);
+		return remappedCount == model.meshList.count;
+	}
+}
@@ -0,0 +1,1071 @@
+#pragma once
+
+#include "bmdl.h"
+#include "bmdl_optimize.h"
+
+#include <float.h>
+#include <math.h>
+
+#include <algorithm>
+#include <vector>
+
+// =================================
+// Basic Model : Simplification
+// Builds lower levels of detail by collapsing edges. A collapse moves one vertex on to a neighbour, so every
+// level keeps drawing the vertices of the mesh and only needs indices of its own (BmMesh::lods). Each pass
+// sorts the possible collapses by the quadric error of the planes around the moving vertex and makes the
+// cheapest ones that don't share vertices or fold triangles over, errors are measured against the full
+// mesh since quadrics are merged as vertices collapse. Undoing the collapses one at a time from the coarsest
+// level gives the vertex splits of a progressive mesh.
+//
+// Vertices sharing a position with different attributes (UV and normal seams) only move along the seam,
+// together with their twin on the other side. Vertices on open borders and on borders between submeshes
+// only move along the border, which keeps a plane through the border edge in their quadric. Anything more
+// tangled stays where it is, as do vertices of meshes that were never welded.
+// =================================
+
+namespace bmdl
+{
+	static const float BmLodDefaultMaxError = 0.05f;
+	static const float BmBorderEdgeWeight = 10.0f;
+	static const float BmProgressiveDefaultBaseRatio = 0.05f;
+
+	struct BmLodOptions
+	{
+		BmLodOptions() : levels{ 0.5f, 0.25f, 0.1f }, maxError(BmLodDefaultMaxError) {}
+
+		std::vector<float>	levels;		// triangle count of each level relative to the mesh, most detailed first
+		float				maxError;	// furthest a level may move from the mesh, relative to the mesh extent
+	};
+
+	struct BmProgressiveOptions
+	{
+		BmProgressiveOptions() : baseRatio(BmProgressiveDefaultBaseRatio), maxError(BmLodDefaultMaxError) {}
+
+		float	baseRatio;	// triangle count of the base relative to the mesh
+		float	maxError;	// furthest the base may move from the mesh, relative to the mesh extent
+	};
+
+	// =================================
+	// Quadrics
+	// =================================
+
+	// sum of squared distances to weighted planes, the symmetric 3x3 matrix A, vector b and constant c
+	// of x'Ax + 2b'x + c
+	struct BmQuadric
+	{
+		float a00, a11, a22, a10, a20, a21;
+		float b0, b1, b2;
+		float c;
+		float weight;
+	};
+
+	static inline void AddPlaneQuadric(BmQuadric& q, const float* normal, float distance, float weight)
+	{
+		q.a00 += weight * normal[0] * normal[0];
+		q.a11 += weight * normal[1] * normal[1];
+		q.a22 += weight * normal[2] * normal[2];
+		q.a10 += weight * normal[1] * normal[0];
+		q.a20 += weight * normal[2] * normal[0];
+		q.a21 += weight * normal[2] * normal[1];
+		q.b0 += weight * normal[0] * distance;
+		q.b1 += weight * normal[1] * distance;
+		q.b2 += weight * normal[2] * distance;
+		q.c += weight * distance * distance;
+		q.weight += weight;
+	}
+
+	static inline void AddQuadric(BmQuadric& q, const BmQuadric& other)
+	{
+		q.a00 += other.a00; q.a11 += other.a11; q.a22 += other.a22;
+		q.a10 += other.a10; q.a20 += other.a20; q.a21 += other.a21;
+		q.b0 += other.b0; q.b1 += other.b1; q.b2 += other.b2;
+		q.c += other.c;
+		q.weight += other.weight;
+	}
+
+	// mean squared distance of p to the planes of q
+	static inline float GetQuadricError(const BmQuadric& q, const float* p)
+	{
+		float rx = q.b0 + q.a00 * p[0] + q.a10 * p[1] + q.a20 * p[2];
+		float ry = q.b1 + q.a10 * p[0] + q.a11 * p[1] + q.a21 * p[2];
+		float rz = q.b2 + q.a20 * p[0] + q.a21 * p[1] + q.a22 * p[2];
+		float error = p[0] * rx + p[1] * ry + p[2] * rz + q.b0 * p[0] + q.b1 * p[1] + q.b2 * p[2] + q.c;
+		return q.weight > 0.0f ? fabsf(error) / q.weight : 0.0f;
+	}
+
+	// =================================
+	// Simplifier
+	// =================================
+
+	// how a vertex may move, see the description at the top
+	enum class BmCollapseKind : uint8_t
+	{
+		Manifold,	// anywhere
+		Border,		// along its open edges, on to a border or locked vertex
+		Seam,		// along the seam with its twin, on to a seam vertex
+		Locked		// nowhere
+	};
+
+	// a collapse made by BmSimplifier, a seam vertex moves together with its twin
+	struct BmCollapse
+	{
+		uint32_t	vertex;
+		uint32_t	target;
+		uint32_t	twin;			// UINT32_MAX when vertex isn't on a seam
+		uint32_t	twinTarget;
+		float		error;			// squared, relative to the mesh extent
+	};
+
+	// simplifies one mesh level after level, each call to Simplify continues from the triangles left by the one before
+	class BmSimplifier
+	{
+	public:
+
+		BmSimplifier() : vertexCount(0), error(0.0f), recordCollapses(false) {}
+
+		// copies the triangles, positions hold 3 floats for each of vertexCount vertices and groups, when given,
+		// a number per triangle telling which submesh it belongs to. false when indices reference missing vertices
+		template<typename I>
+		bool Init(const I* indices, uint32_t indexCount, const uint16_t* triangleGroups, const float* positions, uint32_t vertexCount)
+		{
+			uint32_t triangleCount = indexCount / 3;
+			this->vertexCount = vertexCount;
+			error = 0.0f;
+			collapseLog.clear();
+
+			this->indices.resize(static_cast<size_t>(triangleCount) * 3);
+			groups.resize(triangleCount);
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+			{
+				this->indices[i] = static_cast<uint32_t>(indices[i]);
+				if (this->indices[i] >= vertexCount)
+					return false;
+			}
+			for (uint32_t t = 0; t < triangleCount; t++)
+				groups[t] = triangleGroups != nullptr ? triangleGroups[t] : 0;
+
+			// positions are scaled to the unit box so errors are relative to the mesh extent
+			float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+			float high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+			{
+				const float* p = positions + static_cast<size_t>(this->indices[i]) * 3;
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					low[c] = p[c] < low[c] ? p[c] : low[c];
+					high[c] = p[c] > high[c] ? p[c] : high[c];
+				}
+			}
+
+			float extent = 0.0f;
+			for (uint32_t c = 0; c < 3 && triangleCount > 0; c++)
+				extent = high[c] - low[c] > extent ? high[c] - low[c] : extent;
+			float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+			this->positions.resize(static_cast<size_t>(vertexCount) * 3);
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+					this->positions[v * 3 + c] = triangleCount > 0 ? (positions[static_cast<size_t>(v) * 3 + c] - low[c]) * scale : 0.0f;
+			}
+
+			BuildPositionRemap(positions);
+			RemoveDegenerateTriangles();
+
+			// planes of the triangles, weighted by area, and of the open edges, at right angles to their triangle
+			quadrics.assign(vertexCount, BmQuadric());
+			FindOpenEdges();
+			for (uint32_t t = 0; t < this->indices.size() / 3; t++)
+			{
+				const uint32_t* corners = &this->indices[t * 3];
+				float normal[3];
+				float area = GetTriangleNormal(corners[0], corners[1], corners[2], normal);
+				if (area <= 0.0f)
+					continue;
+
+				const float* p0 = &this->positions[corners[0] * 3];
+				float distance = -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]);
+				for (uint32_t c = 0; c < 3; c++)
+					AddPlaneQuadric(quadrics[remap[corners[c]]], normal, distance, area);
+
+				for (uint32_t e = 0; e < 3; e++)
+				{
+					uint32_t a = corners[e], b = corners[(e + 1) % 3];
+					if (!IsOpenEdge(a, b))
+						continue;
+
+					const float* pa = &this->positions[a * 3];
+					const float* pb = &this->positions[b * 3];
+					float edge[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+					float edgeNormal[3] = { edge[1] * normal[2] - edge[2] * normal[1], edge[2] * normal[0] - edge[0] * normal[2], edge[0] * normal[1] - edge[1] * normal[0] };
+					float length = sqrtf(edgeNormal[0] * edgeNormal[0] + edgeNormal[1] * edgeNormal[1] + edgeNormal[2] * edgeNormal[2]);
+					if (length <= 0.0f)
+						continue;
+
+					for (uint32_t c = 0; c < 3; c++)
+						edgeNormal[c] /= length;
+
+					float edgeDistance = -(edgeNormal[0] * pa[0] + edgeNormal[1] * pa[1] + edgeNormal[2] * pa[2]);
+					float weight = (edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]) * BmBorderEdgeWeight;
+					AddPlaneQuadric(quadrics[remap[a]], edgeNormal, edgeDistance, weight);
+					AddPlaneQuadric(quadrics[remap[b]], edgeNormal, edgeDistance, weight);
+				}
+			}
+
+			return true;
+		}
+
+		// collapses edges until at most targetTriangleCount triangles are left or the next collapse would move the
+		// surface further than maxError from the mesh, relative to its extent. returns the furthest it has moved
+		float Simplify(uint32_t targetTriangleCount, float maxError)
+		{
+			float maxErrorSq = maxError * maxError;
+
+			while (GetTriangleCount() > targetTriangleCount)
+			{
+				uint32_t triangleCount = GetTriangleCount();
+				FindOpenEdges();
+				ClassifyVertices();
+				BuildTriangleAdjacency();
+
+				// possible collapses of every edge, each undirected edge is visited from one of its triangles
+				candidates.clear();
+				for (uint32_t t = 0; t < triangleCount; t++)
+				{
+					for (uint32_t e = 0; e < 3; e++)
+					{
+						uint32_t a = indices[t * 3 + e], b = indices[t * 3 + (e + 1) % 3];
+						if (a > b && !IsOpenEdge(a, b))
+							continue;
+
+						// only the cheaper way round is kept
+						float forward = GetCollapseError(a, b), backward = GetCollapseError(b, a);
+						if (forward < backward)
+							candidates.push_back(Candidate{ a, b, forward });
+						else if (backward < FLT_MAX)
+							candidates.push_back(Candidate{ b, a, backward });
+					}
+				}
+
+				SortCandidates();
+
+				// errors go stale as quadrics merge, so a big pass stops once collapses cost well more than the ones it
+				// needs would if half of them could be made. the last few percent are done in one go
+				uint32_t removeGoal = triangleCount - targetTriangleCount;
+				float errorGoal = removeGoal < candidates.size() && removeGoal > triangleCount / 16 ? candidates[removeGoal].error * 1.5f : FLT_MAX;
+
+				collapseRemap.resize(vertexCount);
+				for (uint32_t v = 0; v < vertexCount; v++)
+					collapseRemap[v] = v;
+				collapseLocked.assign(vertexCount, 0);
+
+				uint32_t removed = 0;
+				uint32_t collapses = 0;
+				for (const Candidate& candidate : candidates)
+				{
+					if (candidate.error > maxErrorSq || removed >= removeGoal || (candidate.error > errorGoal && removed > removeGoal / 10))
+						break;
+
+					uint32_t v = candidate.vertex, target = candidate.target;
+					if (collapseLocked[remap[v]] || collapseLocked[remap[target]])
+						continue;
+
+					bool seam = kinds[v] == BmCollapseKind::Seam;
+					uint32_t twin = wedge[v], twinTarget = wedge[target];
+					if (HasFlips(v, target) || (seam && HasFlips(twin, twinTarget)))
+						continue;
+
+					removed += CountSharedTriangles(v, target) + (seam ? CountSharedTriangles(twin, twinTarget) : 0);
+					collapseRemap[v] = target;
+					if (seam)
+						collapseRemap[twin] = twinTarget;
+
+					if (recordCollapses)
+						collapseLog.push_back(BmCollapse{ v, target, seam ? twin : UINT32_MAX, seam ? twinTarget : UINT32_MAX, candidate.error });
+
+					AddQuadric(quadrics[remap[target]], quadrics[remap[v]]);
+					collapseLocked[remap[v]] = 1;
+					collapseLocked[remap[target]] = 1;
+					error = candidate.error > error ? candidate.error : error;
+					collapses++;
+				}
+
+				if (collapses == 0)
+					break;
+
+				for (uint32_t& index : indices)
+					index = collapseRemap[index];
+				RemoveDegenerateTriangles();
+			}
+
+			return sqrtf(error);
+		}
+
+		uint32_t GetTriangleCount() const { return static_cast<uint32_t>(indices.size() / 3); }
+
+		// triangles left after the last call to Simplify and the group of each
+		const std::vector<uint32_t>& GetIndices() const { return indices; }
+		const std::vector<uint16_t>& GetGroups() const { return groups; }
+
+		// keeps every collapse Simplify makes from now on, in an order they can be made one at a time.
+		// collapses of the same pass don't touch each other's positions so the order within a pass is free
+		void RecordCollapses(bool record) { recordCollapses = record; }
+		const std::vector<BmCollapse>& GetCollapses() const { return collapseLog; }
+
+		// the same number for every vertex at a position, triangles with two corners at one position are dropped
+		const std::vector<uint32_t>& GetPositionRemap() const { return remap; }
+
+	private:
+
+		struct Candidate
+		{
+			uint32_t	vertex;
+			uint32_t	target;
+			float		error;
+		};
+
+		// remap[v] is the first vertex at the position of v, wedge[v] the next one there in a ring
+		void BuildPositionRemap(const float* sourcePositions)
+		{
+			remap.resize(vertexCount);
+			wedge.resize(vertexCount);
+
+			uint32_t tableSize = 1;
+			while (tableSize < vertexCount * 2)
+				tableSize *= 2;
+			std::vector<uint32_t> table(tableSize, UINT32_MAX);
+
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				// -0 and 0 are the same position
+				float key[3] = { sourcePositions[static_cast<size_t>(v) * 3] + 0.0f, sourcePositions[static_cast<size_t>(v) * 3 + 1] + 0.0f,
+					sourcePositions[static_cast<size_t>(v) * 3 + 2] + 0.0f };
+				uint32_t bits[3];
+				memcpy(bits, key, sizeof(bits));
+
+				uint32_t hash = 2166136261u;
+				for (uint32_t c = 0; c < 3; c++)
+					hash = ((hash ^ bits[c]) * 16777619u) ^ (hash >> 15);
+
+				for (uint32_t slot = hash & (tableSize - 1); ; slot = (slot + 1) & (tableSize - 1))
+				{
+					uint32_t other = table[slot];
+					if (other == UINT32_MAX)
+					{
+						table[slot] = v;
+						remap[v] = v;
+						wedge[v] = v;
+						break;
+					}
+
+					float otherKey[3] = { sourcePositions[static_cast<size_t>(other) * 3] + 0.0f, sourcePositions[static_cast<size_t>(other) * 3 + 1] + 0.0f,
+						sourcePositions[static_cast<size_t>(other) * 3 + 2] + 0.0f };
+					if (memcmp(key, otherKey, sizeof(key)) == 0)
+					{
+						remap[v] = other;
+						wedge[v] = wedge[other];
+						wedge[other] = v;
+						break;
+					}
+				}
+			}
+		}
+
+		// drops triangles with two corners at the same position
+		void RemoveDegenerateTriangles()
+		{
+			uint32_t kept = 0;
+			for (uint32_t t = 0; t < indices.size() / 3; t++)
+			{
+				uint32_t a = indices[t * 3], b = indices[t * 3 + 1], c = indices[t * 3 + 2];
+				if (remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c])
+					continue;
+
+				indices[kept * 3] = a;
+				indices[kept * 3 + 1] = b;
+				indices[kept * 3 + 2] = c;
+				groups[kept] = groups[t];
+				kept++;
+			}
+			indices.resize(static_cast<size_t>(kept) * 3);
+			groups.resize(kept);
+		}
+
+		// unit normal of a triangle and its area
+		float GetTriangleNormal(uint32_t a, uint32_t b, uint32_t c, float* normal) const
+		{
+			const float* pa = &positions[a * 3];
+			const float* pb = &positions[b * 3];
+			const float* pc = &positions[c * 3];
+			float e1[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+			float e2[3] = { pc[0] - pa[0], pc[1] - pa[1], pc[2] - pa[2] };
+			normal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+			normal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+			normal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+
+			float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (uint32_t i = 0; i < 3 && length > 0.0f; i++)
+				normal[i] /= length;
+			return length * 0.5f;
+		}
+
+		// an edge a->b is open when no triangle of the same group runs b->a, up to two open edges are kept
+		// going out of and coming in to each vertex, with a count that stops at 3
+		void FindOpenEdges()
+		{
+			uint32_t triangleCount = GetTriangleCount();
+			edgeStart.assign(vertexCount + 1, 0);
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+				edgeStart[indices[i] + 1]++;
+			for (uint32_t v = 0; v < vertexCount; v++)
+				edgeStart[v + 1] += edgeStart[v];
+
+			edgeTarget.resize(static_cast<size_t>(triangleCount) * 3);
+			edgeGroup.resize(static_cast<size_t>(triangleCount) * 3);
+			{
+				std::vector<uint32_t> fill(edgeStart.begin(), edgeStart.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; t++)
+				{
+					for (uint32_t e = 0; e < 3; e++)
+					{
+						uint32_t a = indices[t * 3 + e];
+						uint32_t slot = fill[a]++;
+						edgeTarget[slot] = indices[t * 3 + (e + 1) % 3];
+						edgeGroup[slot] = groups[t];
+					}
+				}
+			}
+
+			openOutCount.assign(vertexCount, 0);
+			openInCount.assign(vertexCount, 0);
+			openOut.resize(static_cast<size_t>(vertexCount) * 2);
+			openIn.resize(static_cast<size_t>(vertexCount) * 2);
+
+			for (uint32_t a = 0; a < vertexCount; a++)
+			{
+				for (uint32_t e = edgeStart[a]; e < edgeStart[a + 1]; e++)
+				{
+					uint32_t b = edgeTarget[e];
+					bool closed = false;
+					for (uint32_t r = edgeStart[b]; r < edgeStart[b + 1] && !closed; r++)
+						closed = edgeTarget[r] == a && edgeGroup[r] == edgeGroup[e];
+
+					if (closed)
+						continue;
+
+					if (openOutCount[a] < 2)
+						openOut[a * 2 + openOutCount[a]] = b;
+					openOutCount[a] += openOutCount[a] < 3 ? 1 : 0;
+
+					if (openInCount[b] < 2)
+						openIn[b * 2 + openInCount[b]] = a;
+					openInCount[b] += openInCount[b] < 3 ? 1 : 0;
+				}
+			}
+		}
+
+		bool IsOpenEdge(uint32_t a, uint32_t b) const
+		{
+			return (openOutCount[a] > 0 && openOut[a * 2] == b) || (openOutCount[a] > 1 && openOut[a * 2 + 1] == b);
+		}
+
+		bool IsOpenNeighbour(uint32_t v, uint32_t other) const
+		{
+			for (uint32_t k = 0; k < openOutCount[v] && k < 2; k++)
+			{
+				if (openOut[v * 2 + k] == other)
+					return true;
+			}
+			for (uint32_t k = 0; k < openInCount[v] && k < 2; k++)
+			{
+				if (openIn[v * 2 + k] == other)
+					return true;
+			}
+			return false;
+		}
+
+		void ClassifyVertices()
+		{
+			kinds.resize(vertexCount);
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				uint32_t outCount = openOutCount[v], inCount = openInCount[v];
+				const uint32_t* outs = &openOut[v * 2];
+				const uint32_t* ins = &openIn[v * 2];
+				BmCollapseKind kind = BmCollapseKind::Locked;
+
+				if (wedge[v] == v)
+				{
+					// a border has two neighbours along it at different positions, an open border gives one edge
+					// each way and a border between submeshes two
+					if (outCount == 0 && inCount == 0)
+						kind = BmCollapseKind::Manifold;
+					else if (outCount == 1 && inCount == 1 && remap[outs[0]] != remap[ins[0]])
+						kind = BmCollapseKind::Border;
+					else if (outCount == 2 && inCount == 2 && remap[outs[0]] != remap[outs[1]] &&
+						((outs[0] == ins[0] && outs[1] == ins[1]) || (outs[0] == ins[1] && outs[1] == ins[0])))
+						kind = BmCollapseKind::Border;
+				}
+				else if (wedge[wedge[v]] == v)
+				{
+					// the open edges of the two sides of a seam run between the same positions the opposite way
+					uint32_t twin = wedge[v];
+					if (outCount == 1 && inCount == 1 && openOutCount[twin] == 1 && openInCount[twin] == 1 && remap[outs[0]] != remap[ins[0]] &&
+						remap[outs[0]] == remap[openIn[twin * 2]] && remap[ins[0]] == remap[openOut[twin * 2]])
+						kind = BmCollapseKind::Seam;
+				}
+
+				kinds[v] = kind;
+			}
+		}
+
+		// triangles around each vertex
+		void BuildTriangleAdjacency()
+		{
+			uint32_t triangleCount = GetTriangleCount();
+			adjacencyStart.assign(vertexCount + 1, 0);
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+				adjacencyStart[indices[i] + 1]++;
+			for (uint32_t v = 0; v < vertexCount; v++)
+				adjacencyStart[v + 1] += adjacencyStart[v];
+
+			adjacency.resize(static_cast<size_t>(triangleCount) * 3);
+			std::vector<uint32_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+			for (uint32_t i = 0; i < triangleCount * 3; i++)
+				adjacency[fill[indices[i]]++] = i / 3;
+		}
+
+		// error of moving v on to target, FLT_MAX when v can't move there
+		float GetCollapseError(uint32_t v, uint32_t target) const
+		{
+			BmCollapseKind kind = kinds[v], targetKind = kinds[target];
+			switch (kind)
+			{
+				case BmCollapseKind::Manifold:
+				break;
+				case BmCollapseKind::Border:
+					if ((targetKind != BmCollapseKind::Border && targetKind != BmCollapseKind::Locked) || !IsOpenNeighbour(v, target))
+						return FLT_MAX;
+				break;
+				case BmCollapseKind::Seam:
+					if (targetKind != BmCollapseKind::Seam || !IsOpenNeighbour(v, target) || !IsOpenNeighbour(wedge[v], wedge[target]))
+						return FLT_MAX;
+				break;
+				default:
+				return FLT_MAX;
+			}
+
+			return GetQuadricError(quadrics[remap[v]], &positions[target * 3]);
+		}
+
+		// orders the candidates by error with a radix sort of the top 16 bits of the error. errors aren't negative
+		// so their bits sort like integers, and ordering them to within a percent is plenty for picking collapses
+		void SortCandidates()
+		{
+			uint32_t counts[2][256] = {};
+			for (const Candidate& candidate : candidates)
+			{
+				uint32_t key;
+				memcpy(&key, &candidate.error, sizeof(key));
+				counts[0][(key >> 16) & 0xFF]++;
+				counts[1][key >> 24]++;
+			}
+
+			sortedCandidates.resize(candidates.size());
+			for (uint32_t pass = 0; pass < 2; pass++)
+			{
+				uint32_t offset = 0;
+				for (uint32_t b = 0; b < 256; b++)
+				{
+					uint32_t count = counts[pass][b];
+					counts[pass][b] = offset;
+					offset += count;
+				}
+
+				for (const Candidate& candidate : candidates)
+				{
+					uint32_t key;
+					memcpy(&key, &candidate.error, sizeof(key));
+					sortedCandidates[counts[pass][(key >> (16 + pass * 8)) & 0xFF]++] = candidate;
+				}
+				candidates.swap(sortedCandidates);
+			}
+		}
+
+		// true when moving v on to target turns a triangle that stays over, positions of vertices collapsed
+		// earlier in the pass are where they moved to
+		bool HasFlips(uint32_t v, uint32_t target) const
+		{
+			const float* pv = &positions[v * 3];
+			const float* pt = &positions[target * 3];
+
+			for (uint32_t a = adjacencyStart[v]; a < adjacencyStart[v + 1]; a++)
+			{
+				const uint32_t* corners = &indices[adjacency[a] * 3];
+				uint32_t first = corners[0] == v ? 1 : (corners[1] == v ? 2 : 0);
+				uint32_t b = collapseRemap[corners[first]], c = collapseRemap[corners[(first + 1) % 3]];
+				if (remap[b] == remap[target] || remap[c] == remap[target])
+					continue;
+
+				const float* pb = &positions[b * 3];
+				const float* pc = &positions[c * 3];
+				float before[3], after[3];
+				float e1[3] = { pb[0] - pv[0], pb[1] - pv[1], pb[2] - pv[2] };
+				float e2[3] = { pc[0] - pv[0], pc[1] - pv[1], pc[2] - pv[2] };
+				float f1[3] = { pb[0] - pt[0], pb[1] - pt[1], pb[2] - pt[2] };
+				float f2[3] = { pc[0] - pt[0], pc[1] - pt[1], pc[2] - pt[2] };
+				before[0] = e1[1] * e2[2] - e1[2] * e2[1]; before[1] = e1[2] * e2[0] - e1[0] * e2[2]; before[2] = e1[0] * e2[1] - e1[1] * e2[0];
+				after[0] = f1[1] * f2[2] - f1[2] * f2[1]; after[1] = f1[2] * f2[0] - f1[0] * f2[2]; after[2] = f1[0] * f2[1] - f1[1] * f2[0];
+
+				if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0.0f)
+					return true;
+			}
+
+			return false;
+		}
+
+		uint32_t CountSharedTriangles(uint32_t v, uint32_t target) const
+		{
+			uint32_t count = 0;
+			for (uint32_t a = adjacencyStart[v]; a < adjacencyStart[v + 1]; a++)
+			{
+				const uint32_t* corners = &indices[adjacency[a] * 3];
+				count += (corners[0] == target || corners[1] == target || corners[2] == target) ? 1 : 0;
+			}
+			return count;
+		}
+
+		uint32_t				vertexCount;
+		float					error;			// largest squared error of the collapses made
+
+		std::vector<uint32_t>	indices;
+		std::vector<uint16_t>	groups;
+		std::vector<float>		positions;
+		std::vector<uint32_t>	remap;
+		std::vector<uint32_t>	wedge;
+		std::vector<BmQuadric>	quadrics;		// of each position, at its first vertex
+		bool					recordCollapses;
+		std::vector<BmCollapse>	collapseLog;
+
+		// rebuilt every pass
+		std::vector<uint32_t>	edgeStart;
+		std::vector<uint32_t>	edgeTarget;
+		std::vector<uint16_t>	edgeGroup;
+		std::vector<uint8_t>	openOutCount;
+		std::vector<uint8_t>	openInCount;
+		std::vector<uint32_t>	openOut;
+		std::vector<uint32_t>	openIn;
+		std::vector<BmCollapseKind>	kinds;
+		std::vector<uint32_t>	adjacencyStart;
+		std::vector<uint32_t>	adjacency;
+		std::vector<Candidate>	candidates;
+		std::vector<Candidate>	sortedCandidates;
+		std::vector<uint32_t>	collapseRemap;
+		std::vector<uint8_t>	collapseLocked;
+	};
+
+	// =================================
+	// Levels of Detail
+	// =================================
+
+	// builds the levels of detail of every mesh of the model on the worker pool, replacing any it had. each level
+	// continues from the one before and the chain ends early when maxError stops a level before it removes more
+	// than a tenth of the triangles left, such a level would be little cheaper than the one before.
+	// positions are read through vertLayout, which must describe V. meshes without positions or with indices
+	// referencing missing vertices are left without levels and make it return false
+	template<typename V, typename I>
+	BM_FUNC_DECL bool BuildLods(BmModel<V, I>& model, const BmVertLayout* vertLayout = &BmDefaultLayout, const BmLodOptions& options = BmLodOptions())
+	{
+		uint32_t meshCount = model.meshList.count;
+
+		std::vector<BmIndexRange> ranges;
+		GetIndexRanges(model, ranges);
+
+		std::vector<uint32_t> firstRange(meshCount + 1, static_cast<uint32_t>(ranges.size()));
+		for (uint32_t r = static_cast<uint32_t>(ranges.size()); r-- > 0; )
+			firstRange[ranges[r].mesh] = r;
+		for (uint32_t m = meshCount; m-- > 0; )
+			firstRange[m] = firstRange[m] < firstRange[m + 1] ? firstRange[m] : firstRange[m + 1];
+
+		std::vector<uint8_t> meshBuilt(meshCount, 0);
+		GetWorkerPool().ParallelFor(meshCount, [&](uint32_t m)
+		{
+			BmMesh<V, I>& mesh = model.meshList[m];
+			mesh.lods.resize(0);
+			mesh.lodIndices.resize(0);
+			mesh.lodSubMeshes.resize(0);
+
+			std::vector<float> positions;
+			if (!GetMeshPositions(mesh, vertLayout, positions))
+				return;
+
+			// the triangles of every submesh, grouped by the number of the range they came from
+			uint32_t rangeCount = firstRange[m + 1] - firstRange[m];
+			std::vector<uint32_t> indices;
+			std::vector<uint16_t> groups;
+			for (uint32_t r = 0; r < rangeCount; r++)
+			{
+				VisitIndexRange(mesh, ranges[firstRange[m] + r], [&](auto* rangeIndices, uint32_t indexCount)
+				{
+					indices.insert(indices.end(), rangeIndices, rangeIndices + indexCount / 3 * 3);
+				});
+				groups.resize(indices.size() / 3, static_cast<uint16_t>(r));
+			}
+
+			BmSimplifier simplifier;
+			if (!simplifier.Init(indices.data(), static_cast<uint32_t>(indices.size()), groups.data(), positions.data(), static_cast<uint32_t>(positions.size() / 3)))
+				return;
+
+			uint32_t meshTriangles = static_cast<uint32_t>(indices.size() / 3);
+			uint32_t previousTriangles = meshTriangles;
+			std::vector<uint32_t> rangeStart(rangeCount + 1);
+
+			for (size_t l = 0; l < options.levels.size(); l++)
+			{
+				uint32_t targetTriangles = static_cast<uint32_t>(meshTriangles * options.levels[l]);
+				float lodError = simplifier.Simplify(targetTriangles, options.maxError);
+				uint32_t triangleCount = simplifier.GetTriangleCount();
+				if (triangleCount >= previousTriangles ||
+					(triangleCount > targetTriangles && static_cast<uint64_t>(previousTriangles - triangleCount) * 10 <= previousTriangles))
+					break;
+				previousTriangles = triangleCount;
+
+				// back in submesh order, each submesh ordered for the vertex cache
+				const std::vector<uint32_t>& simplified = simplifier.GetIndices();
+				const std::vector<uint16_t>& simplifiedGroups = simplifier.GetGroups();
+
+				std::fill(rangeStart.begin(), rangeStart.end(), 0);
+				for (uint32_t t = 0; t < triangleCount; t++)
+					rangeStart[simplifiedGroups[t] + 1]++;
+				for (uint32_t r = 0; r < rangeCount; r++)
+					rangeStart[r + 1] += rangeStart[r];
+
+				std::vector<uint32_t> levelIndices(static_cast<size_t>(triangleCount) * 3);
+				{
+					std::vector<uint32_t> fill(rangeStart.begin(), rangeStart.end() - 1);
+					for (uint32_t t = 0; t < triangleCount; t++)
+					{
+						uint32_t slot = fill[simplifiedGroups[t]]++;
+						for (uint32_t c = 0; c < 3; c++)
+							levelIndices[slot * 3 + c] = simplified[t * 3 + c];
+					}
+				}
+
+				BmMeshLod lod;
+				lod.indexOffset = mesh.lodIndices.count;
+				lod.indexCount = triangleCount * 3;
+				lod.subMeshOffset = mesh.lodSubMeshes.count;
+				lod.subMeshCount = 0;
+				lod.level = static_cast<uint16_t>(l + 1);
+				lod.error = lodError;
+
+				for (uint32_t r = 0; r < rangeCount; r++)
+				{
+					uint32_t first = rangeStart[r] * 3, count = (rangeStart[r + 1] - rangeStart[r]) * 3;
+					OptimizeVertexCache(levelIndices.data() + first, count);
+
+					if (mesh.subMeshList.count > 0)
+					{
+						mesh.lodSubMeshes.add(BmSubMesh{ first, count, mesh.subMeshList[ranges[firstRange[m] + r].subMesh].materialID });
+						lod.subMeshCount++;
+					}
+				}
+
+				mesh.lodIndices.reserve(lod.indexOffset + lod.indexCount);
+				for (uint32_t index : levelIndices)
+					mesh.lodIndices.add(static_cast<I>(index));
+				mesh.lods.add(lod);
+			}
+
+			meshBuilt[m] = 1;
+		});
+
+		uint32_t builtCount = 0;
+		for (uint32_t m = 0; m < meshCount; m++)
+			builtCount += meshBuilt[m];
+
+		BM_LOG("Levels of detail built for %u of %u meshes\n", builtCount, meshCount);
+
+		return builtCount == meshCount;
+	}
+
+	// =================================
+	// Progressive Meshes
+	// =================================
+
+	// turns every mesh of the model in to a progressive mesh on the worker pool, the coarse base the simplifier collapses it
+	// to and the vertex splits undoing those collapses one at a time, see BmMesh::vertexSplits. vertices are renumbered with
+	// the ones of the base first and then the ones each split adds, and each submesh holds its base triangles followed by the
+	// ones the splits add in the order they are made. with every split made the mesh has all of its triangles again.
+	// meshlet vertices and lod indices are renumbered along with the vertices, passes reordering vertices or triangles
+	// afterwards leave the splits describing the wrong mesh so this goes last. meshes with vertex streams, compact indices or
+	// submeshes reaching past their indices are left as they are and make it return false
+	template<typename V, typename I>
+	BM_FUNC_DECL bool BuildProgressiveMeshes(BmModel<V, I>& model, const BmVertLayout* vertLayout = &BmDefaultLayout, const BmProgressiveOptions& options = BmProgressiveOptions())
+	{
+		uint32_t meshCount = model.meshList.count;
+
+		std::vector<BmIndexRange> ranges;
+		GetIndexRanges(model, ranges);
+
+		std::vector<uint32_t> firstRange(meshCount + 1, static_cast<uint32_t>(ranges.size()));
+		for (uint32_t r = static_cast<uint32_t>(ranges.size()); r-- > 0; )
+			firstRange[ranges[r].mesh] = r;
+		for (uint32_t m = meshCount; m-- > 0; )
+			firstRange[m] = firstRange[m] < firstRange[m + 1] ? firstRange[m] : firstRange[m + 1];
+
+		std::vector<uint8_t> meshBuilt(meshCount, 0);
+		GetWorkerPool().ParallelFor(meshCount, [&](uint32_t m)
+		{
+			BmMesh<V, I>& mesh = model.meshList[m];
+			mesh.vertexSplits.resize(0);
+			mesh.splitTriangles.resize(0);
+			mesh.splitUpdates.resize(0);
+
+			uint32_t rangeCount = firstRange[m + 1] - firstRange[m];
+			if (mesh.streams.count > 0 || mesh.compactIndices.count > 0 || (mesh.subMeshList.count > 0 && rangeCount != mesh.subMeshList.count))
+				return;
+
+			std::vector<float> positions;
+			if (!GetMeshPositions(mesh, vertLayout, positions))
+				return;
+
+			// the triangles of every submesh, grouped by the submesh they came from
+			std::vector<uint32_t> indices;
+			std::vector<uint16_t> groups;
+			for (uint32_t r = 0; r < rangeCount; r++)
+			{
+				const BmIndexRange& range = ranges[firstRange[m] + r];
+				if (range.indexCount % 3 != 0)
+					return;
+
+				indices.insert(indices.end(), mesh.indices.data + range.indexOffset, mesh.indices.data + range.indexOffset + range.indexCount);
+				groups.resize(indices.size() / 3, static_cast<uint16_t>(r));
+			}
+
+			uint32_t vertexCount = mesh.vertices.count;
+			uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+
+			BmSimplifier simplifier;
+			simplifier.RecordCollapses(true);
+			if (!simplifier.Init(indices.data(), static_cast<uint32_t>(indices.size()), groups.data(), positions.data(), vertexCount))
+				return;
+			simplifier.Simplify(static_cast<uint32_t>(triangleCount * options.baseRatio), options.maxError);
+
+			const std::vector<BmCollapse>& collapses = simplifier.GetCollapses();
+			const std::vector<uint32_t>& positionRemap = simplifier.GetPositionRemap();
+			uint32_t collapseCount = static_cast<uint32_t>(collapses.size());
+
+			std::vector<uint32_t> collapsedAt(vertexCount, UINT32_MAX);
+			std::vector<uint32_t> collapseTarget(vertexCount);
+			for (uint32_t k = 0; k < collapseCount; k++)
+			{
+				collapsedAt[collapses[k].vertex] = k;
+				collapseTarget[collapses[k].vertex] = collapses[k].target;
+				if (collapses[k].twin != UINT32_MAX)
+				{
+					collapsedAt[collapses[k].twin] = k;
+					collapseTarget[collapses[k].twin] = collapses[k].twinTarget;
+				}
+			}
+
+			auto isDegenerate = [&](const uint32_t* corners)
+			{
+				return positionRemap[corners[0]] == positionRemap[corners[1]] || positionRemap[corners[1]] == positionRemap[corners[2]] ||
+					positionRemap[corners[0]] == positionRemap[corners[2]];
+			};
+
+			// follows each triangle through the collapses until it is dropped, keeping the corners that move on the way.
+			// the split undoing collapse k is split collapseCount - 1 - k, a triangle dropped by it is added by that split
+			// and one never dropped is in the base. triangles that had no area to begin with are added by a last split
+			struct CornerMove
+			{
+				uint32_t collapse;
+				uint32_t corner;
+				uint32_t from;
+				uint32_t to;
+			};
+
+			std::vector<uint32_t> addedBy(triangleCount);
+			std::vector<CornerMove> moves;
+			uint32_t lastSplit = collapseCount;
+			for (uint32_t t = 0; t < triangleCount; t++)
+			{
+				uint32_t corners[3] = { indices[t * 3], indices[t * 3 + 1], indices[t * 3 + 2] };
+				if (isDegenerate(corners))
+				{
+					addedBy[t] = lastSplit + 1;
+					continue;
+				}
+
+				addedBy[t] = 0;
+				while (true)
+				{
+					uint32_t k = collapsedAt[corners[0]];
+					k = collapsedAt[corners[1]] < k ? collapsedAt[corners[1]] : k;
+					k = collapsedAt[corners[2]] < k ? collapsedAt[corners[2]] : k;
+					if (k == UINT32_MAX)
+						break;
+
+					uint32_t moved[3];
+					for (uint32_t c = 0; c < 3; c++)
+						moved[c] = collapsedAt[corners[c]] == k ? collapseTarget[corners[c]] : corners[c];
+
+					if (isDegenerate(moved))
+					{
+						addedBy[t] = collapseCount - k;
+						break;
+					}
+
+					for (uint32_t c = 0; c < 3; c++)
+					{
+						if (moved[c] != corners[c])
+							moves.push_back(CornerMove{ k, t * 3 + c, corners[c], moved[c] });
+						corners[c] = moved[c];
+					}
+				}
+			}
+
+			// vertices of the base, then the ones each split brings back, then any no triangle uses
+			std::vector<uint8_t> used(vertexCount, 0);
+			for (uint32_t index : indices)
+				used[index] = 1;
+
+			std::vector<uint32_t> vertexRemap(vertexCount, UINT32_MAX);
+			uint32_t nextVertex = 0;
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				if (used[v] && collapsedAt[v] == UINT32_MAX)
+					vertexRemap[v] = nextVertex++;
+			}
+			for (uint32_t k = collapseCount; k-- > 0; )
+			{
+				uint32_t twin = collapses[k].twin;
+				if (vertexRemap[collapses[k].vertex] != UINT32_MAX || (twin != UINT32_MAX && (twin == collapses[k].vertex || vertexRemap[twin] != UINT32_MAX)))
+					return;
+
+				vertexRemap[collapses[k].vertex] = nextVertex++;
+				if (twin != UINT32_MAX)
+					vertexRemap[twin] = nextVertex++;
+			}
+			uint32_t unusedCount = 0;
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				if (!used[v])
+				{
+					vertexRemap[v] = nextVertex++;
+					unusedCount++;
+				}
+			}
+
+			// base triangles first in each submesh, then the triangles of each split in the order the splits are made
+			uint32_t splitCount = collapseCount + 1;
+			std::vector<uint32_t> splitStart(splitCount + 2, 0);
+			for (uint32_t t = 0; t < triangleCount; t++)
+				splitStart[addedBy[t] + 1]++;
+			for (uint32_t j = 0; j <= splitCount; j++)
+				splitStart[j + 1] += splitStart[j];
+
+			std::vector<uint32_t> orderedTriangles(triangleCount);
+			{
+				std::vector<uint32_t> fill(splitStart.begin(), splitStart.end() - 1);
+				for (uint32_t t = 0; t < triangleCount; t++)
+					orderedTriangles[fill[addedBy[t]]++] = t;
+			}
+
+			std::vector<uint32_t> regionStart(rangeCount + 1, 0);
+			for (uint32_t t = 0; t < triangleCount; t++)
+				regionStart[groups[t] + 1] += 3;
+			for (uint32_t r = 0; r < rangeCount; r++)
+				regionStart[r + 1] += regionStart[r];
+
+			std::vector<uint32_t> trianglePosition(triangleCount);
+			{
+				std::vector<uint32_t> fill(regionStart.begin(), regionStart.end() - 1);
+				for (uint32_t t : orderedTriangles)
+				{
+					trianglePosition[t] = fill[groups[t]];
+					fill[groups[t]] += 3;
+				}
+			}
+
+			// corner moves of each split, undone in the opposite order to the collapses
+			std::vector<uint32_t> moveStart(collapseCount + 1, 0);
+			for (const CornerMove& move : moves)
+				moveStart[collapseCount - move.collapse]++;
+			for (uint32_t j = 0; j < collapseCount; j++)
+				moveStart[j + 1] += moveStart[j];
+
+			std::vector<BmIndexUpdate> updates(moves.size());
+			{
+				std::vector<uint32_t> fill(moveStart.begin(), moveStart.end() - 1);
+				for (const CornerMove& move : moves)
+				{
+					BmIndexUpdate& update = updates[fill[collapseCount - 1 - move.collapse]++];
+					update.position = trianglePosition[move.corner / 3] + move.corner % 3;
+					update.previous = vertexRemap[move.to];
+					update.vertex = vertexRemap[move.from];
+				}
+			}
+
+			// the mesh with every split made, in the new order
+			RemapVertices(reinterpret_cast<uint8_t*>(mesh.vertices.data), vertexCount, sizeof(V), vertexRemap.data());
+			RemapIndices(mesh.meshletVertices.data, mesh.meshletVertices.count, vertexRemap.data());
+			RemapIndices(mesh.lodIndices.data, mesh.lodIndices.count, vertexRemap.data());
+
+			mesh.indices.resize(triangleCount * 3);
+			for (uint32_t t = 0; t < triangleCount; t++)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+					mesh.indices[trianglePosition[t] + c] = static_cast<I>(vertexRemap[indices[t * 3 + c]]);
+			}
+
+			for (uint32_t r = 0; r < mesh.subMeshList.count; r++)
+			{
+				mesh.subMeshList[r].indexOffset = regionStart[r];
+				mesh.subMeshList[r].indexCount = regionStart[r + 1] - regionStart[r];
+			}
+
+			float error = 0.0f;
+			std::vector<float> collapseError(collapseCount);
+			for (uint32_t k = 0; k < collapseCount; k++)
+			{
+				error = collapses[k].error > error ? collapses[k].error : error;
+				collapseError[k] = sqrtf(error);
+			}
+
+			for (uint32_t j = 0; j < splitCount; j++)
+			{
+				bool last = j == collapseCount;
+				uint32_t triangleFirst = splitStart[j + 1], triangleEnd = splitStart[j + 2];
+				if (last && triangleFirst == triangleEnd && unusedCount == 0)
+					break;
+
+				BmVertexSplit split;
+				split.vertexCount = last ? unusedCount : (collapses[collapseCount - 1 - j].twin != UINT32_MAX ? 2 : 1);
+				split.triangleOffset = mesh.splitTriangles.count;
+				split.triangleCount = triangleEnd - triangleFirst;
+				split.updateOffset = mesh.splitUpdates.count;
+				split.updateCount = last ? 0 : moveStart[j + 1] - moveStart[j];
+				split.error = last ? 0.0f : collapseError[collapseCount - 1 - j];
+
+				for (uint32_t o = triangleFirst; o < triangleEnd; o++)
+					mesh.splitTriangles.add(trianglePosition[orderedTriangles[o]]);
+				for (uint32_t u = 0; u < split.updateCount; u++)
+					mesh.splitUpdates.add(updates[moveStart[j] + u]);
+				mesh.vertexSplits.add(split);
+			}
+
+			meshBuilt[m] = 1;
+		});
+
+		uint32_t builtCount = 0;
+		for (uint32_t m = 0; m < meshCount; m++)
+			builtCount += meshBuilt[m];
+
+		BM_LOG("Progressive meshes built for %u of %u meshes\n", builtCount, meshCount);
+
+		return builtCount == meshCount;
+	}
+}
@@ -2,6 +2,8 @@
 
 #include "bmdl_common.h"
 
+#include <new>
+
 // =================================
 // Basic Model : List
 // Simple dynamic array implementation
@@ -12,11 +14,11 @@ class BmList
 {
 public:
 
-	BmList() { count = capacity = 0; data = nullptr; }
+	BmList() { count = capacity = 0; data = nullptr; ownsData = true; }
 	BmList(uint32_t size) : BmList() { reserve(size); }
 	BmList(T* newData, uint32_t length) : BmList() { setData(newData, length); }
 
-	~BmList() { if (data != nullptr) BM_FREE(data); }
+	~BmList() { if (data != nullptr && ownsData) BM_FREE(data); }
 
 	typedef T* iterator;
 
@@ -27,6 +29,15 @@ public:
 
 	inline T& last() { BM_ASSERT(count > 0); return data[count - 1]; }
 
+	// grow or shrink the list to newCount elements, new elements are default constructed
+	inline void resize(uint32_t newCount)
+	{
+		reserve(newCount);
+		for (uint32_t i = count; i < newCount; i++)
+			new (&data[i]) T();
+		count = newCount;
+	}
+
 	inline void setData(T* newData, uint32_t length)
 	{
 		reserve(length);
@@ -34,18 +45,42 @@ public:
 		count = length;
 	}
 
+	// reference existing memory without copying it, the list will not free it.
+	// the memory is copied in to an owned buffer the first time the list needs to grow or be overwritten
+	inline void setView(T* viewData, uint32_t length)
+	{
+		if (data != nullptr && ownsData) BM_FREE(data);
+
+		data = viewData;
+		count = capacity = length;
+		ownsData = false;
+	}
+
+	inline bool isView() const { return !ownsData; }
+
+	// exchange contents with other, lists can't be copied as they would both free the data
+	inline void swap(BmList& other)
+	{
+		T* otherData = other.data; other.data = data; data = otherData;
+		uint32_t otherCount = other.count; other.count = count; count = otherCount;
+		uint32_t otherCapacity = other.capacity; other.capacity = capacity; capacity = otherCapacity;
+		bool otherOwnsData = other.ownsData; other.ownsData = ownsData; ownsData = otherOwnsData;
+	}
+
 	inline void reserve(uint32_t newCapacity)
 	{
-		if (newCapacity <= capacity) return;
+		if (newCapacity <= capacity && ownsData) return;
+		if (newCapacity < count) newCapacity = count;
 
 		T* newData = (T*)BM_ALLOC(sizeof(T) * newCapacity);
 		if (data != nullptr)
 		{
-			memcpy(newData, data, sizeof(T) * capacity);
-			BM_FREE(data);
+			memcpy(newData, data, sizeof(T) * (ownsData ? capacity : count));
+			if (ownsData) BM_FREE(data);
 		}
 		data = newData;
 		capacity = newCapacity;
+		ownsData = true;
 	}
 
 private:
@@ -57,6 +92,7 @@ public:
 	uint32_t count;
 	uint32_t capacity;
 	T* data;
+	bool ownsData;	// false when data references memory owned elsewhere (see setView)
 
 	static const uint32_t defaultCapacity = 4;
 
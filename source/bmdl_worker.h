@@ -0,0 +1,233 @@
+#pragma once
+
+#include "bmdl_common.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// =================================
+// Basic Model : Worker Pool
+// Fixed set of worker threads pulling tasks from a shared queue, used to spread
+// loading work such as mesh decoding across cores. Tasks with a higher priority
+// run first, tasks of equal priority run in the order they were submitted.
+// =================================
+
+class BmWorkerPool
+{
+public:
+
+	static const uint32_t DefaultWorkerCount = UINT32_MAX;
+
+	// DefaultWorkerCount uses one worker per hardware thread, not counting the calling thread. a pool
+	// without workers runs every task on the thread submitting it
+	explicit BmWorkerPool(uint32_t workerCount = DefaultWorkerCount) : shutdown(false), nextSequence(0)
+	{
+		if (workerCount == DefaultWorkerCount)
+		{
+			uint32_t hardwareThreads = std::thread::hardware_concurrency();
+			workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+		}
+
+		for (uint32_t w = 0; w < workerCount; w++)
+			workers.emplace_back(&BmWorkerPool::WorkerMain, this);
+	}
+
+	~BmWorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			shutdown = true;
+		}
+		queueSignal.notify_all();
+
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	BmWorkerPool(const BmWorkerPool&) = delete;
+	BmWorkerPool& operator=(const BmWorkerPool&) = delete;
+
+	uint32_t GetWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+	// queue a task to be run by the next free worker, or run it now when the pool has no workers
+	void Submit(std::function<void()> task, int32_t priority = 0)
+	{
+		if (workers.empty())
+		{
+			task();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(queueMutex);
+			tasks.push(QueuedTask(std::move(task), priority, nextSequence++));
+		}
+		queueSignal.notify_one();
+	}
+
+	static const int32_t HighestPriority = INT32_MAX;
+
+	// calls fn(i) for every i in [0, count) across the workers and the calling thread, returns once all calls completed.
+	// called from inside a worker the loop runs on the calling thread only so nested loops can't starve the pool
+	template<typename F>
+	void ParallelFor(uint32_t count, const F& fn)
+	{
+		uint32_t helpers = count > 0 ? (GetWorkerCount() < count ? GetWorkerCount() : count - 1) : 0;
+		if (helpers == 0 || IsWorkerThread())
+		{
+			for (uint32_t i = 0; i < count; i++)
+				fn(i);
+			return;
+		}
+
+		// the caller returns once every index has run, helpers dequeued after that find nothing left to claim.
+		// they only touch the shared state then, which outlives the caller's stack
+		std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>();
+		const F* loop = &fn;
+
+		auto run = [state, loop, count]()
+		{
+			uint32_t finished = 0;
+			for (uint32_t i = state->next++; i < count; i = state->next++, finished++)
+				(*loop)(i);
+
+			if (finished > 0)
+			{
+				std::lock_guard<std::mutex> lock(state->doneMutex);
+				state->completed += finished;
+				if (state->completed == count)
+					state->doneSignal.notify_one();
+			}
+		};
+
+		// the caller is blocked until the loop finishes so its helpers jump the queue
+		for (uint32_t h = 0; h < helpers; h++)
+			Submit(run, HighestPriority);
+
+		run();
+
+		std::unique_lock<std::mutex> lock(state->doneMutex);
+		state->doneSignal.wait(lock, [&]() { return state->completed == count; });
+	}
+
+	static bool IsWorkerThread() { return CurrentWorkerFlag(); }
+
+private:
+
+	struct ParallelForState
+	{
+		ParallelForState() : next(0), completed(0) {}
+
+		std::atomic<uint32_t>	next;		// next index to claim
+		uint32_t				completed;	// indices that finished running, guarded by doneMutex
+		std::mutex				doneMutex;
+		std::condition_variable	doneSignal;
+	};
+
+	struct QueuedTask
+	{
+		QueuedTask(std::function<void()> fn, int32_t priority, uint64_t sequence) :
+			fn(std::move(fn)), priority(priority), sequence(sequence) {}
+
+		// ordering for the max heap, highest priority first then oldest first
+		bool operator<(const QueuedTask& other) const
+		{
+			if (priority != other.priority)
+				return priority < other.priority;
+			return sequence > other.sequence;
+		}
+
+		std::function<void()>	fn;
+		int32_t					priority;
+		uint64_t				sequence;
+	};
+
+	static bool& CurrentWorkerFlag() { static thread_local bool isWorker = false; return isWorker; }
+
+	void WorkerMain()
+	{
+		CurrentWorkerFlag() = true;
+
+		for (;;)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(queueMutex);
+				queueSignal.wait(lock, [this]() { return shutdown || !tasks.empty(); });
+
+				if (tasks.empty())
+					return; // shutting down and nothing left to run
+
+				task = std::move(const_cast<QueuedTask&>(tasks.top()).fn);
+				tasks.pop();
+			}
+
+			task();
+		}
+	}
+
+	std::vector<std::thread>		workers;
+	std::priority_queue<QueuedTask>	tasks;
+
+	std::mutex				queueMutex;
+	std::condition_variable	queueSignal;
+	bool					shutdown;
+	uint64_t				nextSequence;
+};
+
+namespace bmdl
+{
+	inline std::unique_ptr<BmWorkerPool>& WorkerPoolInstance()
+	{
+		static std::unique_ptr<BmWorkerPool> pool;
+		return pool;
+	}
+
+	inline std::mutex& WorkerPoolMutex()
+	{
+		static std::mutex poolMutex;
+		return poolMutex;
+	}
+
+	// pool shared by the loader, created with one worker per hardware thread on first use
+	inline BmWorkerPool& GetWorkerPool()
+	{
+		std::lock_guard<std::mutex> lock(WorkerPoolMutex());
+
+		std::unique_ptr<BmWorkerPool>& pool = WorkerPoolInstance();
+		if (!pool)
+			pool.reset(new BmWorkerPool());
+
+		return *pool;
+	}
+
+	// single thread pool that performs file reads for asynchronous loads, kept separate from the
+	// worker pool so a read for one model overlaps with decoding of models already in memory
+	inline BmWorkerPool& GetIoPool()
+	{
+		static BmWorkerPool ioPool(1);
+		return ioPool;
+	}
+
+	// recreates the shared pool so loading uses threadCount threads including the caller,
+	// 0 = one per hardware thread, 1 = load on the calling thread only.
+	// must not be called while a load is in progress
+	inline void SetWorkerCount(uint32_t threadCount)
+	{
+		std::lock_guard<std::mutex> lock(WorkerPoolMutex());
+
+		std::unique_ptr<BmWorkerPool>& pool = WorkerPoolInstance();
+		pool.reset();
+		pool.reset(new BmWorkerPool(threadCount == 0 ? BmWorkerPool::DefaultWorkerCount : threadCount - 1));
+	}
+}
+
+// =================================
@@ -0,0 +1,1002 @@
+#pragma once
+
+#include "bmdl.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <queue>
+#include <string>
+#include <vector>
+
+// =================================
+// Basic Model : Writer
+// Writes .bmf files from BmModel. Output is gathered in one large buffer and written to the file
+// in big pieces, vertex and index arrays larger than the buffer go straight from the mesh to the file.
+// Meshes are prepared (index compaction, stream coding) in parallel on the worker pool before their
+// block is written, so the block length is known up front and nothing has to be patched afterwards.
+// =================================
+
+namespace bmdl
+{
+	static const uint32_t BmWriterDefaultBufferSize = 1024 * 1024;
+
+	struct BmSaveOptions
+	{
+		BmSaveOptions() : compressMeshes(false), compressBlocks(false), compactIndices(false), chunkSize(BmLzDefaultChunkSize) {}
+
+		bool		compressMeshes;		// write CompressedMeshData blocks, vertices and indices coded with bmdl_codec.h
+		bool		compressBlocks;		// wrap each block in a CompressedBlock (bmdl_lz.h)
+		bool		compactIndices;		// store indices with the smallest type able to hold them
+		uint32_t	chunkSize;			// uncompressed bytes per chunk of a CompressedBlock
+	};
+
+	// appends everything written to a vector, used to build blocks in memory
+	struct BmMemoryOutput
+	{
+		explicit BmMemoryOutput(std::vector<uint8_t>& data) : data(data) {}
+
+		void Write(const void* bytes, size_t size)
+		{
+			const uint8_t* first = static_cast<const uint8_t*>(bytes);
+			data.insert(data.end(), first, first + size);
+		}
+
+		template<typename T>
+		void Write(const T& value) { Write(&value, sizeof(T)); }
+
+		std::vector<uint8_t>& data;
+	};
+
+	struct BmWritePiece
+	{
+		const uint8_t*	data;
+		size_t			size;
+	};
+
+	// everything needed to write one mesh, referencing the mesh's own data wherever it is written as is
+	struct BmMeshWriteRecord
+	{
+		BmMeshWriteRecord() : header(), hasBounds(false), bounds(), compressed(false) {}
+
+		BmMeshHeader					header;
+		std::vector<BmSubMeshHeader>	subMeshes;
+
+		bool			hasBounds;
+		BmAttrBounds	bounds;
+		bool			compressed;
+
+		std::vector<BmWritePiece>	vertexPieces;	// vertex data, one piece per stream for non-interleaved meshes
+		BmWritePiece				indexPiece;
+
+		// storage for vertex and index data that was converted or coded before writing
+		std::vector<uint8_t>	vertexStorage;
+		std::vector<uint8_t>	indexStorage;
+
+		uint64_t GetVertexBytes() const
+		{
+			uint64_t bytes = 0;
+			for (const BmWritePiece& piece : vertexPieces)
+				bytes += piece.size;
+			return bytes;
+		}
+
+		uint64_t GetSize() const
+		{
+			return sizeof(BmMeshHeader) + subMeshes.size() * sizeof(BmSubMeshHeader) + (hasBounds ? sizeof(BmAttrBounds) : 0) +
+				(compressed ? sizeof(BmCompressedStreamHeader) : 0) + GetVertexBytes() + indexPiece.size;
+		}
+	};
+
+	inline BmIndexType GetIndexTypeForSize(uint32_t indexSize)
+	{
+		return indexSize == 1 ? BmIndexType::UInt8 : (indexSize == 2 ? BmIndexType::UInt16 : BmIndexType::UInt32);
+	}
+
+	// the coarse base of a progressive mesh. baseIndices gets the mesh indices with every split undone, regionStart where
+	// each region starts and where the last ends and baseCounts the indices each region starts with. false when the
+	// splits don't describe the mesh, as happens when a pass reorders its vertices or triangles after they were built
+	template<typename V, typename I>
+	bool GetProgressiveBase(const BmMesh<V, I>& mesh, std::vector<I>& baseIndices, std::vector<uint32_t>& regionStart, std::vector<uint32_t>& baseCounts, uint32_t& baseVertexCount)
+	{
+		if (mesh.streams.count > 0 || mesh.compactIndices.count > 0)
+		{
+			BmSetLastError("Progressive meshes need interleaved vertices and indices of the mesh index type");
+			return false;
+		}
+
+		// regions follow each other and hold every index
+		uint32_t regionCount = mesh.subMeshList.count > 0 ? mesh.subMeshList.count : 1;
+		regionStart.assign(1, 0);
+		for (uint32_t r = 0; r < mesh.subMeshList.count; r++)
+		{
+			if (mesh.subMeshList[r].indexOffset != regionStart.back())
+			{
+				BmSetLastError("Progressive mesh submeshes don't follow each other");
+				return false;
+			}
+			regionStart.push_back(regionStart.back() + mesh.subMeshList[r].indexCount);
+		}
+		if (mesh.subMeshList.count == 0)
+			regionStart.push_back(mesh.indices.count);
+
+		if (regionStart.back() != mesh.indices.count)
+		{
+			BmSetLastError("Progressive mesh submeshes don't cover its indices");
+			return false;
+		}
+
+		// splits add triangles to the end of each region in the order they are made
+		std::vector<uint32_t> addedCounts(regionCount, 0);
+		uint64_t addedVertices = 0;
+		for (uint32_t v = 0; v < mesh.vertexSplits.count; v++)
+		{
+			const BmVertexSplit& split = mesh.vertexSplits[v];
+			if (static_cast<uint64_t>(split.triangleOffset) + split.triangleCount > mesh.splitTriangles.count ||
+				static_cast<uint64_t>(split.updateOffset) + split.updateCount > mesh.splitUpdates.count)
+			{
+				BmSetLastError("Mesh vertex split data is incomplete");
+				return false;
+			}
+
+			for (uint32_t t = 0; t < split.triangleCount; t++)
+			{
+				uint32_t position = mesh.splitTriangles[split.triangleOffset + t];
+				uint32_t region = static_cast<uint32_t>(std::upper_bound(regionStart.begin(), regionStart.end(), position) - regionStart.begin()) - 1;
+				if (region >= regionCount)
+				{
+					BmSetLastError("Mesh vertex split adds a triangle outside its mesh");
+					return false;
+				}
+				addedCounts[region] += 3;
+			}
+			addedVertices += split.vertexCount;
+		}
+
+		if (addedVertices > mesh.vertices.count)
+		{
+			BmSetLastError("Mesh vertex splits add more vertices than the mesh has");
+			return false;
+		}
+		baseVertexCount = mesh.vertices.count - static_cast<uint32_t>(addedVertices);
+
+		baseCounts.resize(regionCount);
+		std::vector<uint32_t> fill(regionCount);
+		for (uint32_t r = 0; r < regionCount; r++)
+		{
+			baseCounts[r] = regionStart[r + 1] - regionStart[r] - addedCounts[r];
+			fill[r] = regionStart[r] + baseCounts[r];
+		}
+
+		for (uint32_t v = 0; v < mesh.vertexSplits.count; v++)
+		{
+			const BmVertexSplit& split = mesh.vertexSplits[v];
+			for (uint32_t t = 0; t < split.triangleCount; t++)
+			{
+				uint32_t position = mesh.splitTriangles[split.triangleOffset + t];
+				uint32_t region = static_cast<uint32_t>(std::upper_bound(regionStart.begin(), regionStart.end(), position) - regionStart.begin()) - 1;
+				if (position != fill[region])
+				{
+					BmSetLastError("Mesh vertex splits are out of order");
+					return false;
+				}
+				fill[region] += 3;
+			}
+		}
+
+		baseIndices.assign(mesh.indices.data, mesh.indices.data + mesh.indices.count);
+		for (uint32_t u = mesh.splitUpdates.count; u-- > 0; )
+		{
+			const BmIndexUpdate& update = mesh.splitUpdates[u];
+			if (update.position >= mesh.indices.count)
+			{
+				BmSetLastError("Mesh vertex split updates a corner outside its mesh");
+				return false;
+			}
+			baseIndices[update.position] = static_cast<I>(update.previous);
+		}
+
+		return true;
+	}
+
+	// fills record with the headers and data to write for mesh. interleaved vertices are described by vertLayout,
+	// which must describe V (nullptr writes no attribute list), non-interleaved meshes by their streams
+	template<typename V, typename I>
+	bool PrepareMeshRecord(const BmMesh<V, I>& mesh, const BmVertLayout* vertLayout, const BmSaveOptions& options, BmMeshWriteRecord& record)
+	{
+		BmMeshHeader& header = record.header;
+
+		// a progressive mesh is written as its coarse base, its splits go in a ProgressiveData block
+		std::vector<I> baseIndices;
+		std::vector<uint32_t> regionStart, baseCounts;
+		uint32_t baseVertexCount = mesh.vertices.count;
+		bool progressive = mesh.vertexSplits.count > 0;
+		if (progressive && !GetProgressiveBase(mesh, baseIndices, regionStart, baseCounts, baseVertexCount))
+			return false;
+
+		header.interleaved = mesh.streams.count == 0;
+		if (header.interleaved)
+		{
+			if (vertLayout != nullptr)
+			{
+				if (vertLayout->attributeCount > MAX_VERTEX_ATTRIBS || GetVertexStride(vertLayout->attributes, vertLayout->attributeCount) != sizeof(V))
+				{
+					BmSetLastError("Vertex layout does not describe the mesh vertex type");
+					return false;
+				}
+
+				header.vertAttrCount = vertLayout->attributeCount;
+				memcpy(header.verAttrList, vertLayout->attributes, sizeof(BmVertAttr) * vertLayout->attributeCount);
+			}
+
+			header.vertCount = baseVertexCount;
+			record.vertexPieces.push_back({ reinterpret_cast<const uint8_t*>(mesh.vertices.data), static_cast<size_t>(baseVertexCount) * sizeof(V) });
+		}
+		else
+		{
+			if (mesh.streams.count > MAX_VERTEX_ATTRIBS)
+			{
+				BmSetLastError("Mesh has more vertex streams than MAX_VERTEX_ATTRIBS");
+				return false;
+			}
+
+			header.vertCount = mesh.streams[0].count;
+			header.vertAttrCount = static_cast<uint16_t>(mesh.streams.count);
+
+			for (uint32_t s = 0; s < mesh.streams.count; s++)
+			{
+				const BmVertStream& stream = mesh.streams[s];
+				if (stream.count != header.vertCount || stream.stride != GetVertexStride(&stream.attribute, 1))
+				{
+					BmSetLastError("Mesh vertex streams do not match their attributes");
+					return false;
+				}
+
+				header.verAttrList[s] = stream.attribute;
+				record.vertexPieces.push_back({ stream.data, static_cast<size_t>(stream.count) * stream.stride });
+			}
+		}
+
+		record.hasBounds = UsesAttrBounds(header.verAttrList, header.vertAttrCount);
+		if (record.hasBounds)
+		{
+			if (!mesh.hasBounds)
+			{
+				BmSetLastError("Mesh has BoundsUnorm16 attributes but no bounds");
+				return false;
+			}
+			record.bounds = mesh.bounds;
+		}
+
+		// indices, from compactIndices when the mesh was loaded with them
+		const uint8_t* indexData = reinterpret_cast<const uint8_t*>(mesh.indices.data);
+		uint32_t indexSize = sizeof(I);
+		uint32_t indexCount = mesh.indices.count;
+
+		if (mesh.compactIndices.count > 0)
+		{
+			indexData = mesh.compactIndices.data;
+			indexSize = GetIndexTypeSize(static_cast<uint8_t>(mesh.compactIndexType));
+			indexCount = mesh.compactIndices.count / indexSize;
+		}
+
+		if (progressive)
+		{
+			BmMemoryOutput baseOutput(record.indexStorage);
+			indexCount = 0;
+			for (uint32_t r = 0; r < baseCounts.size(); r++)
+			{
+				if (mesh.subMeshList.count > 0)
+					record.subMeshes.push_back({ indexCount, baseCounts[r], mesh.subMeshList[r].materialID });
+
+				baseOutput.Write(baseIndices.data() + regionStart[r], baseCounts[r] * sizeof(I));
+				indexCount += baseCounts[r];
+			}
+
+			indexData = record.indexStorage.data();
+		}
+
+		if (indexSize != 1 && indexSize != 2 && indexSize != 4)
+		{
+			BmSetLastError("Mesh index type can't be written");
+			return false;
+		}
+
+		if (options.compactIndices)
+		{
+			uint32_t compactSize = GetIndexTypeSize(static_cast<uint8_t>(GetSmallestIndexType(GetMaxIndex(indexData, indexSize, indexCount))));
+			if (compactSize < indexSize)
+			{
+				std::vector<uint8_t> compacted(static_cast<size_t>(indexCount) * compactSize);
+				ConvertIndices(indexData, indexSize, compacted.data(), compactSize, indexCount);
+				record.indexStorage.swap(compacted);
+
+				indexData = record.indexStorage.data();
+				indexSize = compactSize;
+			}
+		}
+
+		header.indiceType = static_cast<uint8_t>(GetIndexTypeForSize(indexSize));
+		header.indiceCount = indexCount;
+		record.indexPiece = { indexData, static_cast<size_t>(indexCount) * indexSize };
+
+		header.subMeshCount = static_cast<uint16_t>(mesh.subMeshList.count);
+		for (uint32_t s = 0; s < mesh.subMeshList.count && !progressive; s++)
+			record.subMeshes.push_back({ mesh.subMeshList[s].indexOffset, mesh.subMeshList[s].indexCount, mesh.subMeshList[s].materialID });
+
+		if (options.compressMeshes)
+		{
+			uint32_t stride = header.vertAttrCount > 0 ? GetVertexStride(header.verAttrList, header.vertAttrCount) : sizeof(V);
+
+			// streams are coded as one buffer, the same bytes an uncompressed block would hold
+			const uint8_t* vertexData = record.vertexPieces[0].data;
+			std::vector<uint8_t> planar;
+			if (record.vertexPieces.size() > 1)
+			{
+				BmMemoryOutput planarOutput(planar);
+				for (const BmWritePiece& piece : record.vertexPieces)
+					planarOutput.Write(piece.data, piece.size);
+				vertexData = planar.data();
+			}
+
+			EncodeVertexBuffer(vertexData, stride, header.vertCount, record.vertexStorage);
+			record.vertexPieces.assign(1, BmWritePiece{ record.vertexStorage.data(), record.vertexStorage.size() });
+
+			std::vector<uint8_t> encodedIndices;
+			EncodeIndexBuffer(record.indexPiece.data, indexSize, indexCount, encodedIndices);
+			record.indexStorage.swap(encodedIndices);
+			record.indexPiece = { record.indexStorage.data(), record.indexStorage.size() };
+
+			record.compressed = true;
+		}
+
+		return true;
+	}
+
+	// writes the contents of a mesh block, Out needs Write(const void* data, size_t size)
+	template<typename Out>
+	void WriteMeshRecords(Out& out, const std::vector<BmMeshWriteRecord>& records)
+	{
+		BmMeshBlockHeader blockHeader;
+		blockHeader.numMeshes = static_cast<uint16_t>(records.size());
+		out.Write(&blockHeader, sizeof(blockHeader));
+
+		for (const BmMeshWriteRecord& record : records)
+		{
+			out.Write(&record.header, sizeof(record.header));
+			if (!record.subMeshes.empty())
+				out.Write(record.subMeshes.data(), record.subMeshes.size() * sizeof(BmSubMeshHeader));
+
+			if (record.hasBounds)
+				out.Write(&record.bounds, sizeof(record.bounds));
+
+			if (record.compressed)
+			{
+				BmCompressedStreamHeader streamHeader;
+				streamHeader.vertexBytes = static_cast<uint32_t>(record.GetVertexBytes());
+				streamHeader.indexBytes = static_cast<uint32_t>(record.indexPiece.size);
+				out.Write(&streamHeader, sizeof(streamHeader));
+			}
+
+			for (const BmWritePiece& piece : record.vertexPieces)
+				out.Write(piece.data, piece.size);
+			out.Write(record.indexPiece.data, record.indexPiece.size);
+		}
+	}
+
+	// =================================
+	// Basic Model : Model Writer
+	// =================================
+
+	class BmModelWriter
+	{
+	public:
+
+		explicit BmModelWriter(uint32_t bufferSize = BmWriterDefaultBufferSize) :
+			file(nullptr), memory(nullptr), bufferSize(bufferSize > 0 ? bufferSize : 1), bufferUsed(0), position(0), blockStart(0), inBlock(false), failed(false)
+		{}
+
+		~BmModelWriter() { Close(); }
+
+		BmModelWriter(const BmModelWriter&) = delete;
+		BmModelWriter& operator=(const BmModelWriter&) = delete;
+
+		// starts a file, writing its BmFileHeader
+		bool Open(const char* fileName)
+		{
+			Close();
+
+			file = fopen(fileName, "wb");
+			if (file == nullptr)
+			{
+				BmSetLastError("Unable to open file for writing");
+				return false;
+			}
+
+			buffer.resize(bufferSize);
+			WriteFileHeader();
+			return true;
+		}
+
+		// starts a file in memory, appended to out
+		bool Open(std::vector<uint8_t>& out)
+		{
+			Close();
+
+			memory = &out;
+			WriteFileHeader();
+			return true;
+		}
+
+		// finishes the file, returns false if any write failed
+		bool Close()
+		{
+			if (file == nullptr && memory == nullptr)
+				return !failed;
+
+			if (inBlock)
+				EndBlock();
+
+			if (file != nullptr)
+			{
+				Flush();
+				if (fclose(file) != 0)
+					failed = true;
+			}
+
+			file = nullptr;
+			memory = nullptr;
+
+			if (failed)
+				BmSetLastError("Failed writing model file");
+
+			bool succeeded = !failed;
+			failed = false;
+			return succeeded;
+		}
+
+		bool IsOpen() const { return file != nullptr || memory != nullptr; }
+
+		// bytes written since the file was opened
+		uint64_t GetPosition() const { return position; }
+
+		void Write(const void* data, size_t size)
+		{
+			if (failed || size == 0)
+				return;
+
+			position += size;
+
+			if (memory != nullptr)
+			{
+				const uint8_t* first = static_cast<const uint8_t*>(data);
+				memory->insert(memory->end(), first, first + size);
+				return;
+			}
+
+			if (bufferUsed + size > bufferSize)
+				Flush();
+
+			// anything that doesn't fit the buffer is written directly
+			if (size >= bufferSize)
+			{
+				if (fwrite(data, 1, size, file) != size)
+					failed = true;
+				return;
+			}
+
+			memcpy(buffer.data() + bufferUsed, data, size);
+			bufferUsed += size;
+		}
+
+		template<typename T>
+		void Write(const T& value) { Write(&value, sizeof(T)); }
+
+		// starts a block of the given type whose contents are written with Write, its length is filled in by EndBlock
+		void BeginBlock(BmFileBlockType type)
+		{
+			BM_ASSERT(!inBlock);
+
+			blockStart = position;
+			inBlock = true;
+
+			BmFileBlock fileBlock;
+			fileBlock.type = type;
+			fileBlock.blockLength = 0;
+			Write(fileBlock);
+		}
+
+		bool EndBlock()
+		{
+			BM_ASSERT(inBlock);
+			inBlock = false;
+
+			uint64_t blockLength = position - blockStart - sizeof(BmFileBlock);
+			if (blockLength > UINT32_MAX)
+			{
+				BmSetLastError("Block is larger than 4GB");
+				failed = true;
+				return false;
+			}
+
+			uint32_t length = static_cast<uint32_t>(blockLength);
+			uint64_t lengthPos = blockStart + offsetof(BmFileBlock, blockLength);
+			Patch(lengthPos, &length, sizeof(length));
+
+			return !failed;
+		}
+
+		// writes a whole block, compressed in to a CompressedBlock if compress is set
+		bool WriteBlock(BmFileBlockType type, const uint8_t* data, uint32_t blockLength, bool compress = false, uint32_t chunkSize = BmLzDefaultChunkSize)
+		{
+			if (compress)
+			{
+				std::vector<uint8_t> compressed;
+				CompressFileBlock(type, data, blockLength, compressed, chunkSize);
+				Write(compressed.data(), compressed.size());
+			}
+			else
+			{
+				BmFileBlock fileBlock;
+				fileBlock.type = type;
+				fileBlock.blockLength = blockLength;
+				Write(fileBlock);
+				Write(data, blockLength);
+			}
+
+			return !failed;
+		}
+
+		// writes meshes as a single mesh block, see BmSaveOptions for the forms it can take
+		template<typename V, typename I>
+		bool WriteMeshBlock(const BmMesh<V, I>* meshes, uint32_t meshCount, const BmVertLayout* vertLayout = &BmDefaultLayout, const BmSaveOptions& options = BmSaveOptions())
+		{
+			if (meshCount > UINT16_MAX)
+			{
+				BmSetLastError("Too many meshes for one mesh block");
+				return false;
+			}
+
+			std::vector<BmMeshWriteRecord> records(meshCount);
+
+			std::atomic<bool> prepared(true);
+			bmdl::GetWorkerPool().ParallelFor(meshCount, [&](uint32_t m)
+			{
+				if (!PrepareMeshRecord<V, I>(meshes[m], vertLayout, options, records[m]))
+					prepared = false;
+			});
+
+			if (!prepared)
+				return false;
+
+			uint64_t blockLength = sizeof(BmMeshBlockHeader);
+			for (const BmMeshWriteRecord& record : records)
+				blockLength += record.GetSize();
+
+			if (blockLength > UINT32_MAX)
+			{
+				BmSetLastError("Mesh block is larger than 4GB");
+				return false;
+			}
+
+			BmFileBlockType type = options.compressMeshes ? BmFileBlockType::CompressedMeshData : BmFileBlockType::MeshData;
+
+			if (options.compressBlocks)
+			{
+				std::vector<uint8_t> blockData;
+				blockData.reserve(static_cast<size_t>(blockLength));
+
+				BmMemoryOutput blockOutput(blockData);
+				WriteMeshRecords(blockOutput, records);
+
+				return WriteBlock(type, blockData.data(), static_cast<uint32_t>(blockData.size()), true, options.chunkSize);
+			}
+
+			BmFileBlock fileBlock;
+			fileBlock.type = type;
+			fileBlock.blockLength = static_cast<uint32_t>(blockLength);
+			Write(fileBlock);
+
+			WriteMeshRecords(*this, records);
+
+			return !failed;
+		}
+
+		// writes all meshes of model, split over several mesh blocks if there are more than a block can hold
+		template<typename V, typename I>
+		bool WriteModel(const BmModel<V, I>& model, const BmVertLayout* vertLayout = &BmDefaultLayout, const BmSaveOptions& options = BmSaveOptions())
+		{
+			for (uint32_t first = 0; first < model.meshList.count; first += UINT16_MAX)
+			{
+				uint32_t count = (model.meshList.count - first) < UINT16_MAX ? (model.meshList.count - first) : UINT16_MAX;
+				if (!WriteMeshBlock<V, I>(model.meshList.data + first, count, vertLayout, options))
+					return false;
+			}
+
+			return WriteProgressiveBlock(model, vertLayout) && WriteMeshletBlock(model, options) && WriteLodBlocks(model, options);
+		}
+
+		// writes the vertex splits of every progressive mesh of model as one ProgressiveData block, nothing when no mesh has
+		// any. the splits of different meshes are interleaved so the ones that remove the most error come first, and the
+		// block is never compressed so it can be read as it arrives. the meshes must be written first, as their base
+		template<typename V, typename I>
+		bool WriteProgressiveBlock(const BmModel<V, I>& model, const BmVertLayout* vertLayout = &BmDefaultLayout)
+		{
+			struct ProgressiveSet
+			{
+				uint32_t				mesh;
+				uint32_t				indexSize;
+				uint32_t				nextSplit;
+				uint32_t				nextVertex;
+				std::vector<I>			indices;		// as the loader has them after the splits written so far
+				std::vector<uint32_t>	regionStart;
+				std::vector<uint32_t>	baseCounts;
+			};
+
+			std::vector<ProgressiveSet> sets;
+			uint32_t splitCount = 0;
+			for (uint32_t m = 0; m < model.meshList.count; m++)
+			{
+				const BmMesh<V, I>& mesh = model.meshList[m];
+				if (mesh.vertexSplits.count == 0)
+					continue;
+
+				sets.emplace_back();
+				ProgressiveSet& set = sets.back();
+				if (!GetProgressiveBase(mesh, set.indices, set.regionStart, set.baseCounts, set.nextVertex))
+					return false;
+
+				set.mesh = m;
+				set.indexSize = GetIndexTypeSize(static_cast<uint8_t>(GetSmallestIndexType(mesh.vertices.count - 1)));
+				set.nextSplit = 0;
+				splitCount += mesh.vertexSplits.count;
+			}
+
+			if (sets.empty())
+				return !failed;
+
+			std::vector<uint8_t> blockData;
+			BmMemoryOutput blockOutput(blockData);
+
+			BmProgressiveBlockHeader blockHeader;
+			blockHeader.meshCount = static_cast<uint32_t>(sets.size());
+			blockHeader.splitCount = splitCount;
+			blockOutput.Write(blockHeader);
+
+			for (const ProgressiveSet& set : sets)
+			{
+				BmProgressiveSetHeader setHeader = {};
+				setHeader.meshIndex = set.mesh;
+				setHeader.vertexCount = model.meshList[set.mesh].vertices.count;
+				setHeader.indexType = static_cast<uint8_t>(GetIndexTypeForSize(set.indexSize));
+				setHeader.regionCount = static_cast<uint16_t>(set.regionStart.size() - 1);
+				if (vertLayout != nullptr)
+				{
+					if (vertLayout->attributeCount > MAX_VERTEX_ATTRIBS || GetVertexStride(vertLayout->attributes, vertLayout->attributeCount) != sizeof(V))
+					{
+						BmSetLastError("Vertex layout does not describe the mesh vertex type");
+						return false;
+					}
+
+					setHeader.vertAttrCount = vertLayout->attributeCount;
+					memcpy(setHeader.verAttrList, vertLayout->attributes, sizeof(BmVertAttr) * vertLayout->attributeCount);
+				}
+				blockOutput.Write(setHeader);
+
+				for (uint32_t r = 0; r + 1 < set.regionStart.size(); r++)
+				{
+					blockOutput.Write(set.baseCounts[r]);
+					blockOutput.Write(set.regionStart[r + 1] - set.regionStart[r]);
+				}
+			}
+
+			// the split of whichever mesh is furthest from full detail goes next
+			std::priority_queue<std::pair<float, uint32_t>> next;
+			for (uint32_t s = 0; s < sets.size(); s++)
+				next.push(std::make_pair(model.meshList[sets[s].mesh].vertexSplits[0].error, s));
+
+			while (!next.empty())
+			{
+				uint32_t s = next.top().second;
+				next.pop();
+
+				ProgressiveSet& set = sets[s];
+				const BmMesh<V, I>& mesh = model.meshList[set.mesh];
+				const BmVertexSplit& split = mesh.vertexSplits[set.nextSplit++];
+				if (set.nextSplit < mesh.vertexSplits.count)
+					next.push(std::make_pair(mesh.vertexSplits[set.nextSplit].error, s));
+
+				BmVertexSplitHeader splitHeader;
+				splitHeader.set = s;
+				splitHeader.vertexCount = split.vertexCount;
+				splitHeader.triangleCount = split.triangleCount;
+				splitHeader.updateCount = split.updateCount;
+				splitHeader.error = split.error;
+				blockOutput.Write(splitHeader);
+
+				blockOutput.Write(mesh.vertices.data + set.nextVertex, static_cast<size_t>(split.vertexCount) * sizeof(V));
+				set.nextVertex += split.vertexCount;
+
+				for (uint32_t t = 0; t < split.triangleCount; t++)
+				{
+					uint32_t position = mesh.splitTriangles[split.triangleOffset + t];
+					uint16_t region = static_cast<uint16_t>(std::upper_bound(set.regionStart.begin(), set.regionStart.end(), position) - set.regionStart.begin() - 1);
+					blockOutput.Write(region);
+				}
+
+				for (uint32_t t = 0; t < split.triangleCount; t++)
+				{
+					uint32_t position = mesh.splitTriangles[split.triangleOffset + t];
+					size_t cornerStart = blockData.size();
+					blockData.resize(cornerStart + set.indexSize * 3);
+					ConvertIndices(reinterpret_cast<const uint8_t*>(&set.indices[position]), sizeof(I), blockData.data() + cornerStart, set.indexSize, 3);
+				}
+
+				for (uint32_t u = 0; u < split.updateCount; u++)
+					blockOutput.Write(mesh.splitUpdates[split.updateOffset + u].position);
+
+				for (uint32_t u = 0; u < split.updateCount; u++)
+				{
+					const BmIndexUpdate& update = mesh.splitUpdates[split.updateOffset + u];
+					size_t vertexStart = blockData.size();
+					blockData.resize(vertexStart + set.indexSize);
+					ConvertIndices(reinterpret_cast<const uint8_t*>(&update.vertex), sizeof(uint32_t), blockData.data() + vertexStart, set.indexSize, 1);
+					set.indices[update.position] = static_cast<I>(update.vertex);
+				}
+			}
+
+			if (blockData.size() > UINT32_MAX)
+			{
+				BmSetLastError("Progressive block is larger than 4GB");
+				return false;
+			}
+
+			return WriteBlock(BmFileBlockType::ProgressiveData, blockData.data(), static_cast<uint32_t>(blockData.size()));
+		}
+
+		// writes the meshlets of every mesh of model that has them as one MeshletData block, nothing when
+		// no mesh has meshlets. the meshes must be written first so the loader can attach the meshlets to them
+		template<typename V, typename I>
+		bool WriteMeshletBlock(const BmModel<V, I>& model, const BmSaveOptions& options = BmSaveOptions())
+		{
+			uint32_t setCount = 0;
+			uint64_t setBytes = 0;
+			for (uint32_t m = 0; m < model.meshList.count; m++)
+			{
+				const BmMesh<V, I>& mesh = model.meshList[m];
+				if (mesh.meshlets.count == 0)
+					continue;
+
+				if (mesh.meshletBounds.count != mesh.meshlets.count || mesh.meshletTriangles.count % 3 != 0)
+				{
+					BmSetLastError("Mesh meshlet data is incomplete");
+					return false;
+				}
+
+				setCount++;
+				setBytes += sizeof(BmMeshletSetHeader) + GetMeshletArraySize<BmMeshlet>(mesh.meshlets.count) + GetMeshletArraySize<BmMeshletBounds>(mesh.meshletBounds.count) +
+					GetMeshletArraySize<uint32_t>(mesh.meshletVertices.count) + GetMeshletArraySize<uint8_t>(mesh.meshletTriangles.count);
+			}
+
+			if (setCount == 0)
+				return !failed;
+
+			// pad so the sets are aligned in the file and can be referenced in place when it is mapped
+			uint64_t dataStart = position + sizeof(BmFileBlock) + sizeof(BmMeshletBlockHeader);
+			uint32_t padding = static_cast<uint32_t>((BmMeshletAlignment - dataStart % BmMeshletAlignment) % BmMeshletAlignment);
+
+			uint64_t blockLength = sizeof(BmMeshletBlockHeader) + padding + setBytes;
+			if (blockLength > UINT32_MAX)
+			{
+				BmSetLastError("Meshlet block is larger than 4GB");
+				return false;
+			}
+
+			std::vector<uint8_t> blockData;
+			blockData.reserve(static_cast<size_t>(blockLength));
+			BmMemoryOutput blockOutput(blockData);
+
+			BmMeshletBlockHeader blockHeader;
+			blockHeader.meshCount = setCount;
+			blockHeader.dataOffset = sizeof(BmMeshletBlockHeader) + padding;
+			blockOutput.Write(blockHeader);
+			blockData.resize(blockData.size() + padding, 0);
+
+			for (uint32_t m = 0; m < model.meshList.count; m++)
+			{
+				const BmMesh<V, I>& mesh = model.meshList[m];
+				if (mesh.meshlets.count == 0)
+					continue;
+
+				BmMeshletSetHeader setHeader;
+				setHeader.meshIndex = m;
+				setHeader.meshletCount = mesh.meshlets.count;
+				setHeader.vertexCount = mesh.meshletVertices.count;
+				setHeader.triangleCount = mesh.meshletTriangles.count / 3;
+				blockOutput.Write(setHeader);
+
+				WriteMeshletArray(blockOutput, mesh.meshlets);
+				WriteMeshletArray(blockOutput, mesh.meshletBounds);
+				WriteMeshletArray(blockOutput, mesh.meshletVertices);
+				WriteMeshletArray(blockOutput, mesh.meshletTriangles);
+			}
+
+			return WriteBlock(BmFileBlockType::MeshletData, blockData.data(), static_cast<uint32_t>(blockData.size()), options.compressBlocks, options.chunkSize);
+		}
+
+		// writes the levels of detail of the meshes of model as one LodData block per level, each holding that
+		// level of every mesh that has it. nothing when no mesh has levels of detail, the meshes must be written first
+		template<typename V, typename I>
+		bool WriteLodBlocks(const BmModel<V, I>& model, const BmSaveOptions& options = BmSaveOptions())
+		{
+			std::vector<uint16_t> levels;
+			for (uint32_t m = 0; m < model.meshList.count; m++)
+			{
+				const BmMesh<V, I>& mesh = model.meshList[m];
+				for (uint32_t l = 0; l < mesh.lods.count; l++)
+				{
+					const BmMeshLod& lod = mesh.lods[l];
+					if (static_cast<uint64_t>(lod.indexOffset) + lod.indexCount > mesh.lodIndices.count ||
+						static_cast<uint64_t>(lod.subMeshOffset) + lod.subMeshCount > mesh.lodSubMeshes.count)
+					{
+						BmSetLastError("Mesh level of detail data is incomplete");
+						return false;
+					}
+
+					if (std::find(levels.begin(), levels.end(), lod.level) == levels.end())
+						levels.push_back(lod.level);
+				}
+			}
+			std::sort(levels.begin(), levels.end());
+
+			for (uint16_t level : levels)
+			{
+				std::vector<uint8_t> blockData;
+				BmMemoryOutput blockOutput(blockData);
+
+				BmLodBlockHeader blockHeader;
+				blockHeader.level = level;
+				blockHeader.meshCount = 0;
+				blockOutput.Write(blockHeader);
+
+				for (uint32_t m = 0; m < model.meshList.count; m++)
+				{
+					const BmMesh<V, I>& mesh = model.meshList[m];
+					const BmMeshLod* lod = nullptr;
+					for (uint32_t l = 0; l < mesh.lods.count && lod == nullptr; l++)
+						lod = mesh.lods[l].level == level ? &mesh.lods[l] : nullptr;
+
+					if (lod == nullptr)
+						continue;
+
+					// indices are stored with the smallest type able to hold them
+					const uint8_t* indexData = reinterpret_cast<const uint8_t*>(mesh.lodIndices.data + lod->indexOffset);
+					uint32_t maxIndex = lod->indexCount > 0 ? GetMaxIndex(indexData, sizeof(I), lod->indexCount) : 0;
+					BmIndexType indexType = GetSmallestIndexType(maxIndex);
+					uint32_t indexSize = GetIndexTypeSize(static_cast<uint8_t>(indexType));
+
+					BmLodSetHeader setHeader;
+					setHeader.meshIndex = m;
+					setHeader.indexCount = lod->indexCount;
+					setHeader.indexType = static_cast<uint8_t>(indexType);
+					setHeader.subMeshCount = lod->subMeshCount;
+					setHeader.error = lod->error;
+					blockOutput.Write(setHeader);
+
+					for (uint32_t sm = 0; sm < lod->subMeshCount; sm++)
+					{
+						const BmSubMesh& subMesh = mesh.lodSubMeshes[lod->subMeshOffset + sm];
+						BmSubMeshHeader subMeshHeader;
+						subMeshHeader.indiceOffset = subMesh.indexOffset;
+						subMeshHeader.indiceCount = subMesh.indexCount;
+						subMeshHeader.materialID = subMesh.materialID;
+						blockOutput.Write(subMeshHeader);
+					}
+
+					size_t indexStart = blockData.size();
+					blockData.resize(indexStart + static_cast<size_t>(lod->indexCount) * indexSize);
+					ConvertIndices(indexData, sizeof(I), blockData.data() + indexStart, indexSize, lod->indexCount);
+					blockHeader.meshCount++;
+				}
+
+				if (blockData.size() > UINT32_MAX)
+				{
+					BmSetLastError("Lod block is larger than 4GB");
+					return false;
+				}
+
+				memcpy(blockData.data(), &blockHeader, sizeof(blockHeader));
+				if (!WriteBlock(BmFileBlockType::LodData, blockData.data(), static_cast<uint32_t>(blockData.size()), options.compressBlocks, options.chunkSize))
+					return false;
+			}
+
+			return !failed;
+		}
+
+	private:
+
+		template<typename T>
+		static void WriteMeshletArray(BmMemoryOutput& out, const BmList<T>& list)
+		{
+			out.Write(list.data, sizeof(T) * list.count);
+			out.data.resize(out.data.size() + static_cast<size_t>(GetMeshletArraySize<T>(list.count) - sizeof(T) * list.count), 0);
+		}
+
+		void WriteFileHeader()
+		{
+			BmFileHeader fileHeader;
+			fileHeader.fileID = BmFileID;
+			fileHeader.versionMajor = BmVersionMajor;
+			fileHeader.versionMinor = BmVersionMinor;
+			Write(fileHeader);
+		}
+
+		void Flush()
+		{
+			if (bufferUsed > 0 && !failed && fwrite(buffer.data(), 1, bufferUsed, file) != bufferUsed)
+				failed = true;
+			bufferUsed = 0;
+		}
+
+		// overwrites bytes already written at pos, in the buffer if they are still there
+		void Patch(uint64_t pos, const void* data, size_t size)
+		{
+			if (failed)
+				return;
+
+			if (memory != nullptr)
+			{
+				memcpy(memory->data() + (memory->size() - (position - pos)), data, size);
+				return;
+			}
+
+			uint64_t bufferStart = position - bufferUsed;
+			if (pos >= bufferStart)
+			{
+				memcpy(buffer.data() + (pos - bufferStart), data, size);
+				return;
+			}
+
+			Flush();
+			if (fseek(file, static_cast<long>(pos), SEEK_SET) || fwrite(data, 1, size, file) != size || fseek(file, 0, SEEK_END))
+				failed = true;
+		}
+
+		FILE*					file;
+		std::vector<uint8_t>*	memory;
+
+		std::vector<uint8_t>	buffer;
+		size_t					bufferSize;
+		size_t					bufferUsed;
+
+		uint64_t	position;
+		uint64_t	blockStart;
+		bool		inBlock;
+		bool		failed;
+	};
+
+	// writes model to a .bmf file. vertLayout describes V, use the layout the model was loaded with
+	template<typename V, typename I>
+	BM_FUNC_DECL bool SaveModel(std::string name, const BmModel<V, I>& model, const BmVertLayout* vertLayout = &BmDefaultLayout, const BmSaveOptions& options = BmSaveOptions())
+	{
+		BmModelWriter writer;
+		if (!writer.Open(name.c_str()))
+			return false;
+
+		bool written = writer.WriteModel(model, vertLayout, options);
+		return writer.Close() && written;
+	}
+
+	// writes model as .bmf file data appended to out
+	template<typename V, typename I>
+	BM_FUNC_DECL bool SaveModel(std::vector<uint8_t>& out, const BmModel<V, I>& model, const BmVertLayout* vertLayout = &BmDefaultLayout, const BmSaveOptions& options = BmSaveOptions())
+	{
+		BmModelWriter writer;
+		writer.Open(out);
+
+		bool written = writer.WriteModel(model, vertLayout, options);
+		return writer.Close() && written;
+	}
+}
+
+// =================================
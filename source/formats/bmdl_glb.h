@@ -0,0 +1,984 @@
+#pragma once
+
+#include "bmdl.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <string>
+#include <vector>
+
+// =================================
+// Basic Model : glTF Binary Import
+// Loads binary glTF (.glb) files in to a BmModel, one BmMesh per triangle primitive.
+//
+// Accessors are read straight out of the BIN chunk through the same paths as .bmf mesh data. A primitive
+// whose attributes are interleaved in one buffer view is read as an interleaved file mesh, so when the
+// view matches the requested vertex layout and BmLoadFlags::MemoryMapped is set the mesh vertices are a
+// view of the file. Loading non-interleaved, accessors that match a layout attribute become its stream
+// without a copy. Indices are referenced the same way when their type matches I.
+//
+// Each mesh holds one BmSubMesh whose materialID is the glTF material index (BmGlbNoMaterial without one),
+// and takes the world transform of the first node that instances it. Sparse accessors, external
+// buffers and the non triangle list primitive modes are not supported.
+// =================================
+
+namespace bmdl
+{
+	static const uint32_t BmGlbMagic = 0x46546C67;		// "glTF"
+	static const uint32_t BmGlbChunkJson = 0x4E4F534A;	// "JSON"
+	static const uint32_t BmGlbChunkBin = 0x004E4942;	// "BIN\0"
+	static const uint16_t BmGlbNoMaterial = 0xFFFF;
+	static const uint32_t BmGlbMaxStride = 252;		// largest byteStride the glTF spec allows
+	static const uint32_t BmJsonMaxDepth = 64;
+
+	// =================================
+	// JSON
+	// The document is tokenized in to one flat array, containers are followed by their children and
+	// know the index just past them so whole values can be skipped. Strings and numbers are only
+	// decoded when asked for.
+	// =================================
+
+	enum class BmJsonType : uint8_t
+	{
+		Null	= 0,
+		Bool	= 1,
+		Number	= 2,
+		String	= 3,
+		Array	= 4,
+		Object	= 5
+	};
+
+	struct BmJsonToken
+	{
+		BmJsonType	type;
+		uint32_t	start;		// offset of the value in the text, strings exclude the quotes
+		uint32_t	length;
+		uint32_t	count;		// elements of an array, key value pairs of an object
+		uint32_t	next;		// index of the token after this value and its children
+	};
+
+	static const uint32_t BmJsonInvalid = 0xFFFFFFFF;
+
+	class BmJsonDocument
+	{
+	public:
+
+		bool Parse(const char* json, uint32_t jsonSize)
+		{
+			text = json;
+			size = jsonSize;
+			pos = 0;
+			tokens.clear();
+			tokens.reserve(jsonSize / 16 + 16);
+
+			if (!ParseValue(0))
+				return false;
+
+			SkipSpace();
+			return pos == size;
+		}
+
+		const BmJsonToken& operator[](uint32_t t) const { return tokens[t]; }
+
+		// value of key in an object, BmJsonInvalid if t isn't an object or doesn't have the key
+		uint32_t Find(uint32_t t, const char* key) const
+		{
+			if (t == BmJsonInvalid || tokens[t].type != BmJsonType::Object)
+				return BmJsonInvalid;
+
+			uint32_t keyLength = static_cast<uint32_t>(strlen(key));
+			for (uint32_t k = t + 1, p = 0; p < tokens[t].count; p++, k = tokens[k + 1].next)
+			{
+				if (tokens[k].length == keyLength && memcmp(text + tokens[k].start, key, keyLength) == 0)
+					return k + 1;
+			}
+
+			return BmJsonInvalid;
+		}
+
+		// element i of an array, BmJsonInvalid if t isn't an array or is too short
+		uint32_t At(uint32_t t, uint32_t i) const
+		{
+			if (t == BmJsonInvalid || tokens[t].type != BmJsonType::Array || i >= tokens[t].count)
+				return BmJsonInvalid;
+
+			uint32_t e = t + 1;
+			for (; i > 0; i--)
+				e = tokens[e].next;
+			return e;
+		}
+
+		uint32_t Count(uint32_t t) const
+		{
+			return (t != BmJsonInvalid && (tokens[t].type == BmJsonType::Array || tokens[t].type == BmJsonType::Object)) ? tokens[t].count : 0;
+		}
+
+		double GetNumber(uint32_t t, double fallback) const
+		{
+			if (t == BmJsonInvalid || tokens[t].type != BmJsonType::Number)
+				return fallback;
+
+			const char* s = text + tokens[t].start;
+			const char* end = s + tokens[t].length;
+
+			bool negative = *s == '-';
+			if (negative)
+				s++;
+
+			// digits past the 19th only move the exponent, the value is then scaled once
+			uint64_t mantissa = 0;
+			int32_t exponent = 0;
+			uint32_t digits = 0;
+			for (; s < end && *s >= '0' && *s <= '9'; s++)
+			{
+				if (digits++ < 19)
+					mantissa = mantissa * 10 + (*s - '0');
+				else
+					exponent++;
+			}
+
+			if (s < end && *s == '.')
+			{
+				for (s++; s < end && *s >= '0' && *s <= '9'; s++)
+				{
+					if (digits++ < 19)
+					{
+						mantissa = mantissa * 10 + (*s - '0');
+						exponent--;
+					}
+				}
+			}
+
+			if (s < end && (*s == 'e' || *s == 'E'))
+			{
+				s++;
+				bool negativeExponent = s < end && *s == '-';
+				if (s < end && (*s == '-' || *s == '+'))
+					s++;
+
+				int32_t value = 0;
+				for (; s < end && *s >= '0' && *s <= '9'; s++)
+					value = value < 100000 ? value * 10 + (*s - '0') : value;
+				exponent += negativeExponent ? -value : value;
+			}
+
+			double result = static_cast<double>(mantissa);
+			if (exponent != 0)
+				result *= pow(10.0, exponent);
+			return negative ? -result : result;
+		}
+
+		// integer value of t, fallback if it is missing or not a whole number in [0, UINT32_MAX]
+		uint32_t GetUInt(uint32_t t, uint32_t fallback) const
+		{
+			double value = GetNumber(t, -1.0);
+			if (value < 0.0 || value > 4294967295.0 || value != floor(value))
+				return fallback;
+			return static_cast<uint32_t>(value);
+		}
+
+		bool GetBool(uint32_t t, bool fallback) const
+		{
+			if (t == BmJsonInvalid || tokens[t].type != BmJsonType::Bool)
+				return fallback;
+			return text[tokens[t].start] == 't';
+		}
+
+		bool Equals(uint32_t t, const char* value) const
+		{
+			if (t == BmJsonInvalid || tokens[t].type != BmJsonType::String)
+				return false;
+
+			uint32_t length = static_cast<uint32_t>(strlen(value));
+			return tokens[t].length == length && memcmp(text + tokens[t].start, value, length) == 0;
+		}
+
+		// decoded string value, \u escapes are written as UTF-8
+		std::string GetString(uint32_t t) const
+		{
+			std::string result;
+			if (t == BmJsonInvalid || tokens[t].type != BmJsonType::String)
+				return result;
+
+			const char* s = text + tokens[t].start;
+			const char* end = s + tokens[t].length;
+			result.reserve(tokens[t].length);
+
+			while (s < end)
+			{
+				if (*s != '\\' || s + 1 == end)
+				{
+					result += *s++;
+					continue;
+				}
+
+				char escape = s[1];
+				s += 2;
+				switch (escape)
+				{
+					case 'b': result += '\b'; break;
+					case 'f': result += '\f'; break;
+					case 'n': result += '\n'; break;
+					case 'r': result += '\r'; break;
+					case 't': result += '\t'; break;
+					case 'u':
+					{
+						uint32_t code = 0;
+						for (uint32_t i = 0; i < 4 && s < end; i++, s++)
+						{
+							char c = *s;
+							code = code * 16 + static_cast<uint32_t>(c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+						}
+
+						// surrogate pairs are not joined, each half is encoded as is
+						if (code < 0x80)
+							result += static_cast<char>(code);
+						else if (code < 0x800)
+						{
+							result += static_cast<char>(0xC0 | (code >> 6));
+							result += static_cast<char>(0x80 | (code & 0x3F));
+						}
+						else
+						{
+							result += static_cast<char>(0xE0 | (code >> 12));
+							result += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+							result += static_cast<char>(0x80 | (code & 0x3F));
+						}
+					}
+					break;
+					default: result += escape; break;
+				}
+			}
+
+			return result;
+		}
+
+	private:
+
+		void SkipSpace()
+		{
+			while (pos < size && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+				pos++;
+		}
+
+		uint32_t AddToken(BmJsonType type, uint32_t start, uint32_t length)
+		{
+			BmJsonToken token = { type, start, length, 0, 0 };
+			tokens.push_back(token);
+			return static_cast<uint32_t>(tokens.size() - 1);
+		}
+
+		bool ParseString()
+		{
+			uint32_t start = ++pos;
+			while (pos < size && text[pos] != '"')
+				pos += text[pos] == '\\' ? 2 : 1;
+
+			if (pos >= size)
+				return false;
+
+			uint32_t t = AddToken(BmJsonType::String, start, pos - start);
+			tokens[t].next = t + 1;
+			pos++;
+			return true;
+		}
+
+		bool ParseValue(uint32_t depth)
+		{
+			SkipSpace();
+			if (pos == size || depth > BmJsonMaxDepth)
+				return false;
+
+			char c = text[pos];
+			if (c == '"')
+				return ParseString();
+
+			if (c == '{' || c == '[')
+			{
+				bool object = c == '{';
+				char close = object ? '}' : ']';
+				uint32_t t = AddToken(object ? BmJsonType::Object : BmJsonType::Array, pos, 0);
+				uint32_t count = 0;
+
+				pos++;
+				SkipSpace();
+				if (pos < size && text[pos] == close)
+					pos++;
+				else
+				{
+					for (;;)
+					{
+						if (object)
+						{
+							SkipSpace();
+							if (pos == size || text[pos] != '"' || !ParseString())
+								return false;
+
+							SkipSpace();
+							if (pos == size || text[pos] != ':')
+								return false;
+							pos++;
+						}
+
+						if (!ParseValue(depth + 1))
+							return false;
+						count++;
+
+						SkipSpace();
+						if (pos == size)
+							return false;
+						if (text[pos] == close)
+						{
+							pos++;
+							break;
+						}
+						if (text[pos] != ',')
+							return false;
+						pos++;
+					}
+				}
+
+				tokens[t].length = pos - tokens[t].start;
+				tokens[t].count = count;
+				tokens[t].next = static_cast<uint32_t>(tokens.size());
+				return true;
+			}
+
+			// number or literal, validated loosely as they are only decoded on request
+			uint32_t start = pos;
+			while (pos < size && (isalnum(static_cast<unsigned char>(text[pos])) || text[pos] == '-' || text[pos] == '+' || text[pos] == '.'))
+				pos++;
+
+			uint32_t length = pos - start;
+			BmJsonType type;
+			if (length == 4 && memcmp(text + start, "null", 4) == 0)
+				type = BmJsonType::Null;
+			else if ((length == 4 && memcmp(text + start, "true", 4) == 0) || (length == 5 && memcmp(text + start, "false", 5) == 0))
+				type = BmJsonType::Bool;
+			else if (length > 0 && (c == '-' || (c >= '0' && c <= '9')))
+				type = BmJsonType::Number;
+			else
+				return false;
+
+			uint32_t t = AddToken(type, start, length);
+			tokens[t].next = t + 1;
+			return true;
+		}
+
+		const char*					text = nullptr;
+		uint32_t					size = 0;
+		uint32_t					pos = 0;
+		std::vector<BmJsonToken>	tokens;
+	};
+
+	// =================================
+	// Accessors
+	// =================================
+
+	#pragma pack(push, 1)
+
+	struct BmGlbHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t length;
+	};
+
+	struct BmGlbChunkHeader
+	{
+		uint32_t length;
+		uint32_t type;
+	};
+
+	#pragma pack(pop)
+
+	// an accessor resolved to its bytes in the BIN chunk
+	struct BmGlbAccessor
+	{
+		uint8_t*	data;
+		uint32_t	count;
+		uint32_t	stride;		// bytes between elements
+		uint32_t	view;		// buffer view index, accessors sharing a view may be interleaved
+		uint64_t	viewSpace;	// bytes from data to the end of the buffer view
+		BmVertAttr	attr;		// component type and count, attrMap is set by the primitive
+		bool		normalized;
+
+		uint32_t GetElementSize() const { return GetBaseTypeSize(attr.baseType) * attr.components; }
+		bool IsPacked() const { return stride == GetElementSize(); }
+	};
+
+	struct BmGlbPrimitive
+	{
+		uint32_t					mesh;
+		uint16_t					materialID;
+		std::vector<BmGlbAccessor>	attributes;
+		BmGlbAccessor				indices;
+		bool						indexed;
+	};
+
+	static inline BmBaseType GetGlbComponentType(uint32_t componentType)
+	{
+		switch (componentType)
+		{
+			case 5120:	return BmBaseType::Int8;
+			case 5121:	return BmBaseType::Uint8;
+			case 5122:	return BmBaseType::Int16;
+			case 5123:	return BmBaseType::UInt16;
+			case 5125:	return BmBaseType::UInt32;
+			case 5126:	return BmBaseType::Float;
+			default:	return BmBaseType::None;
+		}
+	}
+
+	static inline uint32_t GetGlbComponentCount(const BmJsonDocument& doc, uint32_t type)
+	{
+		if (doc.Equals(type, "SCALAR"))	return 1;
+		if (doc.Equals(type, "VEC2"))	return 2;
+		if (doc.Equals(type, "VEC3"))	return 3;
+		if (doc.Equals(type, "VEC4"))	return 4;
+		return 0;
+	}
+
+	// glTF attribute semantic to BmAttrMap, colors map to Color32 when the layout reads them that way
+	static BmAttrMap GetGlbAttrMap(const char* name, uint32_t length, const BmVertLayout* vertLayout)
+	{
+		std::string semantic(name, length);
+		if (semantic == "POSITION")	return BmAttrMap::Position;
+		if (semantic == "NORMAL")	return BmAttrMap::Normal;
+		if (semantic == "TANGENT")	return BmAttrMap::Tangent;
+
+		uint32_t set = length > 0 ? static_cast<uint32_t>(name[length - 1] - '0') : 4;
+		if (set >= 4 || semantic.size() < 3 || semantic[semantic.size() - 2] != '_')
+			return BmAttrMap::None;
+
+		std::string base = semantic.substr(0, semantic.size() - 2);
+		if (base == "TEXCOORD")
+			return static_cast<BmAttrMap>(static_cast<uint8_t>(BmAttrMap::TexCoord1) + set);
+
+		if (base == "COLOR")
+		{
+			BmAttrMap color32 = static_cast<BmAttrMap>(static_cast<uint8_t>(BmAttrMap::Color32_1) + set);
+			for (uint32_t a = 0; a < vertLayout->attributeCount; a++)
+			{
+				if (vertLayout->attributes[a].attrMap == color32)
+					return color32;
+			}
+			return static_cast<BmAttrMap>(static_cast<uint8_t>(BmAttrMap::Color_1) + set);
+		}
+
+		return BmAttrMap::None;
+	}
+
+	// resolves accessor index to its data in bin, checking it lies inside its buffer view
+	static bool ReadGlbAccessor(const BmJsonDocument& doc, uint32_t root, uint32_t index, uint8_t* bin, uint32_t binSize, BmGlbAccessor& accessor)
+	{
+		uint32_t acc = doc.At(doc.Find(root, "accessors"), index);
+		if (acc == BmJsonInvalid)
+		{
+			BmSetLastError("glTF primitive references a missing accessor");
+			return false;
+		}
+
+		if (doc.Find(acc, "sparse") != BmJsonInvalid)
+		{
+			BmSetLastError("glTF sparse accessors are not supported");
+			return false;
+		}
+
+		accessor.view = doc.GetUInt(doc.Find(acc, "bufferView"), BmJsonInvalid);
+		uint32_t view = doc.At(doc.Find(root, "bufferViews"), accessor.view);
+		if (view == BmJsonInvalid)
+		{
+			BmSetLastError("glTF accessor has no buffer view");
+			return false;
+		}
+
+		// only the GLB's own buffer is loaded, it is always buffer 0 and has no uri
+		uint32_t buffer = doc.At(doc.Find(root, "buffers"), doc.GetUInt(doc.Find(view, "buffer"), BmJsonInvalid));
+		if (buffer == BmJsonInvalid || doc.GetUInt(doc.Find(view, "buffer"), 0) != 0 || doc.Find(buffer, "uri") != BmJsonInvalid || bin == nullptr)
+		{
+			BmSetLastError("glTF external buffers are not supported");
+			return false;
+		}
+
+		accessor.attr.baseType = GetGlbComponentType(doc.GetUInt(doc.Find(acc, "componentType"), 0));
+		accessor.attr.components = static_cast<uint8_t>(GetGlbComponentCount(doc, doc.Find(acc, "type")));
+		accessor.attr.attrMap = BmAttrMap::None;
+		accessor.count = doc.GetUInt(doc.Find(acc, "count"), 0);
+		accessor.normalized = doc.GetBool(doc.Find(acc, "normalized"), false);
+
+		uint32_t elementSize = accessor.GetElementSize();
+		if (elementSize == 0 || accessor.count == 0)
+		{
+			BmSetLastError("glTF accessor has an unsupported type or no elements");
+			return false;
+		}
+
+		uint64_t viewOffset = doc.GetUInt(doc.Find(view, "byteOffset"), 0);
+		uint64_t viewLength = doc.GetUInt(doc.Find(view, "byteLength"), 0);
+		uint64_t offset = doc.GetUInt(doc.Find(acc, "byteOffset"), 0);
+		accessor.stride = doc.GetUInt(doc.Find(view, "byteStride"), elementSize);
+
+		if (accessor.stride > BmGlbMaxStride)
+		{
+			BmSetLastError("glTF buffer view has a byte stride over 252");
+			return false;
+		}
+
+		uint64_t end = offset + static_cast<uint64_t>(accessor.count - 1) * accessor.stride + elementSize;
+		if (accessor.stride < elementSize || viewOffset + viewLength > binSize || end > viewLength)
+		{
+			BmSetLastError("glTF accessor lies outside its buffer view");
+			return false;
+		}
+
+		accessor.data = bin + viewOffset + offset;
+		accessor.viewSpace = viewLength - offset;
+		return true;
+	}
+
+	// =================================
+	// Primitives
+	// =================================
+
+	// true when every attribute is interleaved in one buffer view, the attributes are then sorted by offset.
+	// whole vertices are read from the first attribute, so the last one's padding must also lie in the view
+	static bool IsGlbInterleaved(std::vector<BmGlbAccessor>& attributes)
+	{
+		for (const BmGlbAccessor& accessor : attributes)
+		{
+			if (accessor.view != attributes[0].view || accessor.stride != attributes[0].stride)
+				return false;
+		}
+
+		std::sort(attributes.begin(), attributes.end(), [](const BmGlbAccessor& a, const BmGlbAccessor& b) { return a.data < b.data; });
+
+		// attributes may not overlap, the gaps between them become Uint8 padding attributes
+		for (size_t a = 1; a < attributes.size(); a++)
+		{
+			const uint8_t* previousEnd = attributes[a - 1].data + attributes[a - 1].GetElementSize();
+			if (previousEnd > attributes[a].data || attributes[a].data - previousEnd > UINT8_MAX)
+				return false;
+		}
+
+		const BmGlbAccessor& first = attributes[0];
+		const BmGlbAccessor& last = attributes.back();
+		return static_cast<uint32_t>(last.data - first.data) + last.GetElementSize() <= first.stride &&
+			static_cast<uint64_t>(first.count) * first.stride <= first.viewSpace;
+	}
+
+	// every attribute of the layout is a packed accessor of the same type, so each can be used as its stream
+	static bool CanViewGlbStreams(const std::vector<BmGlbAccessor>& attributes, const BmVertLayout* vertLayout)
+	{
+		for (uint32_t a = 0; a < vertLayout->attributeCount; a++)
+		{
+			const BmVertAttr& attr = vertLayout->attributes[a];
+			auto found = std::find_if(attributes.begin(), attributes.end(), [&](const BmGlbAccessor& accessor) { return accessor.attr.attrMap == attr.attrMap; });
+			if (found == attributes.end() || !found->IsPacked() || found->attr.baseType != attr.baseType || found->attr.components != attr.components ||
+				!CanReferenceData<float>(found->data))
+				return false;
+		}
+
+		return true;
+	}
+
+	// reads a primitive's vertices and indices. the accessors are described to the .bmf readers as a file mesh:
+	// interleaved when they share a buffer view (padding between them becomes unmapped attributes),
+	// otherwise gathered back to back in to scratch as a non-interleaved mesh
+	template<typename V = BmVert, typename I = uint32_t>
+	BM_FUNC_DECL bool ReadGlbPrimitive(BmGlbPrimitive& primitive, BmMesh<V, I>& newMesh, const BmVertLayout* vertLayout, bool interleaved, BmLoadFlags flags)
+	{
+		bool referenceData = BmHasFlag(flags, BmLoadFlags::MemoryMapped);
+		uint32_t vertCount = primitive.attributes[0].count;
+
+		BmMeshHeader header = BmMeshHeader();
+		BmMeshRecord record = BmMeshRecord();
+		record.header = &header;
+		header.vertCount = vertCount;
+
+		std::vector<uint8_t> scratch;
+
+		if (!interleaved && referenceData && CanViewGlbStreams(primitive.attributes, vertLayout))
+		{
+			newMesh.streams.reserve(vertLayout->attributeCount);
+			for (uint32_t a = 0; a < vertLayout->attributeCount; a++)
+			{
+				const BmVertAttr& attr = vertLayout->attributes[a];
+				auto found = std::find_if(primitive.attributes.begin(), primitive.attributes.end(), [&](const BmGlbAccessor& accessor) { return accessor.attr.attrMap == attr.attrMap; });
+
+				BmVertStream stream;
+				stream.attribute = attr;
+				stream.stride = found->stride;
+				stream.count = vertCount;
+				stream.data = found->data;
+				newMesh.streams.add(stream);
+			}
+		}
+		else
+		{
+			bool viewInterleaved = IsGlbInterleaved(primitive.attributes);
+
+			uint32_t offset = 0;
+			for (const BmGlbAccessor& accessor : primitive.attributes)
+			{
+				uint32_t gap = viewInterleaved ? static_cast<uint32_t>(accessor.data - primitive.attributes[0].data) - offset : 0;
+				if (gap > 0)
+					header.verAttrList[header.vertAttrCount++] = BmVertAttr(BmBaseType::Uint8, static_cast<uint8_t>(gap), BmAttrMap::None);
+
+				header.verAttrList[header.vertAttrCount++] = accessor.attr;
+				offset += gap + accessor.GetElementSize();
+			}
+
+			if (viewInterleaved)
+			{
+				uint32_t gap = primitive.attributes[0].stride - offset;
+				if (gap > 0)
+					header.verAttrList[header.vertAttrCount++] = BmVertAttr(BmBaseType::Uint8, static_cast<uint8_t>(gap), BmAttrMap::None);
+
+				header.interleaved = true;
+				record.vertexData = primitive.attributes[0].data;
+			}
+			else
+			{
+				scratch.resize(static_cast<size_t>(offset) * vertCount);
+				uint8_t* out = scratch.data();
+				for (const BmGlbAccessor& accessor : primitive.attributes)
+				{
+					uint32_t elementSize = accessor.GetElementSize();
+					if (accessor.IsPacked())
+						memcpy(out, accessor.data, static_cast<size_t>(elementSize) * vertCount);
+					else
+					{
+						for (uint32_t v = 0; v < vertCount; v++)
+							memcpy(out + static_cast<size_t>(v) * elementSize, accessor.data + static_cast<size_t>(v) * accessor.stride, elementSize);
+					}
+					out += static_cast<size_t>(elementSize) * vertCount;
+				}
+
+				header.interleaved = false;
+				record.vertexData = scratch.data();
+				referenceData = false;
+			}
+
+			bool readVertices = interleaved ?
+				ReadInterleavedVertices<V, I>(record, newMesh, vertLayout, referenceData) :
+				ReadVertexStreams<V, I>(record, newMesh, vertLayout, referenceData);
+
+			if (!readVertices)
+				return false;
+		}
+
+		// primitives without indices draw their vertices in order
+		std::vector<uint32_t> sequence;
+		if (primitive.indexed)
+		{
+			header.indiceCount = primitive.indices.count;
+			header.indiceType = static_cast<uint8_t>(primitive.indices.attr.baseType == BmBaseType::Uint8 ? BmIndexType::UInt8 :
+				(primitive.indices.attr.baseType == BmBaseType::UInt16 ? BmIndexType::UInt16 : BmIndexType::UInt32));
+			record.indexData = primitive.indices.data;
+		}
+		else
+		{
+			sequence.resize(vertCount);
+			for (uint32_t v = 0; v < vertCount; v++)
+				sequence[v] = v;
+
+			header.indiceCount = vertCount;
+			header.indiceType = static_cast<uint8_t>(BmIndexType::UInt32);
+			record.indexData = reinterpret_cast<uint8_t*>(sequence.data());
+			flags = flags & ~BmLoadFlags::MemoryMapped;
+		}
+
+		// glTF doesn't bound index values, ReadIndices rejects any past the primitive's vertices
+		if (!ReadIndices<V, I>(record, newMesh, flags))
+			return false;
+
+		newMesh.subMeshList.add(BmSubMesh{ 0, header.indiceCount, primitive.materialID });
+		return true;
+	}
+
+	// =================================
+	// Nodes
+	// =================================
+
+	// local transform of a node, either its matrix or translation * rotation * scale
+	static BmMat4 GetGlbNodeMatrix(const BmJsonDocument& doc, uint32_t node)
+	{
+		BmMat4 result;
+
+		uint32_t matrix = doc.Find(node, "matrix");
+		if (doc.Count(matrix) == 16)
+		{
+			for (uint32_t i = 0; i < 16; i++)
+				result[i / 4][i % 4] = static_cast<float>(doc.GetNumber(doc.At(matrix, i), i / 4 == i % 4 ? 1.0 : 0.0));
+			return result;
+		}
+
+		uint32_t translation = doc.Find(node, "translation");
+		uint32_t rotation = doc.Find(node, "rotation");
+		uint32_t scale = doc.Find(node, "scale");
+
+		float t[3], q[4], s[3];
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			t[i] = static_cast<float>(doc.GetNumber(doc.At(translation, i), 0.0));
+			s[i] = static_cast<float>(doc.GetNumber(doc.At(scale, i), 1.0));
+		}
+		for (uint32_t i = 0; i < 4; i++)
+			q[i] = static_cast<float>(doc.GetNumber(doc.At(rotation, i), i == 3 ? 1.0 : 0.0));
+
+		float x = q[0], y = q[1], z = q[2], w = q[3];
+		result[0] = BmVec4((1.0f - 2.0f * (y * y + z * z)) * s[0], 2.0f * (x * y + z * w) * s[0], 2.0f * (x * z - y * w) * s[0], 0.0f);
+		result[1] = BmVec4(2.0f * (x * y - z * w) * s[1], (1.0f - 2.0f * (x * x + z * z)) * s[1], 2.0f * (y * z + x * w) * s[1], 0.0f);
+		result[2] = BmVec4(2.0f * (x * z + y * w) * s[2], 2.0f * (y * z - x * w) * s[2], (1.0f - 2.0f * (x * x + y * y)) * s[2], 0.0f);
+		result[3] = BmVec4(t[0], t[1], t[2], 1.0f);
+		return result;
+	}
+
+	// world transform of the first node instancing each mesh, identity for meshes no node uses
+	static std::vector<BmMat4> GetGlbMeshTransforms(const BmJsonDocument& doc, uint32_t root, uint32_t meshCount)
+	{
+		std::vector<BmMat4> transforms(meshCount);
+		std::vector<bool> placed(meshCount, false);
+
+		uint32_t nodes = doc.Find(root, "nodes");
+		uint32_t nodeCount = doc.Count(nodes);
+
+		std::vector<uint32_t> parents(nodeCount, BmJsonInvalid);
+		for (uint32_t n = 0, node = nodes + 1; n < nodeCount; n++, node = doc[node].next)
+		{
+			uint32_t children = doc.Find(node, "children");
+			for (uint32_t c = 0, child = children + 1; c < doc.Count(children); c++, child = doc[child].next)
+			{
+				uint32_t childIndex = doc.GetUInt(child, BmJsonInvalid);
+				if (childIndex < nodeCount)
+					parents[childIndex] = n;
+			}
+		}
+
+		for (uint32_t n = 0, node = nodes + 1; n < nodeCount; n++, node = doc[node].next)
+		{
+			uint32_t mesh = doc.GetUInt(doc.Find(node, "mesh"), BmJsonInvalid);
+			if (mesh >= meshCount || placed[mesh])
+				continue;
+
+			// walk up to the root, bounded by the node count in case the hierarchy has a cycle
+			BmMat4 world = GetGlbNodeMatrix(doc, node);
+			for (uint32_t parent = parents[n], depth = 0; parent != BmJsonInvalid && depth < nodeCount; parent = parents[parent], depth++)
+			{
+				BmMat4 local = world;
+				world = GetGlbNodeMatrix(doc, doc.At(nodes, parent)) * local;
+			}
+
+			transforms[mesh] = world;
+			placed[mesh] = true;
+		}
+
+		return transforms;
+	}
+
+	// =================================
+	// Loading
+	// =================================
+
+	// loads a .glb held in memory. vertices are converted to vertLayout, which must describe V, or stored
+	// as per attribute streams with interleaved = false. with BmLoadFlags::MemoryMapped mesh data may
+	// reference data, which must then outlive the model. materialNames, if given, receives the name
+	// of every glTF material in the order BmSubMesh::materialID indexes them
+	template<typename V = BmVert, typename I = uint32_t>
+	BM_FUNC_DECL BmModel<V, I>* LoadGlb(uint8_t* data, uint32_t dataSize, const BmVertLayout* vertLayout = &BmDefaultLayout, bool interleaved = true,
+		BmLoadFlags flags = BmLoadFlags::None, std::vector<std::string>* materialNames = nullptr)
+	{
+		BmGlbHeader header;
+		BmGlbChunkHeader jsonChunk;
+		if (dataSize < sizeof(header) + sizeof(jsonChunk))
+		{
+			BmSetLastError("File too small to be a glTF binary");
+			return nullptr;
+		}
+
+		memcpy(&header, data, sizeof(header));
+		memcpy(&jsonChunk, data + sizeof(header), sizeof(jsonChunk));
+		if (header.magic != BmGlbMagic || header.version != 2 || header.length > dataSize)
+		{
+			BmSetLastError("File is not a glTF 2.0 binary");
+			return nullptr;
+		}
+
+		uint32_t jsonOffset = sizeof(header) + sizeof(jsonChunk);
+		if (jsonChunk.type != BmGlbChunkJson || jsonChunk.length > header.length - jsonOffset)
+		{
+			BmSetLastError("glTF binary has no JSON chunk");
+			return nullptr;
+		}
+
+		// the BIN chunk is optional and follows the JSON chunk
+		uint8_t* bin = nullptr;
+		uint32_t binSize = 0;
+		uint32_t binOffset = jsonOffset + jsonChunk.length;
+		BmGlbChunkHeader binChunk;
+		if (header.length - binOffset >= sizeof(binChunk))
+		{
+			memcpy(&binChunk, data + binOffset, sizeof(binChunk));
+			if (binChunk.type == BmGlbChunkBin && binChunk.length <= header.length - binOffset - sizeof(binChunk))
+			{
+				bin = data + binOffset + sizeof(binChunk);
+				binSize = binChunk.length;
+			}
+		}
+
+		BmJsonDocument doc;
+		if (!doc.Parse(reinterpret_cast<const char*>(data + jsonOffset), jsonChunk.length) || doc[0].type != BmJsonType::Object)
+		{
+			BmSetLastError("glTF JSON chunk is not valid JSON");
+			return nullptr;
+		}
+
+		const uint32_t root = 0;
+		uint32_t meshes = doc.Find(root, "meshes");
+		uint32_t meshCount = doc.Count(meshes);
+
+		// collect the triangle primitives of every mesh
+		std::vector<BmGlbPrimitive> primitives;
+		for (uint32_t m = 0, mesh = meshes + 1; m < meshCount; m++, mesh = doc[mesh].next)
+		{
+			uint32_t prims = doc.Find(mesh, "primitives");
+			for (uint32_t p = 0, prim = prims + 1; p < doc.Count(prims); p++, prim = doc[prim].next)
+			{
+				if (doc.GetUInt(doc.Find(prim, "mode"), 4) != 4)
+				{
+					BM_LOG("skipping glTF primitive that isn't a triangle list\n");
+					continue;
+				}
+
+				primitives.emplace_back();
+				BmGlbPrimitive& primitive = primitives.back();
+				primitive.mesh = m;
+
+				uint32_t material = doc.GetUInt(doc.Find(prim, "material"), BmGlbNoMaterial);
+				primitive.materialID = static_cast<uint16_t>(material < BmGlbNoMaterial ? material : BmGlbNoMaterial);
+
+				uint32_t attributes = doc.Find(prim, "attributes");
+				for (uint32_t a = 0, key = attributes + 1; a < doc.Count(attributes); a++, key = doc[key + 1].next)
+				{
+					BmAttrMap attrMap = GetGlbAttrMap(reinterpret_cast<const char*>(data + jsonOffset) + doc[key].start, doc[key].length, vertLayout);
+					if (attrMap == BmAttrMap::None)
+						continue;
+
+					BmGlbAccessor accessor;
+					if (!ReadGlbAccessor(doc, root, doc.GetUInt(key + 1, BmJsonInvalid), bin, binSize, accessor))
+						return nullptr;
+
+					// the converters read 8 and 16 bit data as normalized, which glTF requires for these semantics
+					uint32_t componentSize = GetBaseTypeSize(accessor.attr.baseType);
+					if (componentSize < 4 && !accessor.normalized)
+					{
+						BmSetLastError("glTF vertex attributes with unnormalized integer data are not supported");
+						return nullptr;
+					}
+
+					accessor.attr.attrMap = attrMap;
+					primitive.attributes.push_back(accessor);
+				}
+
+				auto position = std::find_if(primitive.attributes.begin(), primitive.attributes.end(), [](const BmGlbAccessor& a) { return a.attr.attrMap == BmAttrMap::Position; });
+				if (position == primitive.attributes.end())
+				{
+					BmSetLastError("glTF primitive has no POSITION attribute");
+					return nullptr;
+				}
+
+				// each attribute may need a padding attribute before it when read as an interleaved file mesh
+				if (primitive.attributes.size() > MAX_VERTEX_ATTRIBS / 2 - 1)
+				{
+					BmSetLastError("glTF primitive has too many vertex attributes");
+					return nullptr;
+				}
+
+				for (const BmGlbAccessor& accessor : primitive.attributes)
+				{
+					if (accessor.count != position->count)
+					{
+						BmSetLastError("glTF primitive attributes have different vertex counts");
+						return nullptr;
+					}
+				}
+
+				uint32_t indices = doc.Find(prim, "indices");
+				primitive.indexed = indices != BmJsonInvalid;
+				if (primitive.indexed)
+				{
+					if (!ReadGlbAccessor(doc, root, doc.GetUInt(indices, BmJsonInvalid), bin, binSize, primitive.indices))
+						return nullptr;
+
+					BmBaseType indexType = primitive.indices.attr.baseType;
+					if (primitive.indices.attr.components != 1 || !primitive.indices.IsPacked() ||
+						(indexType != BmBaseType::Uint8 && indexType != BmBaseType::UInt16 && indexType != BmBaseType::UInt32))
+					{
+						BmSetLastError("glTF primitive indices must be packed unsigned scalars");
+						return nullptr;
+					}
+				}
+			}
+		}
+
+		std::vector<BmMat4> transforms = GetGlbMeshTransforms(doc, root, meshCount);
+
+		BmModel<V, I>* model = new BmModel<V, I>();
+		model->meshList.resize(static_cast<uint32_t>(primitives.size()));
+
+		std::atomic<bool> succeeded(true);
+		GetWorkerPool().ParallelFor(static_cast<uint32_t>(primitives.size()), [&](uint32_t p)
+		{
+			BmMesh<V, I>& mesh = model->meshList[p];
+			mesh.transform = transforms[primitives[p].mesh];
+			if (!ReadGlbPrimitive<V, I>(primitives[p], mesh, vertLayout, interleaved, flags))
+				succeeded = false;
+		});
+
+		if (!succeeded)
+		{
+			delete model;
+			return nullptr;
+		}
+
+		if (materialNames != nullptr)
+		{
+			uint32_t materials = doc.Find(root, "materials");
+			materialNames->clear();
+			for (uint32_t m = 0, material = materials + 1; m < doc.Count(materials); m++, material = doc[material].next)
+				materialNames->push_back(doc.GetString(doc.Find(material, "name")));
+		}
+
+		BM_LOG("Loaded glTF binary with %u meshes\n", model->meshList.count);
+
+		return model;
+	}
+
+	// loads a .glb file. the file is mapped, with BmLoadFlags::MemoryMapped the model keeps the mapping
+	// and mesh data matching V and I references it in place
+	template<typename V = BmVert, typename I = uint32_t>
+	BM_FUNC_DECL BmModel<V, I>* LoadGlb(std::string name, const BmVertLayout* vertLayout = &BmDefaultLayout, bool interleaved = true,
+		BmLoadFlags flags = BmLoadFlags::None, std::vector<std::string>* materialNames = nullptr)
+	{
+		BmFileMapping mapping;
+		if (!FileMap(name.c_str(), mapping))
+		{
+			BmSetLastError("Unable to map file");
+			return nullptr;
+		}
+
+		BmModel<V, I>* model = LoadGlb<V, I>(mapping.data, mapping.size, vertLayout, interleaved, flags, materialNames);
+		if (model != nullptr && BmHasFlag(flags, BmLoadFlags::MemoryMapped))
+			model->fileMapping = mapping;
+		else
+			FileUnmap(mapping);
+
+		return model;
+	}
+}
+
+// =================================
@@ -0,0 +1,753 @@
+#pragma once
+
+#include "bmdl.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// =================================
+// Basic Model : OBJ Import
+// Loads Wavefront OBJ files in to a BmModel with a single mesh.
+//
+// The file is cut in to chunks at line breaks which are parsed in parallel, each chunk collecting its
+// v / vt / vn data and triangulated face corners. Once every chunk's position in the file's attribute
+// lists is known the chunks weld their corners in parallel, hashing the position, uv and normal of each
+// corner, and the chunk vertices are then welded across chunks in parallel shards split by hash.
+// Vertices keep the order they are first used in. usemtl starts a new BmSubMesh whose materialID
+// indexes the material names (BmObjNoMaterial for faces before the first usemtl), polygons are
+// triangulated as fans. Other statements are ignored.
+// =================================
+
+namespace bmdl
+{
+	static const uint32_t BmObjMinChunkSize = 256 * 1024;
+	static const uint32_t BmObjMaxChunkSize = 16 * 1024 * 1024;
+	static const uint32_t BmObjShardBits = 8;
+	static const uint16_t BmObjNoMaterial = 0xFFFF;
+
+	// a welded vertex, compared bitwise
+	struct BmObjVertex
+	{
+		float		position[3];
+		float		texCoord[2];
+		float		normal[3];
+		uint32_t	color;
+	};
+
+	struct BmObjGroup
+	{
+		uint32_t	cornerOffset;	// first corner of the group in its chunk
+		std::string	material;
+	};
+
+	struct BmObjChunk
+	{
+		BmObjChunk() : begin(nullptr), end(nullptr), positionBase(0), texCoordBase(0), normalBase(0),
+			vertexBase(0), newVertexBase(0), newVertexCount(0), indexBase(0), failed(false) {}
+
+		const char* begin;
+		const char* end;
+
+		std::vector<float>		positions;
+		std::vector<float>		texCoords;
+		std::vector<float>		normals;
+		std::vector<uint32_t>	colors;		// only filled once the chunk finds a vertex color
+
+		// position, uv and normal reference of every triangle corner, 0 based, -1 when missing.
+		// references listed in relative (corner * 3 + component) are relative to the chunk's base
+		std::vector<int32_t>	corners;
+		std::vector<uint32_t>	relative;
+		std::vector<BmObjGroup>	groups;
+
+		// welding, indices are in to the chunk's vertices
+		std::vector<BmObjVertex>	vertices;
+		std::vector<uint32_t>		hashes;
+		std::vector<uint32_t>		indices;
+
+		// chunk vertices sorted by shard, shardStart[s] is the first of shard s in shardOrder
+		std::vector<uint32_t>	shardStart;
+		std::vector<uint32_t>	shardOrder;
+
+		uint32_t positionBase;
+		uint32_t texCoordBase;
+		uint32_t normalBase;
+		uint32_t vertexBase;		// first vertex of the chunk in the list of all chunk vertices
+		uint32_t newVertexBase;		// first vertex of the model the chunk adds
+		uint32_t newVertexCount;
+		uint32_t indexBase;
+
+		bool failed;
+	};
+
+	// =================================
+	// Parsing
+	// =================================
+
+	static inline bool IsObjSpace(char c) { return c == ' ' || c == '\t'; }
+	static inline bool IsObjLineEnd(char c) { return c == '\n' || c == '\r'; }
+
+	// r g b in [0, 1] packed as GetColorUInt32 does
+	static inline uint32_t GetObjColor(const float* color)
+	{
+		uint8_t channels[3];
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			float c = color[i] * 255.0f + 0.5f;
+			channels[i] = static_cast<uint8_t>(c < 0.0f ? 0.0f : (c > 255.0f ? 255.0f : c));
+		}
+		return GetColorUInt32(BmColor32(channels[0], channels[1], channels[2], 255));
+	}
+
+	static inline const char* SkipObjSpace(const char* s, const char* end)
+	{
+		while (s < end && IsObjSpace(*s))
+			s++;
+		return s;
+	}
+
+	static inline const char* SkipObjLine(const char* s, const char* end)
+	{
+		while (s < end && *s != '\n')
+			s++;
+		return s < end ? s + 1 : s;
+	}
+
+	// locale independent float parsing, exact for up to 19 significant digits before the final rounding to float
+	static inline const char* ParseObjFloat(const char* s, const char* end, float& value)
+	{
+		static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+		s = SkipObjSpace(s, end);
+
+		bool negative = false;
+		if (s < end && (*s == '-' || *s == '+'))
+			negative = *s++ == '-';
+
+		uint64_t mantissa = 0;
+		int32_t digits = 0;
+		int32_t exponent = 0;
+
+		for (; s < end && static_cast<unsigned>(*s - '0') < 10; s++)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<unsigned>(*s - '0');
+				digits += mantissa != 0 ? 1 : 0;
+			}
+			else
+				exponent++;
+		}
+
+		if (s < end && *s == '.')
+		{
+			for (s++; s < end && static_cast<unsigned>(*s - '0') < 10; s++)
+			{
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<unsigned>(*s - '0');
+					digits += mantissa != 0 ? 1 : 0;
+					exponent--;
+				}
+			}
+		}
+
+		if (s < end && (*s == 'e' || *s == 'E'))
+		{
+			s++;
+			bool negativeExponent = false;
+			if (s < end && (*s == '-' || *s == '+'))
+				negativeExponent = *s++ == '-';
+
+			int32_t e = 0;
+			for (; s < end && static_cast<unsigned>(*s - '0') < 10; s++)
+				e = e < 10000 ? e * 10 + (*s - '0') : e;
+
+			exponent += negativeExponent ? -e : e;
+		}
+
+		double result = static_cast<double>(mantissa);
+		if (mantissa != 0)
+		{
+			for (; exponent > 22; exponent -= 22)
+				result *= powers[22];
+			for (; exponent < -22; exponent += 22)
+				result /= powers[22];
+
+			result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+		}
+
+		value = static_cast<float>(negative ? -result : result);
+		return s;
+	}
+
+	static inline const char* ParseObjInt(const char* s, const char* end, int32_t& value)
+	{
+		bool negative = false;
+		if (s < end && (*s == '-' || *s == '+'))
+			negative = *s++ == '-';
+
+		int64_t result = 0;
+		for (; s < end && static_cast<unsigned>(*s - '0') < 10; s++)
+			result = result < INT32_MAX ? result * 10 + (*s - '0') : result;
+
+		result = result > INT32_MAX ? INT32_MAX : result;
+		value = static_cast<int32_t>(negative ? -result : result);
+		return s;
+	}
+
+	// stores a corner reference, 1 based absolute or negative relative to the end of the chunk's list so far
+	static inline void AddObjReference(BmObjChunk& chunk, int32_t reference, size_t localCount)
+	{
+		if (reference < 0)
+		{
+			chunk.relative.push_back(static_cast<uint32_t>(chunk.corners.size()));
+			chunk.corners.push_back(static_cast<int32_t>(static_cast<int64_t>(localCount) + reference));
+		}
+		else
+			chunk.corners.push_back(reference - 1);
+	}
+
+	static inline void AddObjCorner(BmObjChunk& chunk, const int32_t* corner)
+	{
+		AddObjReference(chunk, corner[0], chunk.positions.size() / 3);
+		AddObjReference(chunk, corner[1], chunk.texCoords.size() / 2);
+		AddObjReference(chunk, corner[2], chunk.normals.size() / 3);
+	}
+
+	static const char* ParseObjFace(BmObjChunk& chunk, const char* s, const char* end)
+	{
+		int32_t first[3];
+		int32_t previous[3];
+		uint32_t cornerCount = 0;
+
+		for (;;)
+		{
+			s = SkipObjSpace(s, end);
+			if (s == end || IsObjLineEnd(*s))
+				break;
+
+			// p, p/t, p//n or p/t/n. 0 marks a missing reference
+			int32_t corner[3] = { 0, 0, 0 };
+			s = ParseObjInt(s, end, corner[0]);
+			if (s < end && *s == '/')
+			{
+				s++;
+				if (s < end && *s != '/')
+					s = ParseObjInt(s, end, corner[1]);
+				if (s < end && *s == '/')
+					s = ParseObjInt(s + 1, end, corner[2]);
+			}
+
+			// skip anything unexpected up to the next separator
+			while (s < end && !IsObjSpace(*s) && !IsObjLineEnd(*s))
+				s++;
+
+			if (corner[0] == 0)
+			{
+				chunk.failed = true;
+				continue;
+			}
+
+			if (cornerCount == 0)
+				memcpy(first, corner, sizeof(first));
+			else if (cornerCount >= 2)
+			{
+				AddObjCorner(chunk, first);
+				AddObjCorner(chunk, previous);
+				AddObjCorner(chunk, corner);
+			}
+
+			memcpy(previous, corner, sizeof(previous));
+			cornerCount++;
+		}
+
+		return s;
+	}
+
+	static void ParseObjChunk(BmObjChunk& chunk)
+	{
+		const char* s = chunk.begin;
+		const char* end = chunk.end;
+
+		while (s < end)
+		{
+			s = SkipObjSpace(s, end);
+			if (s == end)
+				break;
+
+			char c0 = *s;
+			char c1 = s + 1 < end ? s[1] : '\n';
+
+			if (c0 == 'v' && IsObjSpace(c1))
+			{
+				float position[3] = { 0.0f, 0.0f, 0.0f };
+				for (uint32_t i = 0; i < 3; i++)
+					s = ParseObjFloat(s + (i == 0 ? 1 : 0), end, position[i]);
+				chunk.positions.insert(chunk.positions.end(), position, position + 3);
+
+				// optional r g b vertex color
+				s = SkipObjSpace(s, end);
+				if (s < end && !IsObjLineEnd(*s))
+				{
+					float color[3] = { 1.0f, 1.0f, 1.0f };
+					for (uint32_t i = 0; i < 3; i++)
+						s = ParseObjFloat(s, end, color[i]);
+
+					if (chunk.colors.empty())
+						chunk.colors.resize(chunk.positions.size() / 3 - 1, GetColorUInt32(BmColor32(255)));
+					chunk.colors.push_back(GetObjColor(color));
+				}
+				else if (!chunk.colors.empty())
+					chunk.colors.push_back(GetColorUInt32(BmColor32(255)));
+			}
+			else if (c0 == 'v' && c1 == 't')
+			{
+				float texCoord[2] = { 0.0f, 0.0f };
+				s = ParseObjFloat(s + 2, end, texCoord[0]);
+				s = ParseObjFloat(s, end, texCoord[1]);
+				chunk.texCoords.insert(chunk.texCoords.end(), texCoord, texCoord + 2);
+			}
+			else if (c0 == 'v' && c1 == 'n')
+			{
+				float normal[3] = { 0.0f, 0.0f, 0.0f };
+				for (uint32_t i = 0; i < 3; i++)
+					s = ParseObjFloat(s + (i == 0 ? 2 : 0), end, normal[i]);
+				chunk.normals.insert(chunk.normals.end(), normal, normal + 3);
+			}
+			else if (c0 == 'f' && IsObjSpace(c1))
+			{
+				s = ParseObjFace(chunk, s + 1, end);
+			}
+			else if (c0 == 'u' && end - s > 7 && memcmp(s, "usemtl", 6) == 0 && IsObjSpace(s[6]))
+			{
+				const char* name = SkipObjSpace(s + 6, end);
+				const char* nameEnd = name;
+				while (nameEnd < end && !IsObjLineEnd(*nameEnd))
+					nameEnd++;
+				while (nameEnd > name && IsObjSpace(nameEnd[-1]))
+					nameEnd--;
+
+				BmObjGroup group;
+				group.cornerOffset = static_cast<uint32_t>(chunk.corners.size() / 3);
+				group.material.assign(name, nameEnd);
+				chunk.groups.push_back(group);
+				s = nameEnd;
+			}
+
+			s = SkipObjLine(s, end);
+		}
+	}
+
+	// =================================
+	// Welding
+	// =================================
+
+	static inline uint32_t HashObjVertex(const BmObjVertex& vertex)
+	{
+		uint32_t words[9];
+		memcpy(words, &vertex, sizeof(words));
+
+		uint32_t hash = 2166136261u;
+		for (uint32_t w = 0; w < 9; w++)
+		{
+			hash ^= words[w];
+			hash *= 16777619u;
+			hash ^= hash >> 15;
+		}
+		return hash;
+	}
+
+	static inline bool EqualObjVertex(const BmObjVertex& a, const BmObjVertex& b) { return memcmp(&a, &b, sizeof(BmObjVertex)) == 0; }
+
+	// table size for up to count entries, at most half full
+	static inline uint32_t GetObjTableSize(size_t count)
+	{
+		uint32_t size = 16;
+		while (size < count * 2)
+			size *= 2;
+		return size;
+	}
+
+	// resolves the chunk's corner references and welds them in to the chunk's vertices
+	static void WeldObjChunk(BmObjChunk& chunk, const std::vector<float>& positions, const std::vector<float>& texCoords,
+		const std::vector<float>& normals, const std::vector<uint32_t>& colors)
+	{
+		uint32_t bases[3] = { chunk.positionBase, chunk.texCoordBase, chunk.normalBase };
+		for (uint32_t r : chunk.relative)
+			chunk.corners[r] += static_cast<int32_t>(bases[r % 3]);
+
+		uint32_t counts[3] = { static_cast<uint32_t>(positions.size() / 3), static_cast<uint32_t>(texCoords.size() / 2), static_cast<uint32_t>(normals.size() / 3) };
+
+		size_t cornerCount = chunk.corners.size() / 3;
+		std::vector<uint32_t> table(GetObjTableSize(cornerCount), 0);
+		uint32_t mask = static_cast<uint32_t>(table.size() - 1);
+
+		chunk.indices.resize(cornerCount);
+		uint32_t white = GetColorUInt32(BmColor32(255));
+
+		for (size_t c = 0; c < cornerCount; c++)
+		{
+			const int32_t* reference = &chunk.corners[c * 3];
+
+			// a position is required, uv and normal may be missing
+			if (reference[0] < 0 || static_cast<uint32_t>(reference[0]) >= counts[0] ||
+				reference[1] >= static_cast<int64_t>(counts[1]) || reference[2] >= static_cast<int64_t>(counts[2]))
+			{
+				chunk.failed = true;
+				return;
+			}
+
+			BmObjVertex vertex;
+			memset(&vertex, 0, sizeof(vertex));
+			memcpy(vertex.position, &positions[reference[0] * 3], sizeof(vertex.position));
+			if (reference[1] >= 0)
+				memcpy(vertex.texCoord, &texCoords[reference[1] * 2], sizeof(vertex.texCoord));
+			if (reference[2] >= 0)
+				memcpy(vertex.normal, &normals[reference[2] * 3], sizeof(vertex.normal));
+			vertex.color = colors.empty() ? white : colors[reference[0]];
+
+			// -0 and 0 weld together
+			for (float& f : vertex.position) f += 0.0f;
+			for (float& f : vertex.texCoord) f += 0.0f;
+			for (float& f : vertex.normal) f += 0.0f;
+
+			uint32_t hash = HashObjVertex(vertex);
+			uint32_t slot = hash & mask;
+			for (;;)
+			{
+				uint32_t entry = table[slot];
+				if (entry == 0)
+				{
+					chunk.vertices.push_back(vertex);
+					chunk.hashes.push_back(hash);
+					table[slot] = static_cast<uint32_t>(chunk.vertices.size());
+					chunk.indices[c] = table[slot] - 1;
+					break;
+				}
+
+				if (chunk.hashes[entry - 1] == hash && EqualObjVertex(chunk.vertices[entry - 1], vertex))
+				{
+					chunk.indices[c] = entry - 1;
+					break;
+				}
+
+				slot = (slot + 1) & mask;
+			}
+		}
+
+		std::vector<int32_t>().swap(chunk.corners);
+		std::vector<uint32_t>().swap(chunk.relative);
+
+		// order the chunk's vertices by shard, keeping their order within a shard
+		uint32_t shardCount = 1u << BmObjShardBits;
+		chunk.shardStart.assign(shardCount + 1, 0);
+		for (uint32_t hash : chunk.hashes)
+			chunk.shardStart[(hash >> (32 - BmObjShardBits)) + 1]++;
+		for (uint32_t s = 0; s < shardCount; s++)
+			chunk.shardStart[s + 1] += chunk.shardStart[s];
+
+		std::vector<uint32_t> next(chunk.shardStart.begin(), chunk.shardStart.end() - 1);
+		chunk.shardOrder.resize(chunk.vertices.size());
+		for (uint32_t v = 0; v < chunk.vertices.size(); v++)
+			chunk.shardOrder[next[chunk.hashes[v] >> (32 - BmObjShardBits)]++] = v;
+	}
+
+	// =================================
+	// Loading
+	// =================================
+
+	// loads OBJ text in to a model with one mesh. vertices are converted from BmDefaultLayout to vertLayout,
+	// which must describe V. materialNames, if given, receives the usemtl names BmSubMesh::materialID indexes
+	template<typename V = BmVert, typename I = uint32_t>
+	BM_FUNC_DECL BmModel<V, I>* LoadObj(const char* data, size_t dataSize, const BmVertLayout* vertLayout = &BmDefaultLayout, std::vector<std::string>* materialNames = nullptr)
+	{
+		BmWorkerPool& pool = GetWorkerPool();
+		const BmVertConversionPlan* plan = GetConversionPlan(BmDefaultLayout.attributes, BmDefaultLayout.attributeCount, vertLayout->attributes, vertLayout->attributeCount, sizeof(V));
+		if (plan == nullptr)
+			return nullptr;
+
+		// a few chunks per thread so uneven chunks still balance
+		size_t chunkSize = dataSize / ((pool.GetWorkerCount() + 1) * 4) + 1;
+		chunkSize = chunkSize < BmObjMinChunkSize ? BmObjMinChunkSize : (chunkSize > BmObjMaxChunkSize ? BmObjMaxChunkSize : chunkSize);
+
+		std::vector<BmObjChunk> chunks;
+		for (const char* begin = data, *end = data + dataSize; begin < end; )
+		{
+			const char* split = (static_cast<size_t>(end - begin) > chunkSize) ? begin + chunkSize : end;
+			while (split < end && split[-1] != '\n')
+				split++;
+
+			chunks.emplace_back();
+			chunks.back().begin = begin;
+			chunks.back().end = split;
+			begin = split;
+		}
+
+		uint32_t chunkCount = static_cast<uint32_t>(chunks.size());
+		pool.ParallelFor(chunkCount, [&](uint32_t c) { ParseObjChunk(chunks[c]); });
+
+		// place every chunk's attributes in the file wide lists
+		uint64_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+		bool hasColors = false;
+		for (BmObjChunk& chunk : chunks)
+		{
+			if (chunk.failed)
+			{
+				BmSetLastError("OBJ face has a corner without a position");
+				return nullptr;
+			}
+
+			chunk.positionBase = static_cast<uint32_t>(positionCount);
+			chunk.texCoordBase = static_cast<uint32_t>(texCoordCount);
+			chunk.normalBase = static_cast<uint32_t>(normalCount);
+			positionCount += chunk.positions.size() / 3;
+			texCoordCount += chunk.texCoords.size() / 2;
+			normalCount += chunk.normals.size() / 3;
+			hasColors |= !chunk.colors.empty();
+		}
+
+		if (positionCount > INT32_MAX || texCoordCount > INT32_MAX || normalCount > INT32_MAX)
+		{
+			BmSetLastError("OBJ has too many vertices");
+			return nullptr;
+		}
+
+		std::vector<float> positions(static_cast<size_t>(positionCount) * 3);
+		std::vector<float> texCoords(static_cast<size_t>(texCoordCount) * 2);
+		std::vector<float> normals(static_cast<size_t>(normalCount) * 3);
+		std::vector<uint32_t> colors(hasColors ? static_cast<size_t>(positionCount) : 0, GetColorUInt32(BmColor32(255)));
+
+		pool.ParallelFor(chunkCount, [&](uint32_t c)
+		{
+			BmObjChunk& chunk = chunks[c];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase * 3ull);
+			std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), texCoords.begin() + chunk.texCoordBase * 2ull);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase * 3ull);
+			std::copy(chunk.colors.begin(), chunk.colors.end(), colors.begin() + chunk.positionBase);
+
+			std::vector<float>().swap(chunk.positions);
+			std::vector<float>().swap(chunk.texCoords);
+			std::vector<float>().swap(chunk.normals);
+			std::vector<uint32_t>().swap(chunk.colors);
+		});
+
+		pool.ParallelFor(chunkCount, [&](uint32_t c) { WeldObjChunk(chunks[c], positions, texCoords, normals, colors); });
+
+		std::vector<float>().swap(positions);
+		std::vector<float>().swap(texCoords);
+		std::vector<float>().swap(normals);
+		std::vector<uint32_t>().swap(colors);
+
+		uint64_t chunkVertexCount = 0, indexCount = 0;
+		for (BmObjChunk& chunk : chunks)
+		{
+			if (chunk.failed)
+			{
+				BmSetLastError("OBJ face references a missing vertex");
+				return nullptr;
+			}
+
+			chunk.vertexBase = static_cast<uint32_t>(chunkVertexCount);
+			chunk.indexBase = static_cast<uint32_t>(indexCount);
+			chunkVertexCount += chunk.vertices.size();
+			indexCount += chunk.indices.size();
+		}
+
+		if (indexCount > UINT32_MAX || chunkVertexCount > INT32_MAX)
+		{
+			BmSetLastError("OBJ has too many faces");
+			return nullptr;
+		}
+
+		// weld across chunks, each shard maps a vertex to the first chunk vertex equal to it
+		std::vector<uint32_t> first(static_cast<size_t>(chunkVertexCount));
+		pool.ParallelFor(1u << BmObjShardBits, [&](uint32_t s)
+		{
+			size_t shardSize = 0;
+			for (const BmObjChunk& chunk : chunks)
+				shardSize += chunk.shardStart[s + 1] - chunk.shardStart[s];
+
+			std::vector<uint32_t> table(GetObjTableSize(shardSize), 0);
+			uint32_t mask = static_cast<uint32_t>(table.size() - 1);
+
+			// first vertices seen in the shard, as chunk vertex and its index in all chunk vertices
+			std::vector<const BmObjVertex*> entries;
+			std::vector<uint32_t> entryGlobals;
+			entries.reserve(shardSize);
+			entryGlobals.reserve(shardSize);
+
+			for (const BmObjChunk& chunk : chunks)
+			{
+				for (uint32_t o = chunk.shardStart[s]; o < chunk.shardStart[s + 1]; o++)
+				{
+					uint32_t v = chunk.shardOrder[o];
+					uint32_t global = chunk.vertexBase + v;
+
+					for (uint32_t slot = chunk.hashes[v] & mask; ; slot = (slot + 1) & mask)
+					{
+						uint32_t entry = table[slot];
+						if (entry == 0)
+						{
+							entries.push_back(&chunk.vertices[v]);
+							entryGlobals.push_back(global);
+							table[slot] = static_cast<uint32_t>(entries.size());
+							first[global] = global;
+							break;
+						}
+
+						if (EqualObjVertex(*entries[entry - 1], chunk.vertices[v]))
+						{
+							first[global] = entryGlobals[entry - 1];
+							break;
+						}
+					}
+				}
+			}
+		});
+
+		// number the vertices that are first of their kind in order
+		pool.ParallelFor(chunkCount, [&](uint32_t c)
+		{
+			BmObjChunk& chunk = chunks[c];
+			for (uint32_t v = 0; v < chunk.vertices.size(); v++)
+				chunk.newVertexCount += first[chunk.vertexBase + v] == chunk.vertexBase + v ? 1 : 0;
+		});
+
+		uint64_t vertexCount = 0;
+		for (BmObjChunk& chunk : chunks)
+		{
+			chunk.newVertexBase = static_cast<uint32_t>(vertexCount);
+			vertexCount += chunk.newVertexCount;
+		}
+
+		if (sizeof(I) < 4 && vertexCount > (1ull << (sizeof(I) * 8)))
+		{
+			BmSetLastError("OBJ vertices do not fit in the requested index type");
+			return nullptr;
+		}
+
+		BmModel<V, I>* model = new BmModel<V, I>();
+		model->meshList.resize(vertexCount > 0 ? 1 : 0);
+		if (vertexCount == 0)
+			return model;
+
+		BmMesh<V, I>& mesh = model->meshList[0];
+		mesh.vertices.reserve(static_cast<uint32_t>(vertexCount));
+		mesh.vertices.count = static_cast<uint32_t>(vertexCount);
+		mesh.indices.reserve(static_cast<uint32_t>(indexCount));
+		mesh.indices.count = static_cast<uint32_t>(indexCount);
+
+		// ids of first vertices, then of the vertices welded to them, which always come from the same or an earlier chunk
+		std::vector<uint32_t>& ids = first;
+		pool.ParallelFor(chunkCount, [&](uint32_t c)
+		{
+			BmObjChunk& chunk = chunks[c];
+			std::vector<BmVert> converted(chunk.newVertexCount);
+
+			uint32_t id = chunk.newVertexBase;
+			for (uint32_t v = 0; v < chunk.vertices.size(); v++)
+			{
+				uint32_t global = chunk.vertexBase + v;
+				if (ids[global] != global)
+					continue;
+
+				const BmObjVertex& src = chunk.vertices[v];
+				BmVert& dst = converted[id - chunk.newVertexBase];
+				dst.position = BmVec3(src.position[0], src.position[1], src.position[2]);
+				dst.texCoord = BmVec2(src.texCoord[0], src.texCoord[1]);
+				dst.normal = BmVec3(src.normal[0], src.normal[1], src.normal[2]);
+				dst.color = BmColor32(static_cast<uint8_t>(src.color >> 24), static_cast<uint8_t>(src.color >> 16),
+					static_cast<uint8_t>(src.color >> 8), static_cast<uint8_t>(src.color));
+
+				ids[global] = id++ | 0x80000000u;
+			}
+
+			if (chunk.newVertexCount > 0)
+				plan->Convert(reinterpret_cast<const uint8_t*>(converted.data()), reinterpret_cast<uint8_t*>(mesh.vertices.data + chunk.newVertexBase), chunk.newVertexCount, false, false);
+		});
+
+		pool.ParallelFor(chunkCount, [&](uint32_t c)
+		{
+			BmObjChunk& chunk = chunks[c];
+			for (uint32_t v = 0; v < chunk.vertices.size(); v++)
+			{
+				uint32_t global = chunk.vertexBase + v;
+				if ((ids[global] & 0x80000000u) == 0)
+					ids[global] = ids[ids[global]];
+			}
+		});
+
+		pool.ParallelFor(chunkCount, [&](uint32_t c)
+		{
+			BmObjChunk& chunk = chunks[c];
+			I* indices = mesh.indices.data + chunk.indexBase;
+			for (size_t i = 0; i < chunk.indices.size(); i++)
+				indices[i] = static_cast<I>(ids[chunk.vertexBase + chunk.indices[i]] & 0x7FFFFFFFu);
+		});
+
+		// submeshes, one per run of faces between usemtl statements
+		std::unordered_map<std::string, uint16_t> materialIDs;
+		std::vector<std::string> names;
+		uint32_t groupStart = 0;
+		uint16_t groupMaterial = BmObjNoMaterial;
+
+		auto closeGroup = [&](uint32_t groupEnd)
+		{
+			if (groupEnd > groupStart)
+				mesh.subMeshList.add(BmSubMesh{ groupStart, groupEnd - groupStart, groupMaterial });
+			groupStart = groupEnd;
+		};
+
+		for (const BmObjChunk& chunk : chunks)
+		{
+			for (const BmObjGroup& group : chunk.groups)
+			{
+				closeGroup(chunk.indexBase + group.cornerOffset);
+
+				auto found = materialIDs.find(group.material);
+				if (found == materialIDs.end())
+				{
+					if (names.size() >= BmObjNoMaterial)
+					{
+						BmSetLastError("OBJ file uses too many materials");
+						delete model;
+						return nullptr;
+					}
+
+					found = materialIDs.emplace(group.material, static_cast<uint16_t>(names.size())).first;
+					names.push_back(group.material);
+				}
+				groupMaterial = found->second;
+			}
+		}
+		closeGroup(static_cast<uint32_t>(indexCount));
+
+		if (materialNames != nullptr)
+			materialNames->swap(names);
+
+		BM_LOG("Loaded OBJ with %u vertices, %u indices, %u submeshes\n", mesh.vertices.count, mesh.indices.count, mesh.subMeshList.count);
+
+		return model;
+	}
+
+	// loads an OBJ file, mapping it rather than reading it so the text is paged in as it is parsed
+	template<typename V = BmVert, typename I = uint32_t>
+	BM_FUNC_DECL BmModel<V, I>* LoadObj(std::string name, const BmVertLayout* vertLayout = &BmDefaultLayout, std::vector<std::string>* materialNames = nullptr)
+	{
+		BmFileMapping mapping;
+		if (!FileMap(name.c_str(), mapping))
+		{
+			BmSetLastError("Unable to map file");
+			return nullptr;
+		}
+
+		BmModel<V, I>* model = LoadObj<V, I>(reinterpret_cast<const char*>(mapping.data), mapping.size, vertLayout, materialNames);
+		FileUnmap(mapping);
+		return model;
+	}
+}
+
+// =================================
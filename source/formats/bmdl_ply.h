@@ -0,0 +1,791 @@
+#pragma once
+
+#include "bmdl.h"
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <vector>
+
+// =================================
+// Basic Model : PLY Import
+// Loads binary PLY files (either endianness) in to a BmModel.
+//
+// The file is read through a fixed size buffer, so only the converted mesh is held in memory. Vertex
+// records are read BmPlyChunkSize bytes at a time, byte swapped in place when the file is big endian and
+// converted to V with a conversion plan built from the vertex properties: x y z, nx ny nz, u v (or s t)
+// and red green blue alpha, any other property is skipped. Faces are then read the same way and
+// triangulated as fans.
+//
+// A mesh holds at most as many vertices as I can index and BmPlyMaxMeshIndices indices. Models larger
+// than that are split in to several meshes in face order, each with its own copy of the vertices
+// it uses. Every mesh gets a single BmSubMesh.
+// =================================
+
+namespace bmdl
+{
+	static const uint32_t BmPlyChunkSize = 1024 * 1024;
+	static const uint32_t BmPlyMaxHeaderSize = 1024 * 1024;
+	static const uint32_t BmPlyMaxMeshIndices = 3u << 29;
+	static const uint32_t BmPlyMaxListBytes = 64 * 1024 * 1024;
+
+	enum class BmPlyType : uint8_t
+	{
+		Invalid	= 0,
+		Int8	= 1,
+		Uint8	= 2,
+		Int16	= 3,
+		Uint16	= 4,
+		Int32	= 5,
+		Uint32	= 6,
+		Float	= 7,
+		Double	= 8
+	};
+
+	struct BmPlyProperty
+	{
+		std::string	name;
+		BmPlyType	type;		// value type, or the item type of a list
+		BmPlyType	countType;	// type of a list's item count, Invalid for single values
+		uint32_t	offset;		// offset in the record, only meaningful while the element has a fixed size
+	};
+
+	struct BmPlyElement
+	{
+		std::string					name;
+		uint64_t					count;
+		std::vector<BmPlyProperty>	properties;
+		uint32_t					recordSize;	// bytes per record, 0 when the element has list properties
+	};
+
+	static BmPlyType GetPlyType(const std::string& name)
+	{
+		if (name == "char" || name == "int8")		return BmPlyType::Int8;
+		if (name == "uchar" || name == "uint8")		return BmPlyType::Uint8;
+		if (name == "short" || name == "int16")		return BmPlyType::Int16;
+		if (name == "ushort" || name == "uint16")	return BmPlyType::Uint16;
+		if (name == "int" || name == "int32")		return BmPlyType::Int32;
+		if (name == "uint" || name == "uint32")		return BmPlyType::Uint32;
+		if (name == "float" || name == "float32")	return BmPlyType::Float;
+		if (name == "double" || name == "float64")	return BmPlyType::Double;
+		return BmPlyType::Invalid;
+	}
+
+	static inline uint32_t GetPlyTypeSize(BmPlyType type)
+	{
+		static const uint32_t sizes[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+		return sizes[static_cast<uint8_t>(type)];
+	}
+
+	static inline BmBaseType GetPlyBaseType(BmPlyType type)
+	{
+		static const BmBaseType types[] = { BmBaseType::None, BmBaseType::Int8, BmBaseType::Uint8, BmBaseType::Int16, BmBaseType::UInt16,
+			BmBaseType::Int32, BmBaseType::UInt32, BmBaseType::Float, BmBaseType::Double };
+		return types[static_cast<uint8_t>(type)];
+	}
+
+	// =================================
+	// Byte Swapping
+	// =================================
+
+	static inline uint16_t PlyByteSwap16(uint16_t v) { return static_cast<uint16_t>((v >> 8) | (v << 8)); }
+
+	static inline uint32_t PlyByteSwap32(uint32_t v)
+	{
+	#if defined(_MSC_VER)
+		return _byteswap_ulong(v);
+	#else
+		return __builtin_bswap32(v);
+	#endif
+	}
+
+	// integer value of a count or index, read with the file's byte order
+	static inline int64_t ReadPlyInt(const uint8_t* src, BmPlyType type, bool swap)
+	{
+		switch (type)
+		{
+			case BmPlyType::Int8:	return static_cast<int8_t>(*src);
+			case BmPlyType::Uint8:	return *src;
+			case BmPlyType::Int16:	{ uint16_t v; memcpy(&v, src, 2); return static_cast<int16_t>(swap ? PlyByteSwap16(v) : v); }
+			case BmPlyType::Uint16:	{ uint16_t v; memcpy(&v, src, 2); return swap ? PlyByteSwap16(v) : v; }
+			case BmPlyType::Int32:	{ uint32_t v; memcpy(&v, src, 4); return static_cast<int32_t>(swap ? PlyByteSwap32(v) : v); }
+			case BmPlyType::Uint32:	{ uint32_t v; memcpy(&v, src, 4); return swap ? PlyByteSwap32(v) : v; }
+			default:				return -1;
+		}
+	}
+
+	// reverses the bytes of every value in fixed size records. records are swapped as a few 16 byte windows, each
+	// holding whole values and swapped with one shuffle, so records mixing value sizes take the SIMD path too
+	class BmPlyRecordSwap
+	{
+	public:
+
+		explicit BmPlyRecordSwap(const BmPlyElement& element) : recordSize(element.recordSize)
+		{
+			for (size_t p = 0; p < element.properties.size(); )
+			{
+				Window window;
+				window.offset = element.properties[p].offset;
+				window.firstValue = static_cast<uint32_t>(values.size());
+				for (uint32_t i = 0; i < 16; i++)
+					window.shuffle[i] = static_cast<uint8_t>(i);
+
+				bool needsSwap = false;
+				for (; p < element.properties.size(); p++)
+				{
+					const BmPlyProperty& property = element.properties[p];
+					uint32_t size = GetPlyTypeSize(property.type);
+					uint32_t local = property.offset - window.offset;
+					if (local + size > 16)
+						break;
+
+					for (uint32_t i = 0; i < size; i++)
+						window.shuffle[local + i] = static_cast<uint8_t>(local + size - 1 - i);
+
+					needsSwap |= size > 1;
+					values.push_back(Value{ property.offset, size });
+				}
+
+				window.valueCount = static_cast<uint32_t>(values.size()) - window.firstValue;
+				if (needsSwap)
+					windows.push_back(window);
+			}
+		}
+
+		// swaps count records at data, which must be followed by at least 16 bytes of readable memory
+		// or the last record's windows are swapped one value at a time
+		void Swap(uint8_t* data, size_t count, size_t available) const
+		{
+			for (size_t r = 0; r < count; r++)
+			{
+				uint8_t* record = data + r * recordSize;
+				for (const Window& window : windows)
+				{
+				#if defined(BM_SIMD_SSSE3)
+					if (static_cast<size_t>(record + window.offset - data) + 16 <= available)
+					{
+						__m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(window.shuffle));
+						__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(record + window.offset));
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(record + window.offset), _mm_shuffle_epi8(bytes, shuffle));
+						continue;
+					}
+				#else
+					(void)available;
+				#endif
+					for (uint32_t v = window.firstValue; v < window.firstValue + window.valueCount; v++)
+					{
+						uint8_t* value = record + values[v].offset;
+						for (uint32_t i = 0; i < values[v].size / 2; i++)
+							std::swap(value[i], value[values[v].size - 1 - i]);
+					}
+				}
+			}
+		}
+
+	private:
+
+		struct Window
+		{
+			uint32_t	offset;
+			uint32_t	firstValue;
+			uint32_t	valueCount;
+			uint8_t		shuffle[16];
+		};
+
+		struct Value
+		{
+			uint32_t	offset;
+			uint32_t	size;
+		};
+
+		uint32_t			recordSize;
+		std::vector<Window>	windows;
+		std::vector<Value>	values;
+	};
+
+	// =================================
+	// Reading
+	// =================================
+
+	// buffered reader over the file, keeps the bytes not consumed yet at the front of the buffer
+	class BmPlyStream
+	{
+	public:
+
+		explicit BmPlyStream(FILE* file) : file(file), begin(0), end(0), buffer(BmPlyChunkSize) {}
+
+		// makes at least minBytes available unless the file ends first, returns the bytes available
+		size_t Fill(size_t minBytes)
+		{
+			if (end - begin >= minBytes)
+				return end - begin;
+
+			memmove(buffer.data(), buffer.data() + begin, end - begin);
+			end -= begin;
+			begin = 0;
+
+			if (minBytes > buffer.size())
+				buffer.resize(minBytes);
+
+			end += fread(buffer.data() + end, 1, buffer.size() - end, file);
+			return end - begin;
+		}
+
+		uint8_t* Data() { return buffer.data() + begin; }
+		size_t Available() const { return end - begin; }
+		void Consume(size_t bytes) { begin += bytes; }
+
+	private:
+
+		FILE*				file;
+		size_t				begin;
+		size_t				end;
+		std::vector<uint8_t> buffer;
+	};
+
+	static bool ReadPlyHeader(BmPlyStream& stream, std::vector<BmPlyElement>& elements, bool& bigEndian)
+	{
+		// find the end of the header, the data starts after its line break
+		std::string header;
+		for (size_t want = 4096; ; want *= 2)
+		{
+			size_t available = stream.Fill(want);
+			header.assign(reinterpret_cast<const char*>(stream.Data()), available);
+
+			size_t marker = header.find("end_header");
+			size_t lineEnd = marker != std::string::npos ? header.find('\n', marker) : std::string::npos;
+			if (lineEnd != std::string::npos)
+			{
+				header.resize(lineEnd + 1);
+				stream.Consume(lineEnd + 1);
+				break;
+			}
+
+			if (available < want || want >= BmPlyMaxHeaderSize)
+			{
+				BmSetLastError("PLY header has no end_header line");
+				return false;
+			}
+		}
+
+		if (header.compare(0, 3, "ply") != 0)
+		{
+			BmSetLastError("File is not a PLY file");
+			return false;
+		}
+
+		bool hasFormat = false;
+		size_t lineStart = 0;
+		while (lineStart < header.size())
+		{
+			size_t lineEnd = header.find('\n', lineStart);
+			std::string line = header.substr(lineStart, lineEnd - lineStart);
+			lineStart = lineEnd + 1;
+
+			std::vector<std::string> words;
+			for (size_t w = 0; w < line.size(); )
+			{
+				while (w < line.size() && isspace(static_cast<unsigned char>(line[w])))
+					w++;
+				size_t wordEnd = w;
+				while (wordEnd < line.size() && !isspace(static_cast<unsigned char>(line[wordEnd])))
+					wordEnd++;
+				if (wordEnd > w)
+					words.push_back(line.substr(w, wordEnd - w));
+				w = wordEnd;
+			}
+
+			if (words.empty())
+				continue;
+
+			if (words[0] == "format" && words.size() >= 2)
+			{
+				if (words[1] != "binary_little_endian" && words[1] != "binary_big_endian")
+				{
+					BmSetLastError("Only binary PLY files are supported");
+					return false;
+				}
+				bigEndian = words[1] == "binary_big_endian";
+				hasFormat = true;
+			}
+			else if (words[0] == "element" && words.size() == 3)
+			{
+				BmPlyElement element;
+				element.name = words[1];
+				element.count = strtoull(words[2].c_str(), nullptr, 10);
+				element.recordSize = 0;
+				elements.push_back(element);
+			}
+			else if (words[0] == "property" && !elements.empty())
+			{
+				BmPlyProperty property;
+				bool list = words.size() == 5 && words[1] == "list";
+				property.countType = list ? GetPlyType(words[2]) : BmPlyType::Invalid;
+				property.type = GetPlyType(words[list ? 3 : 1]);
+				property.name = words.back();
+				property.offset = 0;
+
+				if (property.type == BmPlyType::Invalid || (list && property.countType == BmPlyType::Invalid) || (!list && words.size() != 3) ||
+					property.countType == BmPlyType::Float || property.countType == BmPlyType::Double)
+				{
+					BmSetLastError("PLY header has an invalid property");
+					return false;
+				}
+
+				elements.back().properties.push_back(property);
+			}
+		}
+
+		if (!hasFormat)
+		{
+			BmSetLastError("PLY header has no format line");
+			return false;
+		}
+
+		// lay out fixed size records
+		for (BmPlyElement& element : elements)
+		{
+			uint32_t offset = 0;
+			bool fixedSize = true;
+			for (BmPlyProperty& property : element.properties)
+			{
+				property.offset = offset;
+				offset += GetPlyTypeSize(property.type);
+				fixedSize &= property.countType == BmPlyType::Invalid;
+			}
+			element.recordSize = fixedSize ? offset : 0;
+		}
+
+		return true;
+	}
+
+	// reads one record of an element with list properties, calling onList for the values of the property at index
+	// listProperty. returns the record's size, 0 if the stream doesn't hold all of it and SIZE_MAX if it is invalid.
+	// onList only runs once the whole record is available, so a record retried after a refill isn't reported twice
+	template<typename F>
+	static size_t ReadPlyListRecord(const uint8_t* data, size_t available, const BmPlyElement& element, bool swap, size_t listProperty, F&& onList)
+	{
+		size_t pos = 0;
+		size_t listOffset = SIZE_MAX;
+		uint32_t listCount = 0;
+		for (size_t p = 0; p < element.properties.size(); p++)
+		{
+			const BmPlyProperty& property = element.properties[p];
+			uint32_t size = GetPlyTypeSize(property.type);
+			if (property.countType == BmPlyType::Invalid)
+			{
+				pos += size;
+				continue;
+			}
+
+			uint32_t countSize = GetPlyTypeSize(property.countType);
+			if (pos + countSize > available)
+				return 0;
+
+			int64_t count = ReadPlyInt(data + pos, property.countType, swap);
+			if (count < 0 || static_cast<uint64_t>(count) * size > BmPlyMaxListBytes)
+			{
+				BmSetLastError("PLY list has an invalid length");
+				return SIZE_MAX;
+			}
+
+			pos += countSize;
+			if (pos + static_cast<size_t>(count) * size > available)
+				return 0;
+
+			if (p == listProperty)
+			{
+				listOffset = pos;
+				listCount = static_cast<uint32_t>(count);
+			}
+			pos += static_cast<size_t>(count) * size;
+		}
+
+		if (pos > available)
+			return 0;
+
+		if (listOffset != SIZE_MAX && !onList(data + listOffset, element.properties[listProperty].type, listCount))
+			return SIZE_MAX;
+
+		return pos;
+	}
+
+	// streams the records of an element with list properties, see ReadPlyListRecord
+	template<typename F>
+	static bool StreamPlyListElement(BmPlyStream& stream, const BmPlyElement& element, bool swap, size_t listProperty, F&& onList)
+	{
+		for (uint64_t r = 0; r < element.count; )
+		{
+			size_t available = stream.Fill(BmPlyChunkSize);
+			const uint8_t* data = stream.Data();
+
+			size_t used = 0;
+			for (; r < element.count; r++)
+			{
+				size_t size = ReadPlyListRecord(data + used, available - used, element, swap, listProperty, onList);
+				if (size == SIZE_MAX)
+					return false;
+				if (size == 0)
+					break;
+				used += size;
+			}
+
+			stream.Consume(used);
+
+			// a record larger than everything buffered, read until it fits
+			if (used == 0 && r < element.count)
+			{
+				if (stream.Fill(available * 2) == available)
+				{
+					BmSetLastError("PLY file is truncated");
+					return false;
+				}
+			}
+		}
+
+		return true;
+	}
+
+	static bool SkipPlyElement(BmPlyStream& stream, const BmPlyElement& element, bool swap)
+	{
+		if (element.recordSize == 0)
+			return StreamPlyListElement(stream, element, swap, SIZE_MAX, [](const uint8_t*, BmPlyType, uint32_t) { return true; });
+
+		for (uint64_t remaining = element.count * element.recordSize; remaining > 0; )
+		{
+			size_t available = stream.Fill(1);
+			if (available == 0)
+			{
+				BmSetLastError("PLY file is truncated");
+				return false;
+			}
+
+			size_t skip = static_cast<size_t>(remaining < available ? remaining : available);
+			stream.Consume(skip);
+			remaining -= skip;
+		}
+
+		return true;
+	}
+
+	// vertex property name to the attribute and component it fills
+	static bool GetPlyVertexComponent(const std::string& name, BmAttrMap colorMap, BmAttrMap& attrMap, uint32_t& component)
+	{
+		static const char* const positions[] = { "x", "y", "z" };
+		static const char* const normals[] = { "nx", "ny", "nz" };
+		static const char* const texCoords[][2] = { { "u", "v" }, { "s", "t" }, { "texture_u", "texture_v" }, { "texture_s", "texture_t" } };
+		static const char* const colors[] = { "red", "green", "blue", "alpha" };
+
+		for (component = 0; component < 3; component++)
+		{
+			if (name == positions[component])	{ attrMap = BmAttrMap::Position; return true; }
+			if (name == normals[component])		{ attrMap = BmAttrMap::Normal; return true; }
+		}
+
+		for (const auto& names : texCoords)
+		{
+			for (component = 0; component < 2; component++)
+			{
+				if (name == names[component])	{ attrMap = BmAttrMap::TexCoord1; return true; }
+			}
+		}
+
+		for (component = 0; component < 4; component++)
+		{
+			if (name == colors[component])		{ attrMap = colorMap; return true; }
+		}
+
+		return false;
+	}
+
+	// describes a vertex record as vertex attributes, runs of properties filling consecutive components of one
+	// attribute with the same type become that attribute and everything else is skipped as unmapped bytes
+	static bool GetPlyVertexAttributes(const BmPlyElement& element, const BmVertLayout* vertLayout, std::vector<BmVertAttr>& attributes)
+	{
+		// colors read as Color32 when the layout stores them that way
+		BmAttrMap colorMap = BmAttrMap::Color_1;
+		for (uint32_t a = 0; a < vertLayout->attributeCount; a++)
+		{
+			if (vertLayout->attributes[a].attrMap == BmAttrMap::Color32_1)
+				colorMap = BmAttrMap::Color32_1;
+		}
+
+		bool hasPosition = false;
+		for (size_t p = 0; p < element.properties.size(); p++)
+		{
+			const BmPlyProperty& property = element.properties[p];
+			BmAttrMap attrMap;
+			uint32_t component;
+
+			bool mapped = GetPlyVertexComponent(property.name, colorMap, attrMap, component);
+			if (mapped && component > 0)
+			{
+				mapped = !attributes.empty() && attributes.back().attrMap == attrMap && attributes.back().components == component &&
+					attributes.back().baseType == GetPlyBaseType(property.type);
+				if (mapped)
+				{
+					attributes.back().components++;
+					hasPosition |= attrMap == BmAttrMap::Position && component == 2;
+					continue;
+				}
+			}
+
+			if (mapped)
+				attributes.push_back(BmVertAttr(GetPlyBaseType(property.type), 1, attrMap));
+			else if (!attributes.empty() && attributes.back().attrMap == BmAttrMap::None && attributes.back().components + 8 <= 255)
+				attributes.back().components += static_cast<uint8_t>(GetPlyTypeSize(property.type));
+			else
+				attributes.push_back(BmVertAttr(BmBaseType::Uint8, static_cast<uint8_t>(GetPlyTypeSize(property.type)), BmAttrMap::None));
+
+			if (attributes.size() > MAX_VERTEX_ATTRIBS)
+			{
+				BmSetLastError("PLY vertices have too many properties");
+				return false;
+			}
+		}
+
+		if (!hasPosition)
+		{
+			BmSetLastError("PLY vertices have no x y z position");
+			return false;
+		}
+
+		return true;
+	}
+
+	// =================================
+	// Loading
+	// =================================
+
+	// loads a binary PLY file, vertices are converted to vertLayout which must describe V.
+	// the file is streamed, meshes too large for I are split (see BmPlyMaxMeshIndices)
+	template<typename V = BmVert, typename I = uint32_t>
+	BM_FUNC_DECL BmModel<V, I>* LoadPly(std::string name, const BmVertLayout* vertLayout = &BmDefaultLayout)
+	{
+		FILE* file = fopen(name.c_str(), "rb");
+		if (file == nullptr)
+		{
+			BmSetLastError("Unable to read file");
+			return nullptr;
+		}
+
+		BmPlyStream stream(file);
+		std::vector<BmPlyElement> elements;
+		bool swap = false;
+		if (!ReadPlyHeader(stream, elements, swap))
+		{
+			fclose(file);
+			return nullptr;
+		}
+
+		BmModel<V, I>* model = new BmModel<V, I>();
+		BmList<V> splitVertices;
+		const V* vertices = nullptr;
+		uint64_t vertexCount = 0;
+		bool hasVertices = false;
+		bool succeeded = true;
+
+		const uint64_t maxVertices = sizeof(I) >= 4 ? 0x100000000ull : (1ull << (sizeof(I) * 8));
+
+		for (const BmPlyElement& element : elements)
+		{
+			if (!succeeded)
+				break;
+
+			if (element.name == "vertex" && !hasVertices)
+			{
+				std::vector<BmVertAttr> attributes;
+				if (element.recordSize == 0 || element.count > UINT32_MAX || !GetPlyVertexAttributes(element, vertLayout, attributes))
+				{
+					if (element.recordSize == 0 || element.count > UINT32_MAX)
+						BmSetLastError("PLY vertices must have a fixed size and fit in 32 bits");
+					succeeded = false;
+					break;
+				}
+
+				const BmVertConversionPlan* plan = GetConversionPlan(attributes.data(), static_cast<uint32_t>(attributes.size()), vertLayout->attributes, vertLayout->attributeCount, sizeof(V));
+				if (plan == nullptr)
+				{
+					succeeded = false;
+					break;
+				}
+
+				// vertices that fit one mesh are converted straight in to it, larger models are split from a shared copy
+				vertexCount = element.count;
+				if (vertexCount <= maxVertices)
+					model->meshList.resize(1);
+
+				BmList<V>& target = vertexCount <= maxVertices ? model->meshList[0].vertices : splitVertices;
+				hasVertices = true;
+
+				BmPlyRecordSwap swapper(element);
+				uint32_t chunkRecords = BmPlyChunkSize / element.recordSize + 1;
+				for (uint64_t v = 0; v < vertexCount; )
+				{
+					uint32_t records = static_cast<uint32_t>(vertexCount - v < chunkRecords ? vertexCount - v : chunkRecords);
+					size_t bytes = static_cast<size_t>(records) * element.recordSize;
+					size_t available = stream.Fill(bytes);
+					if (available < bytes)
+					{
+						BmSetLastError("PLY file is truncated");
+						succeeded = false;
+						break;
+					}
+
+					if (swap)
+						swapper.Swap(stream.Data(), records, available);
+
+					// grown as records arrive, so a count from a corrupt header can't allocate more than the file holds
+					if (v + records > target.capacity)
+					{
+						uint64_t capacity = static_cast<uint64_t>(target.capacity) * 2;
+						capacity = capacity < v + records ? v + records : (capacity > vertexCount ? vertexCount : capacity);
+						target.reserve(static_cast<uint32_t>(capacity));
+					}
+
+					plan->Convert(stream.Data(), reinterpret_cast<uint8_t*>(target.data + v), records, false, false);
+					stream.Consume(bytes);
+					v += records;
+					target.count = static_cast<uint32_t>(v);
+				}
+
+				vertices = target.data;
+			}
+			else if (element.name == "face")
+			{
+				if (!hasVertices)
+				{
+					BmSetLastError("PLY faces before the vertices are not supported");
+					succeeded = false;
+					break;
+				}
+
+				if (model->meshList.count == 0)
+					model->meshList.resize(1);
+
+				// corners of the current split mesh are renumbered, owner marks the vertices it already copied
+				std::vector<uint32_t> owner, local;
+				bool splitting = splitVertices.count > 0;
+				if (splitting)
+				{
+					owner.assign(static_cast<size_t>(vertexCount), 0);
+					local.resize(static_cast<size_t>(vertexCount));
+				}
+
+				// at most a chunk of indices up front, the face count isn't trusted before the records are read
+				BmMesh<V, I>* mesh = &model->meshList.last();
+				mesh->indices.reserve(static_cast<uint32_t>(element.count * 3 < BmPlyChunkSize ? element.count * 3 : BmPlyChunkSize));
+
+				auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c)
+				{
+					uint32_t corners[3] = { a, b, c };
+					uint32_t mark = model->meshList.count;
+
+					// start another mesh when this triangle doesn't fit the current one
+					uint32_t newVertices = 0;
+					if (splitting)
+						newVertices = (owner[a] != mark) + (owner[b] != mark && b != a) + (owner[c] != mark && c != a && c != b);
+
+					if (mesh->indices.count + 3 > BmPlyMaxMeshIndices || static_cast<uint64_t>(mesh->vertices.count) + newVertices > maxVertices)
+					{
+						if (!splitting)
+						{
+							owner.assign(static_cast<size_t>(vertexCount), 0);
+							local.resize(static_cast<size_t>(vertexCount));
+							splitting = true;
+						}
+
+						model->meshList.resize(model->meshList.count + 1);
+						mesh = &model->meshList.last();
+						mark = model->meshList.count;
+					}
+
+					for (uint32_t corner : corners)
+					{
+						if (splitting)
+						{
+							if (owner[corner] != mark)
+							{
+								owner[corner] = mark;
+								local[corner] = mesh->vertices.count;
+								mesh->vertices.add(vertices[corner]);
+							}
+							corner = local[corner];
+						}
+						mesh->indices.add(static_cast<I>(corner));
+					}
+				};
+
+				std::vector<uint32_t> face;
+				auto onFace = [&](const uint8_t* data, BmPlyType type, uint32_t count)
+				{
+					uint32_t size = GetPlyTypeSize(type);
+					face.resize(count);
+					for (uint32_t i = 0; i < count; i++)
+					{
+						int64_t index = ReadPlyInt(data + i * size, type, swap);
+						if (index < 0 || static_cast<uint64_t>(index) >= vertexCount)
+						{
+							BmSetLastError("PLY face references a missing vertex");
+							return false;
+						}
+						face[i] = static_cast<uint32_t>(index);
+					}
+
+					for (uint32_t i = 2; i < count; i++)
+						addTriangle(face[0], face[i - 1], face[i]);
+					return true;
+				};
+
+				size_t listProperty = SIZE_MAX;
+				for (size_t p = 0; p < element.properties.size(); p++)
+				{
+					const BmPlyProperty& property = element.properties[p];
+					if (property.countType != BmPlyType::Invalid && (property.name == "vertex_indices" || property.name == "vertex_index"))
+						listProperty = p;
+				}
+
+				succeeded = StreamPlyListElement(stream, element, swap, listProperty, onFace);
+				break;
+			}
+			else
+			{
+				succeeded = SkipPlyElement(stream, element, swap);
+			}
+		}
+
+		fclose(file);
+
+		if (!succeeded || !hasVertices)
+		{
+			if (succeeded)
+				BmSetLastError("PLY file has no vertex element");
+			delete model;
+			return nullptr;
+		}
+
+		// point clouds too large for one mesh are split in to meshes of consecutive vertices
+		if (model->meshList.count == 0)
+		{
+			for (uint32_t first = 0; first < splitVertices.count; )
+			{
+				uint32_t count = static_cast<uint32_t>(splitVertices.count - first < maxVertices ? splitVertices.count - first : maxVertices);
+				model->meshList.resize(model->meshList.count + 1);
+				model->meshList.last().vertices.setData(splitVertices.data + first, count);
+				first += count;
+			}
+		}
+
+		for (uint32_t m = 0; m < model->meshList.count; m++)
+		{
+			BmMesh<V, I>& mesh = model->meshList[m];
+			mesh.subMeshList.add(BmSubMesh{ 0, mesh.indices.count, 0 });
+		}
+
+		BM_LOG("Loaded PLY with %u meshes\n", model->meshList.count);
+
+		return model;
+	}
+}
+
+// =================================
@@ -0,0 +1,559 @@
+#pragma once
+
+#include "bmdl.h"
+#include "bmdl_obj.h"
+
+#include <math.h>
+
+#include <vector>
+
+// =================================
+// Basic Model : STL Import
+// Loads binary and ASCII STL files in to a BmModel with a single indexed mesh.
+//
+// STL stores three unshared positions per triangle, they are welded on the worker pool: corners are
+// partitioned by the hash of their position with a parallel counting sort and each partition is then
+// welded on its own, keeping the first corner of every position. With a weld epsilon the welded
+// positions are also merged with the earliest position within epsilon, found through a grid of
+// cells twice epsilon wide. Vertices keep the order they are first used in.
+//
+// Normals are recomputed as the area weighted average of the faces using each vertex, the facet
+// normals stored in the file are ignored. ASCII numbers are read with the OBJ float parser.
+// =================================
+
+namespace bmdl
+{
+	static const uint32_t BmStlMinChunkSize = 256 * 1024;
+	static const uint32_t BmStlMaxChunkSize = 16 * 1024 * 1024;
+	static const uint32_t BmStlBlockSize = 64 * 1024;
+	static const uint32_t BmStlPartitionBits = 8;
+
+	struct BmStlOptions
+	{
+		BmStlOptions() : weldEpsilon(0.0f) {}
+
+		float weldEpsilon;	// positions closer than this are merged, 0 only welds identical positions
+	};
+
+	// =================================
+	// Parsing
+	// =================================
+
+	// binary files are recognised by their size matching the triangle count, files starting with
+	// "solid" are otherwise ASCII. some exporters write "solid" at the start of binary headers too
+	static inline bool IsStlBinary(const uint8_t* data, size_t dataSize)
+	{
+		if (dataSize >= 84)
+		{
+			uint32_t triangleCount;
+			memcpy(&triangleCount, data + 80, sizeof(triangleCount));
+			if (84 + static_cast<uint64_t>(triangleCount) * 50 == dataSize)
+				return true;
+		}
+
+		return !(dataSize >= 5 && memcmp(data, "solid", 5) == 0);
+	}
+
+	// false if the data holds control characters, which ASCII files don't but binary triangle data mostly does
+	static inline bool IsStlText(const uint8_t* data, size_t dataSize)
+	{
+		for (size_t i = 0; i < dataSize; i++)
+		{
+			uint8_t c = data[i];
+			if ((c < 0x20 && !IsObjSpace(static_cast<char>(c)) && !IsObjLineEnd(static_cast<char>(c))) || c == 0x7f)
+				return false;
+		}
+
+		return true;
+	}
+
+	struct BmStlChunk
+	{
+		const char*			begin;
+		const char*			end;
+		std::vector<float>	positions;
+	};
+
+	// collects the positions of the vertex lines in a chunk of an ASCII file
+	static void ParseStlChunk(BmStlChunk& chunk)
+	{
+		const char* s = chunk.begin;
+		const char* end = chunk.end;
+
+		while (s < end)
+		{
+			while (s < end && (IsObjSpace(*s) || IsObjLineEnd(*s)))
+				s++;
+
+			if (end - s > 6 && memcmp(s, "vertex", 6) == 0 && IsObjSpace(s[6]))
+			{
+				float position[3] = { 0.0f, 0.0f, 0.0f };
+				s += 6;
+				for (uint32_t i = 0; i < 3; i++)
+					s = ParseObjFloat(s, end, position[i]);
+				chunk.positions.insert(chunk.positions.end(), position, position + 3);
+			}
+
+			s = SkipObjLine(s, end);
+		}
+	}
+
+	// reads the corner positions of every triangle, 9 floats per triangle
+	static bool ReadStlPositions(const uint8_t* data, size_t dataSize, std::vector<float>& positions)
+	{
+		BmWorkerPool& pool = GetWorkerPool();
+
+		if (IsStlBinary(data, dataSize))
+		{
+			uint32_t triangleCount = 0;
+			if (dataSize >= 84)
+				memcpy(&triangleCount, data + 80, sizeof(triangleCount));
+
+			if (dataSize < 84 || (dataSize - 84) / 50 < triangleCount)
+			{
+				BmSetLastError("STL file is truncated");
+				return false;
+			}
+
+			// each 50 byte record is a facet normal, three corners and an attribute word
+			positions.resize(static_cast<size_t>(triangleCount) * 9);
+			uint32_t blockCount = (triangleCount + BmStlBlockSize - 1) / BmStlBlockSize;
+			pool.ParallelFor(blockCount, [&](uint32_t b)
+			{
+				uint32_t first = b * BmStlBlockSize;
+				uint32_t last = triangleCount - first < BmStlBlockSize ? triangleCount : first + BmStlBlockSize;
+				for (uint32_t t = first; t < last; t++)
+					memcpy(&positions[static_cast<size_t>(t) * 9], data + 84 + static_cast<size_t>(t) * 50 + 12, sizeof(float) * 9);
+			});
+
+			return true;
+		}
+
+		size_t chunkSize = dataSize / ((pool.GetWorkerCount() + 1) * 4) + 1;
+		chunkSize = chunkSize < BmStlMinChunkSize ? BmStlMinChunkSize : (chunkSize > BmStlMaxChunkSize ? BmStlMaxChunkSize : chunkSize);
+
+		const char* text = reinterpret_cast<const char*>(data);
+		std::vector<BmStlChunk> chunks;
+		for (const char* begin = text, *end = text + dataSize; begin < end; )
+		{
+			const char* split = (static_cast<size_t>(end - begin) > chunkSize) ? begin + chunkSize : end;
+			while (split < end && split[-1] != '\n')
+				split++;
+
+			chunks.emplace_back();
+			chunks.back().begin = begin;
+			chunks.back().end = split;
+			begin = split;
+		}
+
+		pool.ParallelFor(static_cast<uint32_t>(chunks.size()), [&](uint32_t c) { ParseStlChunk(chunks[c]); });
+
+		size_t floatCount = 0;
+		for (const BmStlChunk& chunk : chunks)
+			floatCount += chunk.positions.size();
+
+		// a binary file cut short no longer matches its triangle count, if its header starts with "solid"
+		// it is parsed as ASCII and has no vertex lines
+		if (floatCount == 0 && !IsStlText(data, dataSize))
+		{
+			BmSetLastError("STL file is truncated");
+			return false;
+		}
+
+		if (floatCount % 9 != 0)
+		{
+			BmSetLastError("STL file has a facet without three vertices");
+			return false;
+		}
+
+		positions.reserve(floatCount);
+		for (const BmStlChunk& chunk : chunks)
+			positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+
+		return true;
+	}
+
+	// =================================
+	// Welding
+	// =================================
+
+	// bit pattern of a position with -0 folded in to 0, so equal positions compare equal bitwise
+	struct BmStlKey
+	{
+		uint32_t bits[3];
+	};
+
+	static inline BmStlKey GetStlKey(const float* position)
+	{
+		BmStlKey key;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			float value = position[i] == 0.0f ? 0.0f : position[i];
+			memcpy(&key.bits[i], &value, sizeof(value));
+		}
+		return key;
+	}
+
+	static inline uint32_t HashStlKey(const BmStlKey& key)
+	{
+		uint32_t hash = 2166136261u;
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			hash = (hash ^ key.bits[i]) * 16777619u;
+			hash ^= hash >> 15;
+		}
+		return hash * 2246822519u;
+	}
+
+	static inline uint32_t GetStlTableSize(size_t count)
+	{
+		uint32_t size = 16;
+		while (size < count * 2)
+			size *= 2;
+		return size;
+	}
+
+	// welds count positions, first[c] receives the first corner with the same position as corner c
+	static void WeldStlExact(const float* positions, uint32_t count, std::vector<uint32_t>& first)
+	{
+		BmWorkerPool& pool = GetWorkerPool();
+		const uint32_t partitionCount = 1u << BmStlPartitionBits;
+		uint32_t blockCount = (count + BmStlBlockSize - 1) / BmStlBlockSize;
+
+		// count the corners of each block in each partition, then place them partition by partition
+		std::vector<uint32_t> hashes(count);
+		std::vector<uint32_t> offsets(static_cast<size_t>(blockCount) * partitionCount, 0);
+		pool.ParallelFor(blockCount, [&](uint32_t b)
+		{
+			uint32_t* blockCounts = &offsets[static_cast<size_t>(b) * partitionCount];
+			uint32_t last = count - b * BmStlBlockSize < BmStlBlockSize ? count : (b + 1) * BmStlBlockSize;
+			for (uint32_t c = b * BmStlBlockSize; c < last; c++)
+			{
+				hashes[c] = HashStlKey(GetStlKey(positions + static_cast<size_t>(c) * 3));
+				blockCounts[hashes[c] >> (32 - BmStlPartitionBits)]++;
+			}
+		});
+
+		std::vector<uint32_t> partitionStart(partitionCount + 1, 0);
+		uint32_t total = 0;
+		for (uint32_t p = 0; p < partitionCount; p++)
+		{
+			partitionStart[p] = total;
+			for (uint32_t b = 0; b < blockCount; b++)
+			{
+				uint32_t n = offsets[static_cast<size_t>(b) * partitionCount + p];
+				offsets[static_cast<size_t>(b) * partitionCount + p] = total;
+				total += n;
+			}
+		}
+		partitionStart[partitionCount] = total;
+
+		std::vector<uint32_t> sorted(count);
+		pool.ParallelFor(blockCount, [&](uint32_t b)
+		{
+			uint32_t* blockOffsets = &offsets[static_cast<size_t>(b) * partitionCount];
+			uint32_t last = count - b * BmStlBlockSize < BmStlBlockSize ? count : (b + 1) * BmStlBlockSize;
+			for (uint32_t c = b * BmStlBlockSize; c < last; c++)
+				sorted[blockOffsets[hashes[c] >> (32 - BmStlPartitionBits)]++] = c;
+		});
+
+		// corners are in ascending order within a partition, so the first seen of a position is its first corner
+		first.resize(count);
+		pool.ParallelFor(partitionCount, [&](uint32_t p)
+		{
+			uint32_t begin = partitionStart[p];
+			uint32_t end = partitionStart[p + 1];
+			if (begin == end)
+				return;
+
+			// slots keep the hash next to the corner so mismatches resolve without touching the hash array
+			uint32_t tableSize = GetStlTableSize(end - begin);
+			std::vector<uint64_t> table(tableSize, UINT64_MAX);
+
+			for (uint32_t s = begin; s < end; s++)
+			{
+				uint32_t c = sorted[s];
+				uint32_t hash = hashes[c];
+				BmStlKey key = GetStlKey(positions + static_cast<size_t>(c) * 3);
+
+				for (uint32_t slot = hash & (tableSize - 1); ; slot = (slot + 1) & (tableSize - 1))
+				{
+					uint64_t entry = table[slot];
+					if (entry == UINT64_MAX)
+					{
+						table[slot] = (static_cast<uint64_t>(hash) << 32) | c;
+						first[c] = c;
+						break;
+					}
+
+					if (static_cast<uint32_t>(entry >> 32) == hash)
+					{
+						uint32_t other = static_cast<uint32_t>(entry);
+						BmStlKey otherKey = GetStlKey(positions + static_cast<size_t>(other) * 3);
+						if (memcmp(&key, &otherKey, sizeof(key)) == 0)
+						{
+							first[c] = other;
+							break;
+						}
+					}
+				}
+			}
+		});
+	}
+
+	// merges each of count positions with the earliest position within epsilon, merged[p] receives the
+	// position it ends up as. points are bucketed in cells twice epsilon wide, so only the cell of a point
+	// and its neighbours towards the nearest cell corner can hold a match, 8 cells in all. the searches
+	// run in parallel against the finished grid
+	static void WeldStlEpsilon(const float* positions, uint32_t count, float epsilon, std::vector<uint32_t>& merged)
+	{
+		// per axis the cell and the side (-1 or 1) of the neighbour that may be within epsilon
+		std::vector<int32_t> cells(static_cast<size_t>(count) * 3);
+		std::vector<int8_t> sides(static_cast<size_t>(count) * 3);
+		float cellScale = 0.5f / epsilon;
+		for (size_t i = 0; i < cells.size(); i++)
+		{
+			float scaled = positions[i] * cellScale;
+			float cell = floorf(scaled);
+			sides[i] = scaled - cell < 0.5f ? -1 : 1;
+			cells[i] = static_cast<int32_t>(cell < -2.0e9f ? -2.0e9f : (cell > 2.0e9f ? 2.0e9f : cell));
+		}
+
+		auto hashCell = [](const int32_t* cell) { return HashStlKey(BmStlKey{ { static_cast<uint32_t>(cell[0]), static_cast<uint32_t>(cell[1]), static_cast<uint32_t>(cell[2]) } }); };
+
+		// grid of cell heads, the points in a cell are chained through next
+		uint32_t tableSize = GetStlTableSize(count);
+		std::vector<uint32_t> heads(tableSize, UINT32_MAX);
+		std::vector<uint32_t> next(count);
+		for (uint32_t p = count; p-- > 0; )
+		{
+			uint32_t slot = hashCell(&cells[static_cast<size_t>(p) * 3]) & (tableSize - 1);
+			next[p] = heads[slot];
+			heads[slot] = p;
+		}
+
+		float epsilonSq = epsilon * epsilon;
+		std::vector<uint32_t> target(count);
+		GetWorkerPool().ParallelFor((count + BmStlBlockSize - 1) / BmStlBlockSize, [&](uint32_t b)
+		{
+			uint32_t last = count - b * BmStlBlockSize < BmStlBlockSize ? count : (b + 1) * BmStlBlockSize;
+			for (uint32_t p = b * BmStlBlockSize; p < last; p++)
+			{
+				const float* position = positions + static_cast<size_t>(p) * 3;
+				const int32_t* cell = &cells[static_cast<size_t>(p) * 3];
+				const int8_t* side = &sides[static_cast<size_t>(p) * 3];
+				uint32_t best = p;
+
+				for (int32_t n = 0; n < 8; n++)
+				{
+					int32_t neighbour[3] = { cell[0] + (n & 1) * side[0], cell[1] + ((n >> 1) & 1) * side[1], cell[2] + (n >> 2) * side[2] };
+
+					// chains are in ascending order, nothing after best can improve it
+					for (uint32_t q = heads[hashCell(neighbour) & (tableSize - 1)]; q < best; q = next[q])
+					{
+						const float* other = positions + static_cast<size_t>(q) * 3;
+						float dx = other[0] - position[0], dy = other[1] - position[1], dz = other[2] - position[2];
+						if (dx * dx + dy * dy + dz * dz <= epsilonSq)
+						{
+							best = q;
+							break;
+						}
+					}
+				}
+
+				target[p] = best;
+			}
+		});
+
+		// targets always come earlier, so following them in order resolves chains of merges
+		merged.resize(count);
+		for (uint32_t p = 0; p < count; p++)
+			merged[p] = target[p] == p ? p : merged[target[p]];
+	}
+
+	// =================================
+	// Loading
+	// =================================
+
+	// loads STL data in to a model with one indexed mesh. vertices are converted from positions and normals
+	// to vertLayout, which must describe V
+	template<typename V = BmVert, typename I = uint32_t>
+	BM_FUNC_DECL BmModel<V, I>* LoadStl(const uint8_t* data, size_t dataSize, const BmVertLayout* vertLayout = &BmDefaultLayout, const BmStlOptions& options = BmStlOptions())
+	{
+		BmWorkerPool& pool = GetWorkerPool();
+
+		static const BmVertAttr stlAttributes[] = { BmVertAttr(BmBaseType::Float, 3, BmAttrMap::Position), BmVertAttr(BmBaseType::Float, 3, BmAttrMap::Normal) };
+		const BmVertConversionPlan* plan = GetConversionPlan(stlAttributes, 2, vertLayout->attributes, vertLayout->attributeCount, sizeof(V));
+		if (plan == nullptr)
+			return nullptr;
+
+		std::vector<float> positions;
+		if (!ReadStlPositions(data, dataSize, positions))
+			return nullptr;
+
+		if (positions.size() / 3 > UINT32_MAX)
+		{
+			BmSetLastError("STL has too many triangles");
+			return nullptr;
+		}
+
+		uint32_t cornerCount = static_cast<uint32_t>(positions.size() / 3);
+		uint32_t blockCount = (cornerCount + BmStlBlockSize - 1) / BmStlBlockSize;
+
+		std::vector<uint32_t> first;
+		WeldStlExact(positions.data(), cornerCount, first);
+
+		// number the first corners in order, every corner then takes its first corner's number
+		std::vector<uint32_t> blockBase(blockCount + 1, 0);
+		pool.ParallelFor(blockCount, [&](uint32_t b)
+		{
+			uint32_t last = cornerCount - b * BmStlBlockSize < BmStlBlockSize ? cornerCount : (b + 1) * BmStlBlockSize;
+			for (uint32_t c = b * BmStlBlockSize; c < last; c++)
+				blockBase[b + 1] += first[c] == c ? 1 : 0;
+		});
+
+		for (uint32_t b = 0; b < blockCount; b++)
+			blockBase[b + 1] += blockBase[b];
+
+		uint32_t vertexCount = blockBase[blockCount];
+		std::vector<float> vertexPositions(static_cast<size_t>(vertexCount) * 3);
+		std::vector<uint32_t> corners(cornerCount);
+		pool.ParallelFor(blockCount, [&](uint32_t b)
+		{
+			uint32_t id = blockBase[b];
+			uint32_t last = cornerCount - b * BmStlBlockSize < BmStlBlockSize ? cornerCount : (b + 1) * BmStlBlockSize;
+			for (uint32_t c = b * BmStlBlockSize; c < last; c++)
+			{
+				if (first[c] != c)
+					continue;
+				memcpy(&vertexPositions[static_cast<size_t>(id) * 3], &positions[static_cast<size_t>(c) * 3], sizeof(float) * 3);
+				corners[c] = id++;
+			}
+		});
+
+		pool.ParallelFor(blockCount, [&](uint32_t b)
+		{
+			uint32_t last = cornerCount - b * BmStlBlockSize < BmStlBlockSize ? cornerCount : (b + 1) * BmStlBlockSize;
+			for (uint32_t c = b * BmStlBlockSize; c < last; c++)
+				corners[c] = corners[first[c]];
+		});
+
+		std::vector<uint32_t>().swap(first);
+		std::vector<float>().swap(positions);
+
+		// merge positions within epsilon, renumbering the survivors in order
+		if (options.weldEpsilon > 0.0f && vertexCount > 0)
+		{
+			std::vector<uint32_t> merged;
+			WeldStlEpsilon(vertexPositions.data(), vertexCount, options.weldEpsilon, merged);
+
+			uint32_t survivors = 0;
+			for (uint32_t v = 0; v < vertexCount; v++)
+			{
+				if (merged[v] != v)
+					merged[v] = merged[merged[v]];
+				else
+				{
+					memmove(&vertexPositions[static_cast<size_t>(survivors) * 3], &vertexPositions[static_cast<size_t>(v) * 3], sizeof(float) * 3);
+					merged[v] = survivors++;
+				}
+			}
+
+			pool.ParallelFor(blockCount, [&](uint32_t b)
+			{
+				uint32_t last = cornerCount - b * BmStlBlockSize < BmStlBlockSize ? cornerCount : (b + 1) * BmStlBlockSize;
+				for (uint32_t c = b * BmStlBlockSize; c < last; c++)
+					corners[c] = merged[corners[c]];
+			});
+
+			vertexCount = survivors;
+			vertexPositions.resize(static_cast<size_t>(vertexCount) * 3);
+		}
+
+		if (sizeof(I) < 4 && vertexCount > (1ull << (sizeof(I) * 8)))
+		{
+			BmSetLastError("STL vertices do not fit in the requested index type");
+			return nullptr;
+		}
+
+		// area weighted normals, the cross product's length is twice the triangle's area
+		std::vector<float> vertices(static_cast<size_t>(vertexCount) * 6, 0.0f);
+		for (uint32_t c = 0; c < cornerCount; c += 3)
+		{
+			const float* p0 = &vertexPositions[static_cast<size_t>(corners[c]) * 3];
+			const float* p1 = &vertexPositions[static_cast<size_t>(corners[c + 1]) * 3];
+			const float* p2 = &vertexPositions[static_cast<size_t>(corners[c + 2]) * 3];
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+
+			for (uint32_t i = 0; i < 3; i++)
+			{
+				float* n = &vertices[static_cast<size_t>(corners[c + i]) * 6 + 3];
+				n[0] += normal[0];
+				n[1] += normal[1];
+				n[2] += normal[2];
+			}
+		}
+
+		BmModel<V, I>* model = new BmModel<V, I>();
+		model->meshList.resize(1);
+		BmMesh<V, I>& mesh = model->meshList[0];
+		mesh.vertices.reserve(vertexCount);
+		mesh.vertices.count = vertexCount;
+		mesh.indices.reserve(cornerCount);
+		mesh.indices.count = cornerCount;
+
+		uint32_t vertexBlocks = (vertexCount + BmStlBlockSize - 1) / BmStlBlockSize;
+		pool.ParallelFor(vertexBlocks, [&](uint32_t b)
+		{
+			uint32_t begin = b * BmStlBlockSize;
+			uint32_t last = vertexCount - begin < BmStlBlockSize ? vertexCount : begin + BmStlBlockSize;
+			for (uint32_t v = begin; v < last; v++)
+			{
+				float* vertex = &vertices[static_cast<size_t>(v) * 6];
+				memcpy(vertex, &vertexPositions[static_cast<size_t>(v) * 3], sizeof(float) * 3);
+
+				float length = sqrtf(vertex[3] * vertex[3] + vertex[4] * vertex[4] + vertex[5] * vertex[5]);
+				float scale = length > 0.0f ? 1.0f / length : 0.0f;
+				vertex[3] *= scale;
+				vertex[4] *= scale;
+				vertex[5] *= scale;
+			}
+
+			plan->Convert(reinterpret_cast<const uint8_t*>(&vertices[static_cast<size_t>(begin) * 6]), reinterpret_cast<uint8_t*>(mesh.vertices.data + begin), last - begin, false, false);
+		});
+
+		pool.ParallelFor(blockCount, [&](uint32_t b)
+		{
+			uint32_t last = cornerCount - b * BmStlBlockSize < BmStlBlockSize ? cornerCount : (b + 1) * BmStlBlockSize;
+			for (uint32_t c = b * BmStlBlockSize; c < last; c++)
+				mesh.indices.data[c] = static_cast<I>(corners[c]);
+		});
+
+		mesh.subMeshList.add(BmSubMesh{ 0, cornerCount, 0 });
+
+		BM_LOG("Loaded STL with %u vertices, %u triangles\n", vertexCount, cornerCount / 3);
+
+		return model;
+	}
+
+	// loads an STL file, mapping it rather than reading it
+	template<typename V = BmVert, typename I = uint32_t>
+	BM_FUNC_DECL BmModel<V, I>* LoadStl(std::string name, const BmVertLayout* vertLayout = &BmDefaultLayout, const BmStlOptions& options = BmStlOptions())
+	{
+		BmFileMapping mapping;
+		if (!FileMap(name.c_str(), mapping))
+		{
+			BmSetLastError("Unable to map file");
+			return nullptr;
+		}
+
+		BmModel<V, I>* model = LoadStl<V, I>(mapping.data, mapping.size, vertLayout, options);
+		FileUnmap(mapping);
+		return model;
+	}
+}
+
+// =================================
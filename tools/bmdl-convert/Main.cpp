@@ -0,0 +1,461 @@
+#define BM_NO_LOGGING
+#include "bmdl.h"
+#include "bmdl_meshlet.h"
+#include "bmdl_optimize.h"
+#include "bmdl_simplify.h"
+#include "bmdl_writer.h"
+#include "formats/bmdl_glb.h"
+#include "formats/bmdl_obj.h"
+#include "formats/bmdl_ply.h"
+#include "formats/bmdl_stl.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+	#include <direct.h>
+#else
+	#include <dirent.h>
+#endif
+
+// Converts source meshes to .bmf, every input file is converted as its own task on the loader's worker pool.
+// usage : bmdl-convert [options] <file or directory>...
+//   -o <dir>              write outputs in to dir, keeping the layout of input directories (default : next to the input)
+//   -j <threads>          number of files converted at once (default : one per hardware thread)
+//   -m <megabytes>        rough limit on memory used by files in flight (default : 1024)
+//   -r                    search input directories recursively
+//   -q                    only report failures and the summary
+//   --compress-meshes     code vertices and indices (CompressedMeshData)
+//   --compress-blocks     compress blocks with the LZ block codec (CompressedBlock)
+//   --compact-indices     store indices with the smallest type able to hold them
+//   --optimize-cache      reorder triangles for the post transform vertex cache
+//   --optimize-overdraw   reorder triangles for the vertex cache and then to reduce overdraw
+//   --optimize-fetch      renumber vertices in the order the indices first use them
+//   --meshlets            build meshlets with culling bounds (MeshletData)
+//   --lods                build simplified levels of detail (LodData)
+//   --progressive         store meshes as a coarse base and vertex splits (ProgressiveData)
+
+typedef BmModel<BmVert, uint32_t> ConvertModel;
+typedef ConvertModel* (*ImportFn)(const std::string& fileName);
+
+// .bmf inputs are re-encoded with the default vertex layout
+static ConvertModel* ImportBmf(const std::string& fileName) { return bmdl::LoadModel<BmVert, uint32_t>(fileName); }
+static ConvertModel* ImportGlb(const std::string& fileName) { return bmdl::LoadGlb<BmVert, uint32_t>(fileName); }
+static ConvertModel* ImportObj(const std::string& fileName) { return bmdl::LoadObj<BmVert, uint32_t>(fileName); }
+static ConvertModel* ImportPly(const std::string& fileName) { return bmdl::LoadPly<BmVert, uint32_t>(fileName); }
+static ConvertModel* ImportStl(const std::string& fileName) { return bmdl::LoadStl<BmVert, uint32_t>(fileName); }
+
+struct SourceFormat
+{
+	const char*	extension;	// lower case, including the dot
+	ImportFn	import;
+};
+
+static const SourceFormat sourceFormats[] =
+{
+	{ ".bmf", ImportBmf },
+	{ ".glb", ImportGlb },
+	{ ".obj", ImportObj },
+	{ ".ply", ImportPly },
+	{ ".stl", ImportStl },
+};
+
+// a file is expected to need about this many times its size in memory while it is converted
+static const uint64_t ConvertMemoryFactor = 4;
+
+struct ConvertJob
+{
+	std::string	input;
+	std::string	output;
+	ImportFn	import;
+	uint64_t	inputBytes;
+};
+
+// =================================
+// Files
+// =================================
+
+static std::string GetExtension(const std::string& path)
+{
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return std::string();
+
+	std::string extension = path.substr(dot);
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(tolower(c)); });
+	return extension;
+}
+
+static const SourceFormat* FindSourceFormat(const std::string& path)
+{
+	std::string extension = GetExtension(path);
+	for (const SourceFormat& format : sourceFormats)
+	{
+		if (extension == format.extension)
+			return &format;
+	}
+	return nullptr;
+}
+
+static bool IsDirectory(const std::string& path)
+{
+#if defined(_WIN32)
+	DWORD attributes = GetFileAttributesA(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+static uint64_t GetFileSize(const std::string& path)
+{
+#if defined(_WIN32)
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data))
+		return 0;
+	return (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+#else
+	struct stat info;
+	return stat(path.c_str(), &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+#endif
+}
+
+// adds the paths of the files in directory, relative to it, to files
+static void ListFiles(const std::string& directory, const std::string& relative, bool recursive, std::vector<std::string>& files)
+{
+	std::string path = relative.empty() ? directory : directory + "/" + relative;
+
+#if defined(_WIN32)
+	WIN32_FIND_DATAA entry;
+	HANDLE find = FindFirstFileA((path + "/*").c_str(), &entry);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		std::string name = entry.cFileName;
+		bool isDirectory = (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+#else
+	DIR* dir = opendir(path.c_str());
+	if (dir == nullptr)
+		return;
+
+	while (dirent* entry = readdir(dir))
+	{
+		std::string name = entry->d_name;
+		bool isDirectory = IsDirectory(path + "/" + name);
+#endif
+		if (name == "." || name == "..")
+			continue;
+
+		std::string entryRelative = relative.empty() ? name : relative + "/" + name;
+		if (isDirectory)
+		{
+			if (recursive)
+				ListFiles(directory, entryRelative, recursive, files);
+		}
+		else
+			files.push_back(entryRelative);
+#if defined(_WIN32)
+	} while (FindNextFileA(find, &entry));
+	FindClose(find);
+#else
+	}
+	closedir(dir);
+#endif
+}
+
+static void MakeDirectories(const std::string& path)
+{
+	for (size_t slash = path.find_first_of("/\\", 1); ; slash = path.find_first_of("/\\", slash + 1))
+	{
+		std::string directory = path.substr(0, slash);
+		if (!directory.empty() && !IsDirectory(directory))
+		{
+		#if defined(_WIN32)
+			_mkdir(directory.c_str());
+		#else
+			mkdir(directory.c_str(), 0755);
+		#endif
+		}
+
+		if (slash == std::string::npos)
+			break;
+	}
+}
+
+static std::string ReplaceExtension(const std::string& path, const char* extension)
+{
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		return path + extension;
+	return path.substr(0, dot) + extension;
+}
+
+// =================================
+// Memory Budget
+// =================================
+
+// files wait for their estimated memory before they are converted, a file larger than the whole
+// budget still runs once nothing else is in flight
+class MemoryBudget
+{
+public:
+
+	explicit MemoryBudget(uint64_t limit) : limit(limit), used(0) {}
+
+	void Acquire(uint64_t bytes)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		available.wait(lock, [&]() { return used == 0 || used + bytes <= limit; });
+		used += bytes;
+	}
+
+	void Release(uint64_t bytes)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			used -= bytes;
+		}
+		available.notify_all();
+	}
+
+private:
+
+	uint64_t				limit;
+	uint64_t				used;
+	std::mutex				mutex;
+	std::condition_variable	available;
+};
+
+// =================================
+
+static void PrintUsage()
+{
+	printf("usage : bmdl-convert [options] <file or directory>...\n");
+	printf("  -o <dir>             output directory (default : next to the input)\n");
+	printf("  -j <threads>         files converted at once (default : one per hardware thread)\n");
+	printf("  -m <megabytes>       rough memory limit for files in flight (default : 1024)\n");
+	printf("  -r                   search directories recursively\n");
+	printf("  -q                   only report failures and the summary\n");
+	printf("  --compress-meshes    code vertex and index data\n");
+	printf("  --compress-blocks    compress blocks with the LZ block codec\n");
+	printf("  --compact-indices    store indices with the smallest type able to hold them\n");
+	printf("  --optimize-cache     reorder triangles for the post transform vertex cache\n");
+	printf("  --optimize-overdraw  reorder triangles for the vertex cache and then to reduce overdraw\n");
+	printf("  --optimize-fetch     renumber vertices in the order the indices first use them\n");
+	printf("  --meshlets           build meshlets with culling bounds\n");
+	printf("  --lods               build simplified levels of detail\n");
+	printf("  --progressive        store meshes as a coarse base and vertex splits\n");
+	printf("input formats :");
+	for (const SourceFormat& format : sourceFormats)
+		printf(" %s", format.extension);
+	printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> inputs;
+	std::string outputDir;
+	uint32_t threads = 0;
+	uint64_t memoryLimit = 1024ull * 1024 * 1024;
+	bool recursive = false;
+	bool quiet = false;
+	bool optimizeCache = false;
+	bool optimizeOverdraw = false;
+	bool optimizeFetch = false;
+	bool buildMeshlets = false;
+	bool buildLods = false;
+	bool buildProgressive = false;
+	bmdl::BmSaveOptions options;
+
+	for (int a = 1; a < argc; a++)
+	{
+		std::string arg = argv[a];
+		bool hasValue = a + 1 < argc;
+
+		if (arg == "-o" && hasValue)					outputDir = argv[++a];
+		else if (arg == "-j" && hasValue)				threads = static_cast<uint32_t>(atoi(argv[++a]));
+		else if (arg == "-m" && hasValue)				memoryLimit = static_cast<uint64_t>(atoll(argv[++a])) * 1024 * 1024;
+		else if (arg == "-r")							recursive = true;
+		else if (arg == "-q")							quiet = true;
+		else if (arg == "--compress-meshes")			options.compressMeshes = true;
+		else if (arg == "--compress-blocks")			options.compressBlocks = true;
+		else if (arg == "--compact-indices")			options.compactIndices = true;
+		else if (arg == "--optimize-cache")				optimizeCache = true;
+		else if (arg == "--optimize-overdraw")			optimizeOverdraw = true;
+		else if (arg == "--optimize-fetch")				optimizeFetch = true;
+		else if (arg == "--meshlets")					buildMeshlets = true;
+		else if (arg == "--lods")						buildLods = true;
+		else if (arg == "--progressive")				buildProgressive = true;
+		else if (arg == "-h" || arg == "--help")		{ PrintUsage(); return 0; }
+		else if (!arg.empty() && arg[0] == '-')			{ printf("unknown option %s\n", arg.c_str()); PrintUsage(); return 1; }
+		else											inputs.push_back(arg);
+	}
+
+	if (inputs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	// gather the files to convert and where they go, each output written by one job only
+	std::vector<ConvertJob> jobs;
+	std::set<std::string> outputs;
+	for (const std::string& input : inputs)
+	{
+		std::vector<std::string> files;
+		std::string root;
+
+		if (IsDirectory(input))
+		{
+			root = input;
+			ListFiles(input, std::string(), recursive, files);
+		}
+		else
+		{
+			size_t slash = input.find_last_of("/\\");
+			root = slash == std::string::npos ? std::string() : input.substr(0, slash);
+			files.push_back(slash == std::string::npos ? input : input.substr(slash + 1));
+		}
+
+		for (const std::string& file : files)
+		{
+			const SourceFormat* format = FindSourceFormat(file);
+			if (format == nullptr)
+				continue;
+
+			ConvertJob job;
+			job.input = root.empty() ? file : root + "/" + file;
+			job.output = ReplaceExtension(outputDir.empty() ? job.input : outputDir + "/" + file, ".bmf");
+			job.import = format->import;
+			job.inputBytes = GetFileSize(job.input);
+
+			if (job.output == job.input)
+			{
+				printf("skipping %s : output would overwrite the input, use -o\n", job.input.c_str());
+				continue;
+			}
+
+			if (!outputs.insert(job.output).second)
+			{
+				printf("skipping %s : %s is already written by another input\n", job.input.c_str(), job.output.c_str());
+				continue;
+			}
+
+			jobs.push_back(job);
+		}
+	}
+
+	if (jobs.empty())
+	{
+		printf("no input files found\n");
+		return 1;
+	}
+
+	// output directories are created up front so tasks only read and write files
+	for (const ConvertJob& job : jobs)
+	{
+		size_t slash = job.output.find_last_of("/\\");
+		if (slash != std::string::npos)
+			MakeDirectories(job.output.substr(0, slash));
+	}
+
+	// largest files first so a big file doesn't start last and hold up the end of the batch
+	std::stable_sort(jobs.begin(), jobs.end(), [](const ConvertJob& a, const ConvertJob& b) { return a.inputBytes > b.inputBytes; });
+
+	// files run on the workers only, so work inside a file (mesh preparation, decompression) stays on that
+	// file's thread rather than waiting for other files to finish
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+	bmdl::SetWorkerCount(threads + 1);
+
+	MemoryBudget budget(memoryLimit);
+	std::mutex printMutex;
+	std::mutex doneMutex;
+	std::condition_variable doneSignal;
+	uint32_t remaining = static_cast<uint32_t>(jobs.size());
+	std::atomic<uint32_t> finished(0);
+	std::atomic<uint32_t> failed(0);
+	std::atomic<uint64_t> bytesIn(0);
+	std::atomic<uint64_t> bytesOut(0);
+
+	printf("converting %u files on %u threads\n", static_cast<uint32_t>(jobs.size()), threads);
+	auto batchStart = std::chrono::high_resolution_clock::now();
+
+	for (const ConvertJob& job : jobs)
+	{
+		bmdl::GetWorkerPool().Submit([&, job]()
+		{
+			uint64_t estimate = job.inputBytes * ConvertMemoryFactor;
+			budget.Acquire(estimate);
+
+			auto start = std::chrono::high_resolution_clock::now();
+
+			ConvertModel* model = job.import(job.input);
+			if (model != nullptr && optimizeOverdraw)
+				bmdl::OptimizeOverdraw(*model);
+			else if (model != nullptr && optimizeCache)
+				bmdl::OptimizeVertexCache(*model);
+			if (model != nullptr && optimizeFetch)
+				bmdl::OptimizeVertexFetch(*model);
+			if (model != nullptr && buildMeshlets)
+				bmdl::BuildMeshlets(*model);
+			if (model != nullptr && buildLods)
+				bmdl::BuildLods(*model);
+			if (model != nullptr && buildProgressive)
+				bmdl::BuildProgressiveMeshes(*model);
+			bool converted = model != nullptr && bmdl::SaveModel(job.output, *model, &BmDefaultLayout, options);
+			delete model;
+
+			auto end = std::chrono::high_resolution_clock::now();
+			budget.Release(estimate);
+
+			uint64_t outputBytes = converted ? GetFileSize(job.output) : 0;
+			double ms = std::chrono::duration<double, std::milli>(end - start).count();
+			uint32_t index = ++finished;
+
+			bytesIn += job.inputBytes;
+			bytesOut += outputBytes;
+			if (!converted)
+				failed++;
+
+			if (!converted || !quiet)
+			{
+				std::lock_guard<std::mutex> lock(printMutex);
+				if (converted)
+					printf("[%u/%u] %s -> %s : %.1f KB -> %.1f KB, %.2f ms, %.1f MB/s\n", index, static_cast<uint32_t>(jobs.size()),
+						job.input.c_str(), job.output.c_str(), job.inputBytes / 1024.0, outputBytes / 1024.0, ms,
+						ms > 0.0 ? (job.inputBytes / (1024.0 * 1024.0)) / (ms / 1000.0) : 0.0);
+				else
+					printf("[%u/%u] %s : FAILED\n", index, static_cast<uint32_t>(jobs.size()), job.input.c_str());
+			}
+
+			std::lock_guard<std::mutex> lock(doneMutex);
+			if (--remaining == 0)
+				doneSignal.notify_one();
+		});
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(doneMutex);
+		doneSignal.wait(lock, [&]() { return remaining == 0; });
+	}
+
+	double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - batchStart).count();
+	printf("converted %u of %u files in %.2f s, %.1f files/s, %.1f MB in -> %.1f MB out, %.1f MB/s\n",
+		static_cast<uint32_t>(jobs.size()) - failed, static_cast<uint32_t>(jobs.size()), seconds, jobs.size() / seconds,
+		bytesIn / (1024.0 * 1024.0), bytesOut / (1024.0 * 1024.0), (bytesIn / (1024.0 * 1024.0)) / seconds);
+
+	return failed == 0 ? 0 : 1;
+}